@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+
+/**
+ * Statistics of the native allocator serving key/value data buffers.
+ *
+ * <p>
+ * Value buffers are served from sector-aligned slab segments and dedicated
+ * mappings reserved from the system. Comparing the reserved and used byte
+ * counts gives the memory held by the allocator's free lists and size class
+ * rounding.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class AllocatorStats {
+
+	/** The number of bytes reserved from the system. */
+	private final long reserved;
+
+	/** The number of bytes currently handed out to values. */
+	private final long used;
+
+	/** The number of slab segments reserved. */
+	private final long segments;
+
+	/** The number of dedicated mappings held for large values. */
+	private final long mappings;
+
+	public AllocatorStats(long reserved, long used, long segments,
+			long mappings) {
+		this.reserved = reserved;
+		this.used = used;
+		this.segments = segments;
+		this.mappings = mappings;
+	}
+
+	/**
+	 * Returns the number of bytes reserved from the system by the allocator.
+	 */
+	public long getReservedBytes() {
+		return this.reserved;
+	}
+
+	/**
+	 * Returns the number of bytes currently allocated to values, rounded up
+	 * to their size class.
+	 */
+	public long getUsedBytes() {
+		return this.used;
+	}
+
+	/**
+	 * Returns the number of slab segments reserved by the allocator.
+	 */
+	public long getSegmentCount() {
+		return this.segments;
+	}
+
+	/**
+	 * Returns the number of dedicated mappings, in use or cached, held for
+	 * large values.
+	 */
+	public long getMappingCount() {
+		return this.mappings;
+	}
+
+	@Override
+	public String toString() {
+		return String.format("AllocatorStats(reserved=%d, used=%d, " +
+			"segments=%d, mappings=%d)", this.reserved, this.used,
+			this.segments, this.mappings);
+	}
+}
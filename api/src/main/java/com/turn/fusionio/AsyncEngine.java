@@ -0,0 +1,262 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.util.concurrent.Future;
+import java.util.concurrent.Semaphore;
+
+/**
+ * Asynchronous I/O engine for a key/value store.
+ *
+ * <p>
+ * Operations are executed by a pool of native worker threads, which lets a
+ * few submitting threads keep many operations in flight on the device. The
+ * number of operations in flight is bounded by the number of request slots
+ * of the engine: submitting blocks while all slots are in use, which provides
+ * backpressure to the callers. Completed operations are collected by a
+ * single reaper thread that completes their {@link Future}.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+class AsyncEngine {
+
+	/** Default number of native worker threads. */
+	static final int DEFAULT_THREADS = 8;
+
+	/** Default maximum number of operations in flight. */
+	static final int DEFAULT_MAX_IN_FLIGHT = 256;
+
+	/** Maximum number of completions collected at once by the reaper. */
+	private static final int REAP_BATCH_SIZE = 64;
+
+	private final long handle;
+	private final Semaphore permits;
+	private final AsyncResult<?>[] pending;
+	private final boolean[] reads;
+	private final int[] free;
+	private int freeCount;
+	private final Thread reaper;
+
+	private boolean stopped;
+
+	AsyncEngine(int threads, int maxInFlight) throws FusionIOException {
+		if (threads <= 0 || maxInFlight <= 0) {
+			throw new IllegalArgumentException(
+				"Invalid asynchronous engine configuration!");
+		}
+
+		this.handle = FusionIOAPI.fio_kv_async_create(threads, maxInFlight);
+		if (this.handle == 0) {
+			throw new FusionIOException(
+				"Could not start the asynchronous I/O engine!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		this.permits = new Semaphore(maxInFlight);
+		this.pending = new AsyncResult<?>[maxInFlight];
+		this.reads = new boolean[maxInFlight];
+		this.free = new int[maxInFlight];
+		for (int i=0; i<maxInFlight; i++) {
+			this.free[i] = i;
+		}
+		this.freeCount = maxInFlight;
+		this.stopped = false;
+
+		this.reaper = new Thread(new Runnable() {
+			@Override
+			public void run() {
+				reap();
+			}
+		}, "fusionio-async-reaper");
+		this.reaper.setDaemon(true);
+		this.reaper.start();
+	}
+
+	/**
+	 * Submit an asynchronous read of a key/value pair.
+	 */
+	Future<Value> get(Pool pool, Key key) throws FusionIOException {
+		AsyncResult<Value> result = new AsyncResult<Value>(pool, key, null);
+		long poolHandle = pool.handle();
+
+		this.permits.acquireUninterruptibly();
+		synchronized (this.free) {
+			int slot = this.assign(result, true);
+			if (!FusionIOAPI.fio_kv_async_get(this.handle, slot, poolHandle,
+					key.address(), key.size())) {
+				this.release(slot);
+				throw new IllegalStateException(
+					"Asynchronous I/O engine is shut down!");
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * Submit an asynchronous write of a key/value pair.
+	 */
+	Future<Void> put(Pool pool, Key key, Value value)
+			throws FusionIOException {
+		AsyncResult<Void> result = new AsyncResult<Void>(pool, key, value);
+		KeyValueInfo info = value.info();
+		long poolHandle = pool.handle();
+
+		this.permits.acquireUninterruptibly();
+		synchronized (this.free) {
+			int slot = this.assign(result, false);
+			if (!FusionIOAPI.fio_kv_async_put(this.handle, slot, poolHandle,
+					key.address(), key.size(),
+					value.address(), info.value_len,
+					info.expiry, info.gen_count)) {
+				this.release(slot);
+				throw new IllegalStateException(
+					"Asynchronous I/O engine is shut down!");
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * Stop the engine.
+	 *
+	 * <p>
+	 * Operations already submitted are completed before the native worker
+	 * threads and the reaper thread exit.
+	 * </p>
+	 */
+	void shutdown() {
+		synchronized (this.free) {
+			if (this.stopped) {
+				return;
+			}
+
+			this.stopped = true;
+			FusionIOAPI.fio_kv_async_shutdown(this.handle);
+		}
+
+		boolean interrupted = false;
+		while (this.reaper.isAlive()) {
+			try {
+				this.reaper.join();
+			} catch (InterruptedException ie) {
+				interrupted = true;
+			}
+		}
+
+		FusionIOAPI.fio_kv_async_destroy(this.handle);
+		if (interrupted) {
+			Thread.currentThread().interrupt();
+		}
+	}
+
+	/**
+	 * Assign a free request slot to the given result.
+	 *
+	 * <p>
+	 * Must be called with a permit acquired and the slot lock held, which
+	 * guarantees that a slot is available and that the engine is not being
+	 * shut down while the request is submitted.
+	 * </p>
+	 */
+	private int assign(AsyncResult<?> result, boolean read) {
+		if (this.stopped) {
+			this.permits.release();
+			throw new IllegalStateException(
+				"Asynchronous I/O engine is shut down!");
+		}
+
+		int slot = this.free[--this.freeCount];
+		this.pending[slot] = result;
+		this.reads[slot] = read;
+		return slot;
+	}
+
+	/**
+	 * Return a request slot to the free list.
+	 */
+	private void release(int slot) {
+		synchronized (this.free) {
+			this.pending[slot] = null;
+			this.free[this.freeCount++] = slot;
+		}
+		this.permits.release();
+	}
+
+	/**
+	 * Reaper thread main loop.
+	 */
+	private void reap() {
+		int[] slots = new int[REAP_BATCH_SIZE];
+		int count;
+
+		while ((count = FusionIOAPI.fio_kv_async_reap(this.handle, slots)) >= 0) {
+			for (int i=0; i<count; i++) {
+				this.complete(slots[i]);
+			}
+		}
+	}
+
+	/**
+	 * Complete the result of the request in the given slot.
+	 */
+	@SuppressWarnings("unchecked")
+	private void complete(int slot) {
+		AsyncResult<?> result;
+		boolean read;
+		synchronized (this.free) {
+			result = this.pending[slot];
+			read = this.reads[slot];
+		}
+
+		int ret = FusionIOAPI.fio_kv_async_result(this.handle, slot);
+		if (read) {
+			Value value = FusionIOAPI.fio_kv_async_value(this.handle, slot);
+			if (value != null) {
+				((AsyncResult<Value>) result).set(value.prepare());
+			} else {
+				result.fail(new FusionIOException(
+					"Error reading key/value pair!",
+					FusionIOAPI.fio_kv_async_error(this.handle, slot)));
+			}
+		} else if (ret >= 0) {
+			((AsyncResult<Void>) result).set(null);
+		} else {
+			result.fail(new FusionIOException(
+				"Error writing key/value pair!",
+				FusionIOAPI.fio_kv_async_error(this.handle, slot)));
+		}
+
+		this.release(slot);
+	}
+}
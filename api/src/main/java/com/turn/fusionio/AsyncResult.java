@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
+
+/**
+ * The pending result of an asynchronous key/value store operation.
+ *
+ * <p>
+ * Results are completed by the {@link AsyncEngine}'s reaper thread. Until
+ * then, they hold on to the {@link Pool}, {@link Key} and {@link Value}
+ * objects of the operation so that the native memory they point to remains
+ * valid while the request is in flight. Operations submitted to the device
+ * cannot be cancelled.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+class AsyncResult<V> implements Future<V> {
+
+	private final CountDownLatch done;
+
+	private Pool pool;
+	private Key key;
+	private Value value;
+
+	private V result;
+	private FusionIOException error;
+
+	AsyncResult(Pool pool, Key key, Value value) {
+		this.done = new CountDownLatch(1);
+		this.pool = pool;
+		this.key = key;
+		this.value = value;
+	}
+
+	/**
+	 * Complete this result successfully.
+	 */
+	void set(V result) {
+		this.result = result;
+		this.release();
+	}
+
+	/**
+	 * Complete this result with an error.
+	 */
+	void fail(FusionIOException error) {
+		this.error = error;
+		this.release();
+	}
+
+	private void release() {
+		this.pool = null;
+		this.key = null;
+		this.value = null;
+		this.done.countDown();
+	}
+
+	@Override
+	public boolean cancel(boolean mayInterruptIfRunning) {
+		return false;
+	}
+
+	@Override
+	public boolean isCancelled() {
+		return false;
+	}
+
+	@Override
+	public boolean isDone() {
+		return this.done.getCount() == 0;
+	}
+
+	@Override
+	public V get() throws InterruptedException, ExecutionException {
+		this.done.await();
+		return this.outcome();
+	}
+
+	@Override
+	public V get(long timeout, TimeUnit unit)
+			throws InterruptedException, ExecutionException, TimeoutException {
+		if (!this.done.await(timeout, unit)) {
+			throw new TimeoutException();
+		}
+
+		return this.outcome();
+	}
+
+	private V outcome() throws ExecutionException {
+		if (this.error != null) {
+			throw new ExecutionException(this.error);
+		}
+
+		return this.result;
+	}
+}
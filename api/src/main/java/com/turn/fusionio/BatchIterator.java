@@ -0,0 +1,241 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.nio.ByteBuffer;
+import java.util.Iterator;
+import java.util.NoSuchElementException;
+
+/**
+ * Base class for iterators reading the records of a FusionIO pool in batches.
+ *
+ * <p>
+ * Records are read from the device in batches, packed by the native side into
+ * a single sector-aligned buffer with one JNI call per batch. Subclasses turn
+ * each record into the element they return, which may refer to slices of this
+ * buffer, only valid until the following batch is read.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+abstract class BatchIterator<E> implements Iterator<E> {
+
+	/** Maximum number of records read in one batch. */
+	static final int BATCH_MAX_RECORDS = 1024;
+
+	/** Size of the fio_kv_batch_t header, in bytes. */
+	private static final int BATCH_HEADER_SIZE = 8;
+
+	/** Size of the fio_kv_record_t header, in bytes. */
+	private static final int RECORD_HEADER_SIZE = 20;
+
+	private final Pool pool;
+	private final int iterator;
+	private final boolean keysOnly;
+
+	private Value buffer;
+	private int count;
+	private int index;
+	private boolean ended;
+
+	/**
+	 * Instantiate a new batch iterator on the given key/value store.
+	 *
+	 * @param pool The key/value store pool to iterate over.
+	 * @param size The size of the batch buffer.
+	 * @param keysOnly Whether to only read keys and their metadata.
+	 * @throws FusionIOException If the native store iterator could not be
+	 *	obtained.
+	 */
+	BatchIterator(Pool pool, int size, boolean keysOnly)
+			throws FusionIOException {
+		this.pool = pool;
+		this.keysOnly = keysOnly;
+		this.iterator = FusionIOAPI.fio_kv_iterator(this.pool);
+		if (this.iterator < 0) {
+			throw new FusionIOException("Could not create iterator on " +
+				this.pool + "!", FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		this.buffer = Value.get(size);
+		this.count = 0;
+		this.index = 0;
+		this.ended = false;
+	}
+
+	@Override
+	protected final void finalize() throws Throwable {
+		this.end();
+		super.finalize();
+	}
+
+	@Override
+	public boolean hasNext() {
+		if (this.index < this.count) {
+			return true;
+		}
+
+		if (!this.ended) {
+			this.fetch();
+			if (this.index < this.count) {
+				return true;
+			}
+		}
+
+		this.end();
+		return false;
+	}
+
+	@Override
+	public E next() {
+		if (!this.hasNext()) {
+			throw new NoSuchElementException();
+		}
+
+		ByteBuffer data = this.buffer.getByteBuffer();
+		int offset = offset(data, this.index++);
+		return this.read(data, offset, info(data, offset, this.pool.id));
+	}
+
+	@Override
+	public void remove() {
+		throw new UnsupportedOperationException();
+	}
+
+	/**
+	 * Build the element returned for a record of the current batch.
+	 *
+	 * @param data The batch buffer.
+	 * @param offset The offset of the record in the batch buffer.
+	 * @param info The record's key/value information.
+	 */
+	protected abstract E read(ByteBuffer data, int offset, KeyValueInfo info);
+
+	/**
+	 * Return the number of records in a batch buffer.
+	 */
+	static int count(ByteBuffer data) {
+		return data.getInt(0);
+	}
+
+	/**
+	 * Tell whether the iteration ended with the batch in the given buffer.
+	 */
+	static boolean ended(ByteBuffer data) {
+		return data.getInt(4) != 0;
+	}
+
+	/**
+	 * Return the offset of a record in a batch buffer.
+	 *
+	 * @param data The batch buffer.
+	 * @param index The index of the record in the batch.
+	 */
+	static int offset(ByteBuffer data, int index) {
+		return data.getInt(BATCH_HEADER_SIZE + 4 * index);
+	}
+
+	/**
+	 * Return the key/value information of a record.
+	 *
+	 * @param data The batch buffer.
+	 * @param offset The offset of the record in the batch buffer.
+	 * @param poolId The ID of the pool the record was read from.
+	 */
+	static KeyValueInfo info(ByteBuffer data, int offset, int poolId) {
+		return new KeyValueInfo(poolId, data.getInt(offset),
+			data.getInt(offset + 4), data.getInt(offset + 8),
+			data.getInt(offset + 12));
+	}
+
+	/**
+	 * Return the key of a record as a slice of the batch buffer.
+	 */
+	static Key key(ByteBuffer data, int offset, KeyValueInfo info) {
+		return Key.wrap(slice(data, offset + RECORD_HEADER_SIZE,
+			info.key_len));
+	}
+
+	/**
+	 * Return the value of a record as a slice of the batch buffer.
+	 */
+	static Value value(ByteBuffer data, int offset, KeyValueInfo info) {
+		return Value.wrap(slice(data, data.getInt(offset + 16),
+			info.value_len), info);
+	}
+
+	/**
+	 * Return a slice of the given buffer.
+	 */
+	private static ByteBuffer slice(ByteBuffer data, int offset, int length) {
+		ByteBuffer slice = data.duplicate();
+		slice.limit(offset + length).position(offset);
+		return slice.slice();
+	}
+
+	/**
+	 * Read the next batch of records into the batch buffer.
+	 */
+	private void fetch() {
+		ByteBuffer data = this.buffer.getByteBuffer();
+		int read = FusionIOAPI.fio_kv_next_batch(this.pool.handle(),
+			this.iterator, this.buffer.address(), data.capacity(),
+			BATCH_MAX_RECORDS, this.keysOnly);
+
+		this.index = 0;
+		if (read < 0) {
+			this.count = 0;
+			this.ended = true;
+		} else {
+			this.count = read;
+			this.ended = ended(data);
+		}
+	}
+
+	/**
+	 * End the native iteration and release the batch buffer.
+	 *
+	 * <p>
+	 * This happens as soon as the iteration reaches its end, instead of
+	 * waiting for the iterator to be finalized.
+	 * </p>
+	 */
+	private synchronized void end() {
+		this.ended = true;
+		if (this.buffer == null) {
+			return;
+		}
+
+		this.buffer.free();
+		this.buffer = null;
+		FusionIOAPI.fio_kv_end_iteration(this.pool, this.iterator);
+	}
+}
@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+
+/**
+ * Statistics of the in-process read cache of a {@link Store}.
+ *
+ * <p>
+ * The read cache keeps recently read key/value pairs in native memory, up to
+ * its byte budget, so that reads of hot keys don't need a device I/O.
+ * Entries leave the cache when they are evicted to make room for others,
+ * when they expire, or when their key/value pair is written or removed.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class CacheStats {
+
+	/** The number of reads served from the cache. */
+	private final long hits;
+
+	/** The number of reads that had to go to the device. */
+	private final long misses;
+
+	/** The number of key/value pairs added to the cache. */
+	private final long insertions;
+
+	/** The number of entries evicted to make room for others. */
+	private final long evictions;
+
+	/** The number of entries dropped because they expired. */
+	private final long expirations;
+
+	/** The number of entries dropped by writes and removals. */
+	private final long invalidations;
+
+	/** The number of entries currently cached. */
+	private final long entries;
+
+	/** The number of bytes currently used by cached entries. */
+	private final long bytes;
+
+	/** The cache's byte budget. */
+	private final long capacity;
+
+	public CacheStats(long hits, long misses, long insertions, long evictions,
+			long expirations, long invalidations, long entries, long bytes,
+			long capacity) {
+		this.hits = hits;
+		this.misses = misses;
+		this.insertions = insertions;
+		this.evictions = evictions;
+		this.expirations = expirations;
+		this.invalidations = invalidations;
+		this.entries = entries;
+		this.bytes = bytes;
+		this.capacity = capacity;
+	}
+
+	/**
+	 * Returns the number of reads served from the cache.
+	 */
+	public long getHitCount() {
+		return this.hits;
+	}
+
+	/**
+	 * Returns the number of reads that missed the cache.
+	 */
+	public long getMissCount() {
+		return this.misses;
+	}
+
+	/**
+	 * Returns the ratio of reads served from the cache, or 0 if nothing was
+	 * read yet.
+	 */
+	public double getHitRatio() {
+		long reads = this.hits + this.misses;
+		return reads > 0 ? (double) this.hits / reads : 0;
+	}
+
+	/**
+	 * Returns the number of key/value pairs added to the cache.
+	 */
+	public long getInsertionCount() {
+		return this.insertions;
+	}
+
+	/**
+	 * Returns the number of entries evicted to make room for others.
+	 */
+	public long getEvictionCount() {
+		return this.evictions;
+	}
+
+	/**
+	 * Returns the number of entries dropped because they expired.
+	 */
+	public long getExpirationCount() {
+		return this.expirations;
+	}
+
+	/**
+	 * Returns the number of entries dropped because their key/value pair was
+	 * written or removed.
+	 */
+	public long getInvalidationCount() {
+		return this.invalidations;
+	}
+
+	/**
+	 * Returns the number of entries currently cached.
+	 */
+	public long getEntryCount() {
+		return this.entries;
+	}
+
+	/**
+	 * Returns the number of bytes used by the cached entries, including their
+	 * keys and bookkeeping.
+	 */
+	public long getUsedBytes() {
+		return this.bytes;
+	}
+
+	/**
+	 * Returns the cache's byte budget.
+	 */
+	public long getCapacity() {
+		return this.capacity;
+	}
+
+	@Override
+	public String toString() {
+		return String.format("CacheStats(hits=%d, misses=%d, " +
+			"insertions=%d, evictions=%d, expirations=%d, " +
+			"invalidations=%d, entries=%d, bytes=%d, capacity=%d)",
+			this.hits, this.misses, this.insertions, this.evictions,
+			this.expirations, this.invalidations, this.entries, this.bytes,
+			this.capacity);
+	}
+}
@@ -56,10 +56,20 @@ public class FusionIOAPI {
 	 */
 	private static final String LIBRARY_NAME = "fio_kv_helper";
 
+	/**
+	 * System property enabling huge pages for the native value buffers.
+	 *
+	 * <p>
+	 * When set to <tt>true</tt>, the native allocator backs the memory it
+	 * reserves for value buffers with huge pages when available.
+	 * </p>
+	 */
+	public static final String HUGEPAGES_PROPERTY = "fusionio.hugepages";
+
 	static {
 		try {
 			System.loadLibrary(LIBRARY_NAME);
-			fio_kv_init_jni_cache();
+			fio_kv_use_hugepages(Boolean.getBoolean(HUGEPAGES_PROPERTY));
 		} catch (Exception e) {
 			System.err.println("Could not initialize FusionIO binding!");
 			e.printStackTrace(System.err);
@@ -84,6 +94,33 @@ public class FusionIOAPI {
 		return new Store(path, version, expiryMode, expiryTime);
 	}
 
+	/**
+	 * Retrieve an instanciated {@link ShardedStore} spread over the given
+	 * FusionIO devices or directFS files.
+	 *
+	 * @param paths The FusionIO device files or directFS file paths, in the
+	 *	order of their position on the store's hashing ring.
+	 * @param version The user-defined FusionIO store version.
+	 * @param expiryMode The key/value pair expiration policy.
+	 * @param expiryTime Only used for {@link ExpiryMode.GLOBAL_EXPIRY},
+	 *	defines the key/value pair TTL in seconds after insertion.
+	 * @return Returns an initialized {@link ShardedStore} instance.
+	 */
+	public static ShardedStore get(String[] paths, int version,
+			ExpiryMode expiryMode, int expiryTime) {
+		return new ShardedStore(paths, version, expiryMode, expiryTime);
+	}
+
+	/**
+	 * Retrieve the statistics of the native allocator serving the
+	 * sector-aligned memory of {@link Value} buffers.
+	 *
+	 * @return Returns an {@link AllocatorStats} snapshot.
+	 */
+	public static AllocatorStats getAllocatorStats() {
+		return fio_kv_get_allocator_stats();
+	}
+
 	/**
 	 * Expiry modes fore the FusionIO store.
 	 *
@@ -99,12 +136,19 @@ public class FusionIOAPI {
 		GLOBAL_EXPIRY;
 	};
 
-	static native void fio_kv_init_jni_cache();
-
 	static native boolean fio_kv_open(Store store, int version,
-		ExpiryMode expiryMode, int expiryTime);
+		ExpiryMode expiryMode, int expiryTime, long cacheSize);
 	static native void fio_kv_close(Store store);
 	static native StoreInfo fio_kv_get_store_info(Store store);
+	static native CacheStats fio_kv_get_cache_stats(long store);
+	static native StoreStats fio_kv_get_stats(long store);
+	static native boolean fio_kv_set_group_commit(long store, int maxPairs,
+		int delay);
+	static native boolean fio_kv_set_sched(long store, int ioClass, int rate,
+		int burst, int maxDefer);
+	static native boolean fio_kv_set_hot_keys(long store, String path,
+		int maxKeys);
+	static native boolean fio_kv_prefetch_hot_keys(long store);
 
 	static native Pool fio_kv_get_or_create_pool(Store store, String tag);
 	static native Pool[] fio_kv_get_all_pools(Store store);
@@ -113,6 +157,8 @@ public class FusionIOAPI {
 
 	static native ByteBuffer fio_kv_alloc(int length);
 	static native void fio_kv_free_value(Value value);
+	static native void fio_kv_use_hugepages(boolean enabled);
+	static native AllocatorStats fio_kv_get_allocator_stats();
 
 	static native int fio_kv_get_value_len(Pool pool, Key key);
 	static native KeyValueInfo fio_kv_get_key_info(Pool pool, Key key);
@@ -124,6 +170,9 @@ public class FusionIOAPI {
 	static native boolean fio_kv_delete_all(Store store);
 
 	static native boolean fio_kv_batch_put(Pool pool, Key[] keys, Value[] values);
+	static native int fio_kv_batch_put_count(Pool pool, Key[] keys,
+		Value[] values);
+	static native Value[] fio_kv_batch_get(Pool pool, Key[] keys);
 
 	static native int fio_kv_iterator(Pool pool);
 	static native boolean fio_kv_next(Pool pool, int iterator);
@@ -131,4 +180,151 @@ public class FusionIOAPI {
 	static native boolean fio_kv_end_iteration(Pool pool, int iterator);
 
 	static native int fio_kv_get_last_error();
+
+	/*
+	 * Handle-based fast path.
+	 *
+	 * These entry points take pre-resolved native pool handles and raw key
+	 * and value buffer addresses, as cached by Pool, Key and Value objects,
+	 * instead of walking the Java objects through JNI on every call.
+	 */
+
+	static native void fio_kv_release_store_handle(long store);
+	static native long fio_kv_pool_handle(Pool pool);
+	static native void fio_kv_release_pool_handle(long pool);
+	static native long fio_kv_address(ByteBuffer buffer);
+
+	static native int fio_kv_fast_get_value_len(long pool, long key, int keyLength);
+	static native int fio_kv_fast_get(long pool, long key, int keyLength,
+		long value, int valueLength);
+	static native Value fio_kv_fast_get_alloc(long pool, long key,
+		int keyLength);
+	static native int fio_kv_fast_put(long pool, long key, int keyLength,
+		long value, int valueLength, int expiry, int genCount);
+	static native boolean fio_kv_fast_exists(long pool, long key, int keyLength);
+	static native boolean fio_kv_fast_delete(long pool, long key, int keyLength);
+	static native int fio_kv_fast_compare_and_put(long pool, long key,
+		int keyLength, long value, int valueLength, int expiry, int genCount);
+	static native int fio_kv_fast_put_if_absent(long pool, long key,
+		int keyLength, long value, int valueLength, int expiry);
+	static native boolean fio_kv_fast_increment(long pool, long key,
+		int keyLength, long delta, int expiry, long[] result);
+	static native int fio_kv_fast_append(long pool, long key, int keyLength,
+		long data, int length, int expiry);
+	static native int fio_kv_fast_batch_put(long pool, long buffer, int size,
+		int count);
+	static native int fio_kv_fast_batch_delete(long pool, Key[] keys);
+	static native int fio_kv_fast_batch_exists(long pool, Key[] keys,
+		byte[] bitmap);
+	static native int fio_kv_next_batch(long pool, int iterator, long buffer,
+		int size, int max, boolean keysOnly);
+
+	/*
+	 * Long key fast path.
+	 *
+	 * These entry points take 8-byte keys as long IDs, in the layout of
+	 * Key.createFrom(long), which the native side builds without any Key
+	 * object.
+	 */
+
+	static native int fio_kv_fast_get_long(long pool, long id, long value,
+		int valueLength);
+	static native Value fio_kv_fast_get_long_alloc(long pool, long id);
+	static native int fio_kv_fast_put_long(long pool, long id, long value,
+		int valueLength, int expiry, int genCount);
+	static native boolean fio_kv_fast_exists_long(long pool, long id);
+	static native boolean fio_kv_fast_delete_long(long pool, long id);
+	static native int fio_kv_fast_batch_put_long(long pool, long[] ids,
+		Value[] values);
+	static native Value[] fio_kv_fast_batch_get_long(long pool, long[] ids);
+	static native int fio_kv_fast_batch_delete_long(long pool, long[] ids);
+	static native int fio_kv_fast_batch_exists_long(long pool, long[] ids,
+		byte[] bitmap);
+
+	/*
+	 * Asynchronous I/O engine.
+	 */
+
+	static native long fio_kv_async_create(int threads, int slots);
+	static native boolean fio_kv_async_get(long engine, int slot, long pool,
+		long key, int keyLength);
+	static native boolean fio_kv_async_put(long engine, int slot, long pool,
+		long key, int keyLength, long value, int valueLength, int expiry,
+		int genCount);
+	static native int fio_kv_async_reap(long engine, int[] slots);
+	static native int fio_kv_async_result(long engine, int slot);
+	static native int fio_kv_async_error(long engine, int slot);
+	static native Value fio_kv_async_value(long engine, int slot);
+	static native void fio_kv_async_shutdown(long engine);
+	static native void fio_kv_async_destroy(long engine);
+
+	/*
+	 * Parallel pool scan.
+	 */
+
+	static native long fio_kv_scan_create(long[] pools, int threads,
+		int buffers, int size, int max, boolean keysOnly);
+	static native ByteBuffer fio_kv_scan_buffer(long scan, int buffer);
+	static native int fio_kv_scan_reap(long scan, int[] pool);
+	static native void fio_kv_scan_release(long scan, int buffer);
+	static native void fio_kv_scan_destroy(long scan);
+
+	/*
+	 * Per-pool Bloom filters.
+	 */
+
+	static native boolean fio_kv_build_filter(long pool, long capacity);
+	static native boolean fio_kv_save_filter(long pool, String path);
+	static native boolean fio_kv_load_filter(long pool, String path);
+
+	/*
+	 * Value compression.
+	 */
+
+	static native boolean fio_kv_set_compression(long pool, boolean enabled);
+
+	/*
+	 * Small-value packing.
+	 */
+
+	static native boolean fio_kv_set_packing(long pool, int buckets);
+
+	/*
+	 * Multi-device sharding.
+	 */
+
+	static native long fio_kv_shard_create(int shards);
+	static native void fio_kv_shard_destroy(long shard);
+	static native int fio_kv_shard_of(long shard, long key, int keyLength);
+	static native int fio_kv_shard_batch(long shard, long[] pools, int op,
+		Key[] keys, Value[] values);
+
+	/*
+	 * Chunked large values.
+	 */
+
+	static native boolean fio_kv_fast_put_large(long pool, long key,
+		int keyLength, long value, int valueLength, int expiry);
+	static native Value fio_kv_fast_get_large(long pool, long key,
+		int keyLength);
+	static native boolean fio_kv_fast_delete_large(long pool, long key,
+		int keyLength);
+
+	/*
+	 * Shared-memory submission and completion rings.
+	 */
+
+	static native long fio_kv_ring_create(int entries, int threads);
+	static native ByteBuffer fio_kv_ring_buffer(long ring);
+	static native void fio_kv_ring_wake(long ring);
+	static native boolean fio_kv_ring_wait(long ring, int head, int timeout);
+	static native void fio_kv_ring_destroy(long ring);
+
+	/*
+	 * Pool export and import.
+	 */
+
+	static native long fio_kv_export_pool(long pool, String path);
+	static native long fio_kv_import_pool(long pool, String path,
+		int threads);
 }
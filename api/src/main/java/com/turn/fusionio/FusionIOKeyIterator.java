@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.nio.ByteBuffer;
+import java.util.AbstractMap;
+import java.util.Map;
+
+/**
+ * An iterator over the keys in a FusionIO store and their metadata.
+ *
+ * <p>
+ * Unlike {@link FusionIOStoreIterator}, value data is never read from the
+ * device: each key is returned along with its {@link KeyValueInfo}, giving
+ * the length of its value, its expiry and its generation count. This makes
+ * scans that only need keys, like rebuilding an index or counting expired
+ * entries, bound by metadata reads instead of by the device's bandwidth.
+ * </p>
+ *
+ * <p>
+ * The returned keys are slices of the iterator's batch buffer and are only
+ * valid until the following batch is read. Callers needing to keep a key
+ * around for longer must copy it.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class FusionIOKeyIterator
+		extends BatchIterator<Map.Entry<Key, KeyValueInfo>> {
+
+	/** Size of the batch buffer. */
+	static final int BATCH_BUFFER_SIZE = 256 * 1024;
+
+	/**
+	 * Instantiate a new key iterator on the given key/value store.
+	 *
+	 * @param pool The key/value store pool to iterate over.
+	 * @throws FusionIOException If the native store iterator could not be
+	 *	obtained.
+	 */
+	public FusionIOKeyIterator(Pool pool) throws FusionIOException {
+		super(pool, BATCH_BUFFER_SIZE, true);
+	}
+
+	@Override
+	protected Map.Entry<Key, KeyValueInfo> read(ByteBuffer data, int offset,
+			KeyValueInfo info) {
+		return new AbstractMap.SimpleImmutableEntry<Key, KeyValueInfo>(
+			key(data, offset, info), info);
+	}
+}
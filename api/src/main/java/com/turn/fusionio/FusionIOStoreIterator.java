@@ -31,23 +31,28 @@
 package com.turn.fusionio;
 
 import java.nio.ByteBuffer;
-import java.util.Iterator;
 import java.util.Map;
-import java.util.NoSuchElementException;
 
 /**
  * An iterator over the key/value pairs in a FusionIO store.
  *
+ * <p>
+ * Key/value pairs are read from the device in batches, packed by the native
+ * side into a single sector-aligned buffer with one JNI call per batch. The
+ * keys and values returned by this iterator are slices of this buffer: they
+ * are only valid until the following batch is read, that is until
+ * {@link #hasNext()} or {@link #next()} are called after the last pair of the
+ * current batch was returned. Callers needing to keep a key or value around
+ * for longer must copy it.
+ * </p>
+ *
  * @author mpetazzoni
  */
-public class FusionIOStoreIterator implements Iterator<Map.Entry<Key, Value>> {
-
-	private final Pool pool;
-	private final int iterator;
+public class FusionIOStoreIterator
+		extends BatchIterator<Map.Entry<Key, Value>> {
 
-	private final KeyValuePair allocated;
-	private KeyValuePair next;
-	private boolean first;
+	/** Size of the batch buffer, large enough for the largest pair. */
+	static final int BATCH_BUFFER_SIZE = 2 * 1024 * 1024;
 
 	/**
 	 * Instantiate a new iterator on the given key/value store.
@@ -57,68 +62,13 @@ public class FusionIOStoreIterator implements Iterator<Map.Entry<Key, Value>> {
 	 *	obtained.
 	 */
 	public FusionIOStoreIterator(Pool pool) throws FusionIOException {
-		this.pool = pool;
-		this.iterator = FusionIOAPI.fio_kv_iterator(this.pool);
-		if (this.iterator < 0) {
-			throw new FusionIOException("Could not create iterator on " +
-				this.pool + "!", FusionIOAPI.fio_kv_get_last_error());
-		}
-
-		this.allocated = new KeyValuePair(
-			Key.get(Key.FUSION_IO_MAX_KEY_SIZE),
-			Value.get(Value.FUSION_IO_MAX_VALUE_SIZE));
-		this.next = null;
-		this.first = true;
-	}
-
-	@Override
-	protected final void finalize() throws Throwable {
-		this.allocated.getValue().free();
-		FusionIOAPI.fio_kv_end_iteration(this.pool, this.iterator);
-		super.finalize();
+		super(pool, BATCH_BUFFER_SIZE, false);
 	}
 
 	@Override
-	public boolean hasNext() {
-		this.next = this.advance();
-		return this.next != null;
-	}
-
-	@Override
-	public Map.Entry<Key, Value> next() {
-		if (this.next == null) {
-			this.next = this.advance();
-		}
-
-		if (this.next == null) {
-			throw new NoSuchElementException();
-		}
-
-		KeyValuePair next = this.next;
-		this.next = null;
-		return next;
-	}
-
-	@Override
-	public void remove() {
-		throw new UnsupportedOperationException();
-	}
-
-	private KeyValuePair advance() {
-		if (!this.first && !FusionIOAPI.fio_kv_next(this.pool, this.iterator)) {
-			return null;
-		}
-
-		this.first = false;
-
-		if (!FusionIOAPI.fio_kv_get_current(this.pool, this.iterator,
-				allocated.getKey(), allocated.getValue())) {
-			return null;
-		}
-
-		ByteBuffer data = allocated.getValue().getByteBuffer();
-		data.rewind();
-		data.limit(allocated.getValue().size());
-		return allocated;
+	protected Map.Entry<Key, Value> read(ByteBuffer data, int offset,
+			KeyValueInfo info) {
+		return new KeyValuePair(key(data, offset, info),
+			value(data, offset, info));
 	}
 }
@@ -0,0 +1,384 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.io.Closeable;
+import java.lang.reflect.Field;
+import java.nio.ByteBuffer;
+import java.util.concurrent.TimeUnit;
+
+import sun.misc.Unsafe;
+
+/**
+ * Shared-memory submission and completion rings to native worker threads.
+ *
+ * <p>
+ * An I/O ring is an alternative transport to the JNI calls of {@link Pool}
+ * for very high operation rates. Operations are described in a submission
+ * queue living in native memory shared with a pool of native worker threads,
+ * which execute them and post their results to a completion queue in the
+ * same memory. Neither submitting nor reaping an operation crosses JNI;
+ * the only native calls are the doorbell, made when all the workers went to
+ * sleep after finding the ring idle, and the blocking part of {@link
+ * #waitFor(CompletionHandler, long, TimeUnit)}.
+ * </p>
+ *
+ * <p>
+ * Each operation carries a caller-defined 64-bit tag, handed back with its
+ * result to the {@link CompletionHandler} when it completes. Operations
+ * complete in no particular order. No more operations than the ring has
+ * entries can be submitted and not reaped: submitting returns
+ * <tt>false</tt> when the ring is full, and the caller must reap completions
+ * before trying again. The keys and values of the submitted operations are
+ * read and written in place by the workers and must not be modified or freed
+ * until the operations complete.
+ * </p>
+ *
+ * <p>
+ * Submissions may be made from any thread, and are serialized by the ring.
+ * Completions must be reaped by one thread at a time.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class IORing implements Closeable {
+
+	/** Ring layout, kept in sync with fio_kv_ring.h. */
+	private static final int SQ_TAIL = 0;
+	private static final int CQ_TAIL = 128;
+	private static final int CQ_HEAD = 192;
+	private static final int FLAGS = 256;
+	private static final int HEADER_SIZE = 320;
+
+	private static final int SQE_SIZE = 48;
+	private static final int SQE_USER_DATA = 0;
+	private static final int SQE_POOL = 8;
+	private static final int SQE_KEY = 16;
+	private static final int SQE_VALUE = 24;
+	private static final int SQE_KEY_LEN = 32;
+	private static final int SQE_VALUE_LEN = 36;
+	private static final int SQE_EXPIRY = 40;
+	private static final int SQE_OP = 44;
+
+	private static final int CQE_SIZE = 16;
+	private static final int CQE_USER_DATA = 0;
+	private static final int CQE_RESULT = 8;
+	private static final int CQE_ERROR = 12;
+
+	private static final int NEED_WAKEUP = 0x1;
+
+	private static final int OP_GET = 1;
+	private static final int OP_PUT = 2;
+	private static final int OP_EXISTS = 3;
+	private static final int OP_DELETE = 4;
+
+	/** Maximum number of entries of a ring. */
+	public static final int MAX_ENTRIES = 65536;
+
+	/** Number of polls of the completion queue before yielding the CPU. */
+	private static final int WAIT_SPIN = 256;
+
+	/** Number of yields before blocking for completions. */
+	private static final int WAIT_YIELD = 16;
+
+	private static final Unsafe UNSAFE;
+	static {
+		try {
+			Field field = Unsafe.class.getDeclaredField("theUnsafe");
+			field.setAccessible(true);
+			UNSAFE = (Unsafe) field.get(null);
+		} catch (Exception e) {
+			throw new ExceptionInInitializerError(e);
+		}
+	}
+
+	/**
+	 * Receives the results of the operations of a ring.
+	 */
+	public interface CompletionHandler {
+
+		/**
+		 * Handle the completion of an operation.
+		 *
+		 * @param tag The tag the operation was submitted with.
+		 * @param result The operation's result: the number of bytes read or
+		 *	written for gets and puts, 1 if the key exists or 0 if it does
+		 *	not for existence checks, and 0 for removals. A negative result
+		 *	means the operation failed.
+		 * @param error The error code of a failed operation, or 0.
+		 */
+		void complete(long tag, int result, int error);
+	}
+
+	private final long handle;
+	private final ByteBuffer buffer;
+	private final long base;
+	private final long sq;
+	private final long cq;
+	private final int entries;
+	private final int mask;
+
+	private int sqTail;
+	private volatile int cqHead;
+	private boolean closed;
+
+	/**
+	 * Create a new I/O ring and start its native worker threads.
+	 *
+	 * @param entries The number of entries of the ring, a power of two no
+	 *	greater than {@link #MAX_ENTRIES}.
+	 * @param threads The number of native worker threads.
+	 * @throws FusionIOException If the ring could not be created.
+	 */
+	public IORing(int entries, int threads) throws FusionIOException {
+		if (entries <= 0 || entries > MAX_ENTRIES ||
+			(entries & (entries - 1)) != 0 || threads <= 0) {
+			throw new IllegalArgumentException("Invalid I/O ring configuration!");
+		}
+
+		this.handle = FusionIOAPI.fio_kv_ring_create(entries, threads);
+		if (this.handle == 0) {
+			throw new FusionIOException("Could not create the I/O ring!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		this.buffer = FusionIOAPI.fio_kv_ring_buffer(this.handle);
+		this.base = FusionIOAPI.fio_kv_address(this.buffer);
+		this.sq = this.base + HEADER_SIZE;
+		this.cq = this.sq + (long) entries * SQE_SIZE;
+		this.entries = entries;
+		this.mask = entries - 1;
+
+		this.sqTail = 0;
+		this.cqHead = 0;
+		this.closed = false;
+	}
+
+	/**
+	 * Return the number of entries of this ring.
+	 */
+	public int getEntries() {
+		return this.entries;
+	}
+
+	/**
+	 * Submit a read of a key/value pair into the given value.
+	 *
+	 * @param pool The pool to read from.
+	 * @param key The key of the pair to read.
+	 * @param value The value to read into, of the expected size.
+	 * @param tag The caller-defined tag of the operation.
+	 * @return Returns <tt>true</tt> if the operation was submitted,
+	 *	<tt>false</tt> if the ring is full.
+	 */
+	public boolean get(Pool pool, Key key, Value value, long tag) {
+		return this.submit(OP_GET, pool, key, value.address(), value.size(),
+			0, tag);
+	}
+
+	/**
+	 * Submit a write of a key/value pair.
+	 *
+	 * @param pool The pool to write into.
+	 * @param key The key of the pair.
+	 * @param value The value of the pair.
+	 * @param tag The caller-defined tag of the operation.
+	 * @return Returns <tt>true</tt> if the operation was submitted,
+	 *	<tt>false</tt> if the ring is full.
+	 */
+	public boolean put(Pool pool, Key key, Value value, long tag) {
+		return this.submit(OP_PUT, pool, key, value.address(), value.size(),
+			value.info().expiry, tag);
+	}
+
+	/**
+	 * Submit an existence check of a key.
+	 *
+	 * @param pool The pool to look into.
+	 * @param key The key to look for.
+	 * @param tag The caller-defined tag of the operation.
+	 * @return Returns <tt>true</tt> if the operation was submitted,
+	 *	<tt>false</tt> if the ring is full.
+	 */
+	public boolean exists(Pool pool, Key key, long tag) {
+		return this.submit(OP_EXISTS, pool, key, 0, 0, 0, tag);
+	}
+
+	/**
+	 * Submit the removal of a key/value pair.
+	 *
+	 * @param pool The pool to remove from.
+	 * @param key The key of the pair to remove.
+	 * @param tag The caller-defined tag of the operation.
+	 * @return Returns <tt>true</tt> if the operation was submitted,
+	 *	<tt>false</tt> if the ring is full.
+	 */
+	public boolean delete(Pool pool, Key key, long tag) {
+		return this.submit(OP_DELETE, pool, key, 0, 0, 0, tag);
+	}
+
+	/**
+	 * Write an operation descriptor in the submission queue and publish it.
+	 *
+	 * <p>
+	 * The descriptor is published with a volatile store of the tail, which
+	 * orders it before the read of the ring's flags; workers set the
+	 * doorbell flag before checking the queue one last time, so one of both
+	 * sides always sees the other.
+	 * </p>
+	 */
+	private synchronized boolean submit(int op, Pool pool, Key key,
+			long value, int valueLength, int expiry, long tag) {
+		if (this.closed) {
+			throw new IllegalStateException("I/O ring is closed!");
+		}
+
+		if (!pool.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (this.sqTail - this.cqHead >= this.entries) {
+			return false;
+		}
+
+		long sqe = this.sq + (long) (this.sqTail & this.mask) * SQE_SIZE;
+		UNSAFE.putLong(sqe + SQE_USER_DATA, tag);
+		UNSAFE.putLong(sqe + SQE_POOL, pool.handle());
+		UNSAFE.putLong(sqe + SQE_KEY, key.address());
+		UNSAFE.putLong(sqe + SQE_VALUE, value);
+		UNSAFE.putInt(sqe + SQE_KEY_LEN, key.size());
+		UNSAFE.putInt(sqe + SQE_VALUE_LEN, valueLength);
+		UNSAFE.putInt(sqe + SQE_EXPIRY, expiry);
+		UNSAFE.putInt(sqe + SQE_OP, op);
+
+		this.sqTail++;
+		UNSAFE.putIntVolatile(null, this.base + SQ_TAIL, this.sqTail);
+		if ((UNSAFE.getIntVolatile(null, this.base + FLAGS) & NEED_WAKEUP) != 0) {
+			FusionIOAPI.fio_kv_ring_wake(this.handle);
+		}
+
+		return true;
+	}
+
+	/**
+	 * Reap the operations completed so far, without waiting.
+	 *
+	 * @param handler The handler receiving the completions.
+	 * @return Returns the number of operations reaped.
+	 */
+	public int poll(CompletionHandler handler) {
+		if (this.closed) {
+			throw new IllegalStateException("I/O ring is closed!");
+		}
+
+		int head = this.cqHead;
+		int tail = UNSAFE.getIntVolatile(null, this.base + CQ_TAIL);
+		int count = tail - head;
+
+		while (head != tail) {
+			long cqe = this.cq + (long) (head & this.mask) * CQE_SIZE;
+			long tag = UNSAFE.getLong(cqe + CQE_USER_DATA);
+			int result = UNSAFE.getInt(cqe + CQE_RESULT);
+			int error = UNSAFE.getInt(cqe + CQE_ERROR);
+
+			// Release the entry before handing out its result, so that the
+			// handler can submit new operations in its place.
+			head++;
+			this.cqHead = head;
+			UNSAFE.putOrderedInt(null, this.base + CQ_HEAD, head);
+			handler.complete(tag, result, error);
+		}
+
+		return count;
+	}
+
+	/**
+	 * Reap completed operations, waiting for at least one if none are
+	 * available.
+	 *
+	 * <p>
+	 * The completion queue is polled for a short while, then the thread
+	 * yields a few times before blocking until completions are posted or the
+	 * timeout expires.
+	 * </p>
+	 *
+	 * @param handler The handler receiving the completions.
+	 * @param timeout The maximum time to wait.
+	 * @param unit The unit of the timeout.
+	 * @return Returns the number of operations reaped, 0 if the timeout
+	 *	expired.
+	 */
+	public int waitFor(CompletionHandler handler, long timeout, TimeUnit unit) {
+		int count;
+		for (int i=0; i<WAIT_SPIN + WAIT_YIELD; i++) {
+			if ((count = this.poll(handler)) > 0) {
+				return count;
+			}
+
+			if (i >= WAIT_SPIN) {
+				Thread.yield();
+			}
+		}
+
+		long deadline = System.nanoTime() + unit.toNanos(timeout);
+		while ((count = this.poll(handler)) == 0) {
+			long remaining = TimeUnit.NANOSECONDS.toMicros(
+				deadline - System.nanoTime());
+			if (remaining <= 0) {
+				break;
+			}
+
+			FusionIOAPI.fio_kv_ring_wait(this.handle, this.cqHead,
+				(int) Math.min(remaining, Integer.MAX_VALUE));
+		}
+
+		return count;
+	}
+
+	/**
+	 * Stop the ring's native worker threads and release the ring.
+	 *
+	 * <p>
+	 * Operations not yet reaped are lost; callers should reap all their
+	 * operations before closing the ring. If the ring is already closed,
+	 * this method does nothing.
+	 * </p>
+	 */
+	@Override
+	public synchronized void close() {
+		if (this.closed) {
+			return;
+		}
+
+		this.closed = true;
+		FusionIOAPI.fio_kv_ring_destroy(this.handle);
+	}
+}
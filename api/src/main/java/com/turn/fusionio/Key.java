@@ -61,6 +61,9 @@ public class Key {
 	/** The key bytes themselves. */
 	private ByteBuffer bytes = null;
 
+	/** The native address of the key bytes, resolved on first use. */
+	private long address = 0;
+
 	/**
 	 * Empty private constructor.
 	 *
@@ -90,6 +93,20 @@ public class Key {
 		return this.bytes;
 	}
 
+	/**
+	 * Return the native address of this key's data.
+	 *
+	 * @return The address of the memory backing this key's
+	 *	{@link ByteBuffer}, for use with the handle-based native calls.
+	 */
+	long address() {
+		if (this.address == 0) {
+			this.address = FusionIOAPI.fio_kv_address(this.bytes);
+		}
+
+		return this.address;
+	}
+
 	/**
 	 * Allocate memory for this {@link Key}.
 	 *
@@ -107,6 +124,7 @@ public class Key {
 		this.length = size;
 		this.bytes = ByteBuffer.allocateDirect(this.length)
 			.order(ByteOrder.nativeOrder());
+		this.address = 0;
 		return this;
 	}
 
@@ -151,6 +169,23 @@ public class Key {
 		return new Key().allocate(size);
 	}
 
+	/**
+	 * Wrap a slice of a native buffer into a {@link Key}.
+	 *
+	 * <p>
+	 * The key's bytes are not copied: the key is only valid as long as the
+	 * buffer's contents are.
+	 * </p>
+	 *
+	 * @param bytes A direct {@link ByteBuffer} slice holding the key.
+	 */
+	static Key wrap(ByteBuffer bytes) {
+		Key k = new Key();
+		k.length = bytes.remaining();
+		k.bytes = bytes.order(ByteOrder.nativeOrder());
+		return k;
+	}
+
 	/**
 	 * Create a new {@link Key} from the given long ID.
 	 *
@@ -0,0 +1,221 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+/**
+ * Statistics of one kind of operation on a {@link Store}.
+ *
+ * <p>
+ * Latencies are the time spent in the native helper library's calls, which
+ * includes the device I/O, and are counted in log-linear histograms whose
+ * buckets are within 12.5% of the latencies they count. The JNI overhead of
+ * the calls made through the object-based API, the time spent marshalling
+ * their Java objects, is kept in a separate histogram; the calls made with
+ * pre-resolved native handles, which don't marshal anything, are not part
+ * of it.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class OperationStats {
+
+	/** Number of linear sub-buckets per power of two in the histograms. */
+	private static final int SUB_BUCKETS = 8;
+
+	/** The number of operations. */
+	private final long count;
+
+	/** The number of operations that failed. */
+	private final long errors;
+
+	/** The number of value bytes written. */
+	private final long bytesIn;
+
+	/** The number of value bytes read. */
+	private final long bytesOut;
+
+	/** The total time spent in the operations, in nanoseconds. */
+	private final long nativeNanos;
+
+	/** The number of JNI calls. */
+	private final long jniCount;
+
+	/** The total JNI overhead of the calls, in nanoseconds. */
+	private final long jniNanos;
+
+	/** The latency histogram of the operations. */
+	private final long[] latencies;
+
+	/** The JNI overhead histogram of the calls. */
+	private final long[] jniLatencies;
+
+	public OperationStats(long count, long errors, long bytesIn,
+			long bytesOut, long nativeNanos, long jniCount, long jniNanos,
+			long[] latencies, long[] jniLatencies) {
+		this.count = count;
+		this.errors = errors;
+		this.bytesIn = bytesIn;
+		this.bytesOut = bytesOut;
+		this.nativeNanos = nativeNanos;
+		this.jniCount = jniCount;
+		this.jniNanos = jniNanos;
+		this.latencies = latencies;
+		this.jniLatencies = jniLatencies;
+	}
+
+	/**
+	 * Returns the number of operations.
+	 */
+	public long getCount() {
+		return this.count;
+	}
+
+	/**
+	 * Returns the number of operations that failed, including the reads of
+	 * keys that don't exist.
+	 */
+	public long getErrorCount() {
+		return this.errors;
+	}
+
+	/**
+	 * Returns the number of value bytes written.
+	 */
+	public long getBytesIn() {
+		return this.bytesIn;
+	}
+
+	/**
+	 * Returns the number of value bytes read.
+	 */
+	public long getBytesOut() {
+		return this.bytesOut;
+	}
+
+	/**
+	 * Returns the mean latency of the operations, in nanoseconds, or 0 if
+	 * there was none.
+	 */
+	public long getMeanLatency() {
+		return this.count > 0 ? this.nativeNanos / this.count : 0;
+	}
+
+	/**
+	 * Returns the given percentile of the latency of the operations.
+	 *
+	 * @param percentile The percentile, between 0 and 100.
+	 * @return The highest latency, in nanoseconds, of the operations within
+	 *	the percentile, or 0 if there was none.
+	 */
+	public long getLatency(double percentile) {
+		return percentile(this.latencies, percentile);
+	}
+
+	/**
+	 * Returns the number of JNI calls, made through the object-based API.
+	 */
+	public long getJNICount() {
+		return this.jniCount;
+	}
+
+	/**
+	 * Returns the mean JNI overhead of the calls, in nanoseconds, or 0 if
+	 * there was none.
+	 */
+	public long getMeanJNIOverhead() {
+		return this.jniCount > 0 ? this.jniNanos / this.jniCount : 0;
+	}
+
+	/**
+	 * Returns the given percentile of the JNI overhead of the calls.
+	 *
+	 * @param percentile The percentile, between 0 and 100.
+	 * @return The highest overhead, in nanoseconds, of the calls within the
+	 *	percentile, or 0 if there was none.
+	 */
+	public long getJNIOverhead(double percentile) {
+		return percentile(this.jniLatencies, percentile);
+	}
+
+	/**
+	 * Returns the highest latency, in nanoseconds, counted in the given
+	 * bucket of a histogram.
+	 */
+	static long bucketLimit(int bucket) {
+		if (bucket < SUB_BUCKETS) {
+			return bucket;
+		}
+
+		int shift = bucket / SUB_BUCKETS - 1;
+		long sub = bucket % SUB_BUCKETS;
+		return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+	}
+
+	/**
+	 * Computes a percentile from a histogram.
+	 */
+	private static long percentile(long[] histogram, double percentile) {
+		if (percentile < 0 || percentile > 100) {
+			throw new IllegalArgumentException("Invalid percentile!");
+		}
+
+		long total = 0;
+		for (long count : histogram) {
+			total += count;
+		}
+
+		if (total == 0) {
+			return 0;
+		}
+
+		long rank = Math.max(1, (long) Math.ceil(percentile / 100 * total));
+		long seen = 0;
+		for (int i=0; i<histogram.length; i++) {
+			seen += histogram[i];
+			if (seen >= rank) {
+				return bucketLimit(i);
+			}
+		}
+
+		return bucketLimit(histogram.length - 1);
+	}
+
+	@Override
+	public String toString() {
+		return String.format("OperationStats(count=%d, errors=%d, " +
+			"bytesIn=%d, bytesOut=%d, mean=%dns, p50=%dns, p99=%dns, " +
+			"p999=%dns, jniCount=%d, jniMean=%dns, jniP99=%dns)",
+			this.count, this.errors, this.bytesIn, this.bytesOut,
+			this.getMeanLatency(), this.getLatency(50), this.getLatency(99),
+			this.getLatency(99.9), this.jniCount, this.getMeanJNIOverhead(),
+			this.getJNIOverhead(99));
+	}
+}
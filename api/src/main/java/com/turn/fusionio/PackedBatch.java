@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.nio.ByteBuffer;
+
+/**
+ * A batch of key/value pairs packed in a single native buffer.
+ *
+ * <p>
+ * Keys and values added to the batch are copied into one sector-aligned
+ * buffer, which starts with a table describing each pair (mapping to the
+ * <tt>fio_kv_packed_t</tt> structure in the helper library) followed by the
+ * key and value bytes. Writing the batch with {@link Pool#put(PackedBatch)}
+ * then takes a single JNI call, whose cost doesn't depend on the number of
+ * Java objects involved.
+ * </p>
+ *
+ * <p>
+ * A batch can be reused for several writes by calling {@link #clear()}, and
+ * must be released with {@link #free()} after use.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class PackedBatch {
+
+	/** Size of a fio_kv_packed_t entry, in bytes. */
+	private static final int ENTRY_SIZE = 24;
+
+	/** The device's sector size, to which values are aligned. */
+	private static final int SECTOR_SIZE = 512;
+
+	private final int capacity;
+	private final int start;
+
+	private Value buffer;
+	private ByteBuffer data;
+	private int count;
+	private int position;
+
+	/**
+	 * Allocate a new packed batch.
+	 *
+	 * @param size The size of the batch buffer, in bytes, including the pair
+	 *	descriptions.
+	 * @param capacity The maximum number of key/value pairs in the batch.
+	 */
+	public PackedBatch(int size, int capacity) {
+		if (capacity <= 0) {
+			throw new IllegalArgumentException("Invalid batch capacity!");
+		}
+
+		this.capacity = capacity;
+		this.start = align(capacity * ENTRY_SIZE);
+		if (size <= this.start) {
+			throw new IllegalArgumentException(
+				"Batch buffer is too small for " + capacity + " pairs!");
+		}
+
+		this.buffer = Value.get(size);
+		this.data = this.buffer.getByteBuffer();
+		this.clear();
+	}
+
+	/**
+	 * Return the number of key/value pairs in this batch.
+	 */
+	public int size() {
+		return this.count;
+	}
+
+	/**
+	 * Add a key/value pair to this batch.
+	 *
+	 * @param key The key.
+	 * @param value The value's data, from its position to its limit.
+	 * @return Returns <tt>true</tt> if the pair was added, <tt>false</tt> if
+	 *	the batch is full.
+	 * @see #add(Key, ByteBuffer, int)
+	 */
+	public boolean add(Key key, ByteBuffer value) {
+		return this.add(key, value, 0);
+	}
+
+	/**
+	 * Add a key/value pair to this batch.
+	 *
+	 * <p>
+	 * The key and value bytes are copied into the batch buffer; the value's
+	 * position is left untouched.
+	 * </p>
+	 *
+	 * @param key The key.
+	 * @param value The value's data, from its position to its limit.
+	 * @param expiry The pair's expiry delay, in seconds.
+	 * @return Returns <tt>true</tt> if the pair was added, <tt>false</tt> if
+	 *	the batch is full.
+	 */
+	public boolean add(Key key, ByteBuffer value, int expiry) {
+		if (this.data == null) {
+			throw new IllegalStateException("Batch was freed!");
+		}
+
+		int keyOffset = this.position;
+		int valueOffset = align(keyOffset + key.size());
+		int length = value.remaining();
+		if (this.count == this.capacity ||
+				length > Value.FUSION_IO_MAX_VALUE_SIZE ||
+				valueOffset + length > this.data.capacity()) {
+			return false;
+		}
+
+		ByteBuffer k = key.getByteBuffer().duplicate();
+		k.clear().limit(key.size());
+		this.data.position(keyOffset);
+		this.data.put(k);
+		this.data.position(valueOffset);
+		this.data.put(value.duplicate());
+
+		int entry = this.count * ENTRY_SIZE;
+		this.data.putInt(entry, keyOffset);
+		this.data.putInt(entry + 4, key.size());
+		this.data.putInt(entry + 8, valueOffset);
+		this.data.putInt(entry + 12, length);
+		this.data.putInt(entry + 16, expiry);
+		this.data.putInt(entry + 20, 0);
+
+		this.count++;
+		this.position = valueOffset + length;
+		return true;
+	}
+
+	/**
+	 * Remove all key/value pairs from this batch.
+	 *
+	 * @return Returns the {@link PackedBatch} object, for chaining.
+	 */
+	public PackedBatch clear() {
+		this.count = 0;
+		this.position = this.start;
+		return this;
+	}
+
+	/**
+	 * Release the native memory backing this batch.
+	 */
+	public void free() {
+		if (this.buffer != null) {
+			this.buffer.free();
+			this.buffer = null;
+			this.data = null;
+		}
+	}
+
+	/**
+	 * Return the native address of the batch buffer.
+	 */
+	long address() {
+		return this.buffer.address();
+	}
+
+	/**
+	 * Return the size of the batch buffer, in bytes.
+	 */
+	int capacity() {
+		return this.data.capacity();
+	}
+
+	private static int align(int offset) {
+		return (offset + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1);
+	}
+}
@@ -30,8 +30,10 @@
  */
 package com.turn.fusionio;
 
+import java.util.BitSet;
 import java.util.Iterator;
 import java.util.Map;
+import java.util.concurrent.Future;
 
 /**
  * Represents a FusionIO-based key/value store pool.
@@ -54,11 +56,27 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 	 * Maximum batch size.
 	 *
 	 * <p>
-	 * Maximum number of elements per batch operation.
+	 * Maximum number of elements per device batch operation. Larger batches
+	 * are transparently split into sub-batches of this size on the native
+	 * side.
 	 * </p>
 	 */
 	public static final int FUSION_IO_MAX_BATCH_SIZE = 16;
 
+	/**
+	 * Maximum size of the values of packed pools.
+	 *
+	 * @see #setPacking(int)
+	 */
+	public static final int FUSION_IO_MAX_PACKED_VALUE_SIZE = 512;
+
+	/**
+	 * Maximum number of threads of a pool import.
+	 *
+	 * @see #importFrom(String, int)
+	 */
+	public static final int FUSION_IO_MAX_IMPORT_THREADS = 64;
+
 	/**
 	 * Maximum pool tag length.
 	 *
@@ -69,6 +87,12 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 	 */
 	public static final int FUSION_IO_MAX_POOL_TAG_LENGTH = 15;
 
+	/**
+	 * Number of bytes appended to the key of a large value to derive the
+	 * keys of its chunks.
+	 */
+	public static final int FUSION_IO_LARGE_KEY_SUFFIX = 9;
+
 	/** The FusionIO store this pool is a part of. */
 	public final Store store;
 
@@ -78,20 +102,73 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 	/** The pool tag. */
 	public final String tag;
 
+	/**
+	 * The native pool handle, a pointer to a long-lived
+	 * <tt>fio_kv_pool_t</tt> structure, resolved on first use.
+	 */
+	private volatile long handle;
+
 	Pool(Store store, int id, String tag) {
 		this.store = store;
 		this.id = id;
 		this.tag = tag;
+		this.handle = 0;
+	}
+
+	/**
+	 * Return the native handle of this pool.
+	 *
+	 * <p>
+	 * The handle is resolved once and gives the handle-based native calls
+	 * direct access to the pool and store structures, without having to walk
+	 * the Pool and Store objects through JNI on every operation.
+	 * </p>
+	 *
+	 * @return The address of this pool's native <tt>fio_kv_pool_t</tt>
+	 *	structure.
+	 */
+	long handle() {
+		long handle = this.handle;
+		if (handle != 0) {
+			return handle;
+		}
+
+		synchronized (this) {
+			if (this.handle == 0) {
+				this.handle = FusionIOAPI.fio_kv_pool_handle(this);
+				if (this.handle == 0) {
+					throw new IllegalStateException(
+						"Could not resolve native handle for " + this + "!");
+				}
+			}
+
+			return this.handle;
+		}
+	}
+
+	@Override
+	protected void finalize() throws Throwable {
+		if (this.handle != 0) {
+			FusionIOAPI.fio_kv_release_pool_handle(this.handle);
+			this.handle = 0;
+		}
+		super.finalize();
 	}
 
 	/**
 	 * Retrieve a value from the key/value store.
 	 *
 	 * <p>
+	 * The value is allocated and read in a single native call, using a
+	 * buffer sized from the size of the last value read from this pool. A
+	 * second device read only happens when the value doesn't fit.
+	 * </p>
+	 *
+	 * <p>
 	 * It is the responsibility of the caller to manage the memory used by the
 	 * {@link Value} object that is returned, in particular calling {@link
 	 * Value#free()} to free the sector-aligned memory allocated on the native
-	 * side by {@link Value#allocate(int)} or {@link Value#get(int)}.
+	 * side.
 	 * </p>
 	 *
 	 * @param key The key of the pair to retrieve.
@@ -104,19 +181,47 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 			throw new IllegalStateException("Key/value store is not opened!");
 		}
 
-		int size = FusionIOAPI.fio_kv_get_value_len(this, key);
-		if (size < 0) {
-			throw new FusionIOException("Error calculating required value size!");
-		}
-
-		Value value = Value.get(size);
-		if (FusionIOAPI.fio_kv_get(this, key, value) < 0) {
+		Value value = FusionIOAPI.fio_kv_fast_get_alloc(this.handle(),
+			key.address(), key.size());
+		if (value == null) {
 			throw new FusionIOException("Error reading key/value pair!",
 				FusionIOAPI.fio_kv_get_last_error());
 		}
 
-		value.getByteBuffer().limit(value.size());
-		return value;
+		return value.prepare();
+	}
+
+	/**
+	 * Asynchronously retrieve a value from the key/value store.
+	 *
+	 * <p>
+	 * The read is executed by the store's asynchronous I/O engine. This
+	 * method blocks only when the engine's maximum number of operations in
+	 * flight is reached. The returned {@link Future} fails with a {@link
+	 * FusionIOException} if the read fails.
+	 * </p>
+	 *
+	 * <p>
+	 * It is the responsibility of the caller to manage the memory used by the
+	 * {@link Value} object that is eventually returned, in particular calling
+	 * {@link Value#free()} to free the sector-aligned memory allocated on the
+	 * native side.
+	 * </p>
+	 *
+	 * @param key The key of the pair to retrieve. It must not be modified
+	 *	until the operation completes.
+	 * @return Returns a {@link Future} of the allocated {@link Value}
+	 *	containing the requested data.
+	 * @throws FusionIOException If the asynchronous I/O engine could not be
+	 *	started.
+	 * @see Store#configureAsync(int, int)
+	 */
+	public Future<Value> getAsync(Key key) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		return this.store.async().get(this, key);
 	}
 
 	/**
@@ -144,12 +249,45 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 			throw new IllegalStateException("Key/value store is not opened!");
 		}
 
-		if (FusionIOAPI.fio_kv_put(this, key, value) != value.size()) {
+		KeyValueInfo info = value.info();
+		if (FusionIOAPI.fio_kv_fast_put(this.handle(),
+				key.address(), key.size(),
+				value.address(), info.value_len,
+				info.expiry, info.gen_count) != value.size()) {
 			throw new FusionIOException("Error writing key/value pair!",
 				FusionIOAPI.fio_kv_get_last_error());
 		}
 	}
 
+	/**
+	 * Asynchronously insert or update a key/value pair into the key/value
+	 * store.
+	 *
+	 * <p>
+	 * The write is executed by the store's asynchronous I/O engine. This
+	 * method blocks only when the engine's maximum number of operations in
+	 * flight is reached. The returned {@link Future} fails with a {@link
+	 * FusionIOException} if the write fails.
+	 * </p>
+	 *
+	 * @param key The key. It must not be modified until the operation
+	 *	completes.
+	 * @param value The value to write for that key. It must not be modified
+	 *	or freed until the operation completes.
+	 * @return Returns a {@link Future} completed once the pair is written.
+	 * @throws FusionIOException If the asynchronous I/O engine could not be
+	 *	started.
+	 * @see Store#configureAsync(int, int)
+	 */
+	public Future<Void> putAsync(Key key, Value value)
+			throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		return this.store.async().put(this, key, value);
+	}
+
 	/**
 	 * Inserts or updates a set of key/value pairs into the key/value store in
 	 * one batch operation.
@@ -176,14 +314,103 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 			throw new IllegalStateException("Key/value store is not opened!");
 		}
 
-		if (keys.length < 1 || keys.length > FUSION_IO_MAX_BATCH_SIZE ||
-			keys.length != values.length) {
+		if (keys.length < 1 || keys.length != values.length) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		int written = FusionIOAPI.fio_kv_batch_put_count(this, keys, values);
+		if (written != keys.length) {
+			throw new FusionIOException(String.format(
+					"Error writing key/value pair batch at pair %d " +
+					"(sub-batch %d)!", written,
+					written / FUSION_IO_MAX_BATCH_SIZE),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Inserts the key/value pairs of a packed batch into the key/value store.
+	 *
+	 * <p>
+	 * The whole batch is written with a single native call, in sub-batches of
+	 * {@link #FUSION_IO_MAX_BATCH_SIZE} pairs. Existing pairs with the same
+	 * keys are overwritten. The batch is left untouched and can be cleared
+	 * for reuse afterwards.
+	 * </p>
+	 *
+	 * @param batch The packed batch of key/value pairs.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pairs batch.
+	 */
+	public void put(PackedBatch batch) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (batch.size() < 1) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		int written = FusionIOAPI.fio_kv_fast_batch_put(this.handle(),
+			batch.address(), batch.capacity(), batch.size());
+		if (written != batch.size()) {
+			throw new FusionIOException(String.format(
+					"Error writing key/value pair batch at pair %d " +
+					"(sub-batch %d)!", written,
+					written / FUSION_IO_MAX_BATCH_SIZE),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Retrieves a set of key/value pairs from the key/value store in one
+	 * batch operation.
+	 *
+	 * <p>
+	 * Values are allocated on the native side to fit each key/value pair and
+	 * are all read from the device in a single batch submission. The returned
+	 * array holds, at each position, the value of the corresponding key, or
+	 * <em>null</em> if no mapping exists for that key. Each value's size
+	 * reflects the number of bytes read. Batches larger than {@link
+	 * #FUSION_IO_MAX_BATCH_SIZE} are read in sub-batches within a single
+	 * native call.
+	 * </p>
+	 *
+	 * <p>
+	 * It is the responsibility of the caller to manage the memory used by the
+	 * returned {@link Value} objects, in particular calling {@link
+	 * Value#free()} on each of them to free the sector-aligned memory
+	 * allocated on the native side.
+	 * </p>
+	 *
+	 * @param keys The array of keys to retrieve.
+	 * @return Returns an array of allocated {@link Value} objects containing
+	 *	the requested data.
+	 * @throws FusionIOException If an error occurred while reading the
+	 *	key/value pairs batch.
+	 */
+	public Value[] get(Key[] keys) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (keys.length < 1) {
 			throw new IllegalArgumentException("Invalid batch size!");
 		}
 
-		if (!FusionIOAPI.fio_kv_batch_put(this, keys, values)) {
-			throw new FusionIOException("Error writing key/value pair batch!");
+		Value[] values = FusionIOAPI.fio_kv_batch_get(this, keys);
+		if (values == null) {
+			throw new FusionIOException("Error reading key/value pair batch!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		for (Value value : values) {
+			if (value != null) {
+				value.prepare();
+			}
 		}
+
+		return values;
 	}
 
 	/**
@@ -211,9 +438,58 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 			throw new IllegalStateException("Key/value store is not opened!");
 		}
 
+		if (info == null) {
+			return FusionIOAPI.fio_kv_fast_exists(this.handle(),
+				key.address(), key.size());
+		}
+
 		return FusionIOAPI.fio_kv_exists(this, key, info);
 	}
 
+	/**
+	 * Tells which keys of a batch exist in the key/value store.
+	 *
+	 * <p>
+	 * The whole batch is checked with a single native call. Like {@link
+	 * #exists(Key)}, keys that are not in this pool's Bloom filter, if it has
+	 * one, are reported missing without any I/O on the device.
+	 * </p>
+	 *
+	 * @param keys The array of keys.
+	 * @return Returns a {@link BitSet} in which the bit of index <em>i</em>
+	 *	is set if a mapping exists for <tt>keys[i]</tt>.
+	 * @throws FusionIOException If an error occurred while checking the
+	 *	batch.
+	 */
+	public BitSet exists(Key[] keys) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		byte[] bitmap = new byte[(keys.length + 7) / 8];
+		if (FusionIOAPI.fio_kv_fast_batch_exists(this.handle(),
+				keys, bitmap) < 0) {
+			throw new FusionIOException("Error checking key batch!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return toBitSet(bitmap, keys.length);
+	}
+
+	/**
+	 * Convert the existence bitmap filled by a native batch existence check
+	 * into a {@link BitSet}.
+	 */
+	private static BitSet toBitSet(byte[] bitmap, int count) {
+		BitSet found = new BitSet(count);
+		for (int i=0; i<count; i++) {
+			if ((bitmap[i / 8] & (1 << (i % 8))) != 0) {
+				found.set(i);
+			}
+		}
+		return found;
+	}
+
 	/**
 	 * Return a filled-in {@link KeyValueInfo} object containing the metadata
 	 * about a key/value pair in this pool.
@@ -247,11 +523,702 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 			throw new IllegalStateException("Key/value store is not opened!");
 		}
 
-		if (!FusionIOAPI.fio_kv_delete(this, key)) {
+		if (!FusionIOAPI.fio_kv_fast_delete(this.handle(),
+				key.address(), key.size())) {
+			throw new FusionIOException("Error removing key/value pair!");
+		}
+	}
+
+	/**
+	 * Remove a batch of key/value pairs.
+	 *
+	 * <p>
+	 * The whole batch is removed with a single native call. Keys that have no
+	 * mapping in the store are ignored.
+	 * </p>
+	 *
+	 * @param keys The keys of the pairs to remove.
+	 * @throws FusionIOException If a pair could not be removed because of a
+	 *	low-level API error; the pairs of the keys before it in the batch
+	 *	have been removed.
+	 */
+	public void delete(Key[] keys) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		int removed = FusionIOAPI.fio_kv_fast_batch_delete(this.handle(),
+			keys);
+		if (removed != keys.length) {
+			throw new FusionIOException(String.format(
+					"Error removing key/value pair batch at pair %d!",
+					removed),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Retrieve the value of a long key.
+	 *
+	 * <p>
+	 * Long keys are the 8-byte keys built by {@link Key#createFrom(long)}:
+	 * <tt>getLong(id)</tt> reads the same pair as
+	 * <tt>get(Key.createFrom(id))</tt>, but without allocating a {@link Key}
+	 * or marshalling it to the native side. It is the responsibility of the
+	 * caller to free the returned {@link Value} with {@link Value#free()}.
+	 * </p>
+	 *
+	 * @param id The key, as a long.
+	 * @return Returns an allocated {@link Value} containing the requested data.
+	 * @throws FusionIOException If an error occurred while reading the
+	 *	key/value pair from the store.
+	 */
+	public Value getLong(long id) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		Value value = FusionIOAPI.fio_kv_fast_get_long_alloc(this.handle(), id);
+		if (value == null) {
+			throw new FusionIOException("Error reading key/value pair!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return value.prepare();
+	}
+
+	/**
+	 * Insert or update the value of a long key.
+	 *
+	 * @param id The key, as a long (see {@link #getLong(long)}).
+	 * @param value The value to write for that key.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pair to the store.
+	 */
+	public void putLong(long id, Value value) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		KeyValueInfo info = value.info();
+		if (FusionIOAPI.fio_kv_fast_put_long(this.handle(), id,
+				value.address(), info.value_len,
+				info.expiry, info.gen_count) != value.size()) {
+			throw new FusionIOException("Error writing key/value pair!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Tells whether a long key exists in the key/value store.
+	 *
+	 * @param id The key, as a long (see {@link #getLong(long)}).
+	 * @return Returns <em>true</em> if a mapping exists for the given key,
+	 * <em>false</em> otherwise.
+	 */
+	public boolean existsLong(long id) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		return FusionIOAPI.fio_kv_fast_exists_long(this.handle(), id);
+	}
+
+	/**
+	 * Remove the key/value pair of a long key.
+	 *
+	 * @param id The key, as a long (see {@link #getLong(long)}).
+	 * @throws FusionIOException If the pair could not be removed because of a
+	 *	low-level API error.
+	 */
+	public void deleteLong(long id) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (!FusionIOAPI.fio_kv_fast_delete_long(this.handle(), id)) {
 			throw new FusionIOException("Error removing key/value pair!");
 		}
 	}
 
+	/**
+	 * Retrieve the values of a batch of long keys.
+	 *
+	 * <p>
+	 * Like {@link #get(Key[])}, values are allocated on the native side and
+	 * the returned array holds <em>null</em> for keys that don't exist.
+	 * </p>
+	 *
+	 * @param ids The keys, as longs (see {@link #getLong(long)}).
+	 * @return Returns an array of {@link Value}s, in the order of the keys.
+	 * @throws FusionIOException If an error occurred while reading the
+	 *	key/value pairs batch.
+	 */
+	public Value[] getLong(long[] ids) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (ids.length < 1) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		Value[] values = FusionIOAPI.fio_kv_fast_batch_get_long(this.handle(),
+			ids);
+		if (values == null) {
+			throw new FusionIOException("Error reading key/value pair batch!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		for (Value value : values) {
+			if (value != null) {
+				value.prepare();
+			}
+		}
+
+		return values;
+	}
+
+	/**
+	 * Insert or update the values of a batch of long keys.
+	 *
+	 * @param ids The keys, as longs (see {@link #getLong(long)}).
+	 * @param values An array of corresponding values.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pairs batch.
+	 */
+	public void putLong(long[] ids, Value[] values) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (ids.length < 1 || ids.length != values.length) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		int written = FusionIOAPI.fio_kv_fast_batch_put_long(this.handle(),
+			ids, values);
+		if (written != ids.length) {
+			throw new FusionIOException(String.format(
+					"Error writing key/value pair batch at pair %d " +
+					"(sub-batch %d)!", written,
+					written / FUSION_IO_MAX_BATCH_SIZE),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Tells which long keys of a batch exist in the key/value store.
+	 *
+	 * @param ids The keys, as longs (see {@link #getLong(long)}).
+	 * @return Returns a {@link BitSet} in which the bit of index <em>i</em>
+	 *	is set if a mapping exists for <tt>ids[i]</tt>.
+	 * @throws FusionIOException If an error occurred while checking the
+	 *	batch.
+	 */
+	public BitSet existsLong(long[] ids) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		byte[] bitmap = new byte[(ids.length + 7) / 8];
+		if (FusionIOAPI.fio_kv_fast_batch_exists_long(this.handle(),
+				ids, bitmap) < 0) {
+			throw new FusionIOException("Error checking key batch!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return toBitSet(bitmap, ids.length);
+	}
+
+	/**
+	 * Remove the key/value pairs of a batch of long keys.
+	 *
+	 * @param ids The keys, as longs (see {@link #getLong(long)}).
+	 * @throws FusionIOException If a pair could not be removed because of a
+	 *	low-level API error; the pairs of the keys before it in the batch
+	 *	have been removed.
+	 */
+	public void deleteLong(long[] ids) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		int removed = FusionIOAPI.fio_kv_fast_batch_delete_long(this.handle(),
+			ids);
+		if (removed != ids.length) {
+			throw new FusionIOException(String.format(
+					"Error removing key/value pair batch at pair %d!",
+					removed),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Replace a key/value pair only if it wasn't modified since it was read.
+	 *
+	 * <p>
+	 * The generation count of the pair, as given by {@link
+	 * Value#getGenCount()} or {@link KeyValueInfo#gen_count}, is checked and
+	 * the pair replaced in a single native call. This is atomic with respect
+	 * to the other conditional and read-modify-write operations of this
+	 * process on the store, which are serialized per key on the native side;
+	 * plain puts to the same keys are not, and may be lost. Conditional
+	 * operations are not available on packed pools.
+	 * </p>
+	 *
+	 * @param key The key.
+	 * @param value The new value for that key.
+	 * @param genCount The generation count the pair is expected to have.
+	 * @return Returns <em>true</em> if the pair was replaced, <em>false</em>
+	 *	if it doesn't exist or was modified in the meantime.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pair to the store.
+	 */
+	public boolean compareAndPut(Key key, Value value, int genCount)
+			throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		KeyValueInfo info = value.info();
+		int ret = FusionIOAPI.fio_kv_fast_compare_and_put(this.handle(),
+			key.address(), key.size(), value.address(), info.value_len,
+			info.expiry, genCount);
+		if (ret < 0) {
+			throw new FusionIOException("Error writing key/value pair!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return ret > 0;
+	}
+
+	/**
+	 * Insert a key/value pair only if no mapping exists for the key.
+	 *
+	 * <p>
+	 * The existence check and the insertion are atomic with respect to the
+	 * other conditional and read-modify-write operations of this process on
+	 * the store (see {@link #compareAndPut(Key, Value, int)}).
+	 * </p>
+	 *
+	 * @param key The key.
+	 * @param value The value to write for that key.
+	 * @return Returns <em>true</em> if the pair was inserted, <em>false</em>
+	 *	if a mapping already exists for the key.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pair to the store.
+	 */
+	public boolean putIfAbsent(Key key, Value value) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		KeyValueInfo info = value.info();
+		int ret = FusionIOAPI.fio_kv_fast_put_if_absent(this.handle(),
+			key.address(), key.size(), value.address(), info.value_len,
+			info.expiry);
+		if (ret < 0) {
+			throw new FusionIOException("Error writing key/value pair!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return ret > 0;
+	}
+
+	/**
+	 * Atomically add to the counter stored as the value of a key.
+	 *
+	 * <p>
+	 * Counters are stored as 8-byte values in native byte order, and a
+	 * missing key is a counter of 0. The counter is read, updated and
+	 * written back in a single native call, atomically with respect to the
+	 * other conditional and read-modify-write operations of this process on
+	 * the store (see {@link #compareAndPut(Key, Value, int)}).
+	 * </p>
+	 *
+	 * @param key The key of the counter.
+	 * @param delta The value to add to the counter.
+	 * @return Returns the new value of the counter.
+	 * @throws FusionIOException If the key's value is not a counter or if an
+	 *	error occurred while updating it.
+	 */
+	public long increment(Key key, long delta) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		long[] result = new long[1];
+		if (!FusionIOAPI.fio_kv_fast_increment(this.handle(),
+				key.address(), key.size(), delta, 0, result)) {
+			throw new FusionIOException("Error incrementing counter!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return result[0];
+	}
+
+	/**
+	 * Atomically append data to the value of a key.
+	 *
+	 * <p>
+	 * A missing key is created with the given data as its value. The value
+	 * is read, extended and written back in a single native call, atomically
+	 * with respect to the other conditional and read-modify-write operations
+	 * of this process on the store (see {@link #compareAndPut(Key, Value,
+	 * int)}). The expiry of the data's {@link Value} applies to the updated
+	 * pair.
+	 * </p>
+	 *
+	 * @param key The key.
+	 * @param data The data to append to the key's value.
+	 * @return Returns the new length, in bytes, of the key's value.
+	 * @throws FusionIOException If the value would exceed {@link
+	 *	Value#FUSION_IO_MAX_VALUE_SIZE} or if an error occurred while updating
+	 *	it.
+	 */
+	public int append(Key key, Value data) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		KeyValueInfo info = data.info();
+		int ret = FusionIOAPI.fio_kv_fast_append(this.handle(),
+			key.address(), key.size(), data.address(), info.value_len,
+			info.expiry);
+		if (ret < 0) {
+			throw new FusionIOException("Error appending to key/value pair!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return ret;
+	}
+
+	/**
+	 * Write a value of any size, beyond {@link
+	 * Value#FUSION_IO_MAX_VALUE_SIZE}, under the given key.
+	 *
+	 * <p>
+	 * The value is split into chunks stored under keys derived from the
+	 * given key, written in parallel, and a small manifest record describing
+	 * them is written under the key itself. Large values must be read with
+	 * {@link #getLarge(Key)} and removed with {@link #deleteLarge(Key)}. The
+	 * key must leave {@value #FUSION_IO_LARGE_KEY_SUFFIX} bytes of room
+	 * below the maximum key size for the chunks' keys.
+	 * </p>
+	 *
+	 * <p>
+	 * Each write stores its chunks under a new generation, and only removes
+	 * the previous value's chunks once the new manifest is written.
+	 * Concurrent readers of the key thus get either the previous or the new
+	 * value, or fail if the previous value is removed while they read it.
+	 * Concurrent writes of the same key are not serialized.
+	 * </p>
+	 *
+	 * @param key The key.
+	 * @param value The value to write for that key.
+	 * @throws FusionIOException If an error occurred while writing the
+	 *	value.
+	 */
+	public void putLarge(Key key, Value value) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		KeyValueInfo info = value.info();
+		if (!FusionIOAPI.fio_kv_fast_put_large(this.handle(), key.address(),
+				key.size(), value.address(), info.value_len, info.expiry)) {
+			throw new FusionIOException("Error writing large value!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Retrieve a value written with {@link #putLarge(Key, Value)}.
+	 *
+	 * <p>
+	 * The value's chunks are read in parallel, directly into a single
+	 * allocated {@link Value}. It is the responsibility of the caller to
+	 * free it with {@link Value#free()}.
+	 * </p>
+	 *
+	 * @param key The key of the value to retrieve.
+	 * @return Returns an allocated {@link Value} containing the requested
+	 *	data.
+	 * @throws FusionIOException If the key doesn't hold a large value or if
+	 *	an error occurred while reading it.
+	 */
+	public Value getLarge(Key key) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		Value value = FusionIOAPI.fio_kv_fast_get_large(this.handle(),
+			key.address(), key.size());
+		if (value == null) {
+			throw new FusionIOException("Error reading large value!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return value.prepare();
+	}
+
+	/**
+	 * Remove a value written with {@link #putLarge(Key, Value)}, along with
+	 * all its chunks.
+	 *
+	 * @param key The key of the value to remove.
+	 * @throws FusionIOException If the value could not be removed because
+	 *	of a low-level API error.
+	 */
+	public void deleteLarge(Key key) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (!FusionIOAPI.fio_kv_fast_delete_large(this.handle(),
+				key.address(), key.size())) {
+			throw new FusionIOException("Error removing large value!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Build the Bloom filter of this pool.
+	 *
+	 * <p>
+	 * The filter is built from a keys-only iteration over the pool. Once
+	 * built, lookups of keys absent from the pool through {@link
+	 * #get(Key)}, {@link #exists(Key)} and {@link #getKeyValueInfo(Key)} are
+	 * answered without a device I/O, save for about 1% of false positives.
+	 * Keys written through this store are added to the filter, including
+	 * while it is being built. Keys written to the pool by another process
+	 * are not, and would be reported absent: filters must only be used on
+	 * pools this store is the only writer of.
+	 * </p>
+	 *
+	 * <p>
+	 * Removed keys can't be taken out of the filter, and only go back to
+	 * costing a device lookup. The filter lives until the store is closed;
+	 * building it again does nothing.
+	 * </p>
+	 *
+	 * @param expectedKeys The expected number of keys in this pool, which
+	 *	sizes the filter at about 10 bits per key.
+	 * @throws FusionIOException If the filter could not be built.
+	 */
+	public void buildFilter(long expectedKeys) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (expectedKeys < 0) {
+			throw new IllegalArgumentException("Invalid filter capacity!");
+		}
+
+		if (!FusionIOAPI.fio_kv_build_filter(this.handle(), expectedKeys)) {
+			throw new FusionIOException("Could not build the filter of " +
+				this + "!", FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Save the Bloom filter of this pool to a file.
+	 *
+	 * <p>
+	 * The saved filter can be loaded with {@link #loadFilter(String)} after
+	 * the store is re-opened, instead of being rebuilt. Keys written while
+	 * the filter is saved may be missing from the file, which should be
+	 * written once writes to the pool are over, typically right before the
+	 * store is closed.
+	 * </p>
+	 *
+	 * @param path The path of the file to write.
+	 * @throws FusionIOException If this pool has no filter, or if it could
+	 *	not be written.
+	 */
+	public void saveFilter(String path) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (!FusionIOAPI.fio_kv_save_filter(this.handle(), path)) {
+			throw new FusionIOException("Could not save the filter of " +
+				this + " to " + path + "!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Load the Bloom filter of this pool from a file written by {@link
+	 * #saveFilter(String)}.
+	 *
+	 * <p>
+	 * The pool must not have been written to since the filter was saved,
+	 * other than by a store using that same filter.
+	 * </p>
+	 *
+	 * @param path The path of the file to read.
+	 * @throws FusionIOException If this pool already has a filter, or if the
+	 *	file could not be read or doesn't hold a filter for this pool.
+	 */
+	public void loadFilter(String path) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (!FusionIOAPI.fio_kv_load_filter(this.handle(), path)) {
+			throw new FusionIOException("Could not load the filter of " +
+				this + " from " + path + "!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Enable or disable the compression of this pool's values.
+	 *
+	 * <p>
+	 * When enabled, values written to this pool are compressed with LZ4
+	 * whenever that saves at least one sector on the device, and values read
+	 * from it are decompressed transparently. Values written uncompressed
+	 * remain readable. The setting lasts until the store is closed, and must
+	 * be enabled by every store reading a pool holding compressed values.
+	 * </p>
+	 *
+	 * <p>
+	 * With compression enabled, {@link #getKeyValueInfo(Key)} and {@link
+	 * #exists(Key, KeyValueInfo)} report the length of the values as stored
+	 * on the device.
+	 * </p>
+	 *
+	 * @param enabled Whether to compress this pool's values.
+	 * @throws FusionIOException If the setting could not be applied.
+	 */
+	public void setCompression(boolean enabled) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (!FusionIOAPI.fio_kv_set_compression(this.handle(), enabled)) {
+			throw new FusionIOException("Could not set the compression of " +
+				this + "!", FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Make this pool a packed pool, holding small values in shared records.
+	 *
+	 * <p>
+	 * The key/value pairs of a packed pool are stored many to a device
+	 * record, in the bucket their key hashes to, so that small values don't
+	 * each take a full sector. Reads take a single device read, and writes
+	 * and removals a read-modify-write of their bucket, which only one
+	 * process at a time may do on a given pool.
+	 * </p>
+	 *
+	 * <p>
+	 * Values of packed pools are limited to {@link
+	 * #FUSION_IO_MAX_PACKED_VALUE_SIZE} bytes, and each bucket to a few
+	 * sectors of pairs, so the number of buckets should allow for the
+	 * expected number of pairs. Packed pools can't be iterated over and
+	 * don't support Bloom filters.
+	 * </p>
+	 *
+	 * <p>
+	 * The number of buckets is recorded in the pool the first time it is
+	 * packed, and every store using the pool must pack it identically before
+	 * any other operation on it.
+	 * </p>
+	 *
+	 * @param buckets The number of buckets.
+	 * @throws FusionIOException If the pool could not be packed, or was
+	 *	packed with a different number of buckets.
+	 */
+	public void setPacking(int buckets) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (buckets <= 0) {
+			throw new IllegalArgumentException("Invalid number of buckets!");
+		}
+
+		if (!FusionIOAPI.fio_kv_set_packing(this.handle(), buckets)) {
+			throw new FusionIOException("Could not pack " + this + "!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Export all the key/value pairs of this pool to a file.
+	 *
+	 * <p>
+	 * The pairs are streamed to the file in large, checksummed blocks,
+	 * written with direct I/O when the file system supports it while the
+	 * pool is read, so that pools much larger than memory can be exported
+	 * without going through the JVM. The file is written under a temporary
+	 * name and only replaces the given path once complete. Pairs written to
+	 * the pool during the export may or may not be exported. Packed pools
+	 * can't be exported.
+	 * </p>
+	 *
+	 * @param path The path of the file to write.
+	 * @return Returns the number of key/value pairs exported.
+	 * @throws FusionIOException If the pool could not be read or the file
+	 *	could not be written.
+	 */
+	public long exportTo(String path) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		long exported = FusionIOAPI.fio_kv_export_pool(this.handle(), path);
+		if (exported < 0) {
+			throw new FusionIOException("Could not export " + this + " to " +
+				path + "!", FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return exported;
+	}
+
+	/**
+	 * Import the key/value pairs of a file written by {@link
+	 * #exportTo(String)} into this pool.
+	 *
+	 * <p>
+	 * The blocks of the file are verified as they are read, and written to
+	 * the pool by the given number of native threads, with batch puts
+	 * scheduled as {@link Store.IOClass#BACKGROUND} work. Pairs already in
+	 * the pool are replaced. A corrupted or truncated file fails the import,
+	 * possibly after some of its pairs were imported.
+	 * </p>
+	 *
+	 * @param path The path of the file to read.
+	 * @param threads The number of threads writing to the pool, up to
+	 *	{@link #FUSION_IO_MAX_IMPORT_THREADS}.
+	 * @return Returns the number of key/value pairs imported.
+	 * @throws FusionIOException If the file could not be read or is not a
+	 *	valid export, or if the pairs could not be written.
+	 */
+	public long importFrom(String path, int threads) throws FusionIOException {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (threads <= 0 || threads > FUSION_IO_MAX_IMPORT_THREADS) {
+			throw new IllegalArgumentException("Invalid number of threads!");
+		}
+
+		long imported = FusionIOAPI.fio_kv_import_pool(this.handle(), path,
+			threads);
+		if (imported < 0) {
+			throw new FusionIOException("Could not import " + path +
+				" into " + this + "!", FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return imported;
+	}
+
 	/**
 	 * Retrieve an iterator on this key/value store.
 	 *
@@ -270,6 +1237,29 @@ public class Pool implements Iterable<Map.Entry<Key, Value>> {
 		}
 	}
 
+	/**
+	 * Retrieve an iterator on the keys of this key/value store.
+	 *
+	 * <p>
+	 * Only keys and their metadata are read from the device, not the values
+	 * they map to.
+	 * </p>
+	 *
+	 * @return Returns a new iterator that returns keys from this store, along
+	 *	with their {@link KeyValueInfo}.
+	 */
+	public Iterator<Map.Entry<Key, KeyValueInfo>> keyIterator() {
+		if (!this.store.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		try {
+			return new FusionIOKeyIterator(this);
+		} catch (FusionIOException fioe) {
+			return null;
+		}
+	}
+
 	@Override
 	public boolean equals(Object o) {
 		if (o == null || ! (o instanceof Pool)) {
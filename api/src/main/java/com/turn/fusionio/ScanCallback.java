@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+/**
+ * Receives the records read by a parallel scan of a FusionIO store.
+ *
+ * <p>
+ * Records are delivered one at a time on the thread that started the scan,
+ * while the store's pools are read in the background. The keys and values
+ * passed to the callback are slices of the scan's batch buffers and are only
+ * valid for the duration of the call; callers needing to keep them around
+ * must copy them.
+ * </p>
+ *
+ * @see Store#scan(Pool[], int, boolean, ScanCallback)
+ * @author mpetazzoni
+ */
+public interface ScanCallback {
+
+	/**
+	 * Handle a record read by the scan.
+	 *
+	 * @param pool The pool the record was read from.
+	 * @param key The record's key.
+	 * @param info The record's key/value information.
+	 * @param value The record's value, or <tt>null</tt> for keys-only scans.
+	 * @return Returns <tt>true</tt> to continue the scan, <tt>false</tt> to
+	 *	stop it.
+	 */
+	boolean record(Pool pool, Key key, KeyValueInfo info, Value value);
+}
@@ -0,0 +1,309 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.util.Iterator;
+import java.util.Map;
+import java.util.NoSuchElementException;
+
+/**
+ * A pool of a {@link ShardedStore}, made of one pool of the same tag on each
+ * of the store's devices.
+ *
+ * <p>
+ * Single key/value pair operations are routed to the pool of the device the
+ * key hashes to. Batch operations are split by device and executed on all
+ * devices in parallel, within a single native call. Iteration goes over the
+ * pools of each device in turn.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class ShardedPool implements Iterable<Map.Entry<Key, Value>> {
+
+	/*
+	 * Batch operations, matching the fio_kv_shard_op_t enum of the helper
+	 * library.
+	 */
+	private static final int SHARD_OP_GET = 0;
+	private static final int SHARD_OP_PUT = 1;
+	private static final int SHARD_OP_DELETE = 2;
+
+	public final ShardedStore store;
+	public final String tag;
+
+	private final Pool[] pools;
+	private final long[] handles;
+
+	ShardedPool(ShardedStore store, String tag, Pool[] pools) {
+		this.store = store;
+		this.tag = tag;
+		this.pools = pools;
+		this.handles = new long[pools.length];
+		for (int i=0; i<pools.length; i++) {
+			this.handles[i] = pools[i].handle();
+		}
+	}
+
+	/**
+	 * Return the pool of this sharded pool on the given device.
+	 *
+	 * @param shard The index of the device.
+	 * @return Returns the device's {@link Pool}.
+	 */
+	public Pool getPool(int shard) {
+		return this.pools[shard];
+	}
+
+	/**
+	 * Return the index of the device the given key lives on.
+	 *
+	 * @param key The key.
+	 * @return Returns the index of the key's device.
+	 */
+	public int shard(Key key) {
+		return FusionIOAPI.fio_kv_shard_of(this.store.handle(),
+			key.address(), key.size());
+	}
+
+	/**
+	 * Return the pool, on its device, the given key lives in.
+	 */
+	private Pool poolOf(Key key) {
+		return this.pools[this.shard(key)];
+	}
+
+	/**
+	 * Retrieve a value from the key/value store.
+	 *
+	 * @see Pool#get(Key)
+	 */
+	public Value get(Key key) throws FusionIOException {
+		return this.poolOf(key).get(key);
+	}
+
+	/**
+	 * Insert (or replace) a key/value pair into the key/value store.
+	 *
+	 * @see Pool#put(Key, Value)
+	 */
+	public void put(Key key, Value value) throws FusionIOException {
+		this.poolOf(key).put(key, value);
+	}
+
+	/**
+	 * Tells whether a given key exists in the key/value store.
+	 *
+	 * @see Pool#exists(Key)
+	 */
+	public boolean exists(Key key) throws FusionIOException {
+		return this.poolOf(key).exists(key);
+	}
+
+	/**
+	 * Remove a key/value pair.
+	 *
+	 * @see Pool#delete(Key)
+	 */
+	public void delete(Key key) throws FusionIOException {
+		this.poolOf(key).delete(key);
+	}
+
+	/**
+	 * Inserts a set of key/value pairs into the key/value store.
+	 *
+	 * <p>
+	 * The batch is split by device, and each device's share of the batch is
+	 * written to it in sub-batches of {@link Pool#FUSION_IO_MAX_BATCH_SIZE}
+	 * pairs, in parallel with the other devices. If one of the devices fails,
+	 * the pairs of the other devices are still written.
+	 * </p>
+	 *
+	 * @param keys The array of keys.
+	 * @param values An array of corresponding values.
+	 * @throws FusionIOException If an error occurred while writing this
+	 *	key/value pairs batch on one of the devices.
+	 */
+	public void put(Key[] keys, Value[] values) throws FusionIOException {
+		if (keys.length < 1 || keys.length != values.length) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		this.batch(SHARD_OP_PUT, keys, values, "writing");
+	}
+
+	/**
+	 * Reads a set of key/value pairs from the key/value store into the given
+	 * values.
+	 *
+	 * <p>
+	 * Each value must be allocated large enough to hold the value it's read
+	 * into, and all keys must exist. The batch is split by device and read
+	 * from all devices in parallel. Upon success, each value's size reflects
+	 * the number of bytes read.
+	 * </p>
+	 *
+	 * @param keys The array of keys to retrieve.
+	 * @param values An array of allocated values for the corresponding keys.
+	 * @throws FusionIOException If an error occurred while reading this
+	 *	key/value pairs batch from one of the devices.
+	 */
+	public void get(Key[] keys, Value[] values) throws FusionIOException {
+		if (keys.length < 1 || keys.length != values.length) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		this.batch(SHARD_OP_GET, keys, values, "reading");
+		for (Value value : values) {
+			value.prepare();
+		}
+	}
+
+	/**
+	 * Removes a set of key/value pairs from the key/value store.
+	 *
+	 * <p>
+	 * The batch is split by device and removed from all devices in
+	 * parallel.
+	 * </p>
+	 *
+	 * @param keys The array of keys of the pairs to remove.
+	 * @throws FusionIOException If an error occurred while removing this
+	 *	key/value pairs batch from one of the devices.
+	 */
+	public void delete(Key[] keys) throws FusionIOException {
+		if (keys.length < 1) {
+			throw new IllegalArgumentException("Invalid batch size!");
+		}
+
+		this.batch(SHARD_OP_DELETE, keys, null, "removing");
+	}
+
+	private void batch(int op, Key[] keys, Value[] values, String action)
+			throws FusionIOException {
+		int done = FusionIOAPI.fio_kv_shard_batch(this.store.handle(),
+			this.handles, op, keys, values);
+		if (done != keys.length) {
+			throw new FusionIOException(String.format(
+					"Error %s key/value pair batch (%d of %d pairs done)!",
+					action, Math.max(done, 0), keys.length),
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Retrieve an iterator on this sharded pool.
+	 *
+	 * @return Returns a new iterator that returns the key/value pairs of the
+	 *	pool on each device in turn.
+	 * @see Pool#iterator()
+	 */
+	@Override
+	public Iterator<Map.Entry<Key, Value>> iterator() {
+		return new ShardIterator<Map.Entry<Key, Value>>() {
+			@Override
+			protected Iterator<Map.Entry<Key, Value>> open(Pool pool) {
+				return pool.iterator();
+			}
+		};
+	}
+
+	/**
+	 * Retrieve an iterator on the keys of this sharded pool.
+	 *
+	 * @return Returns a new iterator that returns the keys of the pool on
+	 *	each device in turn, along with their {@link KeyValueInfo}.
+	 * @see Pool#keyIterator()
+	 */
+	public Iterator<Map.Entry<Key, KeyValueInfo>> keyIterator() {
+		return new ShardIterator<Map.Entry<Key, KeyValueInfo>>() {
+			@Override
+			protected Iterator<Map.Entry<Key, KeyValueInfo>> open(Pool pool) {
+				return pool.keyIterator();
+			}
+		};
+	}
+
+	/**
+	 * An iterator chaining the iterators of the pools of each device, each
+	 * one being only opened once the previous one is exhausted.
+	 */
+	private abstract class ShardIterator<T> implements Iterator<T> {
+
+		private int shard = 0;
+		private Iterator<T> current = null;
+
+		protected abstract Iterator<T> open(Pool pool);
+
+		@Override
+		public boolean hasNext() {
+			while (this.current == null || !this.current.hasNext()) {
+				if (this.shard >= pools.length) {
+					return false;
+				}
+
+				this.current = this.open(pools[this.shard++]);
+			}
+
+			return true;
+		}
+
+		@Override
+		public T next() {
+			if (!this.hasNext()) {
+				throw new NoSuchElementException();
+			}
+
+			return this.current.next();
+		}
+
+		@Override
+		public void remove() {
+			throw new UnsupportedOperationException();
+		}
+	}
+
+	@Override
+	public boolean equals(Object o) {
+		if (o == null || ! (o instanceof ShardedPool)) {
+			return false;
+		}
+
+		ShardedPool other = (ShardedPool) o;
+		return this.store == other.store && this.tag.equals(other.tag);
+	}
+
+	@Override
+	public String toString() {
+		return String.format("fusionio-sharded-pool(%s:%s)",
+			this.store, this.tag);
+	}
+}
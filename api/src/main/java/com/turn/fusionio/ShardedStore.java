@@ -0,0 +1,311 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import com.turn.fusionio.FusionIOAPI.ExpiryMode;
+
+import java.io.Closeable;
+import java.util.ArrayList;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Set;
+
+/**
+ * A key/value store spread over several FusionIO devices or directFS files.
+ *
+ * <p>
+ * A sharded store is made of one {@link Store} per device. Keys are assigned
+ * to the devices by consistent hashing, computed on the native side, so that
+ * growing a store by one device only moves a fraction of its keys. Pools are
+ * unified across devices: a {@link ShardedPool} is made of one pool of the
+ * same tag on each device.
+ * </p>
+ *
+ * <p>
+ * Batch operations are split by device and executed on all devices in
+ * parallel by native dispatch threads, one per device.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class ShardedStore implements Closeable {
+
+	/** The maximum number of devices of a sharded store. */
+	public static final int FUSION_IO_MAX_SHARDS = 16;
+
+	private final Store[] stores;
+
+	/** The native sharding state, a pointer to a fio_kv_shard_t. */
+	private long handle;
+
+	private volatile boolean opened;
+
+	/**
+	 * Instantiate a new sharded store.
+	 *
+	 * <p>
+	 * The order of the paths matters and must be kept across uses of the
+	 * store: it defines the position of each device on the hashing ring.
+	 * New devices must be added at the end.
+	 * </p>
+	 *
+	 * @param paths The FusionIO device files or directFS file paths.
+	 * @param version The user-defined FusionIO store version.
+	 * @param expiryMode The key/value pair expiration policy.
+	 * @param expiryTime Only used for {@link ExpiryMode.GLOBAL_EXPIRY},
+	 *	defines the key/value pair TTL in seconds after insertion.
+	 */
+	ShardedStore(String[] paths, int version, ExpiryMode expiryMode,
+			int expiryTime) {
+		if (paths.length < 1 || paths.length > FUSION_IO_MAX_SHARDS) {
+			throw new IllegalArgumentException("Invalid number of shards!");
+		}
+
+		this.stores = new Store[paths.length];
+		for (int i=0; i<paths.length; i++) {
+			this.stores[i] = new Store(paths[i], version, expiryMode,
+				expiryTime);
+		}
+
+		this.handle = 0;
+		this.opened = false;
+	}
+
+	/**
+	 * Return the number of devices this store is spread over.
+	 */
+	public int getShardCount() {
+		return this.stores.length;
+	}
+
+	/**
+	 * Return the store of one of the devices of this sharded store.
+	 *
+	 * <p>
+	 * The per-device stores can be configured (read cache, group commit,
+	 * etc.) before the sharded store is opened.
+	 * </p>
+	 *
+	 * @param shard The index of the device.
+	 * @return Returns the device's {@link Store}.
+	 */
+	public Store getStore(int shard) {
+		return this.stores[shard];
+	}
+
+	/**
+	 * Open all the devices of this sharded store.
+	 *
+	 * @throws FusionIOException If one of the devices cannot be opened; the
+	 *	devices already opened are closed again.
+	 */
+	public synchronized void open() throws FusionIOException {
+		if (this.opened) {
+			return;
+		}
+
+		int opened = 0;
+		try {
+			for (; opened<this.stores.length; opened++) {
+				this.stores[opened].open();
+			}
+
+			this.handle = FusionIOAPI.fio_kv_shard_create(this.stores.length);
+			if (this.handle == 0) {
+				throw new FusionIOException(
+					"Could not start the shard dispatch threads!",
+					FusionIOAPI.fio_kv_get_last_error());
+			}
+		} catch (FusionIOException fioe) {
+			for (int i=0; i<opened; i++) {
+				this.stores[i].close();
+			}
+			throw fioe;
+		}
+
+		this.opened = true;
+	}
+
+	/**
+	 * Tells whether this sharded store is opened or not.
+	 */
+	public boolean isOpened() {
+		return this.opened;
+	}
+
+	/**
+	 * Close all the devices of this sharded store.
+	 *
+	 * <p>
+	 * If the store is already closed, this method does nothing.
+	 * </p>
+	 */
+	@Override
+	public synchronized void close() throws FusionIOException {
+		if (!this.opened) {
+			return;
+		}
+
+		this.opened = false;
+		FusionIOAPI.fio_kv_shard_destroy(this.handle);
+		this.handle = 0;
+
+		for (Store store : this.stores) {
+			store.close();
+		}
+	}
+
+	/**
+	 * Return the native sharding state of this store.
+	 */
+	long handle() {
+		if (!this.opened) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		return this.handle;
+	}
+
+	/**
+	 * Get an existing sharded pool by its tag name or create a new one.
+	 *
+	 * <p>
+	 * The pool of the given tag is resolved, or created, on each device.
+	 * </p>
+	 *
+	 * @param tag The pool tag.
+	 * @return Returns the {@link ShardedPool} object that gives access to the
+	 *	requested pool.
+	 * @throws FusionIOException If the pool could not be created on one of
+	 *	the devices.
+	 */
+	public ShardedPool getOrCreatePool(String tag) throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		Pool[] pools = new Pool[this.stores.length];
+		for (int i=0; i<this.stores.length; i++) {
+			pools[i] = this.stores[i].getOrCreatePool(tag);
+		}
+
+		return new ShardedPool(this, tag, pools);
+	}
+
+	/**
+	 * Return an array of all the pools of this sharded store.
+	 *
+	 * <p>
+	 * Each tag found on any of the devices is returned once. A pool missing
+	 * from some of the devices, like after a device was added to the store,
+	 * is created on them.
+	 * </p>
+	 *
+	 * @throws FusionIOException If the pools of one of the devices could not
+	 *	be listed or created.
+	 */
+	public ShardedPool[] getAllPools() throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		Set<String> tags = new LinkedHashSet<String>();
+		for (Store store : this.stores) {
+			for (Pool pool : store.getAllPools()) {
+				if (pool.tag != null) {
+					tags.add(pool.tag);
+				}
+			}
+		}
+
+		List<ShardedPool> pools = new ArrayList<ShardedPool>(tags.size());
+		for (String tag : tags) {
+			pools.add(this.getOrCreatePool(tag));
+		}
+
+		return pools.toArray(new ShardedPool[pools.size()]);
+	}
+
+	/**
+	 * Delete a sharded pool from all the devices of this store.
+	 *
+	 * <p>
+	 * As with {@link Store#deletePool(Pool)}, this is an asynchronous
+	 * operation.
+	 * </p>
+	 *
+	 * @throws FusionIOException If the pool could not be deleted from one of
+	 *	the devices.
+	 */
+	public void deletePool(ShardedPool pool) throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		for (int i=0; i<this.stores.length; i++) {
+			this.stores[i].deletePool(pool.getPool(i));
+		}
+	}
+
+	/**
+	 * Delete all user-created pools from all the devices of this store.
+	 *
+	 * @throws FusionIOException If the operation failed on one of the
+	 *	devices.
+	 */
+	public void deleteAllPools() throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		for (Store store : this.stores) {
+			store.deleteAllPools();
+		}
+	}
+
+	@Override
+	protected void finalize() throws Throwable {
+		if (this.handle != 0) {
+			FusionIOAPI.fio_kv_shard_destroy(this.handle);
+			this.handle = 0;
+		}
+		super.finalize();
+	}
+
+	@Override
+	public String toString() {
+		StringBuilder sb = new StringBuilder("fusionio-sharded-store(");
+		for (int i=0; i<this.stores.length; i++) {
+			sb.append(i > 0 ? "," : "").append(this.stores[i].path);
+		}
+		return sb.append(")").toString();
+	}
+}
@@ -33,6 +33,8 @@ package com.turn.fusionio;
 import com.turn.fusionio.FusionIOAPI.ExpiryMode;
 
 import java.io.Closeable;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 
 /**
  * Represents a FusionIO-based key/value store.
@@ -48,6 +50,34 @@ public class Store implements Closeable {
 
 	public static final int FUSION_IO_MAX_POOLS = 1048576;
 
+	/**
+	 * I/O classes of the operations of a store, by decreasing priority.
+	 *
+	 * <p>
+	 * This enum matches the fio_kv_sched_class_t enum from the helper
+	 * library.
+	 * </p>
+	 *
+	 * @see Store#configureIOClass(IOClass, int, int, int)
+	 */
+	public enum IOClass {
+		/** Single and batch gets and existence checks. */
+		FOREGROUND_READ,
+
+		/**
+		 * Single puts and removals, conditional and read-modify-write
+		 * operations, and batch puts and removals of up to {@link
+		 * Pool#FUSION_IO_MAX_BATCH_SIZE} pairs.
+		 */
+		FOREGROUND_WRITE,
+
+		/**
+		 * Iterations and scans, larger batch puts and removals, and pool
+		 * deletions.
+		 */
+		BACKGROUND;
+	}
+
 	/** The path to the FusionIO device or directFS file. */
 	public final String path;
 
@@ -57,12 +87,33 @@ public class Store implements Closeable {
 	/** The KV store ID as understood by FusionIO's API. */
 	public final long kv;
 
+	/**
+	 * The native store handle, a pointer to a long-lived
+	 * <tt>fio_kv_store_t</tt> structure allocated the first time the store is
+	 * opened. Set from the native side.
+	 */
+	private long handle;
+
 	private final int version;
 	private final ExpiryMode expiryMode;
 	private final int expiryTime;
 
 	private volatile boolean opened;
 
+	private long cacheSize;
+
+	private int groupMaxPairs;
+	private int groupDelay;
+
+	private final int[][] ioSchedule;
+
+	private String hotKeysPath;
+	private int hotKeysMax;
+
+	private int asyncThreads;
+	private int asyncMaxInFlight;
+	private AsyncEngine async;
+
 	/**
 	 * Instantiate a new FusionIO Store object.
 	 *
@@ -88,8 +139,23 @@ public class Store implements Closeable {
 
 		this.fd = 0;
 		this.kv = 0;
+		this.handle = 0;
 
 		this.opened = false;
+
+		this.cacheSize = 0;
+
+		this.groupMaxPairs = 0;
+		this.groupDelay = 0;
+
+		this.ioSchedule = new int[IOClass.values().length][];
+
+		this.hotKeysPath = null;
+		this.hotKeysMax = 0;
+
+		this.asyncThreads = AsyncEngine.DEFAULT_THREADS;
+		this.asyncMaxInFlight = AsyncEngine.DEFAULT_MAX_IN_FLIGHT;
+		this.async = null;
 	}
 
 	/**
@@ -104,12 +170,43 @@ public class Store implements Closeable {
 
 		synchronized (this) {
 			if (!FusionIOAPI.fio_kv_open(this, this.version, this.expiryMode,
-					this.expiryTime)) {
+					this.expiryTime, this.cacheSize)) {
 				throw new FusionIOException(
 					"Could not open file or device for key/value API access!",
 					FusionIOAPI.fio_kv_get_last_error());
 			}
 
+			if (this.groupMaxPairs > 0 &&
+				!FusionIOAPI.fio_kv_set_group_commit(this.handle,
+					this.groupMaxPairs, this.groupDelay)) {
+				int error = FusionIOAPI.fio_kv_get_last_error();
+				FusionIOAPI.fio_kv_close(this);
+				throw new FusionIOException(
+					"Could not enable group commit!", error);
+			}
+
+			for (IOClass ioClass : IOClass.values()) {
+				int[] schedule = this.ioSchedule[ioClass.ordinal()];
+				if (schedule != null &&
+					!FusionIOAPI.fio_kv_set_sched(this.handle,
+						ioClass.ordinal(), schedule[0], schedule[1],
+						schedule[2])) {
+					int error = FusionIOAPI.fio_kv_get_last_error();
+					FusionIOAPI.fio_kv_close(this);
+					throw new FusionIOException(
+						"Could not configure I/O scheduling!", error);
+				}
+			}
+
+			if (this.hotKeysPath != null &&
+				!FusionIOAPI.fio_kv_set_hot_keys(this.handle,
+					this.hotKeysPath, this.hotKeysMax)) {
+				int error = FusionIOAPI.fio_kv_get_last_error();
+				FusionIOAPI.fio_kv_close(this);
+				throw new FusionIOException(
+					"Could not enable the hot key manifest!", error);
+			}
+
 			this.opened = true;
 		}
 	}
@@ -132,6 +229,11 @@ public class Store implements Closeable {
 	 */
 	@Override
 	public synchronized void close() throws FusionIOException {
+		if (this.async != null) {
+			this.async.shutdown();
+			this.async = null;
+		}
+
 		if (this.opened) {
 			FusionIOAPI.fio_kv_close(this);
 		}
@@ -139,6 +241,293 @@ public class Store implements Closeable {
 		this.opened = false;
 	}
 
+	/**
+	 * Configure the in-process read cache of this store.
+	 *
+	 * <p>
+	 * The read cache keeps recently read key/value pairs in native memory, so
+	 * that reads of hot keys are served without a device I/O. Writes and
+	 * removals made through this API keep it coherent, and cached pairs are
+	 * dropped when they expire. The cache is disabled by default; this must
+	 * be called before the store is opened to take effect.
+	 * </p>
+	 *
+	 * <p>
+	 * The read cache is not available in {@link ExpiryMode#GLOBAL_EXPIRY}
+	 * mode, where the expiration time of key/value pairs is not known.
+	 * </p>
+	 *
+	 * @param bytes The cache's memory budget, in bytes, or 0 to disable it.
+	 */
+	public synchronized void configureCache(long bytes) {
+		if (this.opened) {
+			throw new IllegalStateException(
+				"Key/value store is already opened!");
+		}
+
+		if (bytes < 0 ||
+			(bytes > 0 && this.expiryMode == ExpiryMode.GLOBAL_EXPIRY)) {
+			throw new IllegalArgumentException(
+				"Invalid read cache configuration!");
+		}
+
+		this.cacheSize = bytes;
+	}
+
+	/**
+	 * Configure the group commit of single puts on this store.
+	 *
+	 * <p>
+	 * With group commit, concurrent single puts to the same pool are queued
+	 * natively and written together as one batch, once <em>maxPairs</em>
+	 * pairs are queued or <em>delayMicros</em> microseconds after the first
+	 * one was. Each put still only returns once its batch is written. This
+	 * trades some latency on lone puts for fewer device writes under
+	 * concurrent load. Group commit is disabled by default; this must be
+	 * called before the store is opened to take effect.
+	 * </p>
+	 *
+	 * @param maxPairs The number of queued pairs that triggers a batch
+	 *	write, between 2 and {@link Pool#FUSION_IO_MAX_BATCH_SIZE}, or 0 to
+	 *	disable group commit.
+	 * @param delayMicros The longest time, in microseconds, a put waits
+	 *	for other puts to join its batch.
+	 */
+	public synchronized void configureGroupCommit(int maxPairs,
+			int delayMicros) {
+		if (this.opened) {
+			throw new IllegalStateException(
+				"Key/value store is already opened!");
+		}
+
+		if ((maxPairs != 0 &&
+				(maxPairs < 2 || maxPairs > Pool.FUSION_IO_MAX_BATCH_SIZE)) ||
+			delayMicros < 0) {
+			throw new IllegalArgumentException(
+				"Invalid group commit configuration!");
+		}
+
+		this.groupMaxPairs = maxPairs;
+		this.groupDelay = delayMicros;
+	}
+
+	/**
+	 * Configure the scheduling of an I/O class on this store.
+	 *
+	 * <p>
+	 * Operations of the class are limited to <em>rate</em> operations per
+	 * second, with bursts of up to <em>burst</em> operations, a batch
+	 * counting for as many operations as it has pairs. And while operations
+	 * of a class of higher priority are in flight, they wait for them to
+	 * complete, for up to <em>maxDeferMicros</em> microseconds, before
+	 * going to the device. Deferring {@link IOClass#BACKGROUND} work lets
+	 * scans and bulk loads use the device's idle time without adding to
+	 * the latency of concurrent point reads and writes. Operations are not
+	 * scheduled by default; this must be called before the store is opened
+	 * to take effect.
+	 * </p>
+	 *
+	 * @param ioClass The I/O class to configure.
+	 * @param rate The maximum rate of the class, in operations per second,
+	 *	or 0 for no limit.
+	 * @param burst The number of operations that can be issued at once
+	 *	above the rate, at least 1 if the rate is limited.
+	 * @param maxDeferMicros The longest time, in microseconds, an
+	 *	operation of the class yields to operations of higher priority, or 0
+	 *	to never yield.
+	 */
+	public synchronized void configureIOClass(IOClass ioClass, int rate,
+			int burst, int maxDeferMicros) {
+		if (this.opened) {
+			throw new IllegalStateException(
+				"Key/value store is already opened!");
+		}
+
+		if (ioClass == null || rate < 0 || burst < 0 ||
+			(rate > 0 && burst == 0) || maxDeferMicros < 0) {
+			throw new IllegalArgumentException(
+				"Invalid I/O class configuration!");
+		}
+
+		this.ioSchedule[ioClass.ordinal()] =
+			new int[] { rate, burst, maxDeferMicros };
+	}
+
+	/**
+	 * Configure the hot key manifest of this store's read cache.
+	 *
+	 * <p>
+	 * When the store is closed, the keys held by its read cache, most
+	 * recently read first, are saved to the manifest file. Once it is opened
+	 * again, {@link #prefetchHotKeys()} prefetches the keys of the manifest
+	 * into the read cache, so that the cache is warm within seconds instead
+	 * of refilling from client reads. Only keys are saved: values are always
+	 * read from the device.
+	 * </p>
+	 *
+	 * <p>
+	 * The manifest is disabled by default; this must be called before the
+	 * store is opened to take effect, and requires a read cache.
+	 * </p>
+	 *
+	 * @param path The path of the manifest file, or <em>null</em> to
+	 *	disable it.
+	 * @param maxKeys The maximum number of keys saved to the manifest.
+	 * @see #configureCache(long)
+	 * @see #prefetchHotKeys()
+	 */
+	public synchronized void configureHotKeys(String path, int maxKeys) {
+		if (this.opened) {
+			throw new IllegalStateException(
+				"Key/value store is already opened!");
+		}
+
+		if (path != null && (maxKeys <= 0 || this.cacheSize == 0)) {
+			throw new IllegalArgumentException(
+				"Invalid hot key manifest configuration!");
+		}
+
+		this.hotKeysPath = path;
+		this.hotKeysMax = maxKeys;
+	}
+
+	/**
+	 * Start prefetching the keys of this store's hot key manifest into its
+	 * read cache.
+	 *
+	 * <p>
+	 * The keys saved to the manifest when the store was last closed are read
+	 * back by a native thread, with batch reads scheduled as {@link
+	 * IOClass#BACKGROUND} work. Keys of compressed or packed pools are only
+	 * prefetched if their pool is configured as it was when the manifest was
+	 * saved, so this should be called once the pools of the store are
+	 * configured with {@link Pool#setCompression(boolean)} and {@link
+	 * Pool#setPacking(int)}. It does nothing if no manifest was saved yet.
+	 * </p>
+	 *
+	 * @throws FusionIOException If the prefetch could not be started, or
+	 *	was already started.
+	 * @see #configureHotKeys(String, int)
+	 */
+	public synchronized void prefetchHotKeys() throws FusionIOException {
+		if (!this.opened || this.hotKeysPath == null) {
+			throw new IllegalStateException(
+				"Key/value store has no hot key manifest!");
+		}
+
+		if (!FusionIOAPI.fio_kv_prefetch_hot_keys(this.handle)) {
+			throw new FusionIOException(
+				"Could not prefetch the hot key manifest!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+	}
+
+	/**
+	 * Returns a snapshot of the statistics of this store's read cache.
+	 *
+	 * @return Returns a {@link CacheStats} snapshot, or <em>null</em> if the
+	 *	store has no read cache.
+	 * @see #configureCache(long)
+	 */
+	public CacheStats getCacheStats() {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		return FusionIOAPI.fio_kv_get_cache_stats(this.handle);
+	}
+
+	/**
+	 * Returns a snapshot of the operation statistics of this store.
+	 *
+	 * <p>
+	 * Statistics are kept natively for all operations on this store's pools,
+	 * from the time it was opened, and give their latency distribution,
+	 * error and byte counts, and the JNI overhead of their calls.
+	 * </p>
+	 *
+	 * @return Returns a {@link StoreStats} snapshot.
+	 * @throws FusionIOException If the snapshot could not be taken.
+	 */
+	public StoreStats getStats() throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		StoreStats stats = FusionIOAPI.fio_kv_get_stats(this.handle);
+		if (stats == null) {
+			throw new FusionIOException("Error while gathering store statistics!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		return stats;
+	}
+
+	/**
+	 * Configure the asynchronous I/O engine used by the asynchronous
+	 * operations of this store's pools.
+	 *
+	 * <p>
+	 * The engine is started on the first asynchronous operation; this must be
+	 * called before then. By default, {@link AsyncEngine#DEFAULT_THREADS}
+	 * native worker threads execute up to {@link
+	 * AsyncEngine#DEFAULT_MAX_IN_FLIGHT} operations at a time.
+	 * </p>
+	 *
+	 * @param threads The number of native worker threads.
+	 * @param maxInFlight The maximum number of operations in flight.
+	 *	Submitting more operations blocks until some complete.
+	 */
+	public synchronized void configureAsync(int threads, int maxInFlight) {
+		if (this.async != null) {
+			throw new IllegalStateException(
+				"Asynchronous I/O engine is already started!");
+		}
+
+		if (threads <= 0 || maxInFlight <= 0) {
+			throw new IllegalArgumentException(
+				"Invalid asynchronous engine configuration!");
+		}
+
+		this.asyncThreads = threads;
+		this.asyncMaxInFlight = maxInFlight;
+	}
+
+	/**
+	 * Return this store's asynchronous I/O engine, starting it if needed.
+	 */
+	synchronized AsyncEngine async() throws FusionIOException {
+		if (!this.opened) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (this.async == null) {
+			this.async = new AsyncEngine(this.asyncThreads,
+				this.asyncMaxInFlight);
+		}
+
+		return this.async;
+	}
+
+	/**
+	 * Return the native store handle.
+	 *
+	 * @return The address of this store's native <tt>fio_kv_store_t</tt>
+	 *	structure, or 0 if the store was never opened.
+	 */
+	long handle() {
+		return this.handle;
+	}
+
+	@Override
+	protected void finalize() throws Throwable {
+		if (this.handle != 0) {
+			FusionIOAPI.fio_kv_release_store_handle(this.handle);
+			this.handle = 0;
+		}
+		super.finalize();
+	}
+
 	/**
 	 * Removes all key/value pairs from all pools, including the default pool.
 	 *
@@ -180,7 +569,8 @@ public class Store implements Closeable {
 	 *
 	 * <p>
 	 * If a pool with the given tag name already exists no new pool is created
-	 * and the existing one will returned instead.
+	 * and the existing one will returned instead. Pools known to the store's
+	 * native pool registry are resolved without any device I/O.
 	 * </p>
 	 *
 	 * @param tag The pool tag.
@@ -231,6 +621,14 @@ public class Store implements Closeable {
 	/**
 	 * Return an array of all pools in this key/value store.
 	 *
+	 * <p>
+	 * Pools are listed, in increasing ID order, from the store's native pool
+	 * registry without any device I/O. The registry is loaded from the device
+	 * when the store is opened and follows the pools created and deleted
+	 * through this store; pools created by other processes after that are
+	 * not listed.
+	 * </p>
+	 *
 	 * @throws FusionIOException
 	 */
 	public Pool[] getAllPools() throws FusionIOException {
@@ -247,6 +645,105 @@ public class Store implements Closeable {
 		return pools;
 	}
 
+	/**
+	 * Scan all the pools of this key/value store in parallel.
+	 *
+	 * @param threads The number of pools scanned concurrently.
+	 * @param keysOnly Whether to only read keys and their metadata.
+	 * @param callback The callback receiving the records.
+	 * @throws FusionIOException If the scan could not be started.
+	 * @see #scan(Pool[], int, boolean, ScanCallback)
+	 */
+	public void scan(int threads, boolean keysOnly, ScanCallback callback)
+			throws FusionIOException {
+		this.scan(this.getAllPools(), threads, keysOnly, callback);
+	}
+
+	/**
+	 * Scan the given pools in parallel.
+	 *
+	 * <p>
+	 * Native worker threads each iterate over one pool at a time, reading
+	 * records in batches, while the calling thread hands the records over to
+	 * the given callback. Records from different pools are interleaved, but
+	 * the records of one pool are delivered in iteration order. The scan
+	 * returns once all pools have been read, or as soon as the callback asks
+	 * for it to stop.
+	 * </p>
+	 *
+	 * <p>
+	 * Within a pool, iteration is sequential: directKV iterators cannot be
+	 * split, so the parallelism of a scan is bounded by the number of pools.
+	 * </p>
+	 *
+	 * @param pools The pools to scan.
+	 * @param threads The number of pools scanned concurrently.
+	 * @param keysOnly Whether to only read keys and their metadata.
+	 * @param callback The callback receiving the records.
+	 * @throws FusionIOException If the scan could not be started.
+	 */
+	public void scan(Pool[] pools, int threads, boolean keysOnly,
+			ScanCallback callback) throws FusionIOException {
+		if (!this.isOpened()) {
+			throw new IllegalStateException("Key/value store is not opened!");
+		}
+
+		if (threads <= 0 || callback == null) {
+			throw new IllegalArgumentException("Invalid scan configuration!");
+		}
+
+		long[] handles = new long[pools.length];
+		for (int i=0; i<pools.length; i++) {
+			handles[i] = pools[i].handle();
+		}
+
+		ByteBuffer[] buffers = new ByteBuffer[2 * threads];
+		long scan = FusionIOAPI.fio_kv_scan_create(handles, threads,
+			buffers.length,
+			keysOnly
+				? FusionIOKeyIterator.BATCH_BUFFER_SIZE
+				: FusionIOStoreIterator.BATCH_BUFFER_SIZE,
+			BatchIterator.BATCH_MAX_RECORDS, keysOnly);
+		if (scan == 0) {
+			throw new FusionIOException("Could not start scan of " +
+				pools.length + " pool(s)!",
+				FusionIOAPI.fio_kv_get_last_error());
+		}
+
+		try {
+			for (int i=0; i<buffers.length; i++) {
+				buffers[i] = FusionIOAPI.fio_kv_scan_buffer(scan, i)
+					.order(ByteOrder.nativeOrder());
+			}
+
+			int[] index = new int[1];
+			boolean more = true;
+			while (more) {
+				int buffer = FusionIOAPI.fio_kv_scan_reap(scan, index);
+				if (buffer < 0) {
+					break;
+				}
+
+				ByteBuffer data = buffers[buffer];
+				Pool pool = pools[index[0]];
+				int count = BatchIterator.count(data);
+				for (int i=0; i<count && more; i++) {
+					int offset = BatchIterator.offset(data, i);
+					KeyValueInfo info = BatchIterator.info(data, offset,
+						pool.id);
+					more = callback.record(pool,
+						BatchIterator.key(data, offset, info), info,
+						keysOnly ? null
+							: BatchIterator.value(data, offset, info));
+				}
+
+				FusionIOAPI.fio_kv_scan_release(scan, buffer);
+			}
+		} finally {
+			FusionIOAPI.fio_kv_scan_destroy(scan);
+		}
+	}
+
 	/**
 	 * Delete a pool from the key/value store.
 	 *
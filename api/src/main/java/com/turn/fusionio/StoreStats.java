@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.util.Arrays;
+
+/**
+ * Snapshot of the operation statistics of a {@link Store}.
+ *
+ * <p>
+ * The native helper library times and counts every read, write, lookup,
+ * removal and iteration step made on the store's pools, from all threads,
+ * since the store was opened. The counters are updated while the snapshot
+ * is taken, so they are not an atomic view of the store's activity.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+public class StoreStats {
+
+	/**
+	 * Operations instrumented by the statistics.
+	 *
+	 * <p>
+	 * This enum matches the fio_kv_stats_op_t enum from the helper library.
+	 * </p>
+	 */
+	public enum Operation {
+		GET,
+		PUT,
+		EXISTS,
+		DELETE,
+		GET_VALUE_LEN,
+		GET_KEY_INFO,
+		BATCH_GET,
+		BATCH_PUT,
+		ITERATE,
+		BATCH_DELETE,
+		BATCH_EXISTS;
+	};
+
+	/** The statistics of each operation, by ordinal. */
+	private final OperationStats[] operations;
+
+	/**
+	 * The number of failed operations by errno; errors with an errno beyond
+	 * the last slot are counted in it.
+	 */
+	private final long[] errors;
+
+	public StoreStats(OperationStats[] operations, long[] errors) {
+		this.operations = operations;
+		this.errors = errors;
+	}
+
+	/**
+	 * Returns the statistics of the given operation.
+	 */
+	public OperationStats get(Operation operation) {
+		return this.operations[operation.ordinal()];
+	}
+
+	/**
+	 * Returns the number of operations that failed with the given errno.
+	 *
+	 * <p>
+	 * Errors with large errno values are counted together, as the largest
+	 * one tracked.
+	 * </p>
+	 */
+	public long getErrorCount(int errno) {
+		if (errno <= 0) {
+			throw new IllegalArgumentException("Invalid errno!");
+		}
+
+		return this.errors[Math.min(errno, this.errors.length - 1)];
+	}
+
+	@Override
+	public String toString() {
+		StringBuilder sb = new StringBuilder("StoreStats(");
+		for (Operation operation : Operation.values()) {
+			OperationStats stats = this.get(operation);
+			if (stats.getCount() == 0) {
+				continue;
+			}
+
+			sb.append(operation).append('=').append(stats).append(", ");
+		}
+
+		return sb.append("errors=").append(Arrays.toString(this.errors))
+			.append(')').toString();
+	}
+}
@@ -49,7 +49,8 @@ public class Value {
 	 * Maximum value size supported by FusionIO.
 	 *
 	 * <p>
-	 * The maximum value size is 1MiB - 1KiB.
+	 * The maximum value size is 1MiB - 1KiB. Larger values can be stored
+	 * with {@link Pool#putLarge(Key, Value)}.
 	 * </p>
 	 */
 	public static final int FUSION_IO_MAX_VALUE_SIZE = 1024 * 1023;
@@ -57,6 +58,9 @@ public class Value {
 	/** A {@link ByteBuffer} holding the value's contents. */
 	private ByteBuffer data = null;
 
+	/** The native address of the value's sector-aligned data. */
+	private long address = 0;
+
 	/**
 	 * A reference to the {@link KeyValueInfo} structure holding
 	 * information about the key/value mapping to insert or that was just
@@ -64,6 +68,13 @@ public class Value {
 	 */
 	private KeyValueInfo info = null;
 
+	/**
+	 * Whether this value's data is borrowed from memory owned by someone
+	 * else, like an iterator's batch buffer, in which case it must not be
+	 * freed.
+	 */
+	private boolean borrowed = false;
+
 	/**
 	 * Empty private constructor.
 	 *
@@ -85,6 +96,34 @@ public class Value {
 		return this.data;
 	}
 
+	/**
+	 * Return the native address of this value's data.
+	 *
+	 * @return The address of the sector-aligned memory backing this value's
+	 *	{@link ByteBuffer}, for use with the handle-based native calls.
+	 */
+	long address() {
+		return this.address;
+	}
+
+	/**
+	 * Return the {@link KeyValueInfo} structure attached to this value.
+	 */
+	KeyValueInfo info() {
+		return this.info;
+	}
+
+	/**
+	 * Return the generation count of the key/value pair this value was read
+	 * from.
+	 *
+	 * @return The generation count, to use with {@link
+	 *	Pool#compareAndPut(Key, Value, int)}.
+	 */
+	public int getGenCount() {
+		return this.info.gen_count;
+	}
+
 	/**
 	 * Return the value's size, in bytes.
 	 *
@@ -111,11 +150,28 @@ public class Value {
 
 		this.data = FusionIOAPI.fio_kv_alloc(size)
 			.order(ByteOrder.nativeOrder());
+		this.address = FusionIOAPI.fio_kv_address(this.data);
 		this.info = new KeyValueInfo();
 		this.info.value_len = size;
 		return this;
 	}
 
+	/**
+	 * Prepare a value allocated and read on the native side for use.
+	 *
+	 * <p>
+	 * This sets the byte order of the value's byte buffer and restricts it to
+	 * the number of bytes read, as reported by the value_len field of its
+	 * info structure.
+	 * </p>
+	 *
+	 * @return Returns the {@link Value} object, for chaining.
+	 */
+	Value prepare() {
+		this.data.order(ByteOrder.nativeOrder());
+		return this.forceSize(this.info.value_len);
+	}
+
 	/**
 	 * Forces the value length to the given size.
 	 *
@@ -159,11 +215,20 @@ public class Value {
 	/**
 	 * Free the native memory used by this value's data.
 	 *
+	 * <p>
+	 * Values borrowing their data from another buffer, like the values
+	 * returned by iterators, simply drop their reference to it.
+	 * </p>
+	 *
 	 * @return Returns the {@link Value} object, for chaining.
 	 */
 	public Value free() {
-		FusionIOAPI.fio_kv_free_value(this);
+		if (!this.borrowed) {
+			FusionIOAPI.fio_kv_free_value(this);
+		}
+		this.borrowed = false;
 		this.data = null;
+		this.address = 0;
 		this.info = null;
 		return this;
 	}
@@ -193,4 +258,25 @@ public class Value {
 	public static Value get(int size) {
 		return new Value().allocate(size);
 	}
+
+	/**
+	 * Wrap a slice of a native buffer into a {@link Value}.
+	 *
+	 * <p>
+	 * The value borrows its data from the buffer, which remains owned by the
+	 * caller: it is only valid as long as the buffer is, and freeing the value
+	 * does not release any memory.
+	 * </p>
+	 *
+	 * @param data A direct {@link ByteBuffer} slice holding the value's data.
+	 * @param info The info structure of the key/value mapping.
+	 */
+	static Value wrap(ByteBuffer data, KeyValueInfo info) {
+		Value value = new Value();
+		value.data = data.order(ByteOrder.nativeOrder());
+		value.address = FusionIOAPI.fio_kv_address(value.data);
+		value.info = info;
+		value.borrowed = true;
+		return value;
+	}
 }
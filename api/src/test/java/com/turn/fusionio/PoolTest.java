@@ -32,9 +32,17 @@ package com.turn.fusionio;
 
 import com.turn.fusionio.FusionIOAPI.ExpiryMode;
 
+import java.io.File;
+import java.io.IOException;
 import java.lang.reflect.Method;
 import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.BitSet;
+import java.util.Iterator;
+import java.util.List;
 import java.util.Map;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
 import java.util.concurrent.TimeUnit;
 
 import org.testng.Assert;
@@ -172,6 +180,79 @@ public class PoolTest {
 			: "Key/value mapping should have been removed";
 	}
 
+	public void testCompareAndPut() throws FusionIOException {
+		this.pool.put(TEST_KEYS[0], TEST_VALUES[0]);
+		Value readback = this.pool.get(TEST_KEYS[0]);
+		int genCount = readback.getGenCount();
+		readback.free();
+
+		assert this.pool.compareAndPut(TEST_KEYS[0], TEST_VALUES[1], genCount)
+			: "Pair with the expected generation count should be replaced";
+		assert !this.pool.compareAndPut(TEST_KEYS[0], TEST_VALUES[1], genCount)
+			: "Pair modified since it was read should not be replaced";
+		assert !this.pool.compareAndPut(TEST_KEYS[1], TEST_VALUES[1], 0)
+			: "Missing pair should not be replaced";
+	}
+
+	public void testPutIfAbsent() throws FusionIOException {
+		assert this.pool.putIfAbsent(TEST_KEYS[0], TEST_VALUES[0]);
+		assert !this.pool.putIfAbsent(TEST_KEYS[0], TEST_VALUES[1]);
+		Value readback = this.pool.get(TEST_KEYS[0]);
+		Assert.assertEquals(readback.getByteBuffer(),
+			TEST_VALUES[0].getByteBuffer());
+		readback.free();
+	}
+
+	public void testIncrement() throws Exception {
+		final int threads = 4;
+		final int increments = 250;
+		assert this.pool.increment(TEST_KEYS[0], 5) == 5;
+		assert this.pool.increment(TEST_KEYS[0], -2) == 3;
+
+		Thread[] workers = new Thread[threads];
+		for (int i=0; i<threads; i++) {
+			workers[i] = new Thread() {
+				@Override
+				public void run() {
+					try {
+						for (int j=0; j<increments; j++) {
+							pool.increment(TEST_KEYS[0], 1);
+						}
+					} catch (FusionIOException fioe) {
+						throw new RuntimeException(fioe);
+					}
+				}
+			};
+			workers[i].start();
+		}
+		for (Thread worker : workers) {
+			worker.join();
+		}
+
+		assert this.pool.increment(TEST_KEYS[0], 0) == 3 + threads * increments;
+	}
+
+	@Test(expectedExceptions=FusionIOException.class)
+	public void testIncrementNotACounter() throws FusionIOException {
+		this.pool.put(TEST_KEYS[0], TEST_VALUES[0]);
+		this.pool.increment(TEST_KEYS[0], 1);
+	}
+
+	public void testAppend() throws FusionIOException {
+		assert this.pool.append(TEST_KEYS[0], TEST_VALUES[0])
+			== TEST_DATA.length;
+		assert this.pool.append(TEST_KEYS[0], TEST_VALUES[1])
+			== 2 * TEST_DATA.length;
+
+		Value readback = this.pool.get(TEST_KEYS[0]);
+		assert readback.size() == 2 * TEST_DATA.length;
+		for (int i=0; i<readback.size(); i++) {
+			assert readback.getByteBuffer().get(i)
+				== TEST_DATA[i % TEST_DATA.length];
+		}
+		readback.free();
+	}
+
 	public void testBigValue() throws FusionIOException {
 		Value value = Value.get(BIG_VALUE_SIZE);
 		ByteBuffer data = value.getByteBuffer();
@@ -188,6 +269,88 @@ public class PoolTest {
 		readback.free();
 	}
 
+	public void testLargeValue() throws FusionIOException {
+		int size = 5 * Value.FUSION_IO_MAX_VALUE_SIZE + 123;
+		Value value = Value.get(size);
+		ByteBuffer data = value.getByteBuffer();
+		for (int i=0; data.remaining() > 0; i++) {
+			data.put((byte) (i % 251));
+		}
+		data.rewind();
+
+		this.pool.putLarge(TEST_KEYS[0], value);
+		Value readback = this.pool.getLarge(TEST_KEYS[0]);
+		Assert.assertEquals(readback.size(), size);
+		Assert.assertEquals(readback.getByteBuffer(), data);
+		readback.free();
+
+		// A smaller value replaces it, under the next generation, and the
+		// previous value's chunks are removed.
+		value.forceSize(TEST_DATA.length);
+		this.pool.putLarge(TEST_KEYS[0], value);
+		readback = this.pool.getLarge(TEST_KEYS[0]);
+		Assert.assertEquals(readback.size(), TEST_DATA.length);
+		readback.free();
+		value.free();
+
+		// The keys of the first chunk of both generations of the value.
+		ByteBuffer key = TEST_KEYS[0].getByteBuffer().duplicate();
+		key.rewind();
+		byte[] previous =
+			new byte[key.remaining() + Pool.FUSION_IO_LARGE_KEY_SUFFIX];
+		key.get(previous, 0, key.remaining());
+		previous[previous.length - Pool.FUSION_IO_LARGE_KEY_SUFFIX] = (byte) 0xff;
+		byte[] chunk = previous.clone();
+		chunk[chunk.length - 5] = 1;
+		assert !this.pool.exists(Key.createFrom(previous))
+			: "Chunks of the previous value should have been removed";
+		assert this.pool.exists(Key.createFrom(chunk));
+
+		this.pool.deleteLarge(TEST_KEYS[0]);
+		assert !this.pool.exists(TEST_KEYS[0]);
+		assert !this.pool.exists(Key.createFrom(chunk))
+			: "Chunks of the large value should have been removed";
+	}
+
+	@Test(expectedExceptions=FusionIOException.class)
+	public void testGetLargeNotLarge() throws FusionIOException {
+		this.pool.put(TEST_KEYS[0], TEST_VALUES[0]);
+		this.pool.getLarge(TEST_KEYS[0]);
+	}
+
+	public void testGrowingValues() throws FusionIOException {
+		// Read a small value first, then values exceeding the size of the
+		// previous one, to exercise the re-read path of Pool.get().
+		for (int size = TEST_DATA.length; size <= 4 * BIG_VALUE_SIZE; size *= 4) {
+			Value value = Value.get(size);
+			ByteBuffer data = value.getByteBuffer();
+			while (data.remaining() > 0) {
+				data.put((byte) 0x42);
+			}
+			data.rewind();
+
+			this.pool.put(TEST_KEYS[0], value);
+			Value readback = this.pool.get(TEST_KEYS[0]);
+			Assert.assertEquals(readback.size(), size);
+			Assert.assertEquals(readback.getByteBuffer(), data);
+			readback.free();
+			value.free();
+		}
+	}
+
+	public void testAllocatorStats() {
+		AllocatorStats before = FusionIOAPI.getAllocatorStats();
+		Value value = Value.get(BIG_VALUE_SIZE);
+		AllocatorStats during = FusionIOAPI.getAllocatorStats();
+		assert during.getUsedBytes() >= before.getUsedBytes() + BIG_VALUE_SIZE
+			: "Allocated value is not accounted for!";
+		assert during.getReservedBytes() >= during.getUsedBytes()
+			: "Allocator uses more memory than it reserved!";
+		value.free();
+		Assert.assertEquals(FusionIOAPI.getAllocatorStats().getUsedBytes(),
+			before.getUsedBytes());
+	}
+
 	public void testBatchPut() throws FusionIOException {
 		this.pool.put(TEST_KEYS, TEST_VALUES);
 
@@ -201,6 +364,508 @@ public class PoolTest {
 		}
 	}
 
+	public void testBatchGet() throws FusionIOException {
+		this.pool.put(TEST_KEYS, TEST_VALUES);
+
+		Value[] readback = this.pool.get(TEST_KEYS);
+		Assert.assertEquals(readback.length, BATCH_SIZE);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+		}
+	}
+
+	public void testBatchGetMissingKey() throws FusionIOException {
+		this.pool.put(TEST_KEYS, TEST_VALUES);
+		this.pool.delete(TEST_KEYS[BATCH_SIZE / 2]);
+
+		Value[] readback = this.pool.get(TEST_KEYS);
+		Assert.assertEquals(readback.length, BATCH_SIZE);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			if (i == BATCH_SIZE / 2) {
+				Assert.assertNull(readback[i], "Value #" + i + " was deleted!");
+				continue;
+			}
+
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+		}
+	}
+
+	public void testBatchGetMissingKeysInWindow() throws FusionIOException {
+		// Spans more than one native window, with missing keys in the
+		// middle of the first one and a larger value after them.
+		int count = 2 * BATCH_SIZE;
+		Key[] keys = new Key[count];
+		Value[] values = new Value[count];
+		for (int i=0; i<count; i++) {
+			keys[i] = Key.createFrom(0x3000000000L + i);
+			values[i] = Value.get(i == 9 ? 3 * 4096 : 512);
+			values[i].getByteBuffer().putInt(i);
+			values[i].getByteBuffer().rewind();
+		}
+		this.pool.put(keys, values);
+		this.pool.delete(keys[5]);
+		this.pool.delete(keys[7]);
+
+		Value[] readback = this.pool.get(keys);
+		Assert.assertEquals(readback.length, count);
+		for (int i=0; i<count; i++) {
+			if (i == 5 || i == 7) {
+				Assert.assertNull(readback[i], "Value #" + i + " was deleted!");
+			} else {
+				Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+				Assert.assertEquals(
+					readback[i].getByteBuffer(),
+					values[i].getByteBuffer(),
+					"Value #" + i + "'s data does not match!");
+				readback[i].free();
+			}
+			values[i].free();
+		}
+	}
+
+	public void testBatchGetLargeValues() throws FusionIOException {
+		Value[] values = new Value[BATCH_SIZE];
+		for (int i=0; i<BATCH_SIZE; i++) {
+			values[i] = Value.get(3 * 4096);
+			values[i].getByteBuffer().putInt(i);
+			values[i].getByteBuffer().rewind();
+		}
+		this.pool.put(TEST_KEYS, values);
+
+		Value[] readback = this.pool.get(TEST_KEYS);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				values[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+			values[i].free();
+		}
+	}
+
+	public void testBatchDelete() throws FusionIOException {
+		this.pool.put(TEST_KEYS, TEST_VALUES);
+
+		Key[] keys = new Key[BATCH_SIZE / 2];
+		for (int i=0; i<keys.length; i++) {
+			keys[i] = TEST_KEYS[2 * i];
+		}
+		this.pool.delete(keys);
+		// Deleting missing keys is not an error.
+		this.pool.delete(keys);
+
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Assert.assertEquals(this.pool.exists(TEST_KEYS[i]), i % 2 != 0,
+				"Unexpected state for key #" + i + "!");
+		}
+	}
+
+	public void testBatchExists() throws FusionIOException {
+		this.pool.put(TEST_KEYS, TEST_VALUES);
+		this.pool.delete(TEST_KEYS[1]);
+
+		Key[] keys = new Key[BATCH_SIZE + 1];
+		System.arraycopy(TEST_KEYS, 0, keys, 0, BATCH_SIZE);
+		keys[BATCH_SIZE] = Key.createFrom(-1L);
+
+		BitSet found = this.pool.exists(keys);
+		Assert.assertEquals(found.cardinality(), BATCH_SIZE - 1);
+		for (int i=0; i<keys.length; i++) {
+			Assert.assertEquals(found.get(i), i != 1 && i != BATCH_SIZE,
+				"Unexpected state for key #" + i + "!");
+		}
+	}
+
+	public void testLongKeys() throws FusionIOException {
+		long id = 0x1234567890L;
+		this.pool.deleteLong(id);
+		assert !this.pool.existsLong(id);
+
+		// Long keys are the keys of Key.createFrom(long).
+		this.pool.putLong(id, TEST_VALUES[0]);
+		assert this.pool.existsLong(id);
+		Value readback = this.pool.get(Key.createFrom(id));
+		Assert.assertEquals(readback.getByteBuffer(),
+			TEST_VALUES[0].getByteBuffer());
+		readback.free();
+
+		this.pool.put(Key.createFrom(id), TEST_VALUES[1]);
+		readback = this.pool.getLong(id);
+		Assert.assertEquals(readback.getByteBuffer(),
+			TEST_VALUES[1].getByteBuffer());
+		readback.free();
+
+		this.pool.deleteLong(id);
+		assert !this.pool.exists(Key.createFrom(id));
+	}
+
+	public void testLongKeyBatch() throws FusionIOException {
+		long[] ids = new long[BATCH_SIZE];
+		for (int i=0; i<BATCH_SIZE; i++) {
+			ids[i] = 0x2000000000L + i;
+		}
+		this.pool.deleteLong(ids);
+		this.pool.putLong(ids, TEST_VALUES);
+
+		Value[] readback = this.pool.getLong(ids);
+		Assert.assertEquals(readback.length, BATCH_SIZE);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+		}
+
+		this.pool.deleteLong(new long[] { ids[0], ids[2] });
+		BitSet found = this.pool.existsLong(ids);
+		Assert.assertEquals(found.cardinality(), BATCH_SIZE - 2);
+		assert !found.get(0) && found.get(1) && !found.get(2);
+
+		this.pool.deleteLong(ids);
+		Assert.assertEquals(this.pool.existsLong(ids).cardinality(), 0);
+	}
+
+	public void testLargeIteration() throws FusionIOException {
+		int size = 2500;
+		Key[] keys = new Key[size];
+		Value[] values = new Value[size];
+		for (int i=0; i<size; i++) {
+			keys[i] = Key.createFrom(i);
+			values[i] = TEST_VALUES[i % BATCH_SIZE];
+		}
+
+		this.pool.put(keys, values);
+
+		boolean[] seen = new boolean[size];
+		int count = 0;
+		Iterator<Map.Entry<Key, Value>> it = this.pool.iterator();
+		while (it.hasNext()) {
+			Assert.assertTrue(it.hasNext(), "hasNext() is not idempotent!");
+			Map.Entry<Key, Value> pair = it.next();
+			int i = (int)pair.getKey().longValue();
+			Assert.assertFalse(seen[i], "Key " + i + " returned twice!");
+			Assert.assertEquals(
+				pair.getValue().getByteBuffer(),
+				values[i].getByteBuffer(),
+				"Value data mismatch for key " + i + "!");
+			seen[i] = true;
+			count++;
+		}
+		Assert.assertEquals(count, size);
+
+		for (int i=0; i<size; i++) {
+			this.pool.delete(keys[i]);
+		}
+	}
+
+	public void testKeyIteration() throws FusionIOException {
+		this.pool.put(TEST_KEYS, TEST_VALUES);
+
+		int count = 0;
+		Iterator<Map.Entry<Key, KeyValueInfo>> it = this.pool.keyIterator();
+		while (it.hasNext()) {
+			Map.Entry<Key, KeyValueInfo> entry = it.next();
+			int i = (int)entry.getKey().longValue();
+			Assert.assertEquals(entry.getValue().key_len, 8);
+			Assert.assertEquals(entry.getValue().value_len,
+				TEST_VALUES[i].size(),
+				"Value length mismatch for key " + i + "!");
+			count++;
+		}
+		Assert.assertEquals(count, TEST_VALUES.length);
+	}
+
+	public void testPackedBatch() throws FusionIOException {
+		int size = 3 * Pool.FUSION_IO_MAX_BATCH_SIZE + 5;
+		PackedBatch batch = new PackedBatch(1024 * 1024, 64);
+		Key[] keys = new Key[size];
+		for (int i=0; i<size; i++) {
+			keys[i] = Key.createFrom(2000 + i);
+			assert batch.add(keys[i], TEST_VALUES[i % BATCH_SIZE].getByteBuffer());
+		}
+		Assert.assertEquals(batch.size(), size);
+
+		this.pool.put(batch);
+		batch.free();
+
+		Value[] readback = this.pool.get(keys);
+		for (int i=0; i<size; i++) {
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				TEST_VALUES[i % BATCH_SIZE].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+			this.pool.delete(keys[i]);
+		}
+	}
+
+	public void testLargeBatch() throws FusionIOException {
+		int size = 5 * Pool.FUSION_IO_MAX_BATCH_SIZE + 3;
+		Key[] keys = new Key[size];
+		Value[] values = new Value[size];
+		for (int i=0; i<size; i++) {
+			keys[i] = Key.createFrom(1000 + i);
+			values[i] = TEST_VALUES[i % BATCH_SIZE];
+		}
+
+		this.pool.put(keys, values);
+
+		Value[] readback = this.pool.get(keys);
+		Assert.assertEquals(readback.length, size);
+		for (int i=0; i<size; i++) {
+			Assert.assertNotNull(readback[i], "Value #" + i + " is missing!");
+			Assert.assertEquals(
+				readback[i].getByteBuffer(),
+				values[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback[i].free();
+			this.pool.delete(keys[i]);
+		}
+	}
+
+	public void testAsync() throws Exception {
+		List<Future<Void>> puts = new ArrayList<Future<Void>>();
+		for (int i=0; i<BATCH_SIZE; i++) {
+			puts.add(this.pool.putAsync(TEST_KEYS[i], TEST_VALUES[i]));
+		}
+		for (Future<Void> put : puts) {
+			put.get();
+		}
+
+		List<Future<Value>> gets = new ArrayList<Future<Value>>();
+		for (int i=0; i<BATCH_SIZE; i++) {
+			gets.add(this.pool.getAsync(TEST_KEYS[i]));
+		}
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Value readback = gets.get(i).get();
+			Assert.assertEquals(
+				readback.getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer(),
+				"Value #" + i + "'s data does not match!");
+			readback.free();
+		}
+	}
+
+	@Test(expectedExceptions=ExecutionException.class)
+	public void testAsyncMissingKey() throws Exception {
+		this.pool.getAsync(TEST_KEYS[0]).get();
+	}
+
+	public void testRing() throws FusionIOException {
+		final int[] results = new int[BATCH_SIZE];
+		final int[] count = new int[1];
+		IORing.CompletionHandler handler = new IORing.CompletionHandler() {
+			@Override
+			public void complete(long tag, int result, int error) {
+				assert error == 0 : "Operation #" + tag + " failed: " + error;
+				results[(int) tag] = result;
+				count[0]++;
+			}
+		};
+
+		IORing ring = new IORing(4, 2);
+		try {
+			for (int i=0; i<BATCH_SIZE; i++) {
+				while (!ring.put(this.pool, TEST_KEYS[i], TEST_VALUES[i], i)) {
+					ring.waitFor(handler, 1, TimeUnit.SECONDS);
+				}
+			}
+			while (count[0] < BATCH_SIZE) {
+				ring.waitFor(handler, 1, TimeUnit.SECONDS);
+			}
+			for (int i=0; i<BATCH_SIZE; i++) {
+				Assert.assertEquals(results[i], TEST_DATA.length);
+			}
+
+			count[0] = 0;
+			for (int i=0; i<BATCH_SIZE; i++) {
+				while (!ring.get(this.pool, TEST_KEYS[i], TEST_READBACK[i], i)) {
+					ring.waitFor(handler, 1, TimeUnit.SECONDS);
+				}
+			}
+			while (count[0] < BATCH_SIZE) {
+				ring.waitFor(handler, 1, TimeUnit.SECONDS);
+			}
+			for (int i=0; i<BATCH_SIZE; i++) {
+				Assert.assertEquals(results[i], TEST_DATA.length);
+				Assert.assertEquals(
+					TEST_READBACK[i].getByteBuffer(),
+					TEST_VALUES[i].getByteBuffer(),
+					"Value #" + i + "'s data does not match!");
+			}
+
+			count[0] = 0;
+			assert ring.delete(this.pool, TEST_KEYS[0], 0);
+			while (count[0] < 1) {
+				ring.waitFor(handler, 1, TimeUnit.SECONDS);
+			}
+			assert ring.exists(this.pool, TEST_KEYS[0], 0);
+			assert ring.exists(this.pool, TEST_KEYS[1], 1);
+			while (count[0] < 3) {
+				ring.waitFor(handler, 1, TimeUnit.SECONDS);
+			}
+			Assert.assertEquals(results[0], 0);
+			Assert.assertEquals(results[1], 1);
+		} finally {
+			ring.close();
+		}
+	}
+
+	public void testRingFull() throws FusionIOException {
+		IORing ring = new IORing(1, 1);
+		try {
+			assert ring.exists(this.pool, TEST_KEYS[0], 0);
+			assert !ring.exists(this.pool, TEST_KEYS[1], 1)
+				: "Ring should be full until its completion is reaped";
+
+			final int[] count = new int[1];
+			IORing.CompletionHandler handler = new IORing.CompletionHandler() {
+				@Override
+				public void complete(long tag, int result, int error) {
+					count[0]++;
+				}
+			};
+			while (count[0] == 0) {
+				ring.waitFor(handler, 1, TimeUnit.SECONDS);
+			}
+			assert ring.exists(this.pool, TEST_KEYS[1], 1);
+		} finally {
+			ring.close();
+		}
+	}
+
+	public void testFilter() throws FusionIOException, IOException {
+		Pool p = this.store.getOrCreatePool("filter");
+		p.put(TEST_KEYS[0], TEST_VALUES[0]);
+		p.buildFilter(1000);
+		assert p.exists(TEST_KEYS[0]) : "Existing key was filtered out";
+		assert !p.exists(TEST_KEYS[1]) : "Absent key was reported present";
+
+		p.put(TEST_KEYS[1], TEST_VALUES[1]);
+		assert p.exists(TEST_KEYS[1])
+			: "Key written after the filter was built was filtered out";
+
+		File file = File.createTempFile("fio_kv", ".filter");
+		file.deleteOnExit();
+		p.saveFilter(file.getPath());
+		assert file.length() > 0;
+	}
+
+	public void testEmptyPoolFilter() throws FusionIOException, IOException {
+		Pool p = this.store.getOrCreatePool("emptyfilter");
+		p.buildFilter(1000);
+		assert !p.exists(TEST_KEYS[0]) : "Absent key was reported present";
+
+		p.put(TEST_KEYS[0], TEST_VALUES[0]);
+		assert p.exists(TEST_KEYS[0])
+			: "Key written after the filter was built was filtered out";
+
+		// Only ready filters can be saved.
+		File file = File.createTempFile("fio_kv", ".filter");
+		file.deleteOnExit();
+		p.saveFilter(file.getPath());
+		assert file.length() > 0;
+	}
+
+	@Test(expectedExceptions=FusionIOException.class)
+	public void testLoadMissingFilter() throws FusionIOException {
+		this.store.getOrCreatePool("filter2")
+			.loadFilter("/nonexistent/fio_kv.filter");
+	}
+
+	public void testCompression() throws FusionIOException {
+		Pool p = this.store.getOrCreatePool("compressed");
+		p.setCompression(true);
+
+		Value value = Value.get(BIG_VALUE_SIZE);
+		ByteBuffer data = value.getByteBuffer();
+		while (data.remaining() > 0) {
+			data.put((byte) 0x42);
+		}
+		data.rewind();
+
+		p.put(TEST_KEYS[0], value);
+		assert p.getKeyValueInfo(TEST_KEYS[0]).value_len < BIG_VALUE_SIZE
+			: "Compressible value was stored uncompressed";
+		Value readback = p.get(TEST_KEYS[0]);
+		Assert.assertEquals(readback.size(), BIG_VALUE_SIZE);
+		Assert.assertEquals(readback.getByteBuffer(), data);
+		readback.free();
+		value.free();
+
+		// Values too small to save a sector are stored as is.
+		p.put(TEST_KEYS[1], TEST_VALUES[1]);
+		Assert.assertEquals(p.getKeyValueInfo(TEST_KEYS[1]).value_len,
+			TEST_DATA.length);
+		readback = p.get(TEST_KEYS[1]);
+		Assert.assertEquals(readback.getByteBuffer(),
+			TEST_VALUES[1].getByteBuffer());
+		readback.free();
+	}
+
+	public void testPacking() throws FusionIOException {
+		Pool p = this.store.getOrCreatePool("packed");
+		p.setPacking(16);
+
+		p.put(TEST_KEYS, TEST_VALUES);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Value readback = p.get(TEST_KEYS[i]);
+			Assert.assertEquals(readback.getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer());
+			readback.free();
+		}
+
+		p.delete(TEST_KEYS[0]);
+		assert !p.exists(TEST_KEYS[0]) : "Removed pair is still packed";
+		assert p.exists(TEST_KEYS[1]) : "Packed pair was lost";
+	}
+
+	@Test(expectedExceptions=FusionIOException.class)
+	public void testRepackingWithOtherBuckets() throws FusionIOException {
+		Pool p = this.store.getOrCreatePool("packed2");
+		p.setPacking(16);
+		p.setPacking(32);
+	}
+
+	public void testExportImport() throws FusionIOException, IOException {
+		Pool source = this.store.getOrCreatePool("export");
+		source.put(TEST_KEYS, TEST_VALUES);
+
+		File file = File.createTempFile("fio_kv", ".export");
+		file.deleteOnExit();
+		Assert.assertEquals(source.exportTo(file.getPath()), BATCH_SIZE);
+
+		Pool target = this.store.getOrCreatePool("import");
+		Assert.assertEquals(target.importFrom(file.getPath(), 4), BATCH_SIZE);
+		for (int i=0; i<BATCH_SIZE; i++) {
+			Value readback = target.get(TEST_KEYS[i]);
+			Assert.assertEquals(readback.getByteBuffer(),
+				TEST_VALUES[i].getByteBuffer());
+			readback.free();
+		}
+	}
+
+	@Test(expectedExceptions=FusionIOException.class)
+	public void testImportInvalidFile() throws FusionIOException, IOException {
+		File file = File.createTempFile("fio_kv", ".export");
+		file.deleteOnExit();
+		this.store.getOrCreatePool("import2").importFrom(file.getPath(), 1);
+	}
+
 	public void testIteration() throws FusionIOException {
 		this.pool.put(TEST_KEYS, TEST_VALUES);
 
@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import com.turn.fusionio.FusionIOAPI.ExpiryMode;
+
+import java.lang.reflect.Method;
+import java.util.Iterator;
+import java.util.Map;
+
+import org.testng.ITestResult;
+import org.testng.annotations.AfterMethod;
+import org.testng.annotations.BeforeMethod;
+import org.testng.annotations.Test;
+
+/**
+ * Tests for FusionIO stores sharded over several devices.
+ *
+ * @author mpetazzoni
+ */
+@Test
+public class ShardedStoreTest {
+
+	private static final String[] DEVICE_NAMES = {"/dev/fioa", "/dev/fiob"};
+	private static final int KEYS = 1000;
+	private static final int VALUE_SIZE = 16;
+
+	private ShardedStore store = null;
+
+	@BeforeMethod
+	public void setUp(Method m) throws FusionIOException, InterruptedException {
+		System.out.printf("%s.%s():\n", m.getDeclaringClass().getName(), m.getName());
+		this.store = FusionIOAPI.get(DEVICE_NAMES, 0,
+			StoreTest.TESTING_EXPIRY_MODE, StoreTest.TESTING_EXPIRY_SECONDS);
+		// Need to wait a bit for the device permissions to be set before
+		// opening it.
+		Thread.sleep(150);
+
+		this.store.open();
+		assert this.store.isOpened()
+			: "Sharded store was not opened as expected";
+		this.store.deleteAllPools();
+	}
+
+	@AfterMethod
+	public void tearDown(ITestResult tr) throws FusionIOException {
+		this.store.open();
+		this.store.deleteAllPools();
+		this.store.close();
+		System.out.printf("%s(): done (%d)\n", tr.getName(), tr.getStatus());
+	}
+
+	private Key[] keys() {
+		Key[] keys = new Key[KEYS];
+		for (int i=0; i<KEYS; i++) {
+			keys[i] = Key.createFrom(i);
+		}
+		return keys;
+	}
+
+	private Value[] values() {
+		Value[] values = new Value[KEYS];
+		for (int i=0; i<KEYS; i++) {
+			values[i] = Value.get(VALUE_SIZE);
+			values[i].getByteBuffer().putInt(0, i);
+		}
+		return values;
+	}
+
+	private void free(Value[] values) {
+		for (Value value : values) {
+			value.free();
+		}
+	}
+
+	public void testOpenClose() throws FusionIOException {
+		assert this.store.getShardCount() == DEVICE_NAMES.length;
+		for (int i=0; i<DEVICE_NAMES.length; i++) {
+			assert this.store.getStore(i).isOpened();
+		}
+
+		this.store.close();
+		assert !this.store.isOpened();
+		for (int i=0; i<DEVICE_NAMES.length; i++) {
+			assert !this.store.getStore(i).isOpened();
+		}
+	}
+
+	public void testShardSpread() throws FusionIOException {
+		ShardedPool pool = this.store.getOrCreatePool("spread");
+		int[] counts = new int[DEVICE_NAMES.length];
+		for (Key key : this.keys()) {
+			int shard = pool.shard(key);
+			assert shard == pool.shard(key);
+			counts[shard]++;
+		}
+
+		for (int count : counts) {
+			assert count > KEYS / (2 * DEVICE_NAMES.length) : count;
+		}
+	}
+
+	public void testSinglePutGet() throws FusionIOException {
+		ShardedPool pool = this.store.getOrCreatePool("single");
+		Key key = Key.createFrom(42);
+		Value value = Value.get(VALUE_SIZE);
+		value.getByteBuffer().putInt(0, 42);
+		pool.put(key, value);
+		value.free();
+
+		assert pool.exists(key);
+		assert pool.getPool(pool.shard(key)).exists(key);
+		assert !pool.getPool(1 - pool.shard(key)).exists(key);
+
+		value = pool.get(key);
+		assert value.getByteBuffer().getInt(0) == 42;
+		value.free();
+
+		pool.delete(key);
+		assert !pool.exists(key);
+	}
+
+	public void testBatchPutGet() throws FusionIOException {
+		ShardedPool pool = this.store.getOrCreatePool("batch");
+		Key[] keys = this.keys();
+		Value[] values = this.values();
+		pool.put(keys, values);
+		this.free(values);
+
+		for (Key key : keys) {
+			assert pool.getPool(pool.shard(key)).exists(key);
+		}
+
+		values = new Value[KEYS];
+		for (int i=0; i<KEYS; i++) {
+			values[i] = Value.get(VALUE_SIZE);
+		}
+		pool.get(keys, values);
+		for (int i=0; i<KEYS; i++) {
+			assert values[i].size() == VALUE_SIZE : values[i].size();
+			assert values[i].getByteBuffer().getInt(0) == i;
+		}
+		this.free(values);
+	}
+
+	public void testBatchDelete() throws FusionIOException {
+		ShardedPool pool = this.store.getOrCreatePool("delete");
+		Key[] keys = this.keys();
+		Value[] values = this.values();
+		pool.put(keys, values);
+		this.free(values);
+
+		pool.delete(keys);
+		for (Key key : keys) {
+			assert !pool.exists(key);
+		}
+	}
+
+	public void testIterator() throws FusionIOException {
+		ShardedPool pool = this.store.getOrCreatePool("iterator");
+		Key[] keys = this.keys();
+		Value[] values = this.values();
+		pool.put(keys, values);
+		this.free(values);
+
+		int count = 0;
+		Iterator<Map.Entry<Key, KeyValueInfo>> it = pool.keyIterator();
+		while (it.hasNext()) {
+			Map.Entry<Key, KeyValueInfo> entry = it.next();
+			assert entry.getValue().value_len == VALUE_SIZE;
+			count++;
+		}
+		assert count == KEYS : count;
+
+		count = 0;
+		for (Map.Entry<Key, Value> entry : pool) {
+			assert entry.getValue().size() == VALUE_SIZE;
+			count++;
+		}
+		assert count == KEYS : count;
+	}
+
+	public void testGetAllPools() throws FusionIOException {
+		assert this.store.getAllPools().length == 0;
+		ShardedPool foo = this.store.getOrCreatePool("foo");
+		this.store.getStore(1).getOrCreatePool("bar");
+
+		ShardedPool[] pools = this.store.getAllPools();
+		assert pools.length == 2 : pools.length;
+		assert foo.equals(pools[0]);
+		assert "bar".equals(pools[1].tag);
+		assert pools[1].getPool(0).tag.equals("bar");
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testGetOrCreatePoolClosedStore() throws FusionIOException {
+		this.store.close();
+		this.store.getOrCreatePool("foo");
+	}
+
+	@Test(expectedExceptions=IllegalArgumentException.class)
+	public void testConstructorNoShards() {
+		FusionIOAPI.get(new String[0], 0, ExpiryMode.NO_EXPIRY, 0);
+	}
+}
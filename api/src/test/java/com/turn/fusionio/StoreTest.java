@@ -32,8 +32,11 @@ package com.turn.fusionio;
 
 import com.turn.fusionio.FusionIOAPI.ExpiryMode;
 
+import java.io.File;
+import java.io.IOException;
 import java.lang.reflect.Method;
 
+import org.testng.Assert;
 import org.testng.ITestResult;
 import org.testng.annotations.AfterMethod;
 import org.testng.annotations.BeforeMethod;
@@ -83,10 +86,15 @@ public class StoreTest {
 	}
 
 	private boolean waitForPoolDeletion() throws FusionIOException {
+		return this.waitForPoolDeletion(0);
+	}
+
+	private boolean waitForPoolDeletion(int remaining)
+			throws FusionIOException {
 		long start = System.currentTimeMillis();
 
 		while (System.currentTimeMillis() < start + POOL_DELETION_TIMEOUT_MS) {
-			if (this.store.getInfo().getNumPools() == 0) {
+			if (this.store.getInfo().getNumPools() == remaining) {
 				return true;
 			}
 		}
@@ -148,6 +156,178 @@ public class StoreTest {
 		this.store.getInfo();
 	}
 
+	public void testNoCacheStats() {
+		assert this.store.getCacheStats() == null
+			: "Read cache should be disabled by default";
+	}
+
+	public void testStats() throws FusionIOException {
+		final int keys = 100;
+		Pool pool = this.store.getOrCreatePool("stats");
+		Value value = Value.get(16);
+		for (int i=0; i<keys; i++) {
+			pool.put(Key.createFrom(i), value);
+		}
+		value.free();
+		for (int i=0; i<keys; i++) {
+			pool.get(Key.createFrom(i)).free();
+		}
+
+		StoreStats stats = this.store.getStats();
+		OperationStats puts = stats.get(StoreStats.Operation.PUT);
+		OperationStats gets = stats.get(StoreStats.Operation.GET);
+		assert puts.getCount() == keys : puts;
+		assert puts.getBytesIn() == keys * 16 : puts;
+		assert gets.getCount() == keys : gets;
+		assert gets.getBytesOut() == keys * 16 : gets;
+		assert puts.getLatency(50) > 0 : puts;
+		assert puts.getLatency(99.9) >= puts.getLatency(50) : puts;
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testStatsClosedStore() throws FusionIOException {
+		this.store.close();
+		this.store.getStats();
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testConfigureCacheOpenedStore() {
+		this.store.configureCache(1024 * 1024);
+	}
+
+	@Test(expectedExceptions=IllegalArgumentException.class)
+	public void testConfigureCacheGlobalExpiry() throws FusionIOException {
+		this.store.close();
+		this.store.configureCache(1024 * 1024);
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testConfigureGroupCommitOpenedStore() {
+		this.store.configureGroupCommit(8, 100);
+	}
+
+	@Test(expectedExceptions=IllegalArgumentException.class)
+	public void testConfigureGroupCommitInvalidSize()
+			throws FusionIOException {
+		this.store.close();
+		this.store.configureGroupCommit(Pool.FUSION_IO_MAX_BATCH_SIZE + 1, 100);
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testConfigureIOClassOpenedStore() {
+		this.store.configureIOClass(Store.IOClass.BACKGROUND, 100, 10, 1000);
+	}
+
+	@Test(expectedExceptions=IllegalArgumentException.class)
+	public void testConfigureIOClassInvalidBurst() throws FusionIOException {
+		this.store.close();
+		this.store.configureIOClass(Store.IOClass.BACKGROUND, 100, 0, 1000);
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testConfigureHotKeysOpenedStore() {
+		this.store.configureHotKeys("/tmp/fio_kv.hotkeys", 1000);
+	}
+
+	@Test(expectedExceptions=IllegalArgumentException.class)
+	public void testConfigureHotKeysWithoutCache() throws FusionIOException {
+		this.store.close();
+		this.store.configureHotKeys("/tmp/fio_kv.hotkeys", 1000);
+	}
+
+	@Test(expectedExceptions=IllegalStateException.class)
+	public void testPrefetchHotKeysWithoutManifest() throws FusionIOException {
+		this.store.prefetchHotKeys();
+	}
+
+	public void testHotKeysReopen()
+			throws FusionIOException, IOException, InterruptedException {
+		final int pairs = 64;
+		File file = File.createTempFile("fio_kv", ".store");
+		File manifest = File.createTempFile("fio_kv", ".hotkeys");
+		file.deleteOnExit();
+		manifest.deleteOnExit();
+		manifest.delete();
+
+		Store cached = new Store(file.getAbsolutePath(), 0,
+			ExpiryMode.NO_EXPIRY, 0);
+		cached.configureCache(1024 * 1024);
+		cached.configureHotKeys(manifest.getAbsolutePath(), pairs);
+		cached.open();
+
+		Pool pool = cached.getOrCreatePool("hotkeys");
+		Key[] keys = new Key[pairs];
+		Value[] values = new Value[pairs];
+		for (int i=0; i<pairs; i++) {
+			keys[i] = Key.createFrom(i);
+			values[i] = Value.get(16);
+		}
+		pool.put(keys, values);
+		for (int i=0; i<pairs; i++) {
+			values[i].free();
+		}
+
+		for (int i=0; i<pairs; i++) {
+			pool.get(keys[i]).free();
+		}
+		cached.close();
+		assert manifest.exists() : "Hot key manifest was not written!";
+
+		// The manifest is prefetched in the background once the store is
+		// reopened and its pools configured; wait for the cache to fill up
+		// before reading it back.
+		cached = new Store(file.getAbsolutePath(), 0, ExpiryMode.NO_EXPIRY, 0);
+		cached.configureCache(1024 * 1024);
+		cached.configureHotKeys(manifest.getAbsolutePath(), pairs);
+		cached.open();
+		try {
+			cached.prefetchHotKeys();
+			long start = System.currentTimeMillis();
+			while (cached.getCacheStats().getEntryCount() < pairs &&
+					System.currentTimeMillis() < start + POOL_DELETION_TIMEOUT_MS) {
+				Thread.sleep(10);
+			}
+			Assert.assertEquals(cached.getCacheStats().getEntryCount(), pairs);
+
+			pool = cached.getOrCreatePool("hotkeys");
+			for (int i=0; i<pairs; i++) {
+				pool.get(keys[i]).free();
+			}
+			Assert.assertEquals(cached.getCacheStats().getHitCount(), pairs);
+			Assert.assertEquals(cached.getCacheStats().getMissCount(), 0);
+		} finally {
+			cached.deleteAllPools();
+			cached.close();
+		}
+	}
+
+	public void testBackgroundRateLimit() throws FusionIOException {
+		final int pairs = 4 * Pool.FUSION_IO_MAX_BATCH_SIZE;
+		this.store.close();
+		this.store.configureIOClass(Store.IOClass.BACKGROUND, 200,
+			Pool.FUSION_IO_MAX_BATCH_SIZE, 1000);
+		this.store.open();
+
+		Pool pool = this.store.getOrCreatePool("sched");
+		Key[] keys = new Key[pairs];
+		Value[] values = new Value[pairs];
+		Value value = Value.get(16);
+		for (int i=0; i<pairs; i++) {
+			keys[i] = Key.createFrom(i);
+			values[i] = value;
+		}
+
+		// The first chunk is covered by the burst, the other three by the
+		// 200 operations per second rate.
+		long start = System.nanoTime();
+		pool.put(keys, values);
+		long elapsed = System.nanoTime() - start;
+		value.free();
+
+		assert elapsed >= 200 * 1000000L : elapsed;
+		Assert.assertEquals(pool.exists(keys).cardinality(), pairs);
+	}
+
 	// Very slow test
 	@Test(enabled=false)
 	public void testDeleteAll() throws FusionIOException {
@@ -188,6 +368,26 @@ public class StoreTest {
 		assert this.store.getInfo().getNumPools() == 0;
 	}
 
+	public void testRecreatePool() throws FusionIOException, IOException {
+		File file = File.createTempFile("fio_kv", ".filter");
+		file.deleteOnExit();
+
+		Pool p = this.store.getOrCreatePool("recreated");
+		int id = p.id;
+		p.buildFilter(1000);
+		p.saveFilter(file.getPath());
+		p.setPacking(16);
+		this.store.deletePool(p);
+		assert this.waitForPoolDeletion();
+
+		// The pool gets its ID back, without the filter and packing of the
+		// deleted pool.
+		p = this.store.getOrCreatePool("recreated");
+		Assert.assertEquals(p.id, id);
+		p.loadFilter(file.getPath());
+		p.setPacking(32);
+	}
+
 	public void testForceError() throws FusionIOException {
 		this.store.getOrCreatePool("test");
 		this.store.getOrCreatePool("test2");
@@ -211,6 +411,58 @@ public class StoreTest {
 		assert foo.equals(pools[1]);
 	}
 
+	public void testGetAllPoolsAfterDelete() throws FusionIOException {
+		Pool test = this.store.getOrCreatePool("test");
+		Pool foo = this.store.getOrCreatePool("foo");
+		this.store.deletePool(test);
+		Pool[] pools = this.store.getAllPools();
+		assert pools.length == 1;
+		assert foo.equals(pools[0]);
+		assert "foo".equals(pools[0].tag);
+
+		assert this.waitForPoolDeletion(1);
+		this.store.close();
+		this.store.open();
+		pools = this.store.getAllPools();
+		assert pools.length == 1 : pools.length;
+		assert foo.equals(pools[0]);
+	}
+
+	public void testScan() throws FusionIOException {
+		final int pools = 5;
+		final int keys = 100;
+		Value value = Value.get(16);
+		for (int p=0; p<pools; p++) {
+			Pool pool = this.store.getOrCreatePool("scan" + p);
+			for (int i=0; i<keys; i++) {
+				value.getByteBuffer().clear();
+				value.getByteBuffer().putInt(0, pool.id);
+				pool.put(Key.createFrom(i), value);
+			}
+		}
+		value.free();
+
+		final int[] count = new int[2];
+		ScanCallback callback = new ScanCallback() {
+			@Override
+			public boolean record(Pool pool, Key key, KeyValueInfo info,
+					Value value) {
+				assert info.pool_id == pool.id;
+				assert info.value_len == 16;
+				if (value != null) {
+					assert value.getByteBuffer().getInt(0) == pool.id;
+				}
+				count[value == null ? 1 : 0]++;
+				return true;
+			}
+		};
+
+		this.store.scan(3, false, callback);
+		this.store.scan(3, true, callback);
+		assert count[0] == pools * keys : count[0];
+		assert count[1] == pools * keys : count[1];
+	}
+
 	@Test(expectedExceptions=IllegalArgumentException.class)
 	public void testConstructorWrongExpiryTime() {
 		new Store(DEVICE_NAME, 0, ExpiryMode.GLOBAL_EXPIRY, 0);
@@ -0,0 +1,636 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fio_kv_helper.h"
+
+/**
+ * Native benchmark of the key/value store helper library.
+ *
+ * This drives the helper library directly, without going through the JVM,
+ * with the core YCSB workloads: after a load phase writing all the records
+ * of the benchmark pool, worker threads run a mix of reads, updates and
+ * read-modify-writes over keys drawn from a uniform or a scrambled zipfian
+ * distribution. An optional final phase iterates over the whole pool.
+ *
+ * Latencies are not measured by the benchmark itself: every phase reports
+ * the difference between the store's operation statistics before and after
+ * it, as maintained by the helper library.
+ *
+ * Usage:
+ *
+ *   $ fio_kv_bench -d /dev/fioa -w A -r 1000000 -o 1000000 -t 16 -s 512
+ */
+
+#define _FIO_KV_BENCH_KEY_MAX_LENGTH	32
+#define _FIO_KV_BENCH_ZIPFIAN_THETA		0.99
+#define _FIO_KV_BENCH_SCAN_BUFFER_SIZE	(1024 * 1024)
+#define _FIO_KV_BENCH_SCAN_MAX_PAIRS	256
+
+typedef struct {
+	const char *path;
+	const char *tag;
+	char workload;
+	bool zipfian;
+	uint64_t records;
+	uint64_t operations;
+	uint32_t threads;
+	uint32_t value_size;
+	uint32_t batch;
+	uint32_t exists;
+	uint64_t cache_size;
+	bool load;
+	bool scan;
+} _fio_kv_bench_config_t;
+
+typedef struct {
+	uint32_t read;
+	uint32_t update;
+	uint32_t rmw;
+} _fio_kv_bench_mix_t;
+
+typedef struct {
+	uint64_t items;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+} _fio_kv_bench_zipfian_t;
+
+typedef struct {
+	const _fio_kv_bench_config_t *config;
+	const _fio_kv_bench_zipfian_t *zipfian;
+	_fio_kv_bench_mix_t mix;
+	fio_kv_pool_t *pool;
+	uint32_t index;
+	uint64_t seed;
+	uint64_t failed;
+} _fio_kv_bench_worker_t;
+
+/**
+ * Advance a xorshift64 pseudo-random number generator.
+ *
+ * Args:
+ *	state (uint64_t *): The generator's state, which must not be zero.
+ * Returns:
+ *	Returns the next 64-bit pseudo-random number.
+ */
+uint64_t _fio_kv_bench_random(uint64_t *state)
+{
+	uint64_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return *state = x;
+}
+
+/**
+ * Returns a pseudo-random number uniformly distributed in [0, 1).
+ *
+ * Args:
+ *	state (uint64_t *): The generator's state.
+ */
+double _fio_kv_bench_uniform(uint64_t *state)
+{
+	return (_fio_kv_bench_random(state) >> 11) / 9007199254740992.0;
+}
+
+/**
+ * Initialize a zipfian distribution over the given number of items.
+ *
+ * This is the generator of Gray et al., "Quickly generating billion-record
+ * synthetic databases", as used by YCSB. Computing the zeta constant is
+ * linear in the number of items.
+ *
+ * Args:
+ *	zipfian (_fio_kv_bench_zipfian_t *): The distribution to initialize.
+ *	items (uint64_t): The number of items.
+ *	theta (double): The skew of the distribution.
+ */
+void _fio_kv_bench_zipfian_init(_fio_kv_bench_zipfian_t *zipfian,
+		const uint64_t items, const double theta)
+{
+	double zeta2 = 1 + pow(0.5, theta);
+
+	zipfian->items = items;
+	zipfian->theta = theta;
+	zipfian->alpha = 1 / (1 - theta);
+	zipfian->zetan = 0;
+	for (uint64_t i=1; i<=items; i++) {
+		zipfian->zetan += 1 / pow((double)i, theta);
+	}
+	zipfian->eta = (1 - pow(2.0 / items, 1 - theta)) /
+		(1 - zeta2 / zipfian->zetan);
+}
+
+/**
+ * Draw an item from a zipfian distribution.
+ *
+ * The most popular items are scattered over the whole key space by hashing
+ * the drawn rank, as YCSB's scrambled zipfian generator does, so that they
+ * don't all live in the same region of the device.
+ *
+ * Args:
+ *	zipfian (_fio_kv_bench_zipfian_t *): The distribution.
+ *	state (uint64_t *): The pseudo-random number generator's state.
+ * Returns:
+ *	Returns an item between 0 and the number of items, excluded.
+ */
+uint64_t _fio_kv_bench_zipfian_next(const _fio_kv_bench_zipfian_t *zipfian,
+		uint64_t *state)
+{
+	double u = _fio_kv_bench_uniform(state);
+	double uz = u * zipfian->zetan;
+	uint64_t rank;
+
+	if (uz < 1) {
+		rank = 0;
+	} else if (uz < 1 + pow(0.5, zipfian->theta)) {
+		rank = 1;
+	} else {
+		rank = (uint64_t)(zipfian->items *
+			pow(zipfian->eta * u - zipfian->eta + 1, zipfian->alpha));
+	}
+
+	return fio_kv_pack_hash((const nvm_kv_key_t *)&rank, sizeof(rank)) %
+		zipfian->items;
+}
+
+/**
+ * Format the key of a record.
+ *
+ * Args:
+ *	buffer (char *): A buffer of at least _FIO_KV_BENCH_KEY_MAX_LENGTH bytes.
+ *	record (uint64_t): The record number.
+ *	key (fio_kv_key_t *): The key structure to point at the buffer.
+ */
+void _fio_kv_bench_key(char *buffer, const uint64_t record, fio_kv_key_t *key)
+{
+	key->length = (uint32_t)snprintf(buffer, _FIO_KV_BENCH_KEY_MAX_LENGTH,
+			"user%012lu", (unsigned long)record);
+	key->bytes = (nvm_kv_key_t *)buffer;
+}
+
+/**
+ * Load phase worker, writing the records assigned to a thread.
+ *
+ * Records are interleaved between threads, and written in batches of the
+ * configured size, or one by one with a batch size of 1.
+ */
+void *_fio_kv_bench_load(void *arg)
+{
+	_fio_kv_bench_worker_t *worker = (_fio_kv_bench_worker_t *)arg;
+	const _fio_kv_bench_config_t *config = worker->config;
+	char buffers[FIO_KV_MAX_BATCH_SIZE][_FIO_KV_BENCH_KEY_MAX_LENGTH];
+	fio_kv_key_t keys[FIO_KV_MAX_BATCH_SIZE];
+	fio_kv_value_t values[FIO_KV_MAX_BATCH_SIZE];
+	nvm_kv_key_info_t infos[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_key_t *pkeys[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_value_t *pvalues[FIO_KV_MAX_BATCH_SIZE];
+
+	void *data = fio_kv_alloc(config->value_size);
+	if (data == NULL) {
+		worker->failed++;
+		return NULL;
+	}
+	memset(data, 'v', config->value_size);
+
+	uint64_t record = worker->index;
+	while (record < config->records) {
+		uint32_t count = 0;
+		for (; count < config->batch && record < config->records; count++) {
+			_fio_kv_bench_key(buffers[count], record, &keys[count]);
+			memset(&infos[count], 0, sizeof(nvm_kv_key_info_t));
+			infos[count].value_len = config->value_size;
+			values[count].data = data;
+			values[count].info = &infos[count];
+			pkeys[count] = &keys[count];
+			pvalues[count] = &values[count];
+			record += config->threads;
+		}
+
+		if (count == 1) {
+			worker->failed += fio_kv_put(worker->pool, &keys[0], &values[0]) < 0;
+		} else {
+			worker->failed += count -
+				fio_kv_batch_put_count(worker->pool, pkeys, pvalues, count);
+		}
+	}
+
+	fio_kv_value_t value = { data, NULL };
+	fio_kv_free_value(&value);
+	return NULL;
+}
+
+/**
+ * Run phase worker, executing a thread's share of the operations of the
+ * workload.
+ */
+void *_fio_kv_bench_run(void *arg)
+{
+	_fio_kv_bench_worker_t *worker = (_fio_kv_bench_worker_t *)arg;
+	const _fio_kv_bench_config_t *config = worker->config;
+	char buffer[_FIO_KV_BENCH_KEY_MAX_LENGTH];
+	nvm_kv_key_info_t info;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+
+	value.data = fio_kv_alloc(config->value_size);
+	value.info = &info;
+	if (value.data == NULL) {
+		worker->failed++;
+		return NULL;
+	}
+	memset(value.data, 'v', config->value_size);
+
+	uint64_t operations = config->operations / config->threads +
+		(worker->index < config->operations % config->threads);
+	for (uint64_t i=0; i<operations; i++) {
+		uint64_t record = config->zipfian
+			? _fio_kv_bench_zipfian_next(worker->zipfian, &worker->seed)
+			: _fio_kv_bench_random(&worker->seed) % config->records;
+		uint32_t dice = (uint32_t)(_fio_kv_bench_random(&worker->seed) % 100);
+		_fio_kv_bench_key(buffer, record, &key);
+
+		memset(&info, 0, sizeof(nvm_kv_key_info_t));
+		info.value_len = config->value_size;
+		if (dice < worker->mix.read) {
+			if (_fio_kv_bench_random(&worker->seed) % 100 < config->exists) {
+				worker->failed += !fio_kv_exists(worker->pool, &key, NULL);
+			} else {
+				worker->failed += fio_kv_get(worker->pool, &key, &value) < 0;
+			}
+			continue;
+		}
+
+		if (dice < worker->mix.read + worker->mix.rmw) {
+			if (fio_kv_get(worker->pool, &key, &value) < 0) {
+				worker->failed++;
+				continue;
+			}
+			info.value_len = config->value_size;
+		}
+
+		*(uint64_t *)value.data = i;
+		worker->failed += fio_kv_put(worker->pool, &key, &value) < 0;
+	}
+
+	fio_kv_free_value(&value);
+	return NULL;
+}
+
+/**
+ * Start the given number of workers on a phase, and wait for their
+ * completion.
+ *
+ * Returns:
+ *	Returns the number of operations that failed, or -1 if the workers
+ *	  could not be started.
+ */
+int64_t _fio_kv_bench_spawn(_fio_kv_bench_worker_t *workers,
+		const uint32_t count, void *(*phase)(void *))
+{
+	pthread_t *threads = (pthread_t *)calloc(count, sizeof(pthread_t));
+	uint32_t started = 0;
+	int64_t failed = 0;
+
+	if (threads == NULL) {
+		return -1;
+	}
+
+	for (; started < count; started++) {
+		workers[started].failed = 0;
+		if (pthread_create(&threads[started], NULL, phase,
+					&workers[started]) != 0) {
+			break;
+		}
+	}
+
+	for (uint32_t i=0; i<started; i++) {
+		pthread_join(threads[i], NULL);
+		failed += workers[i].failed;
+	}
+
+	free(threads);
+	return started == count ? failed : -1;
+}
+
+/**
+ * Returns the given percentile of a latency histogram, in microseconds.
+ */
+double _fio_kv_bench_percentile(const uint64_t *histogram,
+		const uint64_t count, const double percentile)
+{
+	uint64_t rank = (uint64_t)ceil(percentile / 100 * count);
+	uint64_t seen = 0;
+
+	for (uint32_t i=0; i<FIO_KV_STATS_BUCKETS; i++) {
+		seen += histogram[i];
+		if (seen >= rank && seen > 0) {
+			return fio_kv_stats_bucket_limit(i) / 1000.0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Report the operations of a phase, from the difference between the store
+ * statistics taken before and after it.
+ *
+ * Args:
+ *	name (const char *): The phase name.
+ *	before (fio_kv_stats_snapshot_t *): The statistics before the phase.
+ *	after (fio_kv_stats_snapshot_t *): The statistics after the phase,
+ *	  replaced by the difference.
+ *	elapsed (double): The duration of the phase, in seconds.
+ *	failed (int64_t): The number of operations the workers saw failing.
+ */
+void _fio_kv_bench_report(const char *name,
+		const fio_kv_stats_snapshot_t *before,
+		fio_kv_stats_snapshot_t *after, const double elapsed,
+		const int64_t failed)
+{
+	static const char *names[FIO_KV_STATS_OPS] = {
+		"get", "put", "exists", "delete", "get_value_len", "get_key_info",
+		"batch_get", "batch_put", "iterate", "batch_delete", "batch_exists"
+	};
+
+	// Both snapshots are made of uint64_t counters only.
+	const size_t counters = sizeof(fio_kv_stats_snapshot_t) / sizeof(uint64_t);
+	const uint64_t *b = (const uint64_t *)before;
+	uint64_t *a = (uint64_t *)after;
+	for (size_t i=0; i<counters; i++) {
+		a[i] -= b[i];
+	}
+
+	printf("[%s] %.3fs, %ld failed operations\n", name, elapsed,
+			(long)failed);
+	printf("  %-14s %10s %10s %9s %9s %9s %9s %9s %9s %8s\n", "operation",
+			"count", "ops/s", "mean(us)", "p50(us)", "p95(us)", "p99(us)",
+			"p999(us)", "MB/s", "errors");
+
+	for (int op=0; op<FIO_KV_STATS_OPS; op++) {
+		const fio_kv_stats_op_counters_t *c = &after->ops[op];
+		if (c->count == 0) {
+			continue;
+		}
+
+		printf("  %-14s %10lu %10.0f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %8lu\n",
+				names[op], (unsigned long)c->count, c->count / elapsed,
+				c->native_ns / 1000.0 / c->count,
+				_fio_kv_bench_percentile(c->native, c->count, 50),
+				_fio_kv_bench_percentile(c->native, c->count, 95),
+				_fio_kv_bench_percentile(c->native, c->count, 99),
+				_fio_kv_bench_percentile(c->native, c->count, 99.9),
+				(c->bytes_in + c->bytes_out) / elapsed / (1024 * 1024),
+				(unsigned long)c->errors);
+	}
+
+	for (int e=1; e<FIO_KV_STATS_ERRNOS; e++) {
+		if (after->errnos[e] > 0) {
+			printf("  errno %d (%s): %lu\n", e, strerror(e),
+					(unsigned long)after->errnos[e]);
+		}
+	}
+}
+
+/**
+ * Run a benchmark phase, and report on it.
+ *
+ * Returns:
+ *	Returns true if all the workers could be started.
+ */
+bool _fio_kv_bench_phase(const char *name, fio_kv_store_t *store,
+		_fio_kv_bench_worker_t *workers, const uint32_t count,
+		void *(*phase)(void *))
+{
+	fio_kv_stats_snapshot_t *before = fio_kv_get_stats(store);
+	uint64_t start = fio_kv_stats_clock();
+	int64_t failed = _fio_kv_bench_spawn(workers, count, phase);
+	double elapsed = (fio_kv_stats_clock() - start) / 1e9;
+	fio_kv_stats_snapshot_t *after = fio_kv_get_stats(store);
+
+	if (failed >= 0 && before != NULL && after != NULL) {
+		_fio_kv_bench_report(name, before, after, elapsed, failed);
+	}
+
+	free(before);
+	free(after);
+	return failed >= 0;
+}
+
+/**
+ * Scan phase worker, iterating over the whole pool in batches.
+ */
+void *_fio_kv_bench_scan(void *arg)
+{
+	_fio_kv_bench_worker_t *worker = (_fio_kv_bench_worker_t *)arg;
+	void *buffer = fio_kv_alloc(_FIO_KV_BENCH_SCAN_BUFFER_SIZE);
+	uint64_t pairs = 0;
+
+	int iterator = buffer != NULL ? fio_kv_iterator(worker->pool) : -1;
+	if (iterator < 0) {
+		worker->failed++;
+	} else {
+		fio_kv_batch_t *batch = (fio_kv_batch_t *)buffer;
+		do {
+			int read = fio_kv_next_batch(worker->pool, iterator, buffer,
+					_FIO_KV_BENCH_SCAN_BUFFER_SIZE,
+					_FIO_KV_BENCH_SCAN_MAX_PAIRS, false);
+			if (read < 0) {
+				worker->failed++;
+				break;
+			}
+			pairs += read;
+		} while (!batch->ended);
+		fio_kv_end_iteration(worker->pool, iterator);
+	}
+
+	if (pairs != worker->config->records) {
+		fprintf(stderr, "Scanned %lu pairs out of %lu records.\n",
+				(unsigned long)pairs, (unsigned long)worker->config->records);
+	}
+
+	fio_kv_value_t value = { buffer, NULL };
+	fio_kv_free_value(&value);
+	return NULL;
+}
+
+void _fio_kv_bench_usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s -d <device> [options]\n"
+		"  -d <path>   FusionIO device or directFS file\n"
+		"  -p <tag>    benchmark pool tag (default: bench)\n"
+		"  -w <A|B|C|F>  YCSB workload: A 50%% reads and 50%% updates,\n"
+		"              B 95%% reads, C read only, F 50%% read-modify-writes\n"
+		"              (default: A)\n"
+		"  -u          uniform instead of zipfian key distribution\n"
+		"  -r <count>  number of records (default: 100000)\n"
+		"  -o <count>  number of operations of the run phase\n"
+		"              (default: 100000)\n"
+		"  -t <count>  number of threads (default: 1)\n"
+		"  -s <bytes>  value size (default: 1024)\n"
+		"  -b <count>  load phase batch size, up to %d (default: 1)\n"
+		"  -e <pct>    percentage of reads issued as existence checks\n"
+		"              (default: 0)\n"
+		"  -c <bytes>  read cache size (default: 0)\n"
+		"  -L          skip the load phase\n"
+		"  -S          iterate over the pool after the run phase\n",
+		name, FIO_KV_MAX_BATCH_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+	_fio_kv_bench_config_t config;
+	_fio_kv_bench_mix_t mix;
+	_fio_kv_bench_zipfian_t zipfian;
+	int opt;
+
+	memset(&config, 0, sizeof(config));
+	config.tag = "bench";
+	config.workload = 'A';
+	config.zipfian = true;
+	config.records = 100000;
+	config.operations = 100000;
+	config.threads = 1;
+	config.value_size = 1024;
+	config.batch = 1;
+	config.load = true;
+
+	while ((opt = getopt(argc, argv, "d:p:w:ur:o:t:s:b:e:c:LSh")) != -1) {
+		switch (opt) {
+			case 'd': config.path = optarg; break;
+			case 'p': config.tag = optarg; break;
+			case 'w': config.workload = optarg[0]; break;
+			case 'u': config.zipfian = false; break;
+			case 'r': config.records = strtoul(optarg, NULL, 10); break;
+			case 'o': config.operations = strtoul(optarg, NULL, 10); break;
+			case 't': config.threads = atoi(optarg); break;
+			case 's': config.value_size = atoi(optarg); break;
+			case 'b': config.batch = atoi(optarg); break;
+			case 'e': config.exists = atoi(optarg); break;
+			case 'c': config.cache_size = strtoul(optarg, NULL, 10); break;
+			case 'L': config.load = false; break;
+			case 'S': config.scan = true; break;
+			default:
+				_fio_kv_bench_usage(argv[0]);
+				return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	switch (config.workload) {
+		case 'A': mix.read = 50; mix.update = 50; mix.rmw = 0; break;
+		case 'B': mix.read = 95; mix.update = 5; mix.rmw = 0; break;
+		case 'C': mix.read = 100; mix.update = 0; mix.rmw = 0; break;
+		case 'F': mix.read = 50; mix.update = 0; mix.rmw = 50; break;
+		default: config.path = NULL; break;
+	}
+
+	if (config.path == NULL || config.records == 0 || config.threads == 0 ||
+			config.value_size == 0 ||
+			config.value_size > NVM_KV_MAX_VALUE_SIZE ||
+			config.batch == 0 || config.batch > FIO_KV_MAX_BATCH_SIZE ||
+			config.exists > 100 ||
+			strlen(config.tag) >= FIO_TAG_MAX_LENGTH) {
+		_fio_kv_bench_usage(argv[0]);
+		return 1;
+	}
+
+	fio_kv_store_t store;
+	memset(&store, 0, sizeof(store));
+	store.path = config.path;
+	if (!fio_kv_open(&store, 0, KV_DISABLE_EXPIRY, 0, config.cache_size)) {
+		perror("Could not open the key/value store");
+		return 1;
+	}
+
+	fio_kv_pool_t *pool = fio_kv_get_or_create_pool(&store, config.tag);
+	if (pool == NULL) {
+		perror("Could not create the benchmark pool");
+		fio_kv_close(&store);
+		return 1;
+	}
+	pool->size_hint = config.value_size;
+
+	if (config.zipfian) {
+		_fio_kv_bench_zipfian_init(&zipfian, config.records,
+				_FIO_KV_BENCH_ZIPFIAN_THETA);
+	}
+
+	_fio_kv_bench_worker_t *workers = (_fio_kv_bench_worker_t *)
+		calloc(config.threads, sizeof(_fio_kv_bench_worker_t));
+	if (workers == NULL) {
+		perror("Could not allocate the workers");
+		fio_kv_close(&store);
+		return 1;
+	}
+
+	for (uint32_t i=0; i<config.threads; i++) {
+		workers[i].config = &config;
+		workers[i].zipfian = &zipfian;
+		workers[i].mix = mix;
+		workers[i].pool = pool;
+		workers[i].index = i;
+		workers[i].seed = (uint64_t)0x9e3779b9U * (i + 1);
+	}
+
+	printf("workload %c, %s keys, %lu records of %u bytes, %lu operations, "
+			"%u threads\n", config.workload,
+			config.zipfian ? "zipfian" : "uniform",
+			(unsigned long)config.records, config.value_size,
+			(unsigned long)config.operations, config.threads);
+
+	bool ret = (!config.load ||
+			_fio_kv_bench_phase("load", &store, workers, config.threads,
+				_fio_kv_bench_load)) &&
+		_fio_kv_bench_phase("run", &store, workers, config.threads,
+				_fio_kv_bench_run) &&
+		(!config.scan ||
+			_fio_kv_bench_phase("scan", &store, workers, 1,
+				_fio_kv_bench_scan));
+	if (!ret) {
+		perror("Could not start the benchmark threads");
+	}
+
+	free(workers);
+	free(pool);
+	fio_kv_close(&store);
+	return ret ? 0 : 1;
+}
@@ -39,7 +39,15 @@
 #include <unistd.h>
 
 #include "com_turn_fusionio_FusionIOAPI.h"
+#include "fio_kv_async.h"
+#include "fio_kv_cache.h"
+#include "fio_kv_export.h"
 #include "fio_kv_helper.h"
+#include "fio_kv_large.h"
+#include "fio_kv_ring.h"
+#include "fio_kv_scan.h"
+#include "fio_kv_shard.h"
+#include "fio_kv_slab.h"
 
 static jclass _expiry_mode_cls;
 static jmethodID _expiry_mode_ordinal;
@@ -47,7 +55,20 @@ static jmethodID _expiry_mode_ordinal;
 static jclass _store_cls;
 static jfieldID _store_field_path,
                 _store_field_fd,
-                _store_field_kv;
+                _store_field_kv,
+                _store_field_handle;
+
+static jclass _allocatorstats_cls;
+static jmethodID _allocatorstats_cstr;
+
+static jclass _cachestats_cls;
+static jmethodID _cachestats_cstr;
+
+static jclass _opstats_cls;
+static jmethodID _opstats_cstr;
+
+static jclass _storestats_cls;
+static jmethodID _storestats_cstr;
 
 static jclass _storeinfo_cls;
 static jmethodID _storeinfo_cstr;
@@ -72,6 +93,7 @@ static jfieldID _key_field_length,
 static jclass _value_cls;
 static jmethodID _value_cstr;
 static jfieldID _value_field_data,
+                _value_field_address,
                 _value_field_info;
 
 static jclass _kvinfo_cls;
@@ -85,8 +107,7 @@ static jfieldID _kvinfo_field_pool_id,
 /**
  * Initializes the JNI class, method and field IDs.
  */
-JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1init_1jni_1cache
-  (JNIEnv *env, jclass cls)
+void __fio_kv_init_jni_cache(JNIEnv *env)
 {
 	jclass _cls;
 
@@ -103,6 +124,32 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1init_1jni_1ca
 	_store_field_path = env->GetFieldID(_store_cls, "path", "Ljava/lang/String;");
 	_store_field_fd   = env->GetFieldID(_store_cls, "fd", "I");
 	_store_field_kv   = env->GetFieldID(_store_cls, "kv", "J");
+	_store_field_handle = env->GetFieldID(_store_cls, "handle", "J");
+
+	_cls = env->FindClass("com/turn/fusionio/AllocatorStats");
+	assert(_cls != NULL);
+	_allocatorstats_cls = (jclass) env->NewGlobalRef(_cls);
+	env->DeleteLocalRef(_cls);
+	_allocatorstats_cstr = env->GetMethodID(_allocatorstats_cls, "<init>", "(JJJJ)V");
+
+	_cls = env->FindClass("com/turn/fusionio/CacheStats");
+	assert(_cls != NULL);
+	_cachestats_cls = (jclass) env->NewGlobalRef(_cls);
+	env->DeleteLocalRef(_cls);
+	_cachestats_cstr = env->GetMethodID(_cachestats_cls, "<init>", "(JJJJJJJJJ)V");
+
+	_cls = env->FindClass("com/turn/fusionio/OperationStats");
+	assert(_cls != NULL);
+	_opstats_cls = (jclass) env->NewGlobalRef(_cls);
+	env->DeleteLocalRef(_cls);
+	_opstats_cstr = env->GetMethodID(_opstats_cls, "<init>", "(JJJJJJJ[J[J)V");
+
+	_cls = env->FindClass("com/turn/fusionio/StoreStats");
+	assert(_cls != NULL);
+	_storestats_cls = (jclass) env->NewGlobalRef(_cls);
+	env->DeleteLocalRef(_cls);
+	_storestats_cstr = env->GetMethodID(_storestats_cls, "<init>",
+			"([Lcom/turn/fusionio/OperationStats;[J)V");
 
 	_cls = env->FindClass("com/turn/fusionio/StoreInfo");
 	assert(_cls != NULL);
@@ -138,8 +185,10 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1init_1jni_1ca
 	assert(_cls != NULL);
 	_value_cls = (jclass) env->NewGlobalRef(_cls);
 	env->DeleteLocalRef(_cls);
+	_value_cstr = env->GetMethodID(_value_cls, "<init>", "()V");
 	_value_field_data = env->GetFieldID(_value_cls, "data",
 			"Ljava/nio/ByteBuffer;");
+	_value_field_address = env->GetFieldID(_value_cls, "address", "J");
 	_value_field_info = env->GetFieldID(_value_cls, "info",
 			"Lcom/turn/fusionio/KeyValueInfo;");
 
@@ -158,18 +207,35 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1init_1jni_1ca
 /**
  * Convert a Store object into a fio_kv_store_t structure.
  *
- * A new fio_kv_store_t structure is allocated and populated. It will need to
- * be freed by the caller when it is no longer needed.
+ * The given fio_kv_store_t structure, usually living on the caller's stack, is
+ * populated from the Store object's fields, and shares the read cache, Bloom
+ * filters, group commit queue, compression settings, packing state,
+ * operation statistics, I/O scheduler and hot key manifest of its native
+ * store handle. No memory is allocated.
  */
-fio_kv_store_t *__jobject_to_fio_kv_store(JNIEnv *env, jobject _store)
+void __jobject_to_fio_kv_store(JNIEnv *env, jobject _store,
+		fio_kv_store_t *store)
 {
 	assert(env != NULL);
 	assert(_store != NULL);
+	assert(store != NULL);
 
-	fio_kv_store_t *store = (fio_kv_store_t *)malloc(sizeof(fio_kv_store_t));
+	fio_kv_store_t *handle = (fio_kv_store_t *)(intptr_t)
+		env->GetLongField(_store, _store_field_handle);
+
+	store->path = NULL;
 	store->fd = env->GetIntField(_store, _store_field_fd);
 	store->kv = env->GetLongField(_store, _store_field_kv);
-	return store;
+	store->cache = handle != NULL ? handle->cache : NULL;
+	store->filters = handle != NULL ? handle->filters : NULL;
+	store->group = handle != NULL ? handle->group : NULL;
+	store->codecs = handle != NULL ? handle->codecs : NULL;
+	store->pack = handle != NULL ? handle->pack : NULL;
+	store->stats = handle != NULL ? handle->stats : NULL;
+	store->sched = handle != NULL ? handle->sched : NULL;
+	store->hotkeys = handle != NULL ? handle->hotkeys : NULL;
+	store->pools = handle != NULL ? handle->pools : NULL;
+	store->locks = handle != NULL ? handle->locks : NULL;
 }
 
 /**
@@ -186,6 +252,52 @@ void __fio_kv_store_set_jobject(JNIEnv *env, fio_kv_store_t *store,
 	env->SetLongField(_store, _store_field_kv, store->kv);
 }
 
+/**
+ * Copy the fd, kv, cache, filters, group, codecs, pack, stats, sched,
+ * hotkeys, pools and locks fields of a fio_kv_store_t structure into the
+ * native store handle held by a Store object.
+ *
+ * The store handle is a long-lived fio_kv_store_t structure, allocated the
+ * first time the store is opened, that pool handles point to. It is kept
+ * up-to-date across open() and close() calls so that pool handles remain
+ * valid for the whole lifetime of the Store object.
+ *
+ * Returns false if the store handle could not be allocated.
+ */
+bool __fio_kv_store_set_handle(JNIEnv *env, fio_kv_store_t *store,
+		jobject _store)
+{
+	assert(env != NULL);
+	assert(store != NULL);
+	assert(_store != NULL);
+
+	fio_kv_store_t *handle = (fio_kv_store_t *)(intptr_t)
+		env->GetLongField(_store, _store_field_handle);
+	if (handle == NULL) {
+		handle = (fio_kv_store_t *)calloc(1, sizeof(fio_kv_store_t));
+		if (handle == NULL) {
+			return false;
+		}
+
+		env->SetLongField(_store, _store_field_handle,
+				(jlong)(intptr_t)handle);
+	}
+
+	handle->fd = store->fd;
+	handle->kv = store->kv;
+	handle->cache = store->cache;
+	handle->filters = store->filters;
+	handle->group = store->group;
+	handle->codecs = store->codecs;
+	handle->pack = store->pack;
+	handle->stats = store->stats;
+	handle->sched = store->sched;
+	handle->hotkeys = store->hotkeys;
+	handle->pools = store->pools;
+	handle->locks = store->locks;
+	return true;
+}
+
 /**
  * Converts a nvm_kv_store_info_t structure into a StoreInfo object.
  */
@@ -202,58 +314,65 @@ jobject __nvm_kv_store_info_to_jobject(JNIEnv *env, nvm_kv_store_info_t *info)
 /**
  * Convert a Pool object into a fio_kv_pool_t structure.
  *
- * A new fio_kv_pool_t structure is allocated and populated. It will need to be
- * freed by the caller when it is no longer needed.
+ * Both the fio_kv_pool_t structure and the fio_kv_store_t structure it will
+ * point to are provided by the caller, usually on its stack. No memory is
+ * allocated.
  */
-fio_kv_pool_t *__jobject_to_fio_kv_pool(JNIEnv *env, jobject _pool)
+void __jobject_to_fio_kv_pool(JNIEnv *env, jobject _pool,
+		fio_kv_pool_t *pool, fio_kv_store_t *store)
 {
 	assert(env != NULL);
 	assert(_pool != NULL);
+	assert(pool != NULL);
+	assert(store != NULL);
 
-	fio_kv_pool_t *pool = (fio_kv_pool_t *)malloc(sizeof(fio_kv_pool_t));
-	pool->store = __jobject_to_fio_kv_store(env,
-			env->GetObjectField(_pool, _pool_field_store));
+	jobject _store = env->GetObjectField(_pool, _pool_field_store);
+	__jobject_to_fio_kv_store(env, _store, store);
+	env->DeleteLocalRef(_store);
+
+	pool->store = store;
 	pool->id = env->GetIntField(_pool, _pool_field_id);
 	// We don't really need to bother with the pool tag here.
-	return pool;
+	pool->tag[0] = '\0';
+	pool->size_hint = FIO_KV_DEFAULT_SIZE_HINT;
 }
 
 /**
  * Convert a Key object into a fio_kv_key_t structure.
  *
- * A new fio_kv_key_t structure is allocated and populated. It will need to be
- * freed by the caller when it is no longer needed.
+ * The given fio_kv_key_t structure is populated in place. No memory is
+ * allocated.
  */
-fio_kv_key_t *__jobject_to_fio_kv_key(JNIEnv *env, jobject _key)
+void __jobject_to_fio_kv_key(JNIEnv *env, jobject _key, fio_kv_key_t *key)
 {
 	assert(env != NULL);
 	assert(_key != NULL);
+	assert(key != NULL);
 
-	fio_kv_key_t *key = (fio_kv_key_t *)malloc(sizeof(fio_kv_key_t));
+	jobject _bytes = env->GetObjectField(_key, _key_field_bytes);
 	key->length = env->GetIntField(_key, _key_field_length);
-	key->bytes = (nvm_kv_key_t *)env->GetDirectBufferAddress(
-			env->GetObjectField(_key, _key_field_bytes));
-	return key;
+	key->bytes = (nvm_kv_key_t *)env->GetDirectBufferAddress(_bytes);
+	env->DeleteLocalRef(_bytes);
 }
 
 /**
  * Convert a KeyValueInfo object into a nvm_kv_key_info_t structure.
  *
- * A new nvm_kv_key_info_t structure is allocated and populated. It will need to be
- * freed by the caller when it is no longer needed.
+ * The given nvm_kv_key_info_t structure is populated in place. No memory is
+ * allocated.
  */
-nvm_kv_key_info_t *__jobject_to_nvm_kv_key_info(JNIEnv *env, jobject _kvinfo)
+void __jobject_to_nvm_kv_key_info(JNIEnv *env, jobject _kvinfo,
+		nvm_kv_key_info_t *kvinfo)
 {
 	assert(env != NULL);
 	assert(_kvinfo != NULL);
+	assert(kvinfo != NULL);
 
-	nvm_kv_key_info_t *kvinfo = (nvm_kv_key_info_t *)malloc(sizeof(nvm_kv_key_info_t));
 	kvinfo->pool_id = env->GetIntField(_kvinfo, _kvinfo_field_pool_id);
 	kvinfo->key_len = env->GetIntField(_kvinfo, _kvinfo_field_key_len);
 	kvinfo->value_len = env->GetIntField(_kvinfo, _kvinfo_field_value_len);
 	kvinfo->expiry = env->GetIntField(_kvinfo, _kvinfo_field_expiry);
 	kvinfo->gen_count = env->GetIntField(_kvinfo, _kvinfo_field_gen_count);
-	return kvinfo;
 }
 
 /**
@@ -286,31 +405,87 @@ void __kv_key_info_set_jobject(JNIEnv *env, nvm_kv_key_info_t *info, jobject _in
 	env->SetIntField(_info, _kvinfo_field_gen_count, info->gen_count);
 }
 
+/**
+ * Re-populates the KeyValueInfo object of a Value object from a
+ * nvm_kv_key_info_t structure.
+ */
+void __kv_value_info_set_jobject(JNIEnv *env, nvm_kv_key_info_t *info,
+		jobject _value)
+{
+	assert(env != NULL);
+	assert(info != NULL);
+	assert(_value != NULL);
+
+	jobject _info = env->GetObjectField(_value, _value_field_info);
+	__kv_key_info_set_jobject(env, info, _info);
+	env->DeleteLocalRef(_info);
+}
+
 /**
  * Convert a Value object into a fio_kv_value_t structure.
  *
- * A new fio_kv_value_t structure is allocated and populated. It will need to
- * be freed by the caller when it is no longer needed.
+ * The given fio_kv_value_t structure is populated in place and its info
+ * field pointed at the given nvm_kv_key_info_t structure, which is filled in
+ * from the Value's KeyValueInfo object. No memory is allocated.
  */
-fio_kv_value_t *__jobject_to_fio_kv_value(JNIEnv *env, jobject _value)
+void __jobject_to_fio_kv_value(JNIEnv *env, jobject _value,
+		fio_kv_value_t *value, nvm_kv_key_info_t *info)
 {
 	assert(env != NULL);
 	assert(_value != NULL);
+	assert(value != NULL);
+	assert(info != NULL);
+
+	jobject _data = env->GetObjectField(_value, _value_field_data);
+	jobject _info = env->GetObjectField(_value, _value_field_info);
 
-	fio_kv_value_t *value = (fio_kv_value_t *)malloc(sizeof(fio_kv_value_t));
-	value->data = env->GetDirectBufferAddress(
-			env->GetObjectField(_value, _value_field_data));
-	value->info = __jobject_to_nvm_kv_key_info(env,
-			env->GetObjectField(_value, _value_field_info));
-	return value;
+	value->data = env->GetDirectBufferAddress(_data);
+	value->info = info;
+	__jobject_to_nvm_kv_key_info(env, _info, info);
+
+	env->DeleteLocalRef(_data);
+	env->DeleteLocalRef(_info);
+}
+
+/**
+ * Build a new Value object around a fio_kv_value_t structure.
+ *
+ * The Value's data buffer maps onto the value structure's sector-aligned
+ * memory, of the given capacity, and its KeyValueInfo object is populated
+ * from the value structure's info. Ownership of the memory is transferred to
+ * the Value object, which must eventually be released with Value.free().
+ */
+jobject __fio_kv_value_to_jobject(JNIEnv *env, fio_kv_value_t *value,
+		uint32_t capacity)
+{
+	assert(env != NULL);
+	assert(value != NULL);
+	assert(value->data != NULL);
+	assert(value->info != NULL);
+
+	jobject _value = env->NewObject(_value_cls, _value_cstr);
+	if (_value == NULL) {
+		return NULL;
+	}
+
+	jobject _data = env->NewDirectByteBuffer(value->data, capacity);
+	jobject _info = __nvm_kv_key_info_to_jobject(env, value->info);
+	env->SetObjectField(_value, _value_field_data, _data);
+	env->SetLongField(_value, _value_field_address,
+			(jlong)(intptr_t)value->data);
+	env->SetObjectField(_value, _value_field_info, _info);
+
+	env->DeleteLocalRef(_data);
+	env->DeleteLocalRef(_info);
+	return _value;
 }
 
 /**
- * boolean fio_kv_open(Store store, int version, ExpiryMode expiryMode, int expiryTime)
+ * boolean fio_kv_open(Store store, int version, ExpiryMode expiryMode, int expiryTime, long cacheSize)
  */
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1open(
 		JNIEnv *env, jclass cls, jobject _store, jint _version,
-		jobject _expiry_mode, jint _expiry_time)
+		jobject _expiry_mode, jint _expiry_time, jlong _cache_size)
 {
 	assert(_store != NULL);
 	assert(_expiry_mode != NULL);
@@ -318,18 +493,24 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1open(
 	nvm_kv_expiry_t expiry_mode = (nvm_kv_expiry_t)
 		env->CallIntMethod(_expiry_mode, _expiry_mode_ordinal);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
-	store->path = env->GetStringUTFChars(
-			(jstring)env->GetObjectField(_store, _store_field_path), 0);
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
+
+	jstring _path = (jstring)env->GetObjectField(_store, _store_field_path);
+	store.path = env->GetStringUTFChars(_path, 0);
+
+	bool ret = fio_kv_open(&store, (uint32_t)_version, expiry_mode,
+			(uint32_t)_expiry_time, (uint64_t)_cache_size);
+
+	env->ReleaseStringUTFChars(_path, store.path);
+	env->DeleteLocalRef(_path);
 
-	bool ret = fio_kv_open(store, (uint32_t)_version, expiry_mode,
-			(uint32_t)_expiry_time);
+	if (ret && !__fio_kv_store_set_handle(env, &store, _store)) {
+		fio_kv_close(&store);
+		ret = false;
+	}
 
-	env->ReleaseStringUTFChars(
-			(jstring)env->GetObjectField(_store, _store_field_path),
-			store->path);
-	__fio_kv_store_set_jobject(env, store, _store);
-	free(store);
+	__fio_kv_store_set_jobject(env, &store, _store);
 	return (jboolean)ret;
 }
 
@@ -341,11 +522,11 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1close(
 {
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
-	fio_kv_close(store);
-	__fio_kv_store_set_jobject(env, store, _store);
-
-	free(store);
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
+	fio_kv_close(&store);
+	__fio_kv_store_set_handle(env, &store, _store);
+	__fio_kv_store_set_jobject(env, &store, _store);
 }
 
 /**
@@ -356,15 +537,197 @@ JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1store
 {
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
-	nvm_kv_store_info_t *info = fio_kv_get_store_info(store);
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
+	nvm_kv_store_info_t *info = fio_kv_get_store_info(&store);
 	jobject _info = info ? __nvm_kv_store_info_to_jobject(env, info) : NULL;
 
-	free(store);
 	free(info);
 	return _info;
 }
 
+/**
+ * CacheStats fio_kv_get_cache_stats(long store);
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1cache_1stats
+	(JNIEnv *env, jclass cls, jlong _store)
+{
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL || store->cache == NULL) {
+		return NULL;
+	}
+
+	fio_kv_cache_stats_t stats;
+	fio_kv_cache_get_stats(store->cache, &stats);
+	return env->NewObject(_cachestats_cls, _cachestats_cstr,
+			(jlong)stats.hits, (jlong)stats.misses,
+			(jlong)stats.insertions, (jlong)stats.evictions,
+			(jlong)stats.expirations, (jlong)stats.invalidations,
+			(jlong)stats.entries, (jlong)stats.bytes,
+			(jlong)stats.capacity);
+}
+
+/**
+ * Converts an array of uint64_t counters into a long[] array.
+ */
+jlongArray __uint64_array_to_jobject(JNIEnv *env, const uint64_t *counters,
+		const int count)
+{
+	jlongArray _array = env->NewLongArray(count);
+	if (_array != NULL) {
+		env->SetLongArrayRegion(_array, 0, count, (const jlong *)counters);
+	}
+
+	return _array;
+}
+
+/**
+ * Converts the counters of an operation into an OperationStats object.
+ */
+jobject __fio_kv_stats_op_to_jobject(JNIEnv *env,
+		const fio_kv_stats_op_counters_t *counters)
+{
+	jlongArray _native = __uint64_array_to_jobject(env, counters->native,
+			FIO_KV_STATS_BUCKETS);
+	jlongArray _jni = __uint64_array_to_jobject(env, counters->jni,
+			FIO_KV_STATS_BUCKETS);
+	if (_native == NULL || _jni == NULL) {
+		return NULL;
+	}
+
+	jobject _stats = env->NewObject(_opstats_cls, _opstats_cstr,
+			(jlong)counters->count, (jlong)counters->errors,
+			(jlong)counters->bytes_in, (jlong)counters->bytes_out,
+			(jlong)counters->native_ns, (jlong)counters->jni_count,
+			(jlong)counters->jni_ns, _native, _jni);
+	env->DeleteLocalRef(_native);
+	env->DeleteLocalRef(_jni);
+	return _stats;
+}
+
+/**
+ * StoreStats fio_kv_get_stats(long store);
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1stats
+	(JNIEnv *env, jclass cls, jlong _store)
+{
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL || store->stats == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fio_kv_stats_snapshot_t *snapshot = fio_kv_get_stats(store);
+	if (snapshot == NULL) {
+		return NULL;
+	}
+
+	jobject _stats = NULL;
+	jobjectArray _ops = env->NewObjectArray(FIO_KV_STATS_OPS, _opstats_cls,
+			(jobject)NULL);
+	for (int i=0; _ops != NULL && i<FIO_KV_STATS_OPS; i++) {
+		jobject _op = __fio_kv_stats_op_to_jobject(env, &snapshot->ops[i]);
+		if (_op == NULL) {
+			env->DeleteLocalRef(_ops);
+			_ops = NULL;
+			break;
+		}
+
+		env->SetObjectArrayElement(_ops, i, _op);
+		env->DeleteLocalRef(_op);
+	}
+
+	jlongArray _errnos = _ops != NULL
+		? __uint64_array_to_jobject(env, snapshot->errnos, FIO_KV_STATS_ERRNOS)
+		: NULL;
+	if (_errnos != NULL) {
+		_stats = env->NewObject(_storestats_cls, _storestats_cstr, _ops,
+				_errnos);
+		env->DeleteLocalRef(_errnos);
+	}
+
+	if (_ops != NULL) {
+		env->DeleteLocalRef(_ops);
+	}
+	free(snapshot);
+	return _stats;
+}
+
+/**
+ * boolean fio_kv_set_group_commit(long store, int maxPairs, int delay);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1group_1commit
+	(JNIEnv *env, jclass cls, jlong _store, jint _max_pairs, jint _delay)
+{
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL || _max_pairs < 0 || _delay < 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return fio_kv_set_group_commit(store, (uint32_t)_max_pairs,
+			(uint32_t)_delay);
+}
+
+/**
+ * boolean fio_kv_set_sched(long store, int ioClass, int rate, int burst,
+ *     int maxDefer);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1sched
+	(JNIEnv *env, jclass cls, jlong _store, jint _class, jint _rate,
+	 jint _burst, jint _max_defer)
+{
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL || _class < 0 || _class >= FIO_KV_SCHED_CLASSES ||
+			_rate < 0 || _burst < 0 || _max_defer < 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return fio_kv_set_sched(store, (fio_kv_sched_class_t)_class,
+			(uint32_t)_rate, (uint32_t)_burst, (uint32_t)_max_defer);
+}
+
+/**
+ * boolean fio_kv_set_hot_keys(long store, String path, int maxKeys);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1hot_1keys
+	(JNIEnv *env, jclass cls, jlong _store, jstring _path, jint _max_keys)
+{
+	assert(env != NULL);
+	assert(_path != NULL);
+
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL || _max_keys <= 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	const char *path = env->GetStringUTFChars(_path, 0);
+	if (path == NULL) {
+		return false;
+	}
+
+	bool ret = fio_kv_set_hot_keys(store, path, (uint32_t)_max_keys);
+	env->ReleaseStringUTFChars(_path, path);
+	return (jboolean)ret;
+}
+
+/**
+ * boolean fio_kv_prefetch_hot_keys(long store);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1prefetch_1hot_1keys
+	(JNIEnv *env, jclass cls, jlong _store)
+{
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)_store;
+	if (store == NULL) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return (jboolean)fio_kv_prefetch_hot_keys(store);
+}
+
 /**
  * Pool fio_kv_get_or_create_pool(Store store);
  */
@@ -373,14 +736,14 @@ JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1or_1c
 {
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
 	const char *tag = env->GetStringUTFChars(_tag, 0);
 
-	fio_kv_pool_t *pool = fio_kv_get_or_create_pool(store, tag);
+	fio_kv_pool_t *pool = fio_kv_get_or_create_pool(&store, tag);
 	jobject _pool = pool ? env->NewObject(_pool_cls, _pool_cstr, _store, pool->id, _tag) : NULL;
 
 	env->ReleaseStringUTFChars(_tag, tag);
-	free(store);
 	free(pool);
 	return _pool;
 }
@@ -393,22 +756,24 @@ JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1
 {
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
 	uint32_t count;
-	fio_kv_pool_t *pools = fio_kv_get_all_pools(store, &count);
+	fio_kv_pool_t *pools = fio_kv_get_all_pools(&store, &count);
 	if (pools == NULL) {
-		free(store);
 		return NULL;
 	}
 
 	jobjectArray _pools = env->NewObjectArray(count, _pool_cls, (jobject)NULL);
-	for (int i = 0 ; i < count ; i++) {
-		env->SetObjectArrayElement(_pools, (jsize)i,
-				env->NewObject(_pool_cls, _pool_cstr,
-					_store, (jint) (pools[i].id), env->NewStringUTF(pools[i].tag)));
+	for (uint32_t i = 0 ; i < count ; i++) {
+		jstring _tag = env->NewStringUTF(pools[i].tag);
+		jobject _pool = env->NewObject(_pool_cls, _pool_cstr,
+				_store, (jint) (pools[i].id), _tag);
+		env->SetObjectArrayElement(_pools, (jsize)i, _pool);
+		env->DeleteLocalRef(_pool);
+		env->DeleteLocalRef(_tag);
 	}
 
-	free(store);
 	free(pools);
 	return _pools;
 }
@@ -421,12 +786,10 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1p
 {
 	assert(_pool != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	bool ret = fio_kv_delete_pool(pool);
-
-	free(pool->store);
-	free(pool);
-	return (jboolean)ret;
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	return (jboolean)fio_kv_delete_pool(&pool);
 }
 
 /**
@@ -437,11 +800,9 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1a
 {
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
-	bool ret = fio_kv_delete_all_pools(store);
-
-	free(store);
-	return (jboolean)ret;
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
+	return (jboolean)fio_kv_delete_all_pools(&store);
 }
 
 /**
@@ -451,7 +812,7 @@ JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1alloc(
 		JNIEnv *env, jclass cls, jint _length)
 {
 	void *p = fio_kv_alloc((uint32_t)_length);
-	return p ? env->NewGlobalRef(env->NewDirectByteBuffer(p, _length)) : NULL;
+	return p ? env->NewDirectByteBuffer(p, _length) : NULL;
 }
 
 /**
@@ -462,13 +823,35 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1free_1value
 {
 	assert(_value != NULL);
 
-	fio_kv_value_t *value = __jobject_to_fio_kv_value(env, _value);
-	fio_kv_free_value(value);
-	env->DeleteGlobalRef(_value);
+	nvm_kv_key_info_t info;
+	fio_kv_value_t value;
+	__jobject_to_fio_kv_value(env, _value, &value, &info);
+	fio_kv_free_value(&value);
 	env->SetObjectField(_value, _value_field_data, NULL);
+}
+
+/**
+ * void fio_kv_use_hugepages(boolean enabled);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1use_1hugepages
+  (JNIEnv *env, jclass cls, jboolean _enabled)
+{
+	fio_kv_slab_use_hugepages(_enabled == JNI_TRUE);
+}
+
+/**
+ * AllocatorStats fio_kv_get_allocator_stats();
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1allocator_1stats
+  (JNIEnv *env, jclass cls)
+{
+	assert(env != NULL);
 
-	free(value->info);
-	free(value);
+	fio_kv_slab_stats_t stats;
+	fio_kv_slab_get_stats(&stats);
+	return env->NewObject(_allocatorstats_cls, _allocatorstats_cstr,
+			(jlong)stats.reserved, (jlong)stats.used,
+			(jlong)stats.segments, (jlong)stats.mappings);
 }
 
 /*
@@ -481,14 +864,15 @@ JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1value_1l
 	assert(_pool != NULL);
 	assert(_key != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
 
-	int ret = fio_kv_get_value_len(pool, key);
-
-	free(pool->store);
-	free(pool);
-	free(key);
+	int ret = fio_kv_get_value_len(&pool, &key);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_GET_VALUE_LEN, start);
 	return (jint)ret;
 }
 
@@ -502,18 +886,20 @@ JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1key_1
 	assert(_pool != NULL);
 	assert(_key != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
 
-	nvm_kv_key_info_t *info = fio_kv_get_key_info(pool, key);
+	nvm_kv_key_info_t *info = fio_kv_get_key_info(&pool, &key);
 	jobject _info = info != NULL
 		? __nvm_kv_key_info_to_jobject(env, info)
 		: NULL;
 
-	free(pool->store);
-	free(pool);
-	free(key);
 	free(info);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_GET_KEY_INFO, start);
 	return _info;
 }
 
@@ -523,11 +909,13 @@ JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1key_1
  *
  * This is a simple wrapper around a fio_kv_ function that manages the
  * conversion of the JNI objects into C structures, calls the fio_kv_
- * operation, frees the structures and returns the result of the operation.
+ * operation and returns the result of the operation. All the structures live
+ * on the stack for the duration of the call, which is recorded in the store's
+ * statistics as the given operation.
  */
 int __fio_kv_call_kv(JNIEnv *env, jobject _pool, jobject _key, jobject _value,
 		int (*op)(const fio_kv_pool_t *, const fio_kv_key_t *,
-			const fio_kv_value_t *))
+			const fio_kv_value_t *), const fio_kv_stats_op_t stats_op)
 {
 	assert(env != NULL);
 	assert(_pool != NULL);
@@ -535,20 +923,20 @@ int __fio_kv_call_kv(JNIEnv *env, jobject _pool, jobject _key, jobject _value,
 	assert(_value != NULL);
 	assert(op != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
-	fio_kv_value_t *value = __jobject_to_fio_kv_value(env, _value);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
+	__jobject_to_fio_kv_value(env, _value, &value, &info);
 
 	// Call the operation and reset the value info fields.
-	int ret = op(pool, key, value);
-	__kv_key_info_set_jobject(env, value->info,
-			env->GetObjectField(_value, _value_field_info));
-
-	free(pool->store);
-	free(pool);
-	free(key);
-	free(value->info);
-	free(value);
+	int ret = op(&pool, &key, &value);
+	__kv_value_info_set_jobject(env, &info, _value);
+	fio_kv_stats_record_jni(store.stats, stats_op, start);
 	return ret;
 }
 
@@ -558,7 +946,8 @@ int __fio_kv_call_kv(JNIEnv *env, jobject _pool, jobject _key, jobject _value,
 JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get
   (JNIEnv *env, jclass cls, jobject _pool, jobject _key, jobject _value)
 {
-	return (jint)__fio_kv_call_kv(env, _pool, _key, _value, fio_kv_get);
+	return (jint)__fio_kv_call_kv(env, _pool, _key, _value, fio_kv_get,
+			FIO_KV_STATS_GET);
 }
 
 /**
@@ -567,7 +956,8 @@ JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get
 JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1put
   (JNIEnv *env, jclass cls, jobject _pool, jobject _key, jobject _value)
 {
-	return (jint)__fio_kv_call_kv(env, _pool, _key, _value, fio_kv_put);
+	return (jint)__fio_kv_call_kv(env, _pool, _key, _value, fio_kv_put,
+			FIO_KV_STATS_PUT);
 }
 
 /**
@@ -580,18 +970,19 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1exists
 	assert(_pool != NULL);
 	assert(_key != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
-	nvm_kv_key_info_t *info = _info != NULL
-		? __jobject_to_nvm_kv_key_info(env, _info)
-		: NULL;
-
-	bool ret = fio_kv_exists(pool, key, info);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	nvm_kv_key_info_t info;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
+	if (_info != NULL) {
+		__jobject_to_nvm_kv_key_info(env, _info, &info);
+	}
 
-	free(pool->store);
-	free(pool);
-	free(key);
-	free(info);
+	bool ret = fio_kv_exists(&pool, &key, _info != NULL ? &info : NULL);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_EXISTS, start);
 	return (jboolean)ret;
 }
 
@@ -605,13 +996,15 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete
 	assert(_pool != NULL);
 	assert(_key != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
-	bool ret = fio_kv_delete(pool, key);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
 
-	free(pool->store);
-	free(pool);
-	free(key);
+	bool ret = fio_kv_delete(&pool, &key);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_DELETE, start);
 	return (jboolean)ret;
 }
 
@@ -624,59 +1017,298 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1a
 	assert(env != NULL);
 	assert(_store != NULL);
 
-	fio_kv_store_t *store = __jobject_to_fio_kv_store(env, _store);
-	bool ret = fio_kv_delete_all(store);
-
-	free(store);
-	return (jboolean)ret;
+	fio_kv_store_t store;
+	__jobject_to_fio_kv_store(env, _store, &store);
+	return (jboolean)fio_kv_delete_all(&store);
 }
 
 /**
  * boolean fio_kv_batch_put(Pool pool, Key[] keys, Value[] values);
+ *
+ * Batches of arbitrary size are written like with fio_kv_batch_put_count().
  */
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1put
   (JNIEnv *env, jclass cls, jobject _pool, jobjectArray _keys, jobjectArray _values)
+{
+	assert(env != NULL);
+	assert(_keys != NULL);
+
+	jint written = Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1put_1count(
+			env, cls, _pool, _keys, _values);
+	return (jboolean)(written == env->GetArrayLength(_keys));
+}
+
+/**
+ * int fio_kv_batch_put_count(Pool pool, Key[] keys, Value[] values);
+ *
+ * Batches of arbitrary size are marshalled and written in windows of
+ * FIO_KV_MAX_BATCH_SIZE pairs. Returns the number of pairs written; if it is
+ * lower than the batch size, the sub-batch starting at that position failed.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1put_1count
+  (JNIEnv *env, jclass cls, jobject _pool, jobjectArray _keys, jobjectArray _values)
 {
 	assert(env != NULL);
 	assert(_pool != NULL);
 	assert(_keys != NULL);
 	assert(_values != NULL);
 
+	uint64_t start = fio_kv_stats_begin();
 	int count = env->GetArrayLength(_keys);
+	int done = 0;
+
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t keys[FIO_KV_MAX_BATCH_SIZE];
+	fio_kv_value_t values[FIO_KV_MAX_BATCH_SIZE];
+	nvm_kv_key_info_t infos[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_key_t *pkeys[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_value_t *pvalues[FIO_KV_MAX_BATCH_SIZE];
+	jobject _window[FIO_KV_MAX_BATCH_SIZE];
+
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	while (done < count) {
+		int chunk = count - done;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		// The window's local references are held in their own frame, which
+		// is popped once the info structures have been written back.
+		if (env->PushLocalFrame(2 * chunk + 4) != 0) {
+			break;
+		}
+
+		for (int i=0; i<chunk; i++) {
+			jobject _key = env->GetObjectArrayElement(_keys, done+i);
+			_window[i] = env->GetObjectArrayElement(_values, done+i);
+			__jobject_to_fio_kv_key(env, _key, &keys[i]);
+			__jobject_to_fio_kv_value(env, _window[i], &values[i], &infos[i]);
+			env->DeleteLocalRef(_key);
+
+			pkeys[i] = &keys[i];
+			pvalues[i] = &values[i];
+		}
+
+		// Call the batch operation on this window of keys and values.
+		int written = (int)fio_kv_batch_put_count(&pool, pkeys, pvalues,
+				chunk);
+
+		for (int i=0; i<written; i++) {
+			__kv_value_info_set_jobject(env, &infos[i], _window[i]);
+		}
+		env->PopLocalFrame(NULL);
+
+		done += written;
+		if (written < chunk) {
+			break;
+		}
+	}
+
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_BATCH_PUT, start);
+	return (jint)done;
+}
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t **keys = (fio_kv_key_t **)calloc(count, sizeof(fio_kv_key_t *));
-	fio_kv_value_t **values = (fio_kv_value_t **)calloc(count, sizeof(fio_kv_value_t *));
+/**
+ * Read a window of at most FIO_KV_MAX_BATCH_SIZE keys from a batch get.
+ *
+ * Values are allocated on the native side, a sector larger than the pool's
+ * size hint, and read in one batch operation. A missing key fails its whole
+ * device batch: the keys the batch didn't get to are then checked with
+ * fio_kv_batch_exists(), which consults the pool's Bloom filter first, and
+ * those that exist are read in a second batch. Only the values that didn't
+ * fit in their buffer, and those neither batch could read, are read again on
+ * their own. The resulting Value objects are stored in the given array, at
+ * the position of their key; keys that don't exist are left with a null
+ * entry. Returns false only if memory could not be allocated.
+ */
+bool __fio_kv_batch_get_window(JNIEnv *env, fio_kv_pool_t *pool,
+		const fio_kv_key_t *keys, jobjectArray _values, const int offset,
+		const int count)
+{
+	assert(count <= FIO_KV_MAX_BATCH_SIZE);
+
+	fio_kv_value_t values[FIO_KV_MAX_BATCH_SIZE];
+	nvm_kv_key_info_t infos[FIO_KV_MAX_BATCH_SIZE];
+	uint32_t capacities[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_key_t *pkeys[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_value_t *pvalues[FIO_KV_MAX_BATCH_SIZE];
+	bool ret = true;
+
+	// One spare sector tells values read in full apart from truncated ones.
+	uint32_t capacity = pool->size_hint + FIO_SECTOR_ALIGNMENT;
+	if (capacity > NVM_KV_MAX_VALUE_SIZE) {
+		capacity = NVM_KV_MAX_VALUE_SIZE;
+	}
 
+	memset(values, 0, sizeof(values));
 	for (int i=0; i<count; i++) {
-		keys[i] = __jobject_to_fio_kv_key(env,
-				env->GetObjectArrayElement(_keys, i));
-		values[i] = __jobject_to_fio_kv_value(env,
-				env->GetObjectArrayElement(_values, i));
+		values[i].info = &infos[i];
+		memset(&infos[i], 0, sizeof(nvm_kv_key_info_t));
+		infos[i].value_len = capacities[i] = capacity;
+		values[i].data = fio_kv_alloc(capacity);
+		if (values[i].data == NULL) {
+			ret = false;
+			break;
+		}
+
+		pkeys[i] = &keys[i];
+		pvalues[i] = &values[i];
 	}
 
-	// Call the batch operation on the sets of keys and values.
-	bool ret = fio_kv_batch_put(pool,
-			(const fio_kv_key_t **)keys,
-			(const fio_kv_value_t **)values,
-			count);
+	int done = ret
+		? (int)fio_kv_batch_get_count(pool, pkeys, pvalues, count)
+		: 0;
 
+	bool fetched[FIO_KV_MAX_BATCH_SIZE];
+	bool missing[FIO_KV_MAX_BATCH_SIZE];
 	for (int i=0; i<count; i++) {
-		__kv_key_info_set_jobject(env, values[i]->info,
-				env->GetObjectField(
-					env->GetObjectArrayElement(_values, i),
-					_value_field_info));
+		fetched[i] = i < done;
+		missing[i] = false;
+	}
 
-		free(keys[i]);
-		free(values[i]->info);
-		free(values[i]);
+	if (ret && done < count) {
+		uint8_t bitmap[(FIO_KV_MAX_BATCH_SIZE + 7) / 8];
+		fio_kv_batch_exists(pool, pkeys + done, count - done, bitmap);
+
+		int index[FIO_KV_MAX_BATCH_SIZE];
+		int found = 0;
+		for (int i=done; i<count; i++) {
+			int bit = i - done;
+			if (!(bitmap[bit / 8] & (1 << (bit % 8)))) {
+				missing[i] = true;
+				continue;
+			}
+
+			infos[i].value_len = capacities[i];
+			pkeys[found] = &keys[i];
+			pvalues[found] = &values[i];
+			index[found] = i;
+			found++;
+		}
+
+		int reread = found > 0
+			? (int)fio_kv_batch_get_count(pool, pkeys, pvalues, found)
+			: 0;
+		for (int j=0; j<reread; j++) {
+			fetched[index[j]] = true;
+		}
 	}
 
-	free(pool->store);
-	free(pool);
-	free(keys);
-	free(values);
-	return (jboolean)ret;
+	for (int i=0; ret && i<count; i++) {
+		if (missing[i]) {
+			continue;
+		}
+
+		if (!fetched[i] || infos[i].value_len >= capacities[i]) {
+			fio_kv_free_value(&values[i]);
+			if (fio_kv_get_alloc(pool, &keys[i], &values[i],
+					&capacities[i]) < 0) {
+				continue;
+			}
+
+			infos[i].pool_id = pool->id;
+			infos[i].key_len = keys[i].length;
+		}
+
+		jobject _value = __fio_kv_value_to_jobject(env, &values[i],
+				capacities[i]);
+		if (_value == NULL) {
+			ret = false;
+			break;
+		}
+
+		env->SetObjectArrayElement(_values, offset+i, _value);
+		env->DeleteLocalRef(_value);
+		values[i].data = NULL;
+	}
+
+	// Release the values that were not handed over to a Value object.
+	for (int i=0; i<count; i++) {
+		if (values[i].data != NULL) {
+			fio_kv_free_value(&values[i]);
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Release the memory of the values of a failed batch get, and the array
+ * holding them.
+ */
+void __fio_kv_batch_get_release(JNIEnv *env, jobjectArray _values,
+		const int count)
+{
+	for (int i=0; i<count; i++) {
+		jobject _value = env->GetObjectArrayElement(_values, i);
+		if (_value != NULL) {
+			fio_kv_value_t value;
+			nvm_kv_key_info_t info;
+			__jobject_to_fio_kv_value(env, _value, &value, &info);
+			fio_kv_free_value(&value);
+			env->DeleteLocalRef(_value);
+		}
+	}
+
+	env->DeleteLocalRef(_values);
+}
+
+/**
+ * Value[] fio_kv_batch_get(Pool pool, Key[] keys);
+ *
+ * Batches of arbitrary size are read in windows of FIO_KV_MAX_BATCH_SIZE
+ * keys, each window being one device batch operation. The returned array
+ * contains a null entry for each key that doesn't exist or couldn't be read.
+ * Returns null if the values could not be allocated, after releasing the
+ * values already read.
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1get
+  (JNIEnv *env, jclass cls, jobject _pool, jobjectArray _keys)
+{
+	assert(env != NULL);
+	assert(_pool != NULL);
+	assert(_keys != NULL);
+
+	uint64_t start = fio_kv_stats_begin();
+	int count = env->GetArrayLength(_keys);
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	bool ret = true;
+
+	jobjectArray _values = env->NewObjectArray(count, _value_cls,
+			(jobject)NULL);
+	if (_values == NULL) {
+		return NULL;
+	}
+
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	for (int offset=0; ret && offset<count; offset+=FIO_KV_MAX_BATCH_SIZE) {
+		fio_kv_key_t keys[FIO_KV_MAX_BATCH_SIZE];
+		int chunk = count - offset;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		for (int i=0; i<chunk; i++) {
+			jobject _key = env->GetObjectArrayElement(_keys, offset+i);
+			__jobject_to_fio_kv_key(env, _key, &keys[i]);
+			env->DeleteLocalRef(_key);
+		}
+
+		ret = __fio_kv_batch_get_window(env, &pool, keys, _values,
+				offset, chunk);
+	}
+
+	if (ret) {
+		fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_BATCH_GET, start);
+		return _values;
+	}
+
+	// Release the memory of the values read before the failure.
+	__fio_kv_batch_get_release(env, _values, count);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_BATCH_GET, start);
+	return NULL;
 }
 
 /**
@@ -687,11 +1319,10 @@ JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1iterator
 {
 	assert(_pool != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	int iterator = fio_kv_iterator(pool);
-	free(pool->store);
-	free(pool);
-	return (jint)iterator;
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	return (jint)fio_kv_iterator(&pool);
 }
 
 /**
@@ -702,10 +1333,13 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1next
 {
 	assert(_pool != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	bool ret = fio_kv_next(pool, (int)_iterator);
-	free(pool->store);
-	free(pool);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+
+	bool ret = fio_kv_next(&pool, (int)_iterator);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_ITERATE, start);
 	return (jboolean)ret;
 }
 
@@ -719,21 +1353,21 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1curr
 	assert(_key != NULL);
 	assert(_value != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	fio_kv_key_t *key = __jobject_to_fio_kv_key(env, _key);
-	fio_kv_value_t *value = __jobject_to_fio_kv_value(env, _value);
-
-	bool ret = fio_kv_get_current(pool, (int)_iterator, key, value);
-
-	env->SetIntField(_key, _key_field_length, key->length);
-	__kv_key_info_set_jobject(env, value->info,
-		env->GetObjectField(_value, _value_field_info));
-
-	free(pool->store);
-	free(pool);
-	free(key);
-	free(value->info);
-	free(value);
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	__jobject_to_fio_kv_key(env, _key, &key);
+	__jobject_to_fio_kv_value(env, _value, &value, &info);
+
+	bool ret = fio_kv_get_current(&pool, (int)_iterator, &key, &value);
+
+	env->SetIntField(_key, _key_field_length, key.length);
+	__kv_value_info_set_jobject(env, &info, _value);
+	fio_kv_stats_record_jni(store.stats, FIO_KV_STATS_ITERATE, start);
 	return (jboolean)ret;
 }
 
@@ -745,18 +1379,1905 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1end_1iter
 {
 	assert(_pool != NULL);
 
-	fio_kv_pool_t *pool = __jobject_to_fio_kv_pool(env, _pool);
-	bool ret = fio_kv_end_iteration(pool, (int)_iterator);
-	free(pool->store);
-	free(pool);
-	return (jboolean)ret;
+	fio_kv_store_t store;
+	fio_kv_pool_t pool;
+	__jobject_to_fio_kv_pool(env, _pool, &pool, &store);
+	return (jboolean)fio_kv_end_iteration(&pool, (int)_iterator);
 }
 
 /**
  * int fio_kv_get_last_error();
  */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1last_1error
+  (void)
+{
+	return (jint)fio_kv_get_last_error();
+}
+
 JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1last_1error
   (JNIEnv *env, jclass cls)
 {
-	return (jint)fio_kv_get_last_error();
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1last_1error();
+}
+
+/**
+ * void fio_kv_release_store_handle(long store);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1release_1store_1handle
+  (JNIEnv *env, jclass cls, jlong _store)
+{
+	free((void *)(intptr_t)_store);
+}
+
+/**
+ * long fio_kv_pool_handle(Pool pool);
+ *
+ * Allocate a long-lived fio_kv_pool_t structure describing the given pool,
+ * for use with the handle-based fio_kv_fast_* entry points. The returned
+ * handle points to the native store handle of the pool's store and must be
+ * released with fio_kv_release_pool_handle().
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1pool_1handle
+  (JNIEnv *env, jclass cls, jobject _pool)
+{
+	assert(env != NULL);
+	assert(_pool != NULL);
+
+	jobject _store = env->GetObjectField(_pool, _pool_field_store);
+	fio_kv_store_t *store = (fio_kv_store_t *)(intptr_t)
+		env->GetLongField(_store, _store_field_handle);
+	env->DeleteLocalRef(_store);
+	if (store == NULL) {
+		return 0;
+	}
+
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)malloc(sizeof(fio_kv_pool_t));
+	if (pool == NULL) {
+		return 0;
+	}
+
+	pool->store = store;
+	pool->id = env->GetIntField(_pool, _pool_field_id);
+	pool->tag[0] = '\0';
+	pool->size_hint = FIO_KV_DEFAULT_SIZE_HINT;
+
+	jstring _tag = (jstring)env->GetObjectField(_pool, _pool_field_tag);
+	if (_tag != NULL) {
+		const char *tag = env->GetStringUTFChars(_tag, 0);
+		strncpy(pool->tag, tag, FIO_TAG_MAX_LENGTH - 1);
+		pool->tag[FIO_TAG_MAX_LENGTH - 1] = '\0';
+		env->ReleaseStringUTFChars(_tag, tag);
+		env->DeleteLocalRef(_tag);
+	}
+
+	return (jlong)(intptr_t)pool;
+}
+
+/**
+ * void fio_kv_release_pool_handle(long pool);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1release_1pool_1handle
+  (JNIEnv *env, jclass cls, jlong _pool)
+{
+	free((void *)(intptr_t)_pool);
+}
+
+/**
+ * long fio_kv_address(ByteBuffer buffer);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1address
+  (JNIEnv *env, jclass cls, jobject _buffer)
+{
+	assert(_buffer != NULL);
+
+	return (jlong)(intptr_t)env->GetDirectBufferAddress(_buffer);
+}
+
+/**
+ * Populate a fio_kv_key_t structure from a raw key buffer address and
+ * length, as cached by Key objects.
+ */
+void __address_to_fio_kv_key(jlong _key, jint _key_len, fio_kv_key_t *key)
+{
+	assert(_key != 0);
+	assert(key != NULL);
+
+	key->length = (uint32_t)_key_len;
+	key->bytes = (nvm_kv_key_t *)(intptr_t)_key;
+}
+
+/**
+ * int fio_kv_fast_get_value_len(long pool, long key, int keyLength);
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1value_1len
+  (jlong _pool, jlong _key, jint _key_len)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return (jint)fio_kv_get_value_len((fio_kv_pool_t *)(intptr_t)_pool, &key);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1value_1len
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1value_1len(
+			_pool, _key, _key_len);
+}
+
+/**
+ * int fio_kv_fast_get(long pool, long key, int keyLength, long value,
+ *	int valueLength);
+ *
+ * Returns the number of bytes read, or -1 if the read failed.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get
+  (jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len)
+{
+	assert(_pool != 0);
+	assert(_value != 0);
+
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+
+	memset(&info, 0, sizeof(info));
+	info.value_len = (uint32_t)_value_len;
+	value.data = (void *)(intptr_t)_value;
+	value.info = &info;
+
+	return (jint)fio_kv_get((fio_kv_pool_t *)(intptr_t)_pool, &key, &value);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get(
+			_pool, _key, _key_len, _value, _value_len);
+}
+
+/**
+ * Value fio_kv_fast_get_alloc(long pool, long key, int keyLength);
+ *
+ * Reads a key/value pair into a natively allocated value sized from the
+ * pool's size hint, in a single device read when the value fits. Returns the
+ * filled-in Value, or null in case of an error.
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1alloc
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	uint32_t capacity;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+
+	value.info = &info;
+	if (fio_kv_get_alloc(pool, &key, &value, &capacity) < 0) {
+		fio_kv_stats_record_jni(pool->store->stats, FIO_KV_STATS_GET, start);
+		return NULL;
+	}
+
+	info.pool_id = pool->id;
+	info.key_len = key.length;
+
+	jobject _value = __fio_kv_value_to_jobject(env, &value, capacity);
+	if (_value == NULL) {
+		fio_kv_free_value(&value);
+	}
+
+	fio_kv_stats_record_jni(pool->store->stats, FIO_KV_STATS_GET, start);
+	return _value;
+}
+
+/**
+ * int fio_kv_fast_put(long pool, long key, int keyLength, long value,
+ *	int valueLength, int expiry, int genCount);
+ *
+ * Returns the number of bytes written, or -1 in case of an error.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put
+  (jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry, jint _gen_count)
+{
+	assert(_pool != 0);
+	assert(_value != 0);
+
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+
+	memset(&info, 0, sizeof(info));
+	info.key_len = (uint32_t)_key_len;
+	info.value_len = (uint32_t)_value_len;
+	info.expiry = (uint32_t)_expiry;
+	info.gen_count = (uint32_t)_gen_count;
+	value.data = (void *)(intptr_t)_value;
+	value.info = &info;
+
+	return (jint)fio_kv_put((fio_kv_pool_t *)(intptr_t)_pool, &key, &value);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry, jint _gen_count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put(
+			_pool, _key, _key_len, _value, _value_len, _expiry, _gen_count);
+}
+
+/**
+ * boolean fio_kv_fast_exists(long pool, long key, int keyLength);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists
+  (jlong _pool, jlong _key, jint _key_len)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return (jboolean)fio_kv_exists((fio_kv_pool_t *)(intptr_t)_pool, &key, NULL);
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists(
+			_pool, _key, _key_len);
+}
+
+/**
+ * boolean fio_kv_fast_delete(long pool, long key, int keyLength);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete
+  (jlong _pool, jlong _key, jint _key_len)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return (jboolean)fio_kv_delete((fio_kv_pool_t *)(intptr_t)_pool, &key);
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete(
+			_pool, _key, _key_len);
+}
+
+/**
+ * Populate a fio_kv_value_t structure, and its info structure, from a raw
+ * value buffer address and length, as cached by Value objects.
+ */
+void __address_to_fio_kv_value(jlong _value, jint _value_len, jint _expiry,
+		fio_kv_value_t *value, nvm_kv_key_info_t *info)
+{
+	assert(_value != 0);
+	assert(value != NULL);
+	assert(info != NULL);
+
+	memset(info, 0, sizeof(nvm_kv_key_info_t));
+	info->value_len = (uint32_t)_value_len;
+	info->expiry = (uint32_t)_expiry;
+	value->data = (void *)(intptr_t)_value;
+	value->info = info;
+}
+
+/**
+ * int fio_kv_fast_compare_and_put(long pool, long key, int keyLength,
+ *     long value, int valueLength, int expiry, int genCount);
+ *
+ * Returns 1 if the pair was replaced, 0 if it doesn't exist or if its
+ * generation count didn't match, or -1 if an error occurred.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1compare_1and_1put
+  (jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry, jint _gen_count)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	__address_to_fio_kv_value(_value, _value_len, _expiry, &value, &info);
+
+	if (fio_kv_compare_and_put((fio_kv_pool_t *)(intptr_t)_pool, &key,
+				&value, (uint32_t)_gen_count) >= 0) {
+		return 1;
+	}
+
+	return errno == ECANCELED ? 0 : -1;
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1compare_1and_1put
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry, jint _gen_count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1compare_1and_1put(
+			_pool, _key, _key_len, _value, _value_len, _expiry, _gen_count);
+}
+
+/**
+ * int fio_kv_fast_put_if_absent(long pool, long key, int keyLength,
+ *     long value, int valueLength, int expiry);
+ *
+ * Returns 1 if the pair was inserted, 0 if the key already exists, or -1 if
+ * an error occurred.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1if_1absent
+  (jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	__address_to_fio_kv_value(_value, _value_len, _expiry, &value, &info);
+
+	if (fio_kv_put_if_absent((fio_kv_pool_t *)(intptr_t)_pool, &key,
+				&value) >= 0) {
+		return 1;
+	}
+
+	return errno == EEXIST ? 0 : -1;
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1if_1absent
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1if_1absent(
+			_pool, _key, _key_len, _value, _value_len, _expiry);
+}
+
+/**
+ * boolean fio_kv_fast_increment(long pool, long key, int keyLength,
+ *     long delta, int expiry, long[] result);
+ *
+ * The new value of the counter is stored in the given array.
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1increment
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _delta, jint _expiry, jlongArray _result)
+{
+	assert(_pool != 0);
+	assert(_result != NULL);
+
+	fio_kv_key_t key;
+	int64_t result;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+
+	if (!fio_kv_increment((fio_kv_pool_t *)(intptr_t)_pool, &key,
+				(int64_t)_delta, (uint32_t)_expiry, &result)) {
+		return false;
+	}
+
+	jlong _counter = (jlong)result;
+	env->SetLongArrayRegion(_result, 0, 1, &_counter);
+	return true;
+}
+
+/**
+ * int fio_kv_fast_append(long pool, long key, int keyLength, long data,
+ *     int length, int expiry);
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1append
+  (jlong _pool, jlong _key, jint _key_len,
+   jlong _data, jint _length, jint _expiry)
+{
+	assert(_pool != 0);
+	assert(_data != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return (jint)fio_kv_append((fio_kv_pool_t *)(intptr_t)_pool, &key,
+			(const void *)(intptr_t)_data, (uint32_t)_length,
+			(uint32_t)_expiry);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1append
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _data, jint _length, jint _expiry)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1append(
+			_pool, _key, _key_len, _data, _length, _expiry);
+}
+
+/**
+ * int fio_kv_fast_batch_put(long pool, long buffer, int size, int count);
+ *
+ * Writes the key/value pairs packed in the given buffer. Returns the number
+ * of pairs written; if it is lower than count, the sub-batch starting at that
+ * position failed.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put
+  (jlong _pool, jlong _buffer, jint _size,
+   jint _count)
+{
+	assert(_pool != 0);
+	assert(_buffer != 0);
+
+	if (_size < 0 || _count < 0) {
+		return 0;
+	}
+
+	return (jint)fio_kv_batch_put_packed((fio_kv_pool_t *)(intptr_t)_pool,
+			(void *)(intptr_t)_buffer, (uint32_t)_size, (uint32_t)_count);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _buffer, jint _size,
+   jint _count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put(
+			_pool, _buffer, _size, _count);
+}
+
+/**
+ * Marshal an array of Key objects into an array of fio_kv_key_t structures
+ * and an array of pointers to them, both allocated with malloc().
+ *
+ * Returns false, with errno set to ENOMEM, if they could not be allocated.
+ */
+bool __jobjectArray_to_fio_kv_keys(JNIEnv *env, jobjectArray _keys,
+		const jsize count, fio_kv_key_t **keys, const fio_kv_key_t ***pkeys)
+{
+	*keys = (fio_kv_key_t *)malloc(count * sizeof(fio_kv_key_t));
+	*pkeys = (const fio_kv_key_t **)malloc(count * sizeof(fio_kv_key_t *));
+	if (*keys == NULL || *pkeys == NULL) {
+		free(*keys);
+		free(*pkeys);
+		errno = ENOMEM;
+		return false;
+	}
+
+	for (jsize i=0; i<count; i++) {
+		jobject _key = env->GetObjectArrayElement(_keys, i);
+		__jobject_to_fio_kv_key(env, _key, &(*keys)[i]);
+		env->DeleteLocalRef(_key);
+		(*pkeys)[i] = &(*keys)[i];
+	}
+
+	return true;
+}
+
+/**
+ * int fio_kv_fast_batch_delete(long pool, Key[] keys);
+ *
+ * Returns the number of keys processed; if it is lower than the batch size,
+ * the removal of the key at that position failed. Returns -1 if the batch
+ * could not be marshalled.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1delete
+  (JNIEnv *env, jclass cls, jlong _pool, jobjectArray _keys)
+{
+	assert(_pool != 0);
+	assert(_keys != NULL);
+
+	jsize count = env->GetArrayLength(_keys);
+	fio_kv_key_t *keys;
+	const fio_kv_key_t **pkeys;
+	if (!__jobjectArray_to_fio_kv_keys(env, _keys, count, &keys, &pkeys)) {
+		return -1;
+	}
+
+	size_t done = fio_kv_batch_delete((fio_kv_pool_t *)(intptr_t)_pool,
+			pkeys, (size_t)count);
+	free(pkeys);
+	free(keys);
+	return (jint)done;
+}
+
+/**
+ * int fio_kv_fast_batch_exists(long pool, Key[] keys, byte[] bitmap);
+ *
+ * Fills the given bitmap, of at least (keys.length + 7) / 8 bytes, with the
+ * existence of each key. Returns the number of keys that exist, or -1 if the
+ * batch could not be marshalled.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1exists
+  (JNIEnv *env, jclass cls, jlong _pool, jobjectArray _keys,
+   jbyteArray _bitmap)
+{
+	assert(_pool != 0);
+	assert(_keys != NULL);
+	assert(_bitmap != NULL);
+
+	jsize count = env->GetArrayLength(_keys);
+	if (env->GetArrayLength(_bitmap) < (count + 7) / 8) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fio_kv_key_t *keys;
+	const fio_kv_key_t **pkeys;
+	if (!__jobjectArray_to_fio_kv_keys(env, _keys, count, &keys, &pkeys)) {
+		return -1;
+	}
+
+	jint found = -1;
+	jsize size = (count + 7) / 8;
+	uint8_t *bitmap = (uint8_t *)calloc(size > 0 ? size : 1, 1);
+	if (bitmap != NULL) {
+		found = (jint)fio_kv_batch_exists((fio_kv_pool_t *)(intptr_t)_pool,
+				pkeys, (size_t)count, bitmap);
+		env->SetByteArrayRegion(_bitmap, 0, size, (const jbyte *)bitmap);
+		free(bitmap);
+	} else {
+		errno = ENOMEM;
+	}
+
+	free(pkeys);
+	free(keys);
+	return found;
+}
+
+/*
+ * Long key fast path.
+ *
+ * These entry points take 8-byte keys as long IDs, laid out in native byte
+ * order like the keys of Key.createFrom(long). The keys are built on the
+ * native stack, or in a native copy of the IDs array for batches, so no Key
+ * object or direct buffer is needed.
+ */
+
+/**
+ * Populate fio_kv_key_t structures from an array of long IDs.
+ */
+void __ids_to_fio_kv_keys(const jlong *ids, const int count,
+		fio_kv_key_t *keys)
+{
+	for (int i=0; i<count; i++) {
+		keys[i].length = sizeof(jlong);
+		keys[i].bytes = (nvm_kv_key_t *)&ids[i];
+	}
+}
+
+/**
+ * Copy an array of long IDs and build the fio_kv_key_t structures, and the
+ * array of pointers to them, of the keys they hold. All three arrays are
+ * allocated with malloc().
+ *
+ * Returns false, with errno set to ENOMEM, if they could not be allocated.
+ */
+bool __jlongArray_to_fio_kv_keys(JNIEnv *env, jlongArray _ids,
+		const jsize count, jlong **ids, fio_kv_key_t **keys,
+		const fio_kv_key_t ***pkeys)
+{
+	size_t n = count > 0 ? count : 1;
+	*ids = (jlong *)malloc(n * sizeof(jlong));
+	*keys = (fio_kv_key_t *)malloc(n * sizeof(fio_kv_key_t));
+	*pkeys = (const fio_kv_key_t **)malloc(n * sizeof(fio_kv_key_t *));
+	if (*ids == NULL || *keys == NULL || *pkeys == NULL) {
+		free(*ids);
+		free(*keys);
+		free(*pkeys);
+		errno = ENOMEM;
+		return false;
+	}
+
+	env->GetLongArrayRegion(_ids, 0, count, *ids);
+	__ids_to_fio_kv_keys(*ids, count, *keys);
+	for (jsize i=0; i<count; i++) {
+		(*pkeys)[i] = &(*keys)[i];
+	}
+
+	return true;
+}
+
+/**
+ * int fio_kv_fast_get_long(long pool, long id, long value, int valueLength);
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long
+  (jlong _pool, jlong _id, jlong _value, jint _value_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get(
+			_pool, (jlong)(intptr_t)&_id, sizeof(_id), _value, _value_len);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _id, jlong _value,
+   jint _value_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long(
+			_pool, _id, _value, _value_len);
+}
+
+/**
+ * Value fio_kv_fast_get_long_alloc(long pool, long id);
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long_1alloc
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _id)
+{
+	return Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1alloc(
+			env, cls, _pool, (jlong)(intptr_t)&_id, sizeof(_id));
+}
+
+/**
+ * int fio_kv_fast_put_long(long pool, long id, long value, int valueLength,
+ *	int expiry, int genCount);
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1long
+  (jlong _pool, jlong _id, jlong _value, jint _value_len, jint _expiry,
+   jint _gen_count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put(
+			_pool, (jlong)(intptr_t)&_id, sizeof(_id), _value, _value_len,
+			_expiry, _gen_count);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _id, jlong _value,
+   jint _value_len, jint _expiry, jint _gen_count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1long(
+			_pool, _id, _value, _value_len, _expiry, _gen_count);
+}
+
+/**
+ * boolean fio_kv_fast_exists_long(long pool, long id);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists_1long
+  (jlong _pool, jlong _id)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists(
+			_pool, (jlong)(intptr_t)&_id, sizeof(_id));
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _id)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists_1long(
+			_pool, _id);
+}
+
+/**
+ * boolean fio_kv_fast_delete_long(long pool, long id);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1long
+  (jlong _pool, jlong _id)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete(
+			_pool, (jlong)(intptr_t)&_id, sizeof(_id));
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _id)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1long(
+			_pool, _id);
+}
+
+/**
+ * int fio_kv_fast_batch_put_long(long pool, long[] ids, Value[] values);
+ *
+ * Batches of arbitrary size are marshalled and written in windows of
+ * FIO_KV_MAX_BATCH_SIZE pairs. Returns the number of pairs written; if it is
+ * lower than the batch size, the sub-batch starting at that position failed.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlongArray _ids, jobjectArray _values)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+	assert(_ids != NULL);
+	assert(_values != NULL);
+
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	int count = env->GetArrayLength(_ids);
+	int done = 0;
+
+	jlong ids[FIO_KV_MAX_BATCH_SIZE];
+	fio_kv_key_t keys[FIO_KV_MAX_BATCH_SIZE];
+	fio_kv_value_t values[FIO_KV_MAX_BATCH_SIZE];
+	nvm_kv_key_info_t infos[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_key_t *pkeys[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_value_t *pvalues[FIO_KV_MAX_BATCH_SIZE];
+	jobject _window[FIO_KV_MAX_BATCH_SIZE];
+
+	while (done < count) {
+		int chunk = count - done;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		if (env->PushLocalFrame(chunk + 4) != 0) {
+			break;
+		}
+
+		env->GetLongArrayRegion(_ids, done, chunk, ids);
+		__ids_to_fio_kv_keys(ids, chunk, keys);
+		for (int i=0; i<chunk; i++) {
+			_window[i] = env->GetObjectArrayElement(_values, done+i);
+			__jobject_to_fio_kv_value(env, _window[i], &values[i], &infos[i]);
+			pkeys[i] = &keys[i];
+			pvalues[i] = &values[i];
+		}
+
+		int written = (int)fio_kv_batch_put_count(pool, pkeys, pvalues,
+				chunk);
+
+		for (int i=0; i<written; i++) {
+			__kv_value_info_set_jobject(env, &infos[i], _window[i]);
+		}
+		env->PopLocalFrame(NULL);
+
+		done += written;
+		if (written < chunk) {
+			break;
+		}
+	}
+
+	fio_kv_stats_record_jni(pool->store->stats, FIO_KV_STATS_BATCH_PUT, start);
+	return (jint)done;
+}
+
+/**
+ * Value[] fio_kv_fast_batch_get_long(long pool, long[] ids);
+ *
+ * Batches of arbitrary size are read in windows of FIO_KV_MAX_BATCH_SIZE
+ * keys, like with fio_kv_batch_get(). The returned array contains a null
+ * entry for each key that doesn't exist or couldn't be read. Returns null if
+ * the values could not be allocated, after releasing the values already
+ * read.
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1get_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlongArray _ids)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+	assert(_ids != NULL);
+
+	uint64_t start = fio_kv_stats_begin();
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	int count = env->GetArrayLength(_ids);
+	bool ret = true;
+
+	jobjectArray _values = env->NewObjectArray(count, _value_cls,
+			(jobject)NULL);
+	if (_values == NULL) {
+		return NULL;
+	}
+
+	for (int offset=0; ret && offset<count; offset+=FIO_KV_MAX_BATCH_SIZE) {
+		jlong ids[FIO_KV_MAX_BATCH_SIZE];
+		fio_kv_key_t keys[FIO_KV_MAX_BATCH_SIZE];
+		int chunk = count - offset;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		env->GetLongArrayRegion(_ids, offset, chunk, ids);
+		__ids_to_fio_kv_keys(ids, chunk, keys);
+		ret = __fio_kv_batch_get_window(env, pool, keys, _values,
+				offset, chunk);
+	}
+
+	fio_kv_stats_record_jni(pool->store->stats, FIO_KV_STATS_BATCH_GET,
+			start);
+	if (ret) {
+		return _values;
+	}
+
+	__fio_kv_batch_get_release(env, _values, count);
+	return NULL;
+}
+
+/**
+ * int fio_kv_fast_batch_delete_long(long pool, long[] ids);
+ *
+ * Returns the number of keys processed, or -1 if the batch could not be
+ * marshalled, like fio_kv_fast_batch_delete().
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1delete_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlongArray _ids)
+{
+	assert(_pool != 0);
+	assert(_ids != NULL);
+
+	jsize count = env->GetArrayLength(_ids);
+	jlong *ids;
+	fio_kv_key_t *keys;
+	const fio_kv_key_t **pkeys;
+	if (!__jlongArray_to_fio_kv_keys(env, _ids, count, &ids, &keys, &pkeys)) {
+		return -1;
+	}
+
+	size_t done = fio_kv_batch_delete((fio_kv_pool_t *)(intptr_t)_pool,
+			pkeys, (size_t)count);
+	free(pkeys);
+	free(keys);
+	free(ids);
+	return (jint)done;
+}
+
+/**
+ * int fio_kv_fast_batch_exists_long(long pool, long[] ids, byte[] bitmap);
+ *
+ * Fills the given bitmap with the existence of each key, like
+ * fio_kv_fast_batch_exists(). Returns the number of keys that exist, or -1
+ * if the batch could not be marshalled.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1exists_1long
+  (JNIEnv *env, jclass cls, jlong _pool, jlongArray _ids,
+   jbyteArray _bitmap)
+{
+	assert(_pool != 0);
+	assert(_ids != NULL);
+	assert(_bitmap != NULL);
+
+	jsize count = env->GetArrayLength(_ids);
+	jsize size = (count + 7) / 8;
+	if (env->GetArrayLength(_bitmap) < size) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	jlong *ids;
+	fio_kv_key_t *keys;
+	const fio_kv_key_t **pkeys;
+	if (!__jlongArray_to_fio_kv_keys(env, _ids, count, &ids, &keys, &pkeys)) {
+		return -1;
+	}
+
+	jint found = -1;
+	uint8_t *bitmap = (uint8_t *)calloc(size > 0 ? size : 1, 1);
+	if (bitmap != NULL) {
+		found = (jint)fio_kv_batch_exists((fio_kv_pool_t *)(intptr_t)_pool,
+				pkeys, (size_t)count, bitmap);
+		env->SetByteArrayRegion(_bitmap, 0, size, (const jbyte *)bitmap);
+		free(bitmap);
+	} else {
+		errno = ENOMEM;
+	}
+
+	free(pkeys);
+	free(keys);
+	free(ids);
+	return found;
+}
+
+/* Asynchronous I/O engine. */
+
+/**
+ * long fio_kv_async_create(int threads, int slots);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1create
+  (JNIEnv *env, jclass cls, jint _threads, jint _slots)
+{
+	if (_threads <= 0 || _slots <= 0) {
+		return 0;
+	}
+
+	return (jlong)(intptr_t)fio_kv_async_create((uint32_t)_threads,
+			(uint32_t)_slots);
+}
+
+/**
+ * boolean fio_kv_async_get(long engine, int slot, long pool, long key,
+ *	int keyLength);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1get
+  (jlong _engine, jint _slot, jlong _pool,
+   jlong _key, jint _key_len)
+{
+	assert(_engine != 0);
+	assert(_pool != 0);
+
+	fio_kv_async_t *engine = (fio_kv_async_t *)(intptr_t)_engine;
+	fio_kv_async_request_t *request = fio_kv_async_request(engine, _slot);
+	request->op = FIO_KV_ASYNC_GET;
+	request->pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	__address_to_fio_kv_key(_key, _key_len, &request->key);
+	request->value.data = NULL;
+
+	return (jboolean)fio_kv_async_submit(engine, _slot);
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1get
+  (JNIEnv *env, jclass cls, jlong _engine, jint _slot, jlong _pool,
+   jlong _key, jint _key_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1get(
+			_engine, _slot, _pool, _key, _key_len);
+}
+
+/**
+ * boolean fio_kv_async_put(long engine, int slot, long pool, long key,
+ *	int keyLength, long value, int valueLength, int expiry, int genCount);
+ */
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1put
+  (jlong _engine, jint _slot, jlong _pool,
+   jlong _key, jint _key_len, jlong _value, jint _value_len, jint _expiry,
+   jint _gen_count)
+{
+	assert(_engine != 0);
+	assert(_pool != 0);
+	assert(_value != 0);
+
+	fio_kv_async_t *engine = (fio_kv_async_t *)(intptr_t)_engine;
+	fio_kv_async_request_t *request = fio_kv_async_request(engine, _slot);
+	request->op = FIO_KV_ASYNC_PUT;
+	request->pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	__address_to_fio_kv_key(_key, _key_len, &request->key);
+
+	memset(&request->info, 0, sizeof(nvm_kv_key_info_t));
+	request->info.value_len = (uint32_t)_value_len;
+	request->info.expiry = (uint32_t)_expiry;
+	request->info.gen_count = (uint32_t)_gen_count;
+	request->value.data = (void *)(intptr_t)_value;
+
+	return (jboolean)fio_kv_async_submit(engine, _slot);
+}
+
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1put
+  (JNIEnv *env, jclass cls, jlong _engine, jint _slot, jlong _pool,
+   jlong _key, jint _key_len, jlong _value, jint _value_len, jint _expiry,
+   jint _gen_count)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1put(
+			_engine, _slot, _pool, _key, _key_len, _value, _value_len, _expiry, _gen_count);
+}
+
+/**
+ * int fio_kv_async_reap(long engine, int[] slots);
+ *
+ * Blocks until requests complete, and stores their slots in the given array.
+ * Returns the number of completed requests, or -1 once the engine is shut
+ * down and drained.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1reap
+  (JNIEnv *env, jclass cls, jlong _engine, jintArray _slots)
+{
+	assert(_engine != 0);
+	assert(_slots != NULL);
+
+	uint32_t slots[64];
+	uint32_t max = (uint32_t)env->GetArrayLength(_slots);
+	if (max > sizeof(slots) / sizeof(slots[0])) {
+		max = sizeof(slots) / sizeof(slots[0]);
+	}
+
+	int count = fio_kv_async_reap((fio_kv_async_t *)(intptr_t)_engine,
+			slots, max);
+	if (count > 0) {
+		jint _completed[64];
+		for (int i=0; i<count; i++) {
+			_completed[i] = (jint)slots[i];
+		}
+		env->SetIntArrayRegion(_slots, 0, count, _completed);
+	}
+
+	return (jint)count;
+}
+
+/**
+ * int fio_kv_async_result(long engine, int slot);
+ *
+ * Returns the result of a completed request: the number of bytes read or
+ * written, or -1 if it failed.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1result
+  (jlong _engine, jint _slot)
+{
+	assert(_engine != 0);
+
+	return (jint)fio_kv_async_request((fio_kv_async_t *)(intptr_t)_engine,
+			_slot)->result;
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1result
+  (JNIEnv *env, jclass cls, jlong _engine, jint _slot)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1result(
+			_engine, _slot);
+}
+
+/**
+ * int fio_kv_async_error(long engine, int slot);
+ *
+ * Returns the error code of a failed request.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1error
+  (jlong _engine, jint _slot)
+{
+	assert(_engine != 0);
+
+	return (jint)fio_kv_async_request((fio_kv_async_t *)(intptr_t)_engine,
+			_slot)->error;
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1error
+  (JNIEnv *env, jclass cls, jlong _engine, jint _slot)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1error(
+			_engine, _slot);
+}
+
+/**
+ * Value fio_kv_async_value(long engine, int slot);
+ *
+ * Returns the Value read by a completed get request, transferring ownership
+ * of its memory, or null if the request failed.
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1value
+  (JNIEnv *env, jclass cls, jlong _engine, jint _slot)
+{
+	assert(env != NULL);
+	assert(_engine != 0);
+
+	fio_kv_async_request_t *request = fio_kv_async_request(
+			(fio_kv_async_t *)(intptr_t)_engine, _slot);
+	if (request->result < 0 || request->value.data == NULL) {
+		return NULL;
+	}
+
+	jobject _value = __fio_kv_value_to_jobject(env, &request->value,
+			request->capacity);
+	if (_value == NULL) {
+		fio_kv_free_value(&request->value);
+	}
+
+	request->value.data = NULL;
+	return _value;
+}
+
+/**
+ * void fio_kv_async_shutdown(long engine);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1shutdown
+  (JNIEnv *env, jclass cls, jlong _engine)
+{
+	assert(_engine != 0);
+	fio_kv_async_shutdown((fio_kv_async_t *)(intptr_t)_engine);
+}
+
+/**
+ * void fio_kv_async_destroy(long engine);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1destroy
+  (JNIEnv *env, jclass cls, jlong _engine)
+{
+	assert(_engine != 0);
+	fio_kv_async_destroy((fio_kv_async_t *)(intptr_t)_engine);
+}
+
+/**
+ * int fio_kv_next_batch(long pool, int iterator, long buffer, int size,
+ *	int max, boolean keysOnly);
+ *
+ * Packs up to max key/value pairs, or only their keys and metadata, of an
+ * iteration into the given buffer. Returns the number of records read, or -1
+ * in case of an error.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1next_1batch
+  (jlong _pool, jint _iterator, jlong _buffer,
+   jint _size, jint _max, jboolean _keys_only)
+{
+	assert(_pool != 0);
+	assert(_buffer != 0);
+
+	if (_size <= 0 || _max <= 0) {
+		return -1;
+	}
+
+	return (jint)fio_kv_next_batch((fio_kv_pool_t *)(intptr_t)_pool,
+			_iterator, (void *)(intptr_t)_buffer,
+			(uint32_t)_size, (uint32_t)_max, _keys_only == JNI_TRUE);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1next_1batch
+  (JNIEnv *env, jclass cls, jlong _pool, jint _iterator, jlong _buffer,
+   jint _size, jint _max, jboolean _keys_only)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1next_1batch(
+			_pool, _iterator, _buffer, _size, _max, _keys_only);
+}
+
+/* Parallel pool scan. */
+
+/**
+ * long fio_kv_scan_create(long[] pools, int threads, int buffers, int size,
+ *	int max, boolean keysOnly);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1create
+  (JNIEnv *env, jclass cls, jlongArray _pools, jint _threads, jint _buffers,
+   jint _size, jint _max, jboolean _keys_only)
+{
+	assert(_pools != NULL);
+
+	if (_threads <= 0 || _buffers <= 0 || _size <= 0 || _max <= 0) {
+		return 0;
+	}
+
+	jsize count = env->GetArrayLength(_pools);
+	jlong *handles = env->GetLongArrayElements(_pools, NULL);
+	if (handles == NULL) {
+		return 0;
+	}
+
+	fio_kv_pool_t **pools = (fio_kv_pool_t **)calloc(count + 1,
+			sizeof(fio_kv_pool_t *));
+	fio_kv_scan_t *scan = NULL;
+	if (pools != NULL) {
+		for (jsize i=0; i<count; i++) {
+			pools[i] = (fio_kv_pool_t *)(intptr_t)handles[i];
+		}
+
+		scan = fio_kv_scan_create(pools, (uint32_t)count,
+				(uint32_t)_threads, (uint32_t)_buffers, (uint32_t)_size,
+				(uint32_t)_max, _keys_only == JNI_TRUE);
+		free(pools);
+	}
+
+	env->ReleaseLongArrayElements(_pools, handles, JNI_ABORT);
+	return (jlong)(intptr_t)scan;
+}
+
+/**
+ * ByteBuffer fio_kv_scan_buffer(long scan, int buffer);
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1buffer
+  (JNIEnv *env, jclass cls, jlong _scan, jint _buffer)
+{
+	assert(_scan != 0);
+
+	fio_kv_scan_t *scan = (fio_kv_scan_t *)(intptr_t)_scan;
+	return env->NewDirectByteBuffer(fio_kv_scan_buffer(scan, _buffer),
+			scan->buffer_size);
+}
+
+/**
+ * int fio_kv_scan_reap(long scan, int[] pool);
+ *
+ * Blocks until a batch buffer is filled, and stores the index of the pool it
+ * was read from in the given array. Returns the index of the buffer, or -1
+ * once the scan is complete.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1reap
+  (JNIEnv *env, jclass cls, jlong _scan, jintArray _pool)
+{
+	assert(_scan != 0);
+	assert(_pool != NULL);
+
+	uint32_t pool = 0;
+	int buffer = fio_kv_scan_reap((fio_kv_scan_t *)(intptr_t)_scan, &pool);
+	if (buffer >= 0) {
+		jint _index = (jint)pool;
+		env->SetIntArrayRegion(_pool, 0, 1, &_index);
+	}
+
+	return (jint)buffer;
+}
+
+/**
+ * void fio_kv_scan_release(long scan, int buffer);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1release
+  (JNIEnv *env, jclass cls, jlong _scan, jint _buffer)
+{
+	assert(_scan != 0);
+	fio_kv_scan_release((fio_kv_scan_t *)(intptr_t)_scan, _buffer);
+}
+
+/**
+ * void fio_kv_scan_destroy(long scan);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1destroy
+  (JNIEnv *env, jclass cls, jlong _scan)
+{
+	assert(_scan != 0);
+	fio_kv_scan_destroy((fio_kv_scan_t *)(intptr_t)_scan);
+}
+
+/* Per-pool Bloom filters. */
+
+/**
+ * boolean fio_kv_build_filter(long pool, long capacity);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1build_1filter
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _capacity)
+{
+	assert(_pool != 0);
+	return (jboolean)fio_kv_build_filter((fio_kv_pool_t *)(intptr_t)_pool,
+			(uint64_t)_capacity);
+}
+
+/**
+ * Call a fio_kv_ filter file operation on a pool handle, with the file path
+ * given as a Java string.
+ */
+jboolean __fio_kv_call_filter_file(JNIEnv *env, jlong _pool, jstring _path,
+		bool (*op)(const fio_kv_pool_t *, const char *))
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+	assert(_path != NULL);
+
+	const char *path = env->GetStringUTFChars(_path, 0);
+	if (path == NULL) {
+		return JNI_FALSE;
+	}
+
+	bool ret = op((fio_kv_pool_t *)(intptr_t)_pool, path);
+	env->ReleaseStringUTFChars(_path, path);
+	return (jboolean)ret;
+}
+
+/**
+ * boolean fio_kv_save_filter(long pool, String path);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1save_1filter
+  (JNIEnv *env, jclass cls, jlong _pool, jstring _path)
+{
+	return __fio_kv_call_filter_file(env, _pool, _path, fio_kv_save_filter);
+}
+
+/**
+ * boolean fio_kv_load_filter(long pool, String path);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1load_1filter
+  (JNIEnv *env, jclass cls, jlong _pool, jstring _path)
+{
+	return __fio_kv_call_filter_file(env, _pool, _path, fio_kv_load_filter);
+}
+
+/* Value compression. */
+
+/**
+ * boolean fio_kv_set_compression(long pool, boolean enabled);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1compression
+  (JNIEnv *env, jclass cls, jlong _pool, jboolean _enabled)
+{
+	return (jboolean)fio_kv_set_compression((fio_kv_pool_t *)(intptr_t)_pool,
+			_enabled ? FIO_KV_CODEC_LZ4 : FIO_KV_CODEC_NONE);
+}
+
+/* Small-value packing. */
+
+/**
+ * boolean fio_kv_set_packing(long pool, int buckets);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1packing
+  (JNIEnv *env, jclass cls, jlong _pool, jint _buckets)
+{
+	if (_buckets <= 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return (jboolean)fio_kv_set_packing((fio_kv_pool_t *)(intptr_t)_pool,
+			(uint32_t)_buckets);
+}
+
+/* Multi-device sharding. */
+
+/**
+ * long fio_kv_shard_create(int shards);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1create
+  (JNIEnv *env, jclass cls, jint _shards)
+{
+	if (_shards <= 0 || _shards > FIO_KV_SHARD_MAX_SHARDS) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	return (jlong)(intptr_t)fio_kv_shard_create((uint32_t)_shards);
+}
+
+/**
+ * void fio_kv_shard_destroy(long shard);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1destroy
+  (JNIEnv *env, jclass cls, jlong _shard)
+{
+	assert(_shard != 0);
+	fio_kv_shard_destroy((fio_kv_shard_t *)(intptr_t)_shard);
+}
+
+/**
+ * int fio_kv_shard_of(long shard, long key, int keyLength);
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1of
+  (jlong _shard, jlong _key, jint _key_len)
+{
+	assert(_shard != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return (jint)fio_kv_shard_of((fio_kv_shard_t *)(intptr_t)_shard, &key);
+}
+
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1of
+  (JNIEnv *env, jclass cls, jlong _shard, jlong _key, jint _key_len)
+{
+	return JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1of(
+			_shard, _key, _key_len);
+}
+
+/**
+ * int fio_kv_shard_batch(long shard, long[] pools, int op, Key[] keys,
+ *     Value[] values);
+ *
+ * The values array is ignored, and may be null, for deletions. For gets and
+ * puts, the info structure of each value is written back into its Value
+ * object. Returns the number of pairs processed, or -1 if the batch could
+ * not be marshalled.
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1batch
+  (JNIEnv *env, jclass cls, jlong _shard, jlongArray _pools, jint _op,
+   jobjectArray _keys, jobjectArray _values)
+{
+	assert(_shard != 0);
+	assert(_pools != NULL);
+	assert(_keys != NULL);
+
+	fio_kv_shard_t *shard = (fio_kv_shard_t *)(intptr_t)_shard;
+	fio_kv_shard_op_t op = (fio_kv_shard_op_t)_op;
+	bool with_values = op != FIO_KV_SHARD_DELETE;
+	jsize count = env->GetArrayLength(_keys);
+	if (count == 0) {
+		return 0;
+	}
+
+	jlong handles[FIO_KV_SHARD_MAX_SHARDS];
+	fio_kv_pool_t *pools[FIO_KV_SHARD_MAX_SHARDS];
+	if (env->GetArrayLength(_pools) != (jsize)shard->count) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	env->GetLongArrayRegion(_pools, 0, shard->count, handles);
+	for (uint32_t i=0; i<shard->count; i++) {
+		pools[i] = (fio_kv_pool_t *)(intptr_t)handles[i];
+	}
+
+	fio_kv_key_t *keys = (fio_kv_key_t *)malloc(count * sizeof(fio_kv_key_t));
+	const fio_kv_key_t **pkeys = (const fio_kv_key_t **)malloc(
+			count * sizeof(fio_kv_key_t *));
+	fio_kv_value_t *values = NULL;
+	nvm_kv_key_info_t *infos = NULL;
+	const fio_kv_value_t **pvalues = NULL;
+	if (with_values) {
+		values = (fio_kv_value_t *)malloc(count * sizeof(fio_kv_value_t));
+		infos = (nvm_kv_key_info_t *)malloc(
+				count * sizeof(nvm_kv_key_info_t));
+		pvalues = (const fio_kv_value_t **)malloc(
+				count * sizeof(fio_kv_value_t *));
+	}
+
+	int done = -1;
+	if (keys == NULL || pkeys == NULL ||
+			(with_values && (values == NULL || infos == NULL ||
+							 pvalues == NULL))) {
+		errno = ENOMEM;
+	} else {
+		for (jsize i=0; i<count; i++) {
+			jobject _key = env->GetObjectArrayElement(_keys, i);
+			__jobject_to_fio_kv_key(env, _key, &keys[i]);
+			env->DeleteLocalRef(_key);
+			pkeys[i] = &keys[i];
+
+			if (with_values) {
+				jobject _value = env->GetObjectArrayElement(_values, i);
+				__jobject_to_fio_kv_value(env, _value, &values[i], &infos[i]);
+				env->DeleteLocalRef(_value);
+				pvalues[i] = &values[i];
+			}
+		}
+
+		done = (int)fio_kv_shard_batch(shard, pools, op, pkeys, pvalues,
+				(size_t)count);
+
+		for (jsize i=0; with_values && i<count; i++) {
+			jobject _value = env->GetObjectArrayElement(_values, i);
+			__kv_value_info_set_jobject(env, &infos[i], _value);
+			env->DeleteLocalRef(_value);
+		}
+	}
+
+	free(pvalues);
+	free(infos);
+	free(values);
+	free(pkeys);
+	free(keys);
+	return (jint)done;
+}
+
+/* Chunked large values. */
+
+/**
+ * boolean fio_kv_fast_put_large(long pool, long key, int keyLength,
+ *	long value, int valueLength, int expiry);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1large
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len,
+   jlong _value, jint _value_len, jint _expiry)
+{
+	assert(_pool != 0);
+	assert(_value != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return fio_kv_put_large((fio_kv_pool_t *)(intptr_t)_pool, &key,
+			(void *)(intptr_t)_value, (uint64_t)_value_len,
+			(uint32_t)_expiry);
+}
+
+/**
+ * Value fio_kv_fast_get_large(long pool, long key, int keyLength);
+ *
+ * Returns a new Value holding the large value of the key, or null in case of
+ * an error.
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1large
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)(intptr_t)_pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+
+	// Retry with the new length if the value grew since its length was read.
+	int64_t length;
+	uint32_t capacity;
+	do {
+		length = fio_kv_get_large_len(pool, &key);
+		if (length < 0) {
+			return NULL;
+		}
+
+		if (length > 0x7fffffff - FIO_SECTOR_ALIGNMENT) {
+			errno = EFBIG;
+			return NULL;
+		}
+
+		capacity = (uint32_t)((length + FIO_SECTOR_ALIGNMENT - 1) /
+				FIO_SECTOR_ALIGNMENT * FIO_SECTOR_ALIGNMENT);
+		value.data = fio_kv_alloc(capacity > 0 ? capacity : 1);
+		if (value.data == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+
+		length = fio_kv_get_large(pool, &key, value.data, capacity);
+		if (length < 0) {
+			fio_kv_free_value(&value);
+		}
+	} while (length < 0 && errno == ENOBUFS);
+
+	if (length < 0) {
+		return NULL;
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.pool_id = pool->id;
+	info.key_len = key.length;
+	info.value_len = (uint32_t)length;
+	value.info = &info;
+
+	jobject _value = __fio_kv_value_to_jobject(env, &value, capacity);
+	if (_value == NULL) {
+		fio_kv_free_value(&value);
+	}
+
+	return _value;
+}
+
+/**
+ * boolean fio_kv_fast_delete_large(long pool, long key, int keyLength);
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1large
+  (JNIEnv *env, jclass cls, jlong _pool, jlong _key, jint _key_len)
+{
+	assert(_pool != 0);
+
+	fio_kv_key_t key;
+	__address_to_fio_kv_key(_key, _key_len, &key);
+	return fio_kv_delete_large((fio_kv_pool_t *)(intptr_t)_pool, &key);
+}
+
+/* Shared-memory rings. */
+
+/**
+ * long fio_kv_ring_create(int entries, int threads);
+ *
+ * Returns the address of the new ring, or 0 if it could not be created.
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1create
+  (JNIEnv *env, jclass cls, jint _entries, jint _threads)
+{
+	if (_entries <= 0 || _threads <= 0) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	return (jlong)(intptr_t)fio_kv_ring_create((uint32_t)_entries,
+			(uint32_t)_threads);
+}
+
+/**
+ * ByteBuffer fio_kv_ring_buffer(long ring);
+ *
+ * Returns a direct buffer mapping the ring's shared memory.
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1buffer
+  (JNIEnv *env, jclass cls, jlong _ring)
+{
+	assert(_ring != 0);
+
+	fio_kv_ring_t *ring = (fio_kv_ring_t *)(intptr_t)_ring;
+	return env->NewDirectByteBuffer(ring->memory, ring->size);
+}
+
+/**
+ * void fio_kv_ring_wake(long ring);
+ */
+JNIEXPORT void JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wake
+  (jlong _ring)
+{
+	assert(_ring != 0);
+
+	fio_kv_ring_wake((fio_kv_ring_t *)(intptr_t)_ring);
+}
+
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wake
+  (JNIEnv *env, jclass cls, jlong _ring)
+{
+	JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wake(_ring);
+}
+
+/**
+ * boolean fio_kv_ring_wait(long ring, int head, int timeout);
+ *
+ * Blocks until completions are posted past the given head, for at most the
+ * given number of microseconds. Not exported as a critical native, since it
+ * blocks.
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wait
+  (JNIEnv *env, jclass cls, jlong _ring, jint _head, jint _timeout)
+{
+	assert(_ring != 0);
+
+	return fio_kv_ring_wait((fio_kv_ring_t *)(intptr_t)_ring,
+			(uint32_t)_head, (uint32_t)_timeout);
+}
+
+/**
+ * void fio_kv_ring_destroy(long ring);
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1destroy
+  (JNIEnv *env, jclass cls, jlong _ring)
+{
+	assert(_ring != 0);
+
+	fio_kv_ring_destroy((fio_kv_ring_t *)(intptr_t)_ring);
+}
+
+/* Pool export and import. */
+
+/**
+ * long fio_kv_export_pool(long pool, String path);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1export_1pool
+  (JNIEnv *env, jclass cls, jlong _pool, jstring _path)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+	assert(_path != NULL);
+
+	const char *path = env->GetStringUTFChars(_path, 0);
+	if (path == NULL) {
+		return -1;
+	}
+
+	int64_t ret = fio_kv_export_file((fio_kv_pool_t *)(intptr_t)_pool, path);
+	env->ReleaseStringUTFChars(_path, path);
+	return (jlong)ret;
+}
+
+/**
+ * long fio_kv_import_pool(long pool, String path, int threads);
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1import_1pool
+  (JNIEnv *env, jclass cls, jlong _pool, jstring _path, jint _threads)
+{
+	assert(env != NULL);
+	assert(_pool != 0);
+	assert(_path != NULL);
+
+	const char *path = env->GetStringUTFChars(_path, 0);
+	if (path == NULL) {
+		return -1;
+	}
+
+	int64_t ret = fio_kv_import_file((fio_kv_pool_t *)(intptr_t)_pool, path,
+			(uint32_t)_threads);
+	env->ReleaseStringUTFChars(_path, path);
+	return (jlong)ret;
+}
+
+/* Library initialization. */
+
+typedef void (*__jni_function_t)(void);
+
+/**
+ * Convert a JNI function pointer for use in a JNINativeMethod structure.
+ */
+void *__jni_function_ptr(__jni_function_t function)
+{
+	union {
+		__jni_function_t function;
+		void *ptr;
+	} u;
+
+	u.function = function;
+	return u.ptr;
+}
+
+#define __JNI_STORE  "Lcom/turn/fusionio/Store;"
+#define __JNI_POOL   "Lcom/turn/fusionio/Pool;"
+#define __JNI_KEY    "Lcom/turn/fusionio/Key;"
+#define __JNI_VALUE  "Lcom/turn/fusionio/Value;"
+#define __JNI_KVINFO "Lcom/turn/fusionio/KeyValueInfo;"
+#define __JNI_BUFFER "Ljava/nio/ByteBuffer;"
+
+#define __FIO_KV_NATIVE(name, signature, function) \
+	{ (char *)name, (char *)signature, __jni_function_ptr( \
+		(__jni_function_t)Java_com_turn_fusionio_FusionIOAPI_##function) }
+
+/**
+ * Native methods of the FusionIOAPI class and their JNI entry points.
+ */
+static JNINativeMethod __fio_kv_natives[] = {
+	__FIO_KV_NATIVE("fio_kv_open",
+		"(" __JNI_STORE "ILcom/turn/fusionio/FusionIOAPI$ExpiryMode;IJ)Z",
+		fio_1kv_1open),
+	__FIO_KV_NATIVE("fio_kv_close", "(" __JNI_STORE ")V",
+		fio_1kv_1close),
+	__FIO_KV_NATIVE("fio_kv_get_store_info",
+		"(" __JNI_STORE ")Lcom/turn/fusionio/StoreInfo;",
+		fio_1kv_1get_1store_1info),
+	__FIO_KV_NATIVE("fio_kv_get_stats",
+		"(J)Lcom/turn/fusionio/StoreStats;",
+		fio_1kv_1get_1stats),
+	__FIO_KV_NATIVE("fio_kv_get_cache_stats",
+		"(J)Lcom/turn/fusionio/CacheStats;",
+		fio_1kv_1get_1cache_1stats),
+	__FIO_KV_NATIVE("fio_kv_set_group_commit", "(JII)Z",
+		fio_1kv_1set_1group_1commit),
+	__FIO_KV_NATIVE("fio_kv_set_sched", "(JIIII)Z",
+		fio_1kv_1set_1sched),
+	__FIO_KV_NATIVE("fio_kv_set_hot_keys", "(JLjava/lang/String;I)Z",
+		fio_1kv_1set_1hot_1keys),
+	__FIO_KV_NATIVE("fio_kv_prefetch_hot_keys", "(J)Z",
+		fio_1kv_1prefetch_1hot_1keys),
+	__FIO_KV_NATIVE("fio_kv_get_or_create_pool",
+		"(" __JNI_STORE "Ljava/lang/String;)" __JNI_POOL,
+		fio_1kv_1get_1or_1create_1pool),
+	__FIO_KV_NATIVE("fio_kv_get_all_pools", "(" __JNI_STORE ")[" __JNI_POOL,
+		fio_1kv_1get_1all_1pools),
+	__FIO_KV_NATIVE("fio_kv_delete_pool", "(" __JNI_POOL ")Z",
+		fio_1kv_1delete_1pool),
+	__FIO_KV_NATIVE("fio_kv_delete_all_pools", "(" __JNI_STORE ")Z",
+		fio_1kv_1delete_1all_1pools),
+	__FIO_KV_NATIVE("fio_kv_alloc", "(I)" __JNI_BUFFER,
+		fio_1kv_1alloc),
+	__FIO_KV_NATIVE("fio_kv_free_value", "(" __JNI_VALUE ")V",
+		fio_1kv_1free_1value),
+	__FIO_KV_NATIVE("fio_kv_use_hugepages", "(Z)V",
+		fio_1kv_1use_1hugepages),
+	__FIO_KV_NATIVE("fio_kv_get_allocator_stats",
+		"()Lcom/turn/fusionio/AllocatorStats;",
+		fio_1kv_1get_1allocator_1stats),
+	__FIO_KV_NATIVE("fio_kv_get_value_len", "(" __JNI_POOL __JNI_KEY ")I",
+		fio_1kv_1get_1value_1len),
+	__FIO_KV_NATIVE("fio_kv_get_key_info",
+		"(" __JNI_POOL __JNI_KEY ")" __JNI_KVINFO,
+		fio_1kv_1get_1key_1info),
+	__FIO_KV_NATIVE("fio_kv_get", "(" __JNI_POOL __JNI_KEY __JNI_VALUE ")I",
+		fio_1kv_1get),
+	__FIO_KV_NATIVE("fio_kv_put", "(" __JNI_POOL __JNI_KEY __JNI_VALUE ")I",
+		fio_1kv_1put),
+	__FIO_KV_NATIVE("fio_kv_exists",
+		"(" __JNI_POOL __JNI_KEY __JNI_KVINFO ")Z",
+		fio_1kv_1exists),
+	__FIO_KV_NATIVE("fio_kv_delete", "(" __JNI_POOL __JNI_KEY ")Z",
+		fio_1kv_1delete),
+	__FIO_KV_NATIVE("fio_kv_delete_all", "(" __JNI_STORE ")Z",
+		fio_1kv_1delete_1all),
+	__FIO_KV_NATIVE("fio_kv_batch_put",
+		"(" __JNI_POOL "[" __JNI_KEY "[" __JNI_VALUE ")Z",
+		fio_1kv_1batch_1put),
+	__FIO_KV_NATIVE("fio_kv_batch_put_count",
+		"(" __JNI_POOL "[" __JNI_KEY "[" __JNI_VALUE ")I",
+		fio_1kv_1batch_1put_1count),
+	__FIO_KV_NATIVE("fio_kv_batch_get",
+		"(" __JNI_POOL "[" __JNI_KEY ")[" __JNI_VALUE,
+		fio_1kv_1batch_1get),
+	__FIO_KV_NATIVE("fio_kv_iterator", "(" __JNI_POOL ")I",
+		fio_1kv_1iterator),
+	__FIO_KV_NATIVE("fio_kv_next", "(" __JNI_POOL "I)Z",
+		fio_1kv_1next),
+	__FIO_KV_NATIVE("fio_kv_get_current",
+		"(" __JNI_POOL "I" __JNI_KEY __JNI_VALUE ")Z",
+		fio_1kv_1get_1current),
+	__FIO_KV_NATIVE("fio_kv_end_iteration", "(" __JNI_POOL "I)Z",
+		fio_1kv_1end_1iteration),
+	__FIO_KV_NATIVE("fio_kv_get_last_error", "()I",
+		fio_1kv_1get_1last_1error),
+	__FIO_KV_NATIVE("fio_kv_release_store_handle", "(J)V",
+		fio_1kv_1release_1store_1handle),
+	__FIO_KV_NATIVE("fio_kv_pool_handle", "(" __JNI_POOL ")J",
+		fio_1kv_1pool_1handle),
+	__FIO_KV_NATIVE("fio_kv_release_pool_handle", "(J)V",
+		fio_1kv_1release_1pool_1handle),
+	__FIO_KV_NATIVE("fio_kv_address", "(" __JNI_BUFFER ")J",
+		fio_1kv_1address),
+	__FIO_KV_NATIVE("fio_kv_fast_get_value_len", "(JJI)I",
+		fio_1kv_1fast_1get_1value_1len),
+	__FIO_KV_NATIVE("fio_kv_fast_get", "(JJIJI)I",
+		fio_1kv_1fast_1get),
+	__FIO_KV_NATIVE("fio_kv_fast_get_alloc", "(JJI)" __JNI_VALUE,
+		fio_1kv_1fast_1get_1alloc),
+	__FIO_KV_NATIVE("fio_kv_fast_put", "(JJIJIII)I",
+		fio_1kv_1fast_1put),
+	__FIO_KV_NATIVE("fio_kv_fast_exists", "(JJI)Z",
+		fio_1kv_1fast_1exists),
+	__FIO_KV_NATIVE("fio_kv_fast_delete", "(JJI)Z",
+		fio_1kv_1fast_1delete),
+	__FIO_KV_NATIVE("fio_kv_fast_compare_and_put", "(JJIJIII)I",
+		fio_1kv_1fast_1compare_1and_1put),
+	__FIO_KV_NATIVE("fio_kv_fast_put_if_absent", "(JJIJII)I",
+		fio_1kv_1fast_1put_1if_1absent),
+	__FIO_KV_NATIVE("fio_kv_fast_increment", "(JJIJI[J)Z",
+		fio_1kv_1fast_1increment),
+	__FIO_KV_NATIVE("fio_kv_fast_append", "(JJIJII)I",
+		fio_1kv_1fast_1append),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_put", "(JJII)I",
+		fio_1kv_1fast_1batch_1put),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_delete", "(J[" __JNI_KEY ")I",
+		fio_1kv_1fast_1batch_1delete),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_exists", "(J[" __JNI_KEY "[B)I",
+		fio_1kv_1fast_1batch_1exists),
+	__FIO_KV_NATIVE("fio_kv_fast_get_long", "(JJJI)I",
+		fio_1kv_1fast_1get_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_get_long_alloc", "(JJ)" __JNI_VALUE,
+		fio_1kv_1fast_1get_1long_1alloc),
+	__FIO_KV_NATIVE("fio_kv_fast_put_long", "(JJJIII)I",
+		fio_1kv_1fast_1put_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_exists_long", "(JJ)Z",
+		fio_1kv_1fast_1exists_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_delete_long", "(JJ)Z",
+		fio_1kv_1fast_1delete_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_put_long", "(J[J[" __JNI_VALUE ")I",
+		fio_1kv_1fast_1batch_1put_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_get_long", "(J[J)[" __JNI_VALUE,
+		fio_1kv_1fast_1batch_1get_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_delete_long", "(J[J)I",
+		fio_1kv_1fast_1batch_1delete_1long),
+	__FIO_KV_NATIVE("fio_kv_fast_batch_exists_long", "(J[J[B)I",
+		fio_1kv_1fast_1batch_1exists_1long),
+	__FIO_KV_NATIVE("fio_kv_next_batch", "(JIJIIZ)I",
+		fio_1kv_1next_1batch),
+	__FIO_KV_NATIVE("fio_kv_async_create", "(II)J",
+		fio_1kv_1async_1create),
+	__FIO_KV_NATIVE("fio_kv_async_get", "(JIJJI)Z",
+		fio_1kv_1async_1get),
+	__FIO_KV_NATIVE("fio_kv_async_put", "(JIJJIJIII)Z",
+		fio_1kv_1async_1put),
+	__FIO_KV_NATIVE("fio_kv_async_reap", "(J[I)I",
+		fio_1kv_1async_1reap),
+	__FIO_KV_NATIVE("fio_kv_async_result", "(JI)I",
+		fio_1kv_1async_1result),
+	__FIO_KV_NATIVE("fio_kv_async_error", "(JI)I",
+		fio_1kv_1async_1error),
+	__FIO_KV_NATIVE("fio_kv_async_value", "(JI)" __JNI_VALUE,
+		fio_1kv_1async_1value),
+	__FIO_KV_NATIVE("fio_kv_async_shutdown", "(J)V",
+		fio_1kv_1async_1shutdown),
+	__FIO_KV_NATIVE("fio_kv_async_destroy", "(J)V",
+		fio_1kv_1async_1destroy),
+	__FIO_KV_NATIVE("fio_kv_scan_create", "([JIIIIZ)J",
+		fio_1kv_1scan_1create),
+	__FIO_KV_NATIVE("fio_kv_scan_buffer", "(JI)" __JNI_BUFFER,
+		fio_1kv_1scan_1buffer),
+	__FIO_KV_NATIVE("fio_kv_scan_reap", "(J[I)I",
+		fio_1kv_1scan_1reap),
+	__FIO_KV_NATIVE("fio_kv_scan_release", "(JI)V",
+		fio_1kv_1scan_1release),
+	__FIO_KV_NATIVE("fio_kv_scan_destroy", "(J)V",
+		fio_1kv_1scan_1destroy),
+	__FIO_KV_NATIVE("fio_kv_build_filter", "(JJ)Z",
+		fio_1kv_1build_1filter),
+	__FIO_KV_NATIVE("fio_kv_save_filter", "(JLjava/lang/String;)Z",
+		fio_1kv_1save_1filter),
+	__FIO_KV_NATIVE("fio_kv_load_filter", "(JLjava/lang/String;)Z",
+		fio_1kv_1load_1filter),
+	__FIO_KV_NATIVE("fio_kv_set_compression", "(JZ)Z",
+		fio_1kv_1set_1compression),
+	__FIO_KV_NATIVE("fio_kv_set_packing", "(JI)Z",
+		fio_1kv_1set_1packing),
+	__FIO_KV_NATIVE("fio_kv_shard_create", "(I)J",
+		fio_1kv_1shard_1create),
+	__FIO_KV_NATIVE("fio_kv_shard_destroy", "(J)V",
+		fio_1kv_1shard_1destroy),
+	__FIO_KV_NATIVE("fio_kv_shard_of", "(JJI)I",
+		fio_1kv_1shard_1of),
+	__FIO_KV_NATIVE("fio_kv_shard_batch",
+		"(J[JI[" __JNI_KEY "[" __JNI_VALUE ")I",
+		fio_1kv_1shard_1batch),
+	__FIO_KV_NATIVE("fio_kv_fast_put_large", "(JJIJII)Z",
+		fio_1kv_1fast_1put_1large),
+	__FIO_KV_NATIVE("fio_kv_fast_get_large", "(JJI)" __JNI_VALUE,
+		fio_1kv_1fast_1get_1large),
+	__FIO_KV_NATIVE("fio_kv_fast_delete_large", "(JJI)Z",
+		fio_1kv_1fast_1delete_1large),
+	__FIO_KV_NATIVE("fio_kv_ring_create", "(II)J",
+		fio_1kv_1ring_1create),
+	__FIO_KV_NATIVE("fio_kv_ring_buffer", "(J)" __JNI_BUFFER,
+		fio_1kv_1ring_1buffer),
+	__FIO_KV_NATIVE("fio_kv_ring_wake", "(J)V",
+		fio_1kv_1ring_1wake),
+	__FIO_KV_NATIVE("fio_kv_ring_wait", "(JII)Z",
+		fio_1kv_1ring_1wait),
+	__FIO_KV_NATIVE("fio_kv_ring_destroy", "(J)V",
+		fio_1kv_1ring_1destroy),
+	__FIO_KV_NATIVE("fio_kv_export_pool", "(JLjava/lang/String;)J",
+		fio_1kv_1export_1pool),
+	__FIO_KV_NATIVE("fio_kv_import_pool", "(JLjava/lang/String;I)J",
+		fio_1kv_1import_1pool),
+};
+
+/**
+ * Library initialization: fill the JNI cache and bind the native methods of
+ * the FusionIOAPI class.
+ *
+ * Methods are registered one by one, so that a method that can't be bound
+ * falls back to the usual symbol lookup instead of failing the whole library.
+ */
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
+{
+	JNIEnv *env;
+	if (vm->GetEnv((void **)&env, JNI_VERSION_1_6) != JNI_OK) {
+		return JNI_ERR;
+	}
+
+	jclass _cls = env->FindClass("com/turn/fusionio/FusionIOAPI");
+	if (_cls == NULL) {
+		return JNI_ERR;
+	}
+
+	__fio_kv_init_jni_cache(env);
+
+	size_t count = sizeof(__fio_kv_natives) / sizeof(__fio_kv_natives[0]);
+	for (size_t i=0; i<count; i++) {
+		if (env->RegisterNatives(_cls, &__fio_kv_natives[i], 1) != 0) {
+			env->ExceptionClear();
+		}
+	}
+
+	env->DeleteLocalRef(_cls);
+	return JNI_VERSION_1_6;
 }
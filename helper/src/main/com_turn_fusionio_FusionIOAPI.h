@@ -7,21 +7,13 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-/*
- * Class:     com_turn_fusionio_FusionIOAPI
- * Method:    fio_kv_init_jni_cache
- * Signature: ()V
- */
-JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1init_1jni_1cache
-  (JNIEnv *, jclass);
-
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_open
- * Signature: (Lcom/turn/fusionio/Store;ILcom/turn/fusionio/FusionIOAPI$ExpiryMode;I)Z
+ * Signature: (Lcom/turn/fusionio/Store;ILcom/turn/fusionio/FusionIOAPI$ExpiryMode;IJ)Z
  */
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1open
-  (JNIEnv *, jclass, jobject, jint, jobject, jint);
+  (JNIEnv *, jclass, jobject, jint, jobject, jint, jlong);
 
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
@@ -39,10 +31,58 @@ JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1close
 JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1store_1info
 	(JNIEnv *env, jclass cls, jobject _store);
 
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_get_stats
+ * Signature: (J)Lcom/turn/fusionio/StoreStats;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1stats
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_get_cache_stats
+ * Signature: (J)Lcom/turn/fusionio/CacheStats;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1cache_1stats
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_set_group_commit
+ * Signature: (JII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1group_1commit
+  (JNIEnv *, jclass, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_set_sched
+ * Signature: (JIIII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1sched
+  (JNIEnv *, jclass, jlong, jint, jint, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_set_hot_keys
+ * Signature: (JLjava/lang/String;I)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1hot_1keys
+  (JNIEnv *, jclass, jlong, jstring, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_prefetch_hot_keys
+ * Signature: (J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1prefetch_1hot_1keys
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_get_or_create_pool
- * Signature: (Lcom/turn/fusionio/Store;Ljava/lang/String)Lcom/turn/fusionio/Pool;
+ * Signature: (Lcom/turn/fusionio/Store;Ljava/lang/String;)Lcom/turn/fusionio/Pool;
  */
 JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1or_1create_1pool
 	(JNIEnv *, jclass, jobject, jstring);
@@ -58,7 +98,7 @@ JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_delete_pool
- * Signature: (Lcom/turn/fusionio/Pool;I)Z
+ * Signature: (Lcom/turn/fusionio/Pool;)Z
  */
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1pool
 	(JNIEnv *, jclass, jobject);
@@ -66,7 +106,7 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1p
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_delete_all_pools
- * Signature: (Lcom/turn/fusionio/Store;I)Z
+ * Signature: (Lcom/turn/fusionio/Store;)Z
  */
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1all_1pools
 	(JNIEnv *, jclass, jobject);
@@ -98,7 +138,7 @@ JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1value_1l
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_get_key_info
- * Signature: (Lcom/turn/fusionio/Pool;Lcom/turn/fusionio/Key;)I
+ * Signature: (Lcom/turn/fusionio/Pool;Lcom/turn/fusionio/Key;)Lcom/turn/fusionio/KeyValueInfo;
  */
 JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1key_1info
 	(JNIEnv *env, jclass cls, jobject _pool, jobject _key);
@@ -151,6 +191,14 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1delete_1a
 JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1put
   (JNIEnv *, jclass, jobject, jobjectArray, jobjectArray);
 
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_batch_put_count
+ * Signature: (Lcom/turn/fusionio/Pool;[Lcom/turn/fusionio/Key;[Lcom/turn/fusionio/Value;)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1put_1count
+  (JNIEnv *, jclass, jobject, jobjectArray, jobjectArray);
+
 /*
  * Class:     com_turn_fusionio_FusionIOAPI
  * Method:    fio_kv_iterator
@@ -180,7 +228,7 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1curr
  * Method:    fio_kv_end_iteration
  * Signature: (Lcom/turn/fusionio/Pool;I)Z
  */
-JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1end_1iteraton
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1end_1iteration
   (JNIEnv *, jclass, jobject, jint);
 
 /*
@@ -191,6 +239,560 @@ JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1end_1iter
 JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1last_1error
   (JNIEnv *, jclass);
 
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_release_store_handle
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1release_1store_1handle
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_pool_handle
+ * Signature: (Lcom/turn/fusionio/Pool;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1pool_1handle
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_release_pool_handle
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1release_1pool_1handle
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_address
+ * Signature: (Ljava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1address
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get_value_len
+ * Signature: (JJI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1value_1len
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get
+ * Signature: (JJIJI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_put
+ * Signature: (JJIJIII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_exists
+ * Signature: (JJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_delete
+ * Signature: (JJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_compare_and_put
+ * Signature: (JJIJIII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1compare_1and_1put
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_put_if_absent
+ * Signature: (JJIJII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1if_1absent
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_increment
+ * Signature: (JJIJI[J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1increment
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jlongArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_append
+ * Signature: (JJIJII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1append
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_batch_get
+ * Signature: (Lcom/turn/fusionio/Pool;[Lcom/turn/fusionio/Key;)[Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1batch_1get
+  (JNIEnv *, jclass, jobject, jobjectArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get_alloc
+ * Signature: (JJI)Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1alloc
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_use_hugepages
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1use_1hugepages
+  (JNIEnv *, jclass, jboolean);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_get_allocator_stats
+ * Signature: ()Lcom/turn/fusionio/AllocatorStats;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1allocator_1stats
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_create
+ * Signature: (II)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1create
+  (JNIEnv *, jclass, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_get
+ * Signature: (JIJJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1get
+  (JNIEnv *, jclass, jlong, jint, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_put
+ * Signature: (JIJJIJIII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1put
+  (JNIEnv *, jclass, jlong, jint, jlong, jlong, jint, jlong, jint, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_reap
+ * Signature: (J[I)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1reap
+  (JNIEnv *, jclass, jlong, jintArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_result
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1result
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_error
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1error
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_value
+ * Signature: (JI)Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1value
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_shutdown
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1shutdown
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_async_destroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1destroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_next_batch
+ * Signature: (JIJIIZ)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1next_1batch
+  (JNIEnv *, jclass, jlong, jint, jlong, jint, jint, jboolean);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_scan_create
+ * Signature: ([JIIIIZ)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1create
+  (JNIEnv *, jclass, jlongArray, jint, jint, jint, jint, jboolean);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_scan_buffer
+ * Signature: (JI)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1buffer
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_scan_reap
+ * Signature: (J[I)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1reap
+  (JNIEnv *, jclass, jlong, jintArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_scan_release
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1release
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_scan_destroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1scan_1destroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_build_filter
+ * Signature: (JJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1build_1filter
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_save_filter
+ * Signature: (JLjava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1save_1filter
+  (JNIEnv *, jclass, jlong, jstring);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_load_filter
+ * Signature: (JLjava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1load_1filter
+  (JNIEnv *, jclass, jlong, jstring);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_set_compression
+ * Signature: (JZ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1compression
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_set_packing
+ * Signature: (JI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1set_1packing
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_shard_create
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1create
+  (JNIEnv *, jclass, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_shard_destroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1destroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_shard_of
+ * Signature: (JJI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1of
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_shard_batch
+ * Signature: (J[JI[Lcom/turn/fusionio/Key;[Lcom/turn/fusionio/Value;)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1batch
+  (JNIEnv *, jclass, jlong, jlongArray, jint, jobjectArray, jobjectArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_put_large
+ * Signature: (JJIJII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1large
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get_large
+ * Signature: (JJI)Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1large
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_delete_large
+ * Signature: (JJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1large
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_ring_create
+ * Signature: (II)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1create
+  (JNIEnv *, jclass, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_ring_buffer
+ * Signature: (J)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1buffer
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_ring_wake
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wake
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_ring_wait
+ * Signature: (JII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wait
+  (JNIEnv *, jclass, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_ring_destroy
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1destroy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_export_pool
+ * Signature: (JLjava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1export_1pool
+  (JNIEnv *, jclass, jlong, jstring);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_import_pool
+ * Signature: (JLjava/lang/String;I)J
+ */
+JNIEXPORT jlong JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1import_1pool
+  (JNIEnv *, jclass, jlong, jstring, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_put
+ * Signature: (JJII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put
+  (JNIEnv *, jclass, jlong, jlong, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_delete
+ * Signature: (J[Lcom/turn/fusionio/Key;)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1delete
+  (JNIEnv *, jclass, jlong, jobjectArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_exists
+ * Signature: (J[Lcom/turn/fusionio/Key;[B)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1exists
+  (JNIEnv *, jclass, jlong, jobjectArray, jbyteArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get_long
+ * Signature: (JJJI)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long
+  (JNIEnv *, jclass, jlong, jlong, jlong, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_get_long_alloc
+ * Signature: (JJ)Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobject JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long_1alloc
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_put_long
+ * Signature: (JJJIII)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1long
+  (JNIEnv *, jclass, jlong, jlong, jlong, jint, jint, jint);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_exists_long
+ * Signature: (JJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists_1long
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_delete_long
+ * Signature: (JJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1long
+  (JNIEnv *, jclass, jlong, jlong);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_put_long
+ * Signature: (J[J[Lcom/turn/fusionio/Value;)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put_1long
+  (JNIEnv *, jclass, jlong, jlongArray, jobjectArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_get_long
+ * Signature: (J[J)[Lcom/turn/fusionio/Value;
+ */
+JNIEXPORT jobjectArray JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1get_1long
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_delete_long
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1delete_1long
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     com_turn_fusionio_FusionIOAPI
+ * Method:    fio_kv_fast_batch_exists_long
+ * Signature: (J[J[B)I
+ */
+JNIEXPORT jint JNICALL Java_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1exists_1long
+  (JNIEnv *, jclass, jlong, jlongArray, jbyteArray);
+
+/*
+ * Critical natives.
+ *
+ * Primitive-only entry points are also exported under their JavaCritical_
+ * names, which HotSpot calls directly from compiled code without setting up
+ * a JNIEnv or transitioning the calling thread out of the VM.
+ */
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1get_1last_1error
+  (void);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1value_1len
+  (jlong, jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get
+  (jlong, jlong, jint, jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put
+  (jlong, jlong, jint, jlong, jint, jint, jint);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists
+  (jlong, jlong, jint);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete
+  (jlong, jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1compare_1and_1put
+  (jlong, jlong, jint, jlong, jint, jint, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1if_1absent
+  (jlong, jlong, jint, jlong, jint, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1append
+  (jlong, jlong, jint, jlong, jint, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1get_1long
+  (jlong, jlong, jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1put_1long
+  (jlong, jlong, jlong, jint, jint, jint);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1exists_1long
+  (jlong, jlong);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1delete_1long
+  (jlong, jlong);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1next_1batch
+  (jlong, jint, jlong, jint, jint, jboolean);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1fast_1batch_1put
+  (jlong, jlong, jint, jint);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1get
+  (jlong, jint, jlong, jlong, jint);
+JNIEXPORT jboolean JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1put
+  (jlong, jint, jlong, jlong, jint, jlong, jint, jint, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1result
+  (jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1async_1error
+  (jlong, jint);
+JNIEXPORT jint JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1shard_1of
+  (jlong, jlong, jint);
+JNIEXPORT void JNICALL JavaCritical_com_turn_fusionio_FusionIOAPI_fio_1kv_1ring_1wake
+  (jlong);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,326 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_async.h"
+
+/**
+ * Asynchronous I/O engine for the key/value store.
+ *
+ * A fixed set of worker threads execute get and put requests on behalf of
+ * submitting threads, so that a few submitters can keep many operations in
+ * flight on the device. Requests live in a preallocated array of slots; slot
+ * numbers go through a submission queue to the workers, then through a
+ * completion queue back to whoever reaps them. Both queues are bounded by the
+ * number of slots, which is the engine's in-flight limit.
+ */
+
+
+/**
+ * Append a slot to a queue. The queue must have room for it.
+ */
+void _fio_kv_async_push(fio_kv_async_queue_t *queue, const uint32_t capacity,
+		const uint32_t slot)
+{
+	assert(queue->count < capacity);
+	queue->slots[(queue->head + queue->count) % capacity] = slot;
+	queue->count++;
+}
+
+/**
+ * Remove the slot at the head of a non-empty queue.
+ */
+uint32_t _fio_kv_async_pop(fio_kv_async_queue_t *queue, const uint32_t capacity)
+{
+	assert(queue->count > 0);
+	uint32_t slot = queue->slots[queue->head];
+	queue->head = (queue->head + 1) % capacity;
+	queue->count--;
+	return slot;
+}
+
+/**
+ * Execute a request, recording its result and error code.
+ */
+void _fio_kv_async_execute(fio_kv_async_request_t *request)
+{
+	request->value.info = &request->info;
+
+	switch (request->op) {
+		case FIO_KV_ASYNC_GET:
+			request->result = fio_kv_get_alloc(request->pool, &request->key,
+					&request->value, &request->capacity);
+			if (request->result >= 0) {
+				request->info.pool_id = request->pool->id;
+				request->info.key_len = request->key.length;
+			}
+			break;
+		case FIO_KV_ASYNC_PUT:
+			request->result = fio_kv_put(request->pool, &request->key,
+					&request->value);
+			break;
+		default:
+			request->result = -1;
+			break;
+	}
+
+	request->error = request->result < 0 ? fio_kv_get_last_error() : 0;
+}
+
+/**
+ * Worker thread main loop: execute submitted requests until the engine shuts
+ * down and the submission queue is drained.
+ */
+void *_fio_kv_async_worker(void *arg)
+{
+	fio_kv_async_t *engine = (fio_kv_async_t *)arg;
+
+	pthread_mutex_lock(&engine->lock);
+	while (true) {
+		while (engine->submissions.count == 0 && !engine->stopping) {
+			pthread_cond_wait(&engine->submitted, &engine->lock);
+		}
+
+		if (engine->submissions.count == 0) {
+			break;
+		}
+
+		uint32_t slot = _fio_kv_async_pop(&engine->submissions,
+				engine->slot_count);
+		pthread_mutex_unlock(&engine->lock);
+
+		_fio_kv_async_execute(&engine->requests[slot]);
+
+		pthread_mutex_lock(&engine->lock);
+		_fio_kv_async_push(&engine->completions, engine->slot_count, slot);
+		pthread_cond_signal(&engine->completed);
+	}
+
+	engine->running--;
+	pthread_cond_broadcast(&engine->completed);
+	pthread_mutex_unlock(&engine->lock);
+	return NULL;
+}
+
+/**
+ * Create an asynchronous I/O engine and start its worker threads.
+ *
+ * The engine owns a fixed number of request slots, which bounds the number of
+ * operations in flight. The caller is responsible for handing out free slots,
+ * filling in their request with fio_kv_async_request() and submitting them
+ * with fio_kv_async_submit(). Completed slots are collected with
+ * fio_kv_async_reap(), after which they can be reused.
+ *
+ * Args:
+ *	workers (uint32_t): The number of worker threads executing requests.
+ *	slots (uint32_t): The number of request slots.
+ * Returns:
+ *	Returns a newly allocated engine, or NULL if it could not be created.
+ */
+fio_kv_async_t *fio_kv_async_create(const uint32_t workers,
+		const uint32_t slots)
+{
+	assert(workers > 0);
+	assert(slots > 0);
+
+	fio_kv_async_t *engine = (fio_kv_async_t *)calloc(1,
+			sizeof(fio_kv_async_t));
+	if (engine == NULL) {
+		return NULL;
+	}
+
+	engine->slot_count = slots;
+	engine->requests = (fio_kv_async_request_t *)calloc(slots,
+			sizeof(fio_kv_async_request_t));
+	engine->submissions.slots = (uint32_t *)calloc(slots, sizeof(uint32_t));
+	engine->completions.slots = (uint32_t *)calloc(slots, sizeof(uint32_t));
+	engine->workers = (pthread_t *)calloc(workers, sizeof(pthread_t));
+	pthread_mutex_init(&engine->lock, NULL);
+	pthread_cond_init(&engine->submitted, NULL);
+	pthread_cond_init(&engine->completed, NULL);
+
+	if (engine->requests == NULL || engine->submissions.slots == NULL ||
+			engine->completions.slots == NULL || engine->workers == NULL) {
+		fio_kv_async_destroy(engine);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&engine->lock);
+	for (uint32_t i=0; i<workers; i++) {
+		if (pthread_create(&engine->workers[i], NULL,
+					_fio_kv_async_worker, engine) != 0) {
+			break;
+		}
+
+		engine->worker_count++;
+		engine->running++;
+	}
+	pthread_mutex_unlock(&engine->lock);
+
+	if (engine->worker_count < workers) {
+		fio_kv_async_shutdown(engine);
+		fio_kv_async_destroy(engine);
+		return NULL;
+	}
+
+	return engine;
+}
+
+/**
+ * Return the request structure of the given slot.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slot (uint32_t): The request slot.
+ * Returns:
+ *	Returns a pointer to the slot's request structure.
+ */
+fio_kv_async_request_t *fio_kv_async_request(fio_kv_async_t *engine,
+		const uint32_t slot)
+{
+	assert(engine != NULL);
+	assert(slot < engine->slot_count);
+
+	return &engine->requests[slot];
+}
+
+/**
+ * Submit the request of the given slot for execution by a worker thread.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slot (uint32_t): The request slot, whose request is filled in.
+ * Returns:
+ *	Returns true if the request was queued, false if the engine is shutting
+ *	  down.
+ */
+bool fio_kv_async_submit(fio_kv_async_t *engine, const uint32_t slot)
+{
+	assert(engine != NULL);
+	assert(slot < engine->slot_count);
+
+	pthread_mutex_lock(&engine->lock);
+	if (engine->stopping) {
+		pthread_mutex_unlock(&engine->lock);
+		return false;
+	}
+
+	_fio_kv_async_push(&engine->submissions, engine->slot_count, slot);
+	pthread_cond_signal(&engine->submitted);
+	pthread_mutex_unlock(&engine->lock);
+	return true;
+}
+
+/**
+ * Wait for completed requests.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slots (uint32_t *): An array to hold the slots of the completed requests.
+ *	max (uint32_t): The size of the slots array.
+ * Returns:
+ *	Returns the number of completed requests, at least one, or -1 once the
+ *	  engine is shut down and all its completed requests have been reaped.
+ */
+int fio_kv_async_reap(fio_kv_async_t *engine, uint32_t *slots,
+		const uint32_t max)
+{
+	assert(engine != NULL);
+	assert(slots != NULL);
+	assert(max > 0);
+
+	uint32_t count = 0;
+
+	pthread_mutex_lock(&engine->lock);
+	while (engine->completions.count == 0 && engine->running > 0) {
+		pthread_cond_wait(&engine->completed, &engine->lock);
+	}
+
+	while (engine->completions.count > 0 && count < max) {
+		slots[count++] = _fio_kv_async_pop(&engine->completions,
+				engine->slot_count);
+	}
+	pthread_mutex_unlock(&engine->lock);
+
+	return count > 0 ? (int)count : -1;
+}
+
+/**
+ * Shut down an asynchronous I/O engine.
+ *
+ * Requests already submitted are executed, then the worker threads are
+ * stopped and fio_kv_async_reap() returns -1 once their completions have been
+ * collected.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ */
+void fio_kv_async_shutdown(fio_kv_async_t *engine)
+{
+	assert(engine != NULL);
+
+	pthread_mutex_lock(&engine->lock);
+	bool stopping = engine->stopping;
+	engine->stopping = true;
+	pthread_cond_broadcast(&engine->submitted);
+	pthread_mutex_unlock(&engine->lock);
+
+	if (stopping) {
+		return;
+	}
+
+	for (uint32_t i=0; i<engine->worker_count; i++) {
+		pthread_join(engine->workers[i], NULL);
+	}
+}
+
+/**
+ * Release the resources of a shut down asynchronous I/O engine.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ */
+void fio_kv_async_destroy(fio_kv_async_t *engine)
+{
+	assert(engine != NULL);
+
+	pthread_cond_destroy(&engine->completed);
+	pthread_cond_destroy(&engine->submitted);
+	pthread_mutex_destroy(&engine->lock);
+	free(engine->workers);
+	free(engine->completions.slots);
+	free(engine->submissions.slots);
+	free(engine->requests);
+	free(engine);
+}
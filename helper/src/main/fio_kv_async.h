@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_ASYNC_H__
+#define __FIO_KV_ASYNC_H__
+
+#include <pthread.h>
+
+#include "fio_kv_helper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	FIO_KV_ASYNC_GET,
+	FIO_KV_ASYNC_PUT
+} fio_kv_async_op_t;
+
+typedef struct {
+	fio_kv_async_op_t op;
+	fio_kv_pool_t *pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+	uint32_t capacity;
+	int result;
+	int error;
+} fio_kv_async_request_t;
+
+typedef struct {
+	uint32_t *slots;
+	uint32_t head;
+	uint32_t count;
+} fio_kv_async_queue_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t submitted;
+	pthread_cond_t completed;
+	fio_kv_async_request_t *requests;
+	uint32_t slot_count;
+	fio_kv_async_queue_t submissions;
+	fio_kv_async_queue_t completions;
+	pthread_t *workers;
+	uint32_t worker_count;
+	uint32_t running;
+	bool stopping;
+} fio_kv_async_t;
+
+
+/**
+ * Create an asynchronous I/O engine and start its worker threads.
+ *
+ * The engine owns a fixed number of request slots, which bounds the number of
+ * operations in flight. The caller is responsible for handing out free slots,
+ * filling in their request with fio_kv_async_request() and submitting them
+ * with fio_kv_async_submit(). Completed slots are collected with
+ * fio_kv_async_reap(), after which they can be reused.
+ *
+ * Args:
+ *	workers (uint32_t): The number of worker threads executing requests.
+ *	slots (uint32_t): The number of request slots.
+ * Returns:
+ *	Returns a newly allocated engine, or NULL if it could not be created.
+ */
+fio_kv_async_t *fio_kv_async_create(const uint32_t workers,
+		const uint32_t slots);
+
+/**
+ * Return the request structure of the given slot.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slot (uint32_t): The request slot.
+ * Returns:
+ *	Returns a pointer to the slot's request structure.
+ */
+fio_kv_async_request_t *fio_kv_async_request(fio_kv_async_t *engine,
+		const uint32_t slot);
+
+/**
+ * Submit the request of the given slot for execution by a worker thread.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slot (uint32_t): The request slot, whose request is filled in.
+ * Returns:
+ *	Returns true if the request was queued, false if the engine is shutting
+ *	  down.
+ */
+bool fio_kv_async_submit(fio_kv_async_t *engine, const uint32_t slot);
+
+/**
+ * Wait for completed requests.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ *	slots (uint32_t *): An array to hold the slots of the completed requests.
+ *	max (uint32_t): The size of the slots array.
+ * Returns:
+ *	Returns the number of completed requests, at least one, or -1 once the
+ *	  engine is shut down and all its completed requests have been reaped.
+ */
+int fio_kv_async_reap(fio_kv_async_t *engine, uint32_t *slots,
+		const uint32_t max);
+
+/**
+ * Shut down an asynchronous I/O engine.
+ *
+ * Requests already submitted are executed, then the worker threads are
+ * stopped and fio_kv_async_reap() returns -1 once their completions have been
+ * collected.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ */
+void fio_kv_async_shutdown(fio_kv_async_t *engine);
+
+/**
+ * Release the resources of a shut down asynchronous I/O engine.
+ *
+ * Args:
+ *	engine (fio_kv_async_t *): The asynchronous I/O engine.
+ */
+void fio_kv_async_destroy(fio_kv_async_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_ASYNC_H__ */
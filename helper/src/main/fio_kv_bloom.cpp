@@ -0,0 +1,340 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fio_kv_bloom.h"
+
+/**
+ * Bloom filters over the keys of a pool.
+ *
+ * A Bloom filter answers whether a key may be present with no false
+ * negatives, so that lookups of absent keys can be answered without a device
+ * I/O. Bits are set with atomic operations, which lets writers add keys
+ * while readers consult the filter. Keys can't be removed from a Bloom
+ * filter: keys deleted from the pool, or expired, remain positives until the
+ * filter is rebuilt, which only costs the device lookup the filter would
+ * otherwise have saved.
+ *
+ * Each key sets FIO_KV_BLOOM_HASHES bits, derived from a single 64-bit hash
+ * of the key with double hashing.
+ */
+
+/**
+ * Build a 64-bit constant from its two halves, as long long literals are not
+ * available to us.
+ */
+#define _FIO_KV_U64(high, low)		(((uint64_t)(high) << 32) | (low))
+
+#define _FIO_KV_BLOOM_MAGIC			_FIO_KV_U64(0x4d4c4256, 0x4b4f4946) // "FIOKVBLM"
+#define _FIO_KV_BLOOM_VERSION		1
+#define _FIO_KV_BLOOM_MIN_BITS		512
+#define _FIO_KV_BLOOM_MAX_BITS		((uint64_t)1 << 40)
+
+
+/**
+ * Hash a key with the 64-bit FNV-1a function, then mix the result so that
+ * its high and low halves can both be used.
+ */
+uint64_t _fio_kv_bloom_hash(const void *key, const uint32_t key_len)
+{
+	const unsigned char *p = (const unsigned char *)key;
+	uint64_t hash = _FIO_KV_U64(0xcbf29ce4, 0x84222325);
+
+	for (uint32_t i=0; i<key_len; i++) {
+		hash = (hash ^ p[i]) * _FIO_KV_U64(0x00000100, 0x000001b3);
+	}
+
+	hash ^= hash >> 33;
+	hash *= _FIO_KV_U64(0xff51afd7, 0xed558ccd);
+	hash ^= hash >> 33;
+	hash *= _FIO_KV_U64(0xc4ceb9fe, 0x1a85ec53);
+	hash ^= hash >> 33;
+	return hash;
+}
+
+/**
+ * Return the step between the bits of a key, from its hash. The step is odd
+ * so that the bits of a key are all distinct.
+ */
+uint64_t _fio_kv_bloom_step(const uint64_t hash)
+{
+	return ((hash >> 32) | (hash << 32)) | 1;
+}
+
+/**
+ * Return the size of a filter's bit array, in bytes.
+ */
+size_t _fio_kv_bloom_size(const fio_kv_bloom_t *bloom)
+{
+	return (size_t)(bloom->bit_count / 8);
+}
+
+/**
+ * Allocate a filter with the given number of bits, a power of two, all
+ * cleared.
+ */
+fio_kv_bloom_t *_fio_kv_bloom_alloc(const uint64_t bit_count,
+		const uint32_t hashes)
+{
+	fio_kv_bloom_t *bloom = (fio_kv_bloom_t *)malloc(sizeof(fio_kv_bloom_t));
+	if (bloom == NULL) {
+		return NULL;
+	}
+
+	bloom->bits = (uint64_t *)calloc(bit_count / 64, sizeof(uint64_t));
+	if (bloom->bits == NULL) {
+		free(bloom);
+		return NULL;
+	}
+
+	bloom->bit_count = bit_count;
+	bloom->hashes = hashes;
+	bloom->ready = 0;
+	bloom->retired = 0;
+	bloom->previous = NULL;
+	return bloom;
+}
+
+/**
+ * Create an empty Bloom filter sized for the given number of keys.
+ *
+ * The filter is created not ready: keys can be added to it, but it must not
+ * be consulted until it has been filled with all the keys of its pool and
+ * marked ready.
+ *
+ * Args:
+ *	capacity (uint64_t): The expected number of keys.
+ * Returns:
+ *	Returns a newly allocated filter, or NULL if it could not be allocated.
+ */
+fio_kv_bloom_t *fio_kv_bloom_create(const uint64_t capacity)
+{
+	uint64_t bit_count = _FIO_KV_BLOOM_MIN_BITS;
+
+	while (bit_count < capacity * FIO_KV_BLOOM_BITS_PER_KEY &&
+			bit_count < _FIO_KV_BLOOM_MAX_BITS) {
+		bit_count *= 2;
+	}
+
+	return _fio_kv_bloom_alloc(bit_count, FIO_KV_BLOOM_HASHES);
+}
+
+/**
+ * Release a Bloom filter.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ */
+void fio_kv_bloom_destroy(fio_kv_bloom_t *bloom)
+{
+	assert(bloom != NULL);
+
+	free(bloom->bits);
+	free(bloom);
+}
+
+/**
+ * Add a key to a Bloom filter. Keys can be added concurrently with other
+ * additions and lookups.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ */
+void fio_kv_bloom_add(fio_kv_bloom_t *bloom, const void *key,
+		const uint32_t key_len)
+{
+	assert(bloom != NULL);
+	assert(key != NULL);
+
+	uint64_t hash = _fio_kv_bloom_hash(key, key_len);
+	uint64_t step = _fio_kv_bloom_step(hash);
+	uint64_t mask = bloom->bit_count - 1;
+
+	for (uint32_t i=0; i<bloom->hashes; i++) {
+		uint64_t bit = (hash + i * step) & mask;
+		uint64_t flag = (uint64_t)1 << (bit % 64);
+
+		// Most bits of keys being re-written are already set; only pay for
+		// the atomic operation when needed.
+		if ((((volatile uint64_t *)bloom->bits)[bit / 64] & flag) == 0) {
+			__sync_fetch_and_or(&bloom->bits[bit / 64], flag);
+		}
+	}
+}
+
+/**
+ * Tell whether a key may have been added to a Bloom filter.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns false if the key was definitely never added, true otherwise.
+ */
+bool fio_kv_bloom_may_contain(const fio_kv_bloom_t *bloom, const void *key,
+		const uint32_t key_len)
+{
+	assert(bloom != NULL);
+	assert(key != NULL);
+
+	uint64_t hash = _fio_kv_bloom_hash(key, key_len);
+	uint64_t step = _fio_kv_bloom_step(hash);
+	uint64_t mask = bloom->bit_count - 1;
+
+	for (uint32_t i=0; i<bloom->hashes; i++) {
+		uint64_t bit = (hash + i * step) & mask;
+		if ((((volatile uint64_t *)bloom->bits)[bit / 64] &
+				((uint64_t)1 << (bit % 64))) == 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Write a Bloom filter to a file.
+ *
+ * The filter is written to a temporary file which then replaces the given
+ * file, so that an interrupted save never leaves a truncated filter behind.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	pool_id (uint32_t): The ID of the pool the filter covers, recorded in
+ *	  the file.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns true if the filter was written, false otherwise.
+ */
+bool fio_kv_bloom_save(const fio_kv_bloom_t *bloom, const uint32_t pool_id,
+		const char *path)
+{
+	assert(bloom != NULL);
+	assert(path != NULL);
+
+	fio_kv_bloom_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = _FIO_KV_BLOOM_MAGIC;
+	header.version = _FIO_KV_BLOOM_VERSION;
+	header.pool_id = pool_id;
+	header.bit_count = bloom->bit_count;
+	header.hashes = bloom->hashes;
+
+	size_t length = strlen(path);
+	char *tmp = (char *)malloc(length + 5);
+	if (tmp == NULL) {
+		return false;
+	}
+	memcpy(tmp, path, length);
+	memcpy(tmp + length, ".tmp", 5);
+
+	FILE *f = fopen(tmp, "wb");
+	if (f == NULL) {
+		free(tmp);
+		return false;
+	}
+
+	bool ret = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(bloom->bits, _fio_kv_bloom_size(bloom), 1, f) == 1 &&
+		fflush(f) == 0 &&
+		fsync(fileno(f)) == 0;
+	ret = fclose(f) == 0 && ret;
+	ret = ret && rename(tmp, path) == 0;
+
+	if (!ret) {
+		unlink(tmp);
+	}
+
+	free(tmp);
+	return ret;
+}
+
+/**
+ * Read a Bloom filter written by fio_kv_bloom_save().
+ *
+ * Args:
+ *	path (char *): The path of the file.
+ *	pool_id (uint32_t): The ID of the pool the filter must cover.
+ * Returns:
+ *	Returns a newly allocated, ready filter, or NULL if it could not be
+ *	  read, with errno set to EINVAL if the file doesn't hold a filter for
+ *	  the given pool.
+ */
+fio_kv_bloom_t *fio_kv_bloom_load(const char *path, const uint32_t pool_id)
+{
+	assert(path != NULL);
+
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return NULL;
+	}
+
+	fio_kv_bloom_header_t header;
+	if (fread(&header, sizeof(header), 1, f) != 1 ||
+			header.magic != _FIO_KV_BLOOM_MAGIC ||
+			header.version != _FIO_KV_BLOOM_VERSION ||
+			header.pool_id != pool_id ||
+			header.bit_count < _FIO_KV_BLOOM_MIN_BITS ||
+			header.bit_count > _FIO_KV_BLOOM_MAX_BITS ||
+			(header.bit_count & (header.bit_count - 1)) != 0 ||
+			header.hashes < 1 || header.hashes > 32) {
+		fclose(f);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fio_kv_bloom_t *bloom = _fio_kv_bloom_alloc(header.bit_count,
+			header.hashes);
+	if (bloom == NULL) {
+		fclose(f);
+		return NULL;
+	}
+
+	if (fread(bloom->bits, _fio_kv_bloom_size(bloom), 1, f) != 1) {
+		fclose(f);
+		fio_kv_bloom_destroy(bloom);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fclose(f);
+	bloom->ready = 1;
+	return bloom;
+}
@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_BLOOM_H__
+#define __FIO_KV_BLOOM_H__
+
+#include <stdint.h>
+
+/**
+ * Number of filter bits per expected key, and number of bits set per key.
+ * Together they give a false positive rate of about 1%.
+ */
+#define FIO_KV_BLOOM_BITS_PER_KEY			10
+#define FIO_KV_BLOOM_HASHES					7
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _fio_kv_bloom {
+	uint64_t *bits;
+	uint64_t bit_count;
+	uint32_t hashes;
+	volatile uint32_t ready;
+	volatile uint32_t retired;
+	struct _fio_kv_bloom *previous;
+} fio_kv_bloom_t;
+
+typedef struct {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t pool_id;
+	uint64_t bit_count;
+	uint32_t hashes;
+	uint32_t reserved;
+} fio_kv_bloom_header_t;
+
+
+/**
+ * Create an empty Bloom filter sized for the given number of keys.
+ *
+ * The filter is created not ready: keys can be added to it, but it must not
+ * be consulted until it has been filled with all the keys of its pool and
+ * marked ready.
+ *
+ * Args:
+ *	capacity (uint64_t): The expected number of keys.
+ * Returns:
+ *	Returns a newly allocated filter, or NULL if it could not be allocated.
+ */
+fio_kv_bloom_t *fio_kv_bloom_create(const uint64_t capacity);
+
+/**
+ * Release a Bloom filter.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ */
+void fio_kv_bloom_destroy(fio_kv_bloom_t *bloom);
+
+/**
+ * Add a key to a Bloom filter. Keys can be added concurrently with other
+ * additions and lookups.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ */
+void fio_kv_bloom_add(fio_kv_bloom_t *bloom, const void *key,
+		const uint32_t key_len);
+
+/**
+ * Tell whether a key may have been added to a Bloom filter.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns false if the key was definitely never added, true otherwise.
+ */
+bool fio_kv_bloom_may_contain(const fio_kv_bloom_t *bloom, const void *key,
+		const uint32_t key_len);
+
+/**
+ * Write a Bloom filter to a file.
+ *
+ * The filter is written to a temporary file which then replaces the given
+ * file, so that an interrupted save never leaves a truncated filter behind.
+ *
+ * Args:
+ *	bloom (fio_kv_bloom_t *): The Bloom filter.
+ *	pool_id (uint32_t): The ID of the pool the filter covers, recorded in
+ *	  the file.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns true if the filter was written, false otherwise.
+ */
+bool fio_kv_bloom_save(const fio_kv_bloom_t *bloom, const uint32_t pool_id,
+		const char *path);
+
+/**
+ * Read a Bloom filter written by fio_kv_bloom_save().
+ *
+ * Args:
+ *	path (char *): The path of the file.
+ *	pool_id (uint32_t): The ID of the pool the filter must cover.
+ * Returns:
+ *	Returns a newly allocated, ready filter, or NULL if it could not be
+ *	  read, with errno set to EINVAL if the file doesn't hold a filter for
+ *	  the given pool.
+ */
+fio_kv_bloom_t *fio_kv_bloom_load(const char *path, const uint32_t pool_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_BLOOM_H__ */
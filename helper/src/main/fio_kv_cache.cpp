@@ -0,0 +1,620 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fio_kv_cache.h"
+
+/**
+ * In-process read cache for the key/value store.
+ *
+ * Key/value pairs read from the device are kept in DRAM, so that reads of
+ * hot keys don't cost a device I/O each. The cache is split into shards,
+ * each protected by its own lock, with its own chained hash table and byte
+ * budget. Entries are single allocations holding the key and value bytes
+ * right after their header. Eviction uses the CLOCK algorithm: the shard's
+ * entries form a ring swept by a hand that clears the referenced bit of
+ * entries read since its last pass, and evicts the first entry found not
+ * referenced.
+ *
+ * Writes and removals invalidate entries rather than updating them, and bump
+ * the shard's epoch so that a read that raced with them can't fill the
+ * cache with the value it read before the update.
+ */
+
+#define _FIO_KV_CACHE_INITIAL_SIZE		64
+
+
+/**
+ * Hash a pool ID and key with the 32-bit FNV-1a function.
+ */
+uint32_t _fio_kv_cache_hash(const uint32_t pool_id, const void *key,
+		const uint32_t key_len)
+{
+	const unsigned char *p = (const unsigned char *)&pool_id;
+	uint32_t hash = 2166136261U;
+
+	for (size_t i=0; i<sizeof(pool_id); i++) {
+		hash = (hash ^ p[i]) * 16777619U;
+	}
+
+	p = (const unsigned char *)key;
+	for (uint32_t i=0; i<key_len; i++) {
+		hash = (hash ^ p[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+/**
+ * Return the shard responsible for the given hash. The shard is picked from
+ * the high bits of the hash, the low bits picking the bucket within it.
+ */
+fio_kv_cache_shard_t *_fio_kv_cache_shard(fio_kv_cache_t *cache,
+		const uint32_t hash)
+{
+	return &cache->shards[(hash >> 16) % FIO_KV_CACHE_SHARDS];
+}
+
+/**
+ * Return the number of bytes accounted for an entry.
+ */
+uint64_t _fio_kv_cache_entry_size(const uint32_t key_len,
+		const uint32_t value_len)
+{
+	return sizeof(fio_kv_cache_entry_t) + key_len + value_len;
+}
+
+/**
+ * Return a pointer to the key bytes of an entry, followed by its value.
+ */
+char *_fio_kv_cache_data(fio_kv_cache_entry_t *entry)
+{
+	return (char *)(entry + 1);
+}
+
+/**
+ * Find the link pointing to the entry of a key in a shard, or to the end of
+ * its bucket's chain if it isn't cached. Called with the shard's lock held.
+ */
+fio_kv_cache_entry_t **_fio_kv_cache_find(fio_kv_cache_shard_t *shard,
+		const uint32_t hash, const uint32_t pool_id, const void *key,
+		const uint32_t key_len)
+{
+	fio_kv_cache_entry_t **link =
+		&shard->buckets[hash & (shard->bucket_count - 1)];
+
+	while (*link != NULL) {
+		fio_kv_cache_entry_t *entry = *link;
+		if (entry->hash == hash && entry->pool_id == pool_id &&
+				entry->key_len == key_len &&
+				memcmp(_fio_kv_cache_data(entry), key, key_len) == 0) {
+			break;
+		}
+		link = &entry->next;
+	}
+
+	return link;
+}
+
+/**
+ * Remove the entry a link points to from its shard, and free it. The last
+ * entry of the ring takes its slot. Called with the shard's lock held.
+ */
+void _fio_kv_cache_remove(fio_kv_cache_shard_t *shard,
+		fio_kv_cache_entry_t **link)
+{
+	fio_kv_cache_entry_t *entry = *link;
+	fio_kv_cache_entry_t *last = shard->ring[--shard->ring_count];
+
+	*link = entry->next;
+	shard->ring[entry->slot] = last;
+	last->slot = entry->slot;
+	if (shard->hand >= shard->ring_count) {
+		shard->hand = 0;
+	}
+
+	shard->stats.entries--;
+	shard->stats.bytes -= _fio_kv_cache_entry_size(entry->key_len,
+			entry->value_len);
+	free(entry);
+}
+
+/**
+ * Remove the entry at the given slot of a shard's ring. Called with the
+ * shard's lock held.
+ */
+void _fio_kv_cache_remove_slot(fio_kv_cache_shard_t *shard,
+		const uint32_t slot)
+{
+	fio_kv_cache_entry_t *entry = shard->ring[slot];
+	fio_kv_cache_entry_t **link =
+		&shard->buckets[entry->hash & (shard->bucket_count - 1)];
+
+	while (*link != entry) {
+		link = &(*link)->next;
+	}
+
+	_fio_kv_cache_remove(shard, link);
+}
+
+/**
+ * Evict one entry from a non-empty shard with the CLOCK algorithm. Called
+ * with the shard's lock held.
+ */
+void _fio_kv_cache_evict(fio_kv_cache_shard_t *shard)
+{
+	assert(shard->ring_count > 0);
+
+	while (shard->ring[shard->hand]->referenced) {
+		shard->ring[shard->hand]->referenced = false;
+		shard->hand = (shard->hand + 1) % shard->ring_count;
+	}
+
+	_fio_kv_cache_remove_slot(shard, shard->hand);
+	shard->stats.evictions++;
+}
+
+/**
+ * Make room for one more entry in a shard's ring, and grow its hash table
+ * once its chains get long. Called with the shard's lock held.
+ *
+ * Returns false if the ring could not be grown.
+ */
+bool _fio_kv_cache_reserve(fio_kv_cache_shard_t *shard)
+{
+	if (shard->ring_count == shard->ring_capacity) {
+		fio_kv_cache_entry_t **ring = (fio_kv_cache_entry_t **)realloc(
+				shard->ring, 2 * shard->ring_capacity * sizeof(*ring));
+		if (ring == NULL) {
+			return false;
+		}
+
+		shard->ring = ring;
+		shard->ring_capacity *= 2;
+	}
+
+	if (shard->ring_count < 2 * shard->bucket_count) {
+		return true;
+	}
+
+	// Rehash all entries, found from the ring, into a table twice as large.
+	// The current table is kept if a larger one can't be allocated.
+	uint32_t bucket_count = 2 * shard->bucket_count;
+	fio_kv_cache_entry_t **buckets = (fio_kv_cache_entry_t **)calloc(
+			bucket_count, sizeof(*buckets));
+	if (buckets == NULL) {
+		return true;
+	}
+
+	for (uint32_t i=0; i<shard->ring_count; i++) {
+		fio_kv_cache_entry_t *entry = shard->ring[i];
+		uint32_t bucket = entry->hash & (bucket_count - 1);
+		entry->next = buckets[bucket];
+		buckets[bucket] = entry;
+	}
+
+	free(shard->buckets);
+	shard->buckets = buckets;
+	shard->bucket_count = bucket_count;
+	return true;
+}
+
+/**
+ * Create a read cache holding up to the given number of bytes.
+ *
+ * The budget is split evenly between the cache's shards, and accounts for
+ * the keys, values and bookkeeping of the cached entries.
+ *
+ * Args:
+ *	size (uint64_t): The cache's byte budget.
+ * Returns:
+ *	Returns a newly allocated cache, or NULL if it could not be allocated.
+ */
+fio_kv_cache_t *fio_kv_cache_create(const uint64_t size)
+{
+	fio_kv_cache_t *cache = (fio_kv_cache_t *)calloc(1,
+			sizeof(fio_kv_cache_t));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	for (uint32_t i=0; i<FIO_KV_CACHE_SHARDS; i++) {
+		fio_kv_cache_shard_t *shard = &cache->shards[i];
+		pthread_mutex_init(&shard->lock, NULL);
+		shard->bucket_count = _FIO_KV_CACHE_INITIAL_SIZE;
+		shard->buckets = (fio_kv_cache_entry_t **)calloc(
+				shard->bucket_count, sizeof(fio_kv_cache_entry_t *));
+		shard->ring_capacity = _FIO_KV_CACHE_INITIAL_SIZE;
+		shard->ring = (fio_kv_cache_entry_t **)malloc(
+				shard->ring_capacity * sizeof(fio_kv_cache_entry_t *));
+		shard->budget = size / FIO_KV_CACHE_SHARDS;
+		shard->stats.capacity = shard->budget;
+	}
+
+	for (uint32_t i=0; i<FIO_KV_CACHE_SHARDS; i++) {
+		if (cache->shards[i].buckets == NULL ||
+				cache->shards[i].ring == NULL) {
+			fio_kv_cache_destroy(cache);
+			return NULL;
+		}
+	}
+
+	return cache;
+}
+
+/**
+ * Release a read cache and all its entries.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ */
+void fio_kv_cache_destroy(fio_kv_cache_t *cache)
+{
+	assert(cache != NULL);
+
+	for (uint32_t i=0; i<FIO_KV_CACHE_SHARDS; i++) {
+		fio_kv_cache_shard_t *shard = &cache->shards[i];
+		for (uint32_t j=0; j<shard->ring_count; j++) {
+			free(shard->ring[j]);
+		}
+
+		free(shard->ring);
+		free(shard->buckets);
+		pthread_mutex_destroy(&shard->lock);
+	}
+
+	free(cache);
+}
+
+/**
+ * Look up a key/value pair in a read cache.
+ *
+ * On a hit, up to size bytes of the value are copied into the given buffer
+ * and the info structure is filled in as nvm_kv_get() would, its value_len
+ * field holding the full length of the value. On a miss, the shard's epoch
+ * is returned for the following fio_kv_cache_fill() call.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	buffer (void *): The buffer to copy the value into.
+ *	size (uint32_t): The size of the buffer.
+ *	info (nvm_kv_key_info_t *): The structure to fill in with the key/value
+ *	  pair information.
+ *	epoch (uint64_t *): Set to the shard's epoch on a miss.
+ * Returns:
+ *	Returns the number of bytes copied, or -1 on a miss.
+ */
+int fio_kv_cache_get(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, void *buffer,
+		const uint32_t size, nvm_kv_key_info_t *info, uint64_t *epoch)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+	assert(info != NULL);
+	assert(epoch != NULL);
+
+	uint32_t hash = _fio_kv_cache_hash(pool_id, key, key_len);
+	fio_kv_cache_shard_t *shard = _fio_kv_cache_shard(cache, hash);
+
+	pthread_mutex_lock(&shard->lock);
+	fio_kv_cache_entry_t **link = _fio_kv_cache_find(shard, hash, pool_id,
+			key, key_len);
+	fio_kv_cache_entry_t *entry = *link;
+
+	if (entry != NULL && entry->expiry != 0 &&
+			entry->expiry <= (uint32_t)time(NULL)) {
+		_fio_kv_cache_remove(shard, link);
+		shard->stats.expirations++;
+		entry = NULL;
+	}
+
+	if (entry == NULL) {
+		shard->stats.misses++;
+		*epoch = shard->epoch;
+		pthread_mutex_unlock(&shard->lock);
+		return -1;
+	}
+
+	uint32_t n = entry->value_len < size ? entry->value_len : size;
+	memcpy(buffer, _fio_kv_cache_data(entry) + key_len, n);
+	info->pool_id = pool_id;
+	info->key_len = key_len;
+	info->value_len = entry->value_len;
+	info->expiry = entry->expiry;
+	info->gen_count = entry->gen_count;
+
+	entry->referenced = true;
+	shard->stats.hits++;
+	pthread_mutex_unlock(&shard->lock);
+	return (int)n;
+}
+
+/**
+ * Insert a key/value pair just read from the device into a read cache.
+ *
+ * The pair is only inserted if its shard wasn't invalidated since the miss
+ * that led to reading it, so that a value read concurrently with its update
+ * or removal never makes it into the cache. Values too large for the shard,
+ * and pairs whose expiry is already past, are not cached. Entries are
+ * evicted with the CLOCK algorithm to make room for the new one.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The full value.
+ *	info (nvm_kv_key_info_t *): The key/value pair information, as reported
+ *	  by the device.
+ *	epoch (uint64_t): The shard's epoch returned by fio_kv_cache_get().
+ * Returns:
+ *	Returns true if the pair was inserted, false otherwise.
+ */
+bool fio_kv_cache_fill(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, const void *value,
+		const nvm_kv_key_info_t *info, const uint64_t epoch)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+	assert(value != NULL || info->value_len == 0);
+	assert(info != NULL);
+
+	uint32_t hash = _fio_kv_cache_hash(pool_id, key, key_len);
+	fio_kv_cache_shard_t *shard = _fio_kv_cache_shard(cache, hash);
+	uint64_t size = _fio_kv_cache_entry_size(key_len, info->value_len);
+
+	// The expiry reported by the device is an absolute time. Pairs that
+	// would expire right away are not worth caching.
+	if (size > shard->budget / FIO_KV_CACHE_MAX_ENTRY_RATIO ||
+			(info->expiry != 0 && info->expiry <= (uint32_t)time(NULL))) {
+		return false;
+	}
+
+	fio_kv_cache_entry_t *entry = (fio_kv_cache_entry_t *)malloc(size);
+	if (entry == NULL) {
+		return false;
+	}
+
+	entry->hash = hash;
+	entry->pool_id = pool_id;
+	entry->key_len = key_len;
+	entry->value_len = info->value_len;
+	entry->expiry = info->expiry;
+	entry->gen_count = info->gen_count;
+	entry->referenced = false;
+	memcpy(_fio_kv_cache_data(entry), key, key_len);
+	memcpy(_fio_kv_cache_data(entry) + key_len, value, info->value_len);
+
+	pthread_mutex_lock(&shard->lock);
+	if (shard->epoch != epoch) {
+		pthread_mutex_unlock(&shard->lock);
+		free(entry);
+		return false;
+	}
+
+	fio_kv_cache_entry_t **link = _fio_kv_cache_find(shard, hash, pool_id,
+			key, key_len);
+	if (*link != NULL) {
+		_fio_kv_cache_remove(shard, link);
+	}
+
+	while (shard->ring_count > 0 && shard->stats.bytes + size > shard->budget) {
+		_fio_kv_cache_evict(shard);
+	}
+
+	if (!_fio_kv_cache_reserve(shard)) {
+		pthread_mutex_unlock(&shard->lock);
+		free(entry);
+		return false;
+	}
+
+	uint32_t bucket = hash & (shard->bucket_count - 1);
+	entry->next = shard->buckets[bucket];
+	shard->buckets[bucket] = entry;
+	entry->slot = shard->ring_count;
+	shard->ring[shard->ring_count++] = entry;
+
+	shard->stats.insertions++;
+	shard->stats.entries++;
+	shard->stats.bytes += size;
+	pthread_mutex_unlock(&shard->lock);
+	return true;
+}
+
+/**
+ * Check whether a key/value pair is in a read cache, without counting a hit
+ * or a miss, nor marking it as referenced.
+ *
+ * When the pair isn't cached, the shard's epoch is returned for a following
+ * fio_kv_cache_fill() call, as fio_kv_cache_get() would on a miss.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	epoch (uint64_t *): Set to the shard's epoch if the pair isn't cached.
+ * Returns:
+ *	Returns true if the pair is cached, false otherwise.
+ */
+bool fio_kv_cache_contains(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, uint64_t *epoch)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+	assert(epoch != NULL);
+
+	uint32_t hash = _fio_kv_cache_hash(pool_id, key, key_len);
+	fio_kv_cache_shard_t *shard = _fio_kv_cache_shard(cache, hash);
+
+	pthread_mutex_lock(&shard->lock);
+	bool cached = *_fio_kv_cache_find(shard, hash, pool_id, key,
+			key_len) != NULL;
+	*epoch = shard->epoch;
+	pthread_mutex_unlock(&shard->lock);
+	return cached;
+}
+
+/**
+ * Remove a key/value pair from a read cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ */
+void fio_kv_cache_invalidate(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+
+	uint32_t hash = _fio_kv_cache_hash(pool_id, key, key_len);
+	fio_kv_cache_shard_t *shard = _fio_kv_cache_shard(cache, hash);
+
+	pthread_mutex_lock(&shard->lock);
+	shard->epoch++;
+	fio_kv_cache_entry_t **link = _fio_kv_cache_find(shard, hash, pool_id,
+			key, key_len);
+	if (*link != NULL) {
+		_fio_kv_cache_remove(shard, link);
+		shard->stats.invalidations++;
+	}
+	pthread_mutex_unlock(&shard->lock);
+}
+
+/**
+ * Remove all the key/value pairs of a pool, or of all pools, from a read
+ * cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (int): The ID of the pool, or -1 for all pools.
+ */
+void fio_kv_cache_invalidate_pool(fio_kv_cache_t *cache, const int pool_id)
+{
+	assert(cache != NULL);
+
+	for (uint32_t i=0; i<FIO_KV_CACHE_SHARDS; i++) {
+		fio_kv_cache_shard_t *shard = &cache->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		shard->epoch++;
+
+		// Walk the ring backwards: removing an entry moves the last one,
+		// which was already looked at, into its slot.
+		for (uint32_t slot=shard->ring_count; slot-- > 0; ) {
+			if (pool_id < 0 ||
+					shard->ring[slot]->pool_id == (uint32_t)pool_id) {
+				_fio_kv_cache_remove_slot(shard, slot);
+				shard->stats.invalidations++;
+			}
+		}
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
+
+/**
+ * Call a function on the entries of a read cache that were, or weren't,
+ * read since the last pass of their shard's CLOCK hand.
+ *
+ * Each shard is locked while its entries are visited, so the visitor must
+ * not call back into the cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	referenced (bool): Whether to visit the referenced or the unreferenced
+ *	  entries.
+ *	visitor (fio_kv_cache_visitor_t): The function to call on each entry.
+ *	arg (void *): The first argument of the visitor.
+ */
+void fio_kv_cache_visit(fio_kv_cache_t *cache, const bool referenced,
+		const fio_kv_cache_visitor_t visitor, void *arg)
+{
+	assert(cache != NULL);
+	assert(visitor != NULL);
+
+	bool visiting = true;
+	for (uint32_t i=0; visiting && i<FIO_KV_CACHE_SHARDS; i++) {
+		fio_kv_cache_shard_t *shard = &cache->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		for (uint32_t slot=0; visiting && slot<shard->ring_count; slot++) {
+			fio_kv_cache_entry_t *entry = shard->ring[slot];
+			if (entry->referenced == referenced) {
+				visiting = visitor(arg, entry->pool_id,
+						_fio_kv_cache_data(entry), entry->key_len,
+						entry->value_len);
+			}
+		}
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
+
+/**
+ * Retrieve the statistics of a read cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	stats (fio_kv_cache_stats_t *): The structure to fill in with the
+ *	  counters summed over all shards.
+ */
+void fio_kv_cache_get_stats(fio_kv_cache_t *cache,
+		fio_kv_cache_stats_t *stats)
+{
+	assert(cache != NULL);
+	assert(stats != NULL);
+
+	memset(stats, 0, sizeof(fio_kv_cache_stats_t));
+	for (uint32_t i=0; i<FIO_KV_CACHE_SHARDS; i++) {
+		fio_kv_cache_shard_t *shard = &cache->shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		stats->hits += shard->stats.hits;
+		stats->misses += shard->stats.misses;
+		stats->insertions += shard->stats.insertions;
+		stats->evictions += shard->stats.evictions;
+		stats->expirations += shard->stats.expirations;
+		stats->invalidations += shard->stats.invalidations;
+		stats->entries += shard->stats.entries;
+		stats->bytes += shard->stats.bytes;
+		stats->capacity += shard->stats.capacity;
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
@@ -0,0 +1,247 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_CACHE_H__
+#define __FIO_KV_CACHE_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <nvm/nvm_kv.h>
+
+/**
+ * Number of independently locked shards of a read cache.
+ */
+#define FIO_KV_CACHE_SHARDS					16
+
+/**
+ * Fraction of a shard's byte budget above which values are not cached, so
+ * that a single large value can't flush a whole shard.
+ */
+#define FIO_KV_CACHE_MAX_ENTRY_RATIO		8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _fio_kv_cache_entry {
+	struct _fio_kv_cache_entry *next;
+	uint32_t hash;
+	uint32_t pool_id;
+	uint32_t key_len;
+	uint32_t value_len;
+	uint32_t expiry;
+	uint32_t gen_count;
+	uint32_t slot;
+	bool referenced;
+} fio_kv_cache_entry_t;
+
+typedef struct {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t insertions;
+	uint64_t evictions;
+	uint64_t expirations;
+	uint64_t invalidations;
+	uint64_t entries;
+	uint64_t bytes;
+	uint64_t capacity;
+} fio_kv_cache_stats_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	fio_kv_cache_entry_t **buckets;
+	uint32_t bucket_count;
+	fio_kv_cache_entry_t **ring;
+	uint32_t ring_count;
+	uint32_t ring_capacity;
+	uint32_t hand;
+	uint64_t budget;
+	uint64_t epoch;
+	fio_kv_cache_stats_t stats;
+} fio_kv_cache_shard_t;
+
+typedef struct {
+	fio_kv_cache_shard_t shards[FIO_KV_CACHE_SHARDS];
+} fio_kv_cache_t;
+
+/**
+ * Function called on the entries of a read cache by fio_kv_cache_visit(),
+ * returning false to stop the visit.
+ */
+typedef bool (*fio_kv_cache_visitor_t)(void *arg, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, const uint32_t value_len);
+
+
+/**
+ * Create a read cache holding up to the given number of bytes.
+ *
+ * The budget is split evenly between the cache's shards, and accounts for
+ * the keys, values and bookkeeping of the cached entries.
+ *
+ * Args:
+ *	size (uint64_t): The cache's byte budget.
+ * Returns:
+ *	Returns a newly allocated cache, or NULL if it could not be allocated.
+ */
+fio_kv_cache_t *fio_kv_cache_create(const uint64_t size);
+
+/**
+ * Release a read cache and all its entries.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ */
+void fio_kv_cache_destroy(fio_kv_cache_t *cache);
+
+/**
+ * Look up a key/value pair in a read cache.
+ *
+ * On a hit, up to size bytes of the value are copied into the given buffer
+ * and the info structure is filled in as nvm_kv_get() would, its value_len
+ * field holding the full length of the value. On a miss, the shard's epoch
+ * is returned for the following fio_kv_cache_fill() call.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	buffer (void *): The buffer to copy the value into.
+ *	size (uint32_t): The size of the buffer.
+ *	info (nvm_kv_key_info_t *): The structure to fill in with the key/value
+ *	  pair information.
+ *	epoch (uint64_t *): Set to the shard's epoch on a miss.
+ * Returns:
+ *	Returns the number of bytes copied, or -1 on a miss.
+ */
+int fio_kv_cache_get(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, void *buffer,
+		const uint32_t size, nvm_kv_key_info_t *info, uint64_t *epoch);
+
+/**
+ * Insert a key/value pair just read from the device into a read cache.
+ *
+ * The pair is only inserted if its shard wasn't invalidated since the miss
+ * that led to reading it, so that a value read concurrently with its update
+ * or removal never makes it into the cache. Values too large for the shard,
+ * and pairs whose expiry is already past, are not cached. Entries are
+ * evicted with the CLOCK algorithm to make room for the new one.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The full value.
+ *	info (nvm_kv_key_info_t *): The key/value pair information, as reported
+ *	  by the device.
+ *	epoch (uint64_t): The shard's epoch returned by fio_kv_cache_get().
+ * Returns:
+ *	Returns true if the pair was inserted, false otherwise.
+ */
+bool fio_kv_cache_fill(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, const void *value,
+		const nvm_kv_key_info_t *info, const uint64_t epoch);
+
+/**
+ * Check whether a key/value pair is in a read cache, without counting a hit
+ * or a miss, nor marking it as referenced.
+ *
+ * When the pair isn't cached, the shard's epoch is returned for a following
+ * fio_kv_cache_fill() call, as fio_kv_cache_get() would on a miss.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	epoch (uint64_t *): Set to the shard's epoch if the pair isn't cached.
+ * Returns:
+ *	Returns true if the pair is cached, false otherwise.
+ */
+bool fio_kv_cache_contains(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, uint64_t *epoch);
+
+/**
+ * Remove a key/value pair from a read cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (uint32_t): The ID of the key's pool.
+ *	key (void *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ */
+void fio_kv_cache_invalidate(fio_kv_cache_t *cache, const uint32_t pool_id,
+		const void *key, const uint32_t key_len);
+
+/**
+ * Remove all the key/value pairs of a pool, or of all pools, from a read
+ * cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	pool_id (int): The ID of the pool, or -1 for all pools.
+ */
+void fio_kv_cache_invalidate_pool(fio_kv_cache_t *cache, const int pool_id);
+
+/**
+ * Call a function on the entries of a read cache that were, or weren't,
+ * read since the last pass of their shard's CLOCK hand.
+ *
+ * Each shard is locked while its entries are visited, so the visitor must
+ * not call back into the cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	referenced (bool): Whether to visit the referenced or the unreferenced
+ *	  entries.
+ *	visitor (fio_kv_cache_visitor_t): The function to call on each entry.
+ *	arg (void *): The first argument of the visitor.
+ */
+void fio_kv_cache_visit(fio_kv_cache_t *cache, const bool referenced,
+		const fio_kv_cache_visitor_t visitor, void *arg);
+
+/**
+ * Retrieve the statistics of a read cache.
+ *
+ * Args:
+ *	cache (fio_kv_cache_t *): The read cache.
+ *	stats (fio_kv_cache_stats_t *): The structure to fill in with the
+ *	  counters summed over all shards.
+ */
+void fio_kv_cache_get_stats(fio_kv_cache_t *cache,
+		fio_kv_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_CACHE_H__ */
@@ -0,0 +1,238 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <lz4.h>
+#include <nvm/nvm_kv.h>
+
+#include "fio_kv_codec.h"
+
+/**
+ * Value compression.
+ *
+ * Compressed values are stored as a fio_kv_codec_header_t header, giving the
+ * codec and the original length of the value, followed by the compressed
+ * data. Values that are stored uncompressed have no header; a value is
+ * considered compressed only if its header is consistent with the length of
+ * the value as stored, if its original length is larger than that, and if
+ * the Adler-32 checksums of the header and of the compressed data match.
+ * The header's checksum is enough to tell compressed values apart from the
+ * first sector of a value; the data's checksum is checked before decoding,
+ * so that a raw value that happens to start with a valid header is still
+ * read as is.
+ */
+
+
+/**
+ * Modulus and largest number of bytes summed before reducing the sums of
+ * Adler-32 checksums.
+ */
+#define _FIO_KV_CODEC_ADLER_BASE			65521
+#define _FIO_KV_CODEC_ADLER_RUN				5552
+
+/**
+ * Compute the Adler-32 checksum of a buffer.
+ */
+uint32_t _fio_kv_codec_adler32(const void *data, const uint32_t length)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint32_t a = 1;
+	uint32_t b = 0;
+	uint32_t count = length;
+
+	while (count > 0) {
+		uint32_t run = count < _FIO_KV_CODEC_ADLER_RUN
+			? count
+			: _FIO_KV_CODEC_ADLER_RUN;
+		for (uint32_t i=0; i<run; i++) {
+			a += bytes[i];
+			b += a;
+		}
+
+		a %= _FIO_KV_CODEC_ADLER_BASE;
+		b %= _FIO_KV_CODEC_ADLER_BASE;
+		bytes += run;
+		count -= run;
+	}
+
+	return (b << 16) | a;
+}
+
+/**
+ * Checksum the fields of a header that precede its header checksum.
+ */
+uint32_t _fio_kv_codec_header_checksum(const fio_kv_codec_header_t *header)
+{
+	return _fio_kv_codec_adler32(header,
+			offsetof(fio_kv_codec_header_t, header_checksum));
+}
+
+
+/**
+ * Compress a value, prefixing it with a header.
+ *
+ * Args:
+ *	codec (fio_kv_codec_t): The compression codec.
+ *	data (void *): The value's data.
+ *	length (uint32_t): The value's length.
+ *	buffer (void *): The buffer to write the compressed value to.
+ *	size (uint32_t): The size of the buffer. Values that don't compress to
+ *	  this size, header included, are not compressed.
+ * Returns:
+ *	Returns the length of the compressed value, header included, or 0 if the
+ *	  value was not compressed.
+ */
+uint32_t fio_kv_codec_encode(const fio_kv_codec_t codec, const void *data,
+		const uint32_t length, void *buffer, const uint32_t size)
+{
+	fio_kv_codec_header_t *header = (fio_kv_codec_header_t *)buffer;
+
+	assert(data != NULL);
+	assert(buffer != NULL);
+
+	if (codec != FIO_KV_CODEC_LZ4 || size <= sizeof(fio_kv_codec_header_t) ||
+			length > NVM_KV_MAX_VALUE_SIZE) {
+		return 0;
+	}
+
+	// LZ4 gives up, returning 0, when the output doesn't fit.
+	int ret = LZ4_compress_default((const char *)data, (char *)(header + 1),
+			(int)length, (int)(size - sizeof(fio_kv_codec_header_t)));
+	if (ret <= 0) {
+		return 0;
+	}
+
+	header->magic = FIO_KV_CODEC_MAGIC;
+	header->codec = (uint16_t)codec;
+	header->reserved = 0;
+	header->length = length;
+	header->encoded_len = (uint32_t)ret;
+	header->checksum = _fio_kv_codec_adler32(header + 1, header->encoded_len);
+	header->header_checksum = _fio_kv_codec_header_checksum(header);
+	return sizeof(fio_kv_codec_header_t) + header->encoded_len;
+}
+
+/**
+ * Return the header of a compressed value.
+ *
+ * Values are recognized as compressed when they start with a header whose
+ * magic number and checksum are valid, and whose lengths match the length of
+ * the value as stored.
+ *
+ * Args:
+ *	data (void *): The first bytes of the value, as stored.
+ *	length (uint32_t): The number of bytes available in data.
+ *	value_len (uint32_t): The length of the value as stored.
+ * Returns:
+ *	Returns a pointer to the header at the start of data, or NULL if the
+ *	  value is not compressed.
+ */
+const fio_kv_codec_header_t *fio_kv_codec_header(const void *data,
+		const uint32_t length, const uint32_t value_len)
+{
+	const fio_kv_codec_header_t *header = (const fio_kv_codec_header_t *)data;
+
+	assert(data != NULL);
+
+	if (length < sizeof(fio_kv_codec_header_t) ||
+			value_len < sizeof(fio_kv_codec_header_t) ||
+			header->magic != FIO_KV_CODEC_MAGIC ||
+			header->codec != FIO_KV_CODEC_LZ4 ||
+			header->reserved != 0 ||
+			header->encoded_len != value_len - sizeof(fio_kv_codec_header_t) ||
+			header->length <= value_len ||
+			header->length > NVM_KV_MAX_VALUE_SIZE ||
+			header->header_checksum != _fio_kv_codec_header_checksum(header)) {
+		return NULL;
+	}
+
+	return header;
+}
+
+/**
+ * Verify the checksum of the compressed data of a value.
+ *
+ * A value holding a valid header but whose compressed data doesn't match the
+ * header's checksum is not a compressed value, and is to be read as is.
+ *
+ * Args:
+ *	header (fio_kv_codec_header_t *): The header of the compressed value,
+ *	  immediately followed by all of its compressed data.
+ * Returns:
+ *	Returns true if the compressed data matches the header, false otherwise.
+ */
+bool fio_kv_codec_verify(const fio_kv_codec_header_t *header)
+{
+	assert(header != NULL);
+
+	return header->checksum ==
+		_fio_kv_codec_adler32(header + 1, header->encoded_len);
+}
+
+/**
+ * Decompress a value.
+ *
+ * Args:
+ *	header (fio_kv_codec_header_t *): The header of the compressed value,
+ *	  immediately followed by all of its compressed data.
+ *	buffer (void *): The buffer to write the value to, which must not
+ *	  overlap the compressed value.
+ *	size (uint32_t): The size of the buffer. Values larger than this are
+ *	  truncated to size bytes.
+ * Returns:
+ *	Returns the number of bytes written to the buffer, or -1 if the
+ *	  compressed data is corrupt, with errno set to EIO.
+ */
+int fio_kv_codec_decode(const fio_kv_codec_header_t *header, void *buffer,
+		const uint32_t size)
+{
+	assert(header != NULL);
+	assert(buffer != NULL);
+
+	const char *encoded = (const char *)(header + 1);
+	int ret = size >= header->length
+		? LZ4_decompress_safe(encoded, (char *)buffer,
+				(int)header->encoded_len, (int)header->length)
+		: LZ4_decompress_safe_partial(encoded, (char *)buffer,
+				(int)header->encoded_len, (int)size, (int)size);
+
+	uint32_t expected = size < header->length ? size : header->length;
+	if (ret < 0 || (uint32_t)ret != expected) {
+		errno = EIO;
+		return -1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_CODEC_H__
+#define __FIO_KV_CODEC_H__
+
+#include <stdint.h>
+
+/**
+ * Magic number opening the header of compressed values ("fkvz").
+ */
+#define FIO_KV_CODEC_MAGIC					0x7a766b66
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	FIO_KV_CODEC_NONE = 0,
+	FIO_KV_CODEC_LZ4 = 1
+} fio_kv_codec_t;
+
+typedef struct {
+	uint32_t magic;
+	uint16_t codec;
+	uint16_t reserved;
+	uint32_t length;
+	uint32_t encoded_len;
+	uint32_t checksum;
+	uint32_t header_checksum;
+} fio_kv_codec_header_t;
+
+
+/**
+ * Compress a value, prefixing it with a header.
+ *
+ * Args:
+ *	codec (fio_kv_codec_t): The compression codec.
+ *	data (void *): The value's data.
+ *	length (uint32_t): The value's length.
+ *	buffer (void *): The buffer to write the compressed value to.
+ *	size (uint32_t): The size of the buffer. Values that don't compress to
+ *	  this size, header included, are not compressed.
+ * Returns:
+ *	Returns the length of the compressed value, header included, or 0 if the
+ *	  value was not compressed.
+ */
+uint32_t fio_kv_codec_encode(const fio_kv_codec_t codec, const void *data,
+		const uint32_t length, void *buffer, const uint32_t size);
+
+/**
+ * Return the header of a compressed value.
+ *
+ * Values are recognized as compressed when they start with a header whose
+ * magic number and checksum are valid, and whose lengths match the length of
+ * the value as stored.
+ *
+ * Args:
+ *	data (void *): The first bytes of the value, as stored.
+ *	length (uint32_t): The number of bytes available in data.
+ *	value_len (uint32_t): The length of the value as stored.
+ * Returns:
+ *	Returns a pointer to the header at the start of data, or NULL if the
+ *	  value is not compressed.
+ */
+const fio_kv_codec_header_t *fio_kv_codec_header(const void *data,
+		const uint32_t length, const uint32_t value_len);
+
+/**
+ * Verify the checksum of the compressed data of a value.
+ *
+ * A value holding a valid header but whose compressed data doesn't match the
+ * header's checksum is not a compressed value, and is to be read as is.
+ *
+ * Args:
+ *	header (fio_kv_codec_header_t *): The header of the compressed value,
+ *	  immediately followed by all of its compressed data.
+ * Returns:
+ *	Returns true if the compressed data matches the header, false otherwise.
+ */
+bool fio_kv_codec_verify(const fio_kv_codec_header_t *header);
+
+/**
+ * Decompress a value.
+ *
+ * Args:
+ *	header (fio_kv_codec_header_t *): The header of the compressed value,
+ *	  immediately followed by all of its compressed data.
+ *	buffer (void *): The buffer to write the value to, which must not
+ *	  overlap the compressed value.
+ *	size (uint32_t): The size of the buffer. Values larger than this are
+ *	  truncated to size bytes.
+ * Returns:
+ *	Returns the number of bytes written to the buffer, or -1 if the
+ *	  compressed data is corrupt, with errno set to EIO.
+ */
+int fio_kv_codec_decode(const fio_kv_codec_header_t *header, void *buffer,
+		const uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_CODEC_H__ */
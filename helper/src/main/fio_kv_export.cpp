@@ -0,0 +1,939 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fio_kv_export.h"
+#include "fio_kv_slab.h"
+
+/**
+ * Streaming pool export and import.
+ *
+ * An export stream starts with a fio_kv_export_header_t padded to
+ * FIO_KV_EXPORT_ALIGNMENT bytes, followed by blocks of records, each with a
+ * fio_kv_export_block_t header giving its number of records, its length and
+ * its sequence number, and a Fletcher-64 checksum of the block. Blocks are
+ * padded to FIO_KV_EXPORT_ALIGNMENT bytes, so that the stream can go through
+ * O_DIRECT file descriptors, and the stream ends with an empty block giving
+ * the total number of pairs, so that truncated streams are detected.
+ *
+ * Exports read the pool with fio_kv_next_batch() and pack its records into
+ * two block buffers in turn: one is filled while a writer thread writes the
+ * other. Imports read the blocks on the calling thread, verify them and
+ * hand them to a set of worker threads, which copy the values of each block
+ * into sector-aligned memory and write them with batch puts larger than a
+ * device batch, so that the device sees maximally sized batches and the
+ * import is scheduled as background work.
+ */
+
+
+/**
+ * Number of words a Fletcher-64 checksum sums before reducing its sums,
+ * which keeps them from overflowing.
+ */
+#define _FIO_KV_EXPORT_CHECKSUM_RUN			16384
+
+typedef struct {
+	int fd;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	const char *pending;
+	uint32_t pending_size;
+	bool stopping;
+	int error;
+} _fio_kv_export_writer_t;
+
+typedef struct {
+	const fio_kv_pool_t *pool;
+	pthread_mutex_t lock;
+	pthread_cond_t filled;
+	pthread_cond_t released;
+	char **buffers;
+	uint32_t buffer_count;
+	uint32_t *free;
+	uint32_t free_count;
+	uint32_t *ready;
+	uint32_t ready_head;
+	uint32_t ready_count;
+	bool stopping;
+	int error;
+	uint64_t imported;
+} _fio_kv_import_t;
+
+typedef struct {
+	_fio_kv_import_t *import;
+	char *arena;
+	uint32_t arena_size;
+	fio_kv_key_t keys[FIO_KV_EXPORT_BATCH];
+	const fio_kv_key_t *pkeys[FIO_KV_EXPORT_BATCH];
+	nvm_kv_key_info_t info[FIO_KV_EXPORT_BATCH];
+	fio_kv_value_t values[FIO_KV_EXPORT_BATCH];
+	const fio_kv_value_t *pvalues[FIO_KV_EXPORT_BATCH];
+} _fio_kv_import_worker_t;
+
+/**
+ * Round a length up to a multiple of FIO_KV_EXPORT_ALIGNMENT.
+ */
+uint32_t _fio_kv_export_round(const uint32_t length)
+{
+	return (length + FIO_KV_EXPORT_ALIGNMENT - 1) &
+		~(uint32_t)(FIO_KV_EXPORT_ALIGNMENT - 1);
+}
+
+/**
+ * Allocate a block buffer.
+ */
+char *_fio_kv_export_alloc(void)
+{
+	void *buffer = NULL;
+	if (posix_memalign(&buffer, FIO_KV_EXPORT_ALIGNMENT,
+			FIO_KV_EXPORT_BLOCK_SIZE) != 0) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return (char *)buffer;
+}
+
+/**
+ * Compute the Fletcher-64 checksum of the given data, a whole number of
+ * 32-bit words.
+ */
+uint64_t _fio_kv_export_checksum(const void *data, const uint32_t length)
+{
+	const uint32_t *words = (const uint32_t *)data;
+	uint32_t count = length / sizeof(uint32_t);
+	uint64_t a = 0;
+	uint64_t b = 0;
+
+	while (count > 0) {
+		uint32_t run = count < _FIO_KV_EXPORT_CHECKSUM_RUN
+			? count
+			: _FIO_KV_EXPORT_CHECKSUM_RUN;
+		for (uint32_t i=0; i<run; i++) {
+			a += words[i];
+			b += a;
+		}
+
+		a %= 0xffffffff;
+		b %= 0xffffffff;
+		words += run;
+		count -= run;
+	}
+
+	return (b << 32) | a;
+}
+
+/**
+ * Checksum a block, with a zero checksum in its header.
+ */
+uint64_t _fio_kv_export_block_checksum(char *block)
+{
+	fio_kv_export_block_t *header = (fio_kv_export_block_t *)block;
+	uint64_t stored = header->checksum;
+	header->checksum = 0;
+	uint64_t checksum = _fio_kv_export_checksum(block,
+			sizeof(fio_kv_export_block_t) + header->length);
+	header->checksum = stored;
+	return checksum;
+}
+
+/**
+ * Write all the given bytes to a file descriptor.
+ */
+bool _fio_kv_export_write(const int fd, const char *data, size_t length)
+{
+	while (length > 0) {
+		ssize_t ret = write(fd, data, length);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		} else if (ret <= 0) {
+			if (ret == 0) {
+				errno = EIO;
+			}
+			return false;
+		}
+
+		data += ret;
+		length -= (size_t)ret;
+	}
+
+	return true;
+}
+
+/**
+ * Read up to the given number of bytes from a file descriptor, stopping
+ * short only at the end of the file.
+ *
+ * Returns the number of bytes read, or -1 if an error occurred.
+ */
+ssize_t _fio_kv_export_read(const int fd, char *data, const size_t length)
+{
+	size_t done = 0;
+	while (done < length) {
+		ssize_t ret = read(fd, data + done, length - done);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		} else if (ret < 0) {
+			return -1;
+		} else if (ret == 0) {
+			break;
+		}
+
+		done += (size_t)ret;
+	}
+
+	return (ssize_t)done;
+}
+
+/**
+ * Writer thread main loop: write the blocks handed over by the exporter.
+ */
+void *_fio_kv_export_writer(void *arg)
+{
+	_fio_kv_export_writer_t *writer = (_fio_kv_export_writer_t *)arg;
+
+	pthread_mutex_lock(&writer->lock);
+	while (true) {
+		while (writer->pending == NULL && !writer->stopping) {
+			pthread_cond_wait(&writer->cond, &writer->lock);
+		}
+
+		if (writer->pending == NULL) {
+			break;
+		}
+
+		const char *block = writer->pending;
+		uint32_t size = writer->pending_size;
+		pthread_mutex_unlock(&writer->lock);
+		bool ok = _fio_kv_export_write(writer->fd, block, size);
+		int error = errno;
+		pthread_mutex_lock(&writer->lock);
+
+		if (!ok && writer->error == 0) {
+			writer->error = error;
+		}
+		writer->pending = NULL;
+		pthread_cond_broadcast(&writer->cond);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	return NULL;
+}
+
+/**
+ * Seal a block and hand it over to the writer, once the writer is done
+ * with the previous one.
+ *
+ * Returns false if the writer failed to write a previous block.
+ */
+bool _fio_kv_export_flush(_fio_kv_export_writer_t *writer, char *block,
+		const uint32_t count, const uint32_t used, const uint64_t sequence)
+{
+	fio_kv_export_block_t *header = (fio_kv_export_block_t *)block;
+	header->magic = FIO_KV_EXPORT_BLOCK_MAGIC;
+	header->count = count;
+	header->length = used - sizeof(fio_kv_export_block_t);
+	header->reserved = 0;
+	header->sequence = sequence;
+	header->checksum = 0;
+	header->checksum = _fio_kv_export_block_checksum(block);
+
+	uint32_t size = _fio_kv_export_round(used);
+	memset(block + used, 0, size - used);
+
+	pthread_mutex_lock(&writer->lock);
+	while (writer->pending != NULL) {
+		pthread_cond_wait(&writer->cond, &writer->lock);
+	}
+
+	int error = writer->error;
+	if (error == 0) {
+		writer->pending = block;
+		writer->pending_size = size;
+		pthread_cond_broadcast(&writer->cond);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	errno = error;
+	return error == 0;
+}
+
+/**
+ * Pack the records of a batch read by fio_kv_next_batch() into export
+ * blocks, flushing and switching blocks as they fill up.
+ *
+ * Returns false if a block could not be written.
+ */
+bool _fio_kv_export_batch(_fio_kv_export_writer_t *writer,
+		const fio_kv_batch_t *batch, char **blocks, uint32_t *current,
+		uint32_t *count, uint32_t *used, uint64_t *sequence, uint64_t *total)
+{
+	const uint32_t *offsets = (const uint32_t *)(batch + 1);
+
+	for (uint32_t i=0; i<batch->count; i++) {
+		const fio_kv_record_t *record = (const fio_kv_record_t *)
+			((const char *)batch + offsets[i]);
+		uint32_t size = (sizeof(fio_kv_export_record_t) + record->key_len +
+				record->value_len + 3) & ~3U;
+
+		if (*used + size > FIO_KV_EXPORT_BLOCK_SIZE) {
+			if (!_fio_kv_export_flush(writer, blocks[*current], *count,
+					*used, (*sequence)++)) {
+				return false;
+			}
+
+			*current = 1 - *current;
+			*count = 0;
+			*used = sizeof(fio_kv_export_block_t);
+		}
+
+		char *out = blocks[*current] + *used;
+		fio_kv_export_record_t *exported = (fio_kv_export_record_t *)out;
+		exported->key_len = record->key_len;
+		exported->value_len = record->value_len;
+		exported->expiry = record->expiry;
+		out += sizeof(fio_kv_export_record_t);
+		memcpy(out, record + 1, record->key_len);
+		memcpy(out + record->key_len,
+				(const char *)batch + record->value_offset, record->value_len);
+		memset(out + record->key_len + record->value_len, 0,
+				size - sizeof(fio_kv_export_record_t) - record->key_len -
+				record->value_len);
+
+		*used += size;
+		(*count)++;
+		(*total)++;
+	}
+
+	return true;
+}
+
+/**
+ * Export all the key/value pairs of a pool to a stream.
+ *
+ * The pool is iterated over in batches, and its pairs are packed back to
+ * back in checksummed blocks of up to FIO_KV_EXPORT_BLOCK_SIZE bytes,
+ * written by a separate thread while the next block is filled. All writes
+ * are aligned on, and multiples of, FIO_KV_EXPORT_ALIGNMENT bytes, starting
+ * at the current offset of the file descriptor, which can be opened with
+ * O_DIRECT. Values are exported uncompressed. Pairs written to the pool
+ * during the export may or may not be part of the stream.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	fd (int): The file descriptor to write the stream to.
+ * Returns:
+ *	Returns the number of pairs exported, or -1 if an error occurred, with
+ *	  errno set to EOPNOTSUPP for packed pools.
+ */
+int64_t fio_kv_export_pool(const fio_kv_pool_t *pool, const int fd)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+
+	// Packed pools can't be iterated over.
+	if (pool->store->pack != NULL && pool->store->pack->buckets[pool->id]) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	char *blocks[2];
+	blocks[0] = _fio_kv_export_alloc();
+	blocks[1] = _fio_kv_export_alloc();
+	char *batch = _fio_kv_export_alloc();
+	if (blocks[0] == NULL || blocks[1] == NULL || batch == NULL) {
+		free(blocks[0]);
+		free(blocks[1]);
+		free(batch);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	fio_kv_export_header_t *header = (fio_kv_export_header_t *)blocks[0];
+	memset(blocks[0], 0, FIO_KV_EXPORT_ALIGNMENT);
+	header->magic = FIO_KV_EXPORT_MAGIC;
+	header->version = FIO_KV_EXPORT_VERSION;
+	header->block_size = FIO_KV_EXPORT_BLOCK_SIZE;
+	header->pool_id = pool->id;
+	memcpy(header->tag, pool->tag, FIO_TAG_MAX_LENGTH);
+
+	_fio_kv_export_writer_t writer;
+	writer.fd = fd;
+	writer.pending = NULL;
+	writer.pending_size = 0;
+	writer.stopping = false;
+	writer.error = 0;
+	pthread_mutex_init(&writer.lock, NULL);
+	pthread_cond_init(&writer.cond, NULL);
+
+	pthread_t thread;
+	bool ok = _fio_kv_export_write(fd, blocks[0], FIO_KV_EXPORT_ALIGNMENT);
+	int error = ok ? 0 : errno;
+	bool started = ok &&
+		pthread_create(&thread, NULL, _fio_kv_export_writer, &writer) == 0;
+	if (ok && !started) {
+		ok = false;
+		error = EAGAIN;
+	}
+
+	// Pools that can't be iterated over are empty.
+	int iterator = ok ? fio_kv_iterator(pool) : -1;
+	uint32_t current = 0;
+	uint32_t count = 0;
+	uint32_t used = sizeof(fio_kv_export_block_t);
+	uint64_t sequence = 0;
+	uint64_t total = 0;
+	bool ended = iterator < 0;
+
+	while (ok && !ended) {
+		int read = fio_kv_next_batch(pool, iterator, batch,
+				FIO_KV_EXPORT_BLOCK_SIZE, FIO_KV_EXPORT_BATCH, false);
+		if (read < 0) {
+			ok = false;
+			error = errno;
+			break;
+		}
+
+		const fio_kv_batch_t *b = (const fio_kv_batch_t *)batch;
+		ended = read == 0 || b->ended;
+		if (!_fio_kv_export_batch(&writer, b, blocks, &current, &count,
+				&used, &sequence, &total)) {
+			ok = false;
+			error = errno;
+		}
+	}
+
+	if (iterator >= 0) {
+		fio_kv_end_iteration(pool, iterator);
+	}
+
+	if (ok && count > 0) {
+		ok = _fio_kv_export_flush(&writer, blocks[current], count, used,
+				sequence++);
+		error = ok ? 0 : errno;
+		current = 1 - current;
+	}
+
+	if (ok) {
+		memcpy(blocks[current] + sizeof(fio_kv_export_block_t), &total,
+				sizeof(uint64_t));
+		ok = _fio_kv_export_flush(&writer, blocks[current], 0,
+				sizeof(fio_kv_export_block_t) + sizeof(uint64_t), sequence);
+		error = ok ? 0 : errno;
+	}
+
+	if (started) {
+		pthread_mutex_lock(&writer.lock);
+		writer.stopping = true;
+		pthread_cond_broadcast(&writer.cond);
+		pthread_mutex_unlock(&writer.lock);
+		pthread_join(thread, NULL);
+		if (ok && writer.error != 0) {
+			ok = false;
+			error = writer.error;
+		}
+	}
+
+	pthread_cond_destroy(&writer.cond);
+	pthread_mutex_destroy(&writer.lock);
+	free(blocks[0]);
+	free(blocks[1]);
+	free(batch);
+
+	if (!ok) {
+		errno = error;
+		return -1;
+	}
+
+	return (int64_t)total;
+}
+
+/**
+ * Write a group of imported pairs to the pool.
+ */
+bool _fio_kv_import_put(_fio_kv_import_worker_t *worker, const uint32_t count)
+{
+	if (count == 0) {
+		return true;
+	}
+
+	return fio_kv_batch_put(worker->import->pool, worker->pkeys,
+			worker->pvalues, count);
+}
+
+/**
+ * Import the records of a verified block, in groups of up to
+ * FIO_KV_EXPORT_BATCH pairs whose values are copied into the worker's arena.
+ */
+bool _fio_kv_import_block(_fio_kv_import_worker_t *worker, const char *block)
+{
+	const fio_kv_export_block_t *header = (const fio_kv_export_block_t *)block;
+	const char *p = block + sizeof(fio_kv_export_block_t);
+	const char *end = p + header->length;
+	uint32_t count = 0;
+	uint32_t offset = 0;
+
+	for (uint32_t i=0; i<header->count; i++) {
+		if (p + sizeof(fio_kv_export_record_t) > end) {
+			errno = EIO;
+			return false;
+		}
+
+		const fio_kv_export_record_t *record =
+			(const fio_kv_export_record_t *)p;
+		uint32_t size = (sizeof(fio_kv_export_record_t) + record->key_len +
+				record->value_len + 3) & ~3U;
+		if (record->key_len < 1 || record->key_len > NVM_KV_MAX_KEY_SIZE ||
+				record->value_len > NVM_KV_MAX_VALUE_SIZE ||
+				size > (uint32_t)(end - p)) {
+			errno = EIO;
+			return false;
+		}
+
+		uint32_t aligned = (record->value_len + FIO_SECTOR_ALIGNMENT - 1) &
+			~(uint32_t)(FIO_SECTOR_ALIGNMENT - 1);
+		if (count == FIO_KV_EXPORT_BATCH ||
+				offset + aligned > worker->arena_size) {
+			if (!_fio_kv_import_put(worker, count)) {
+				return false;
+			}
+			count = 0;
+			offset = 0;
+		}
+
+		const char *key = p + sizeof(fio_kv_export_record_t);
+		memcpy(worker->arena + offset, key + record->key_len,
+				record->value_len);
+
+		memset(&worker->info[count], 0, sizeof(nvm_kv_key_info_t));
+		worker->info[count].value_len = record->value_len;
+		worker->info[count].expiry = record->expiry;
+		worker->keys[count].length = record->key_len;
+		worker->keys[count].bytes = (nvm_kv_key_t *)key;
+		worker->values[count].data = worker->arena + offset;
+		worker->values[count].info = &worker->info[count];
+
+		offset += aligned;
+		count++;
+		p += size;
+	}
+
+	return _fio_kv_import_put(worker, count);
+}
+
+/**
+ * Import worker thread main loop: write the blocks handed over by the
+ * reader until the stream ends or the import fails.
+ */
+void *_fio_kv_import_worker(void *arg)
+{
+	_fio_kv_import_worker_t *worker = (_fio_kv_import_worker_t *)arg;
+	_fio_kv_import_t *import = worker->import;
+
+	for (uint32_t i=0; i<FIO_KV_EXPORT_BATCH; i++) {
+		worker->pkeys[i] = &worker->keys[i];
+		worker->pvalues[i] = &worker->values[i];
+	}
+
+	pthread_mutex_lock(&import->lock);
+	while (true) {
+		while (import->ready_count == 0 && !import->stopping) {
+			pthread_cond_wait(&import->filled, &import->lock);
+		}
+
+		if (import->ready_count == 0) {
+			break;
+		}
+
+		uint32_t buffer = import->ready[import->ready_head];
+		import->ready_head = (import->ready_head + 1) % import->buffer_count;
+		import->ready_count--;
+		bool skip = import->error != 0;
+		pthread_mutex_unlock(&import->lock);
+
+		const char *block = import->buffers[buffer];
+		bool ok = skip || _fio_kv_import_block(worker, block);
+		int error = errno;
+
+		pthread_mutex_lock(&import->lock);
+		if (!ok && import->error == 0) {
+			import->error = error;
+		} else if (ok && !skip) {
+			import->imported +=
+				((const fio_kv_export_block_t *)block)->count;
+		}
+		import->free[import->free_count++] = buffer;
+		pthread_cond_signal(&import->released);
+	}
+	pthread_mutex_unlock(&import->lock);
+
+	return NULL;
+}
+
+/**
+ * Read and verify the next block of a stream into the given buffer.
+ *
+ * Returns false if the block could not be read or is not the expected one.
+ */
+bool _fio_kv_import_read(const int fd, char *block, const uint64_t sequence)
+{
+	ssize_t ret = _fio_kv_export_read(fd, block, FIO_KV_EXPORT_ALIGNMENT);
+	if (ret < 0) {
+		return false;
+	}
+
+	const fio_kv_export_block_t *header = (const fio_kv_export_block_t *)block;
+	if (ret != FIO_KV_EXPORT_ALIGNMENT ||
+			header->magic != FIO_KV_EXPORT_BLOCK_MAGIC ||
+			header->sequence != sequence ||
+			header->length % 4 != 0 ||
+			header->length > FIO_KV_EXPORT_BLOCK_SIZE -
+				sizeof(fio_kv_export_block_t)) {
+		errno = EIO;
+		return false;
+	}
+
+	uint32_t size = _fio_kv_export_round(sizeof(fio_kv_export_block_t) +
+			header->length);
+	if (size > FIO_KV_EXPORT_ALIGNMENT) {
+		ret = _fio_kv_export_read(fd, block + FIO_KV_EXPORT_ALIGNMENT,
+				size - FIO_KV_EXPORT_ALIGNMENT);
+		if (ret < 0) {
+			return false;
+		} else if ((uint32_t)ret != size - FIO_KV_EXPORT_ALIGNMENT) {
+			errno = EIO;
+			return false;
+		}
+	}
+
+	if (_fio_kv_export_block_checksum(block) != header->checksum ||
+			(header->count == 0 && header->length != sizeof(uint64_t))) {
+		errno = EIO;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Release the resources of an import.
+ */
+void _fio_kv_import_free(_fio_kv_import_t *import,
+		_fio_kv_import_worker_t *workers, const uint32_t threads)
+{
+	for (uint32_t i=0; workers != NULL && i<threads; i++) {
+		fio_kv_slab_free(workers[i].arena);
+	}
+	free(workers);
+
+	for (uint32_t i=0; import->buffers != NULL && i<import->buffer_count;
+			i++) {
+		free(import->buffers[i]);
+	}
+	free(import->buffers);
+	free(import->free);
+	free(import->ready);
+
+	pthread_cond_destroy(&import->released);
+	pthread_cond_destroy(&import->filled);
+	pthread_mutex_destroy(&import->lock);
+}
+
+/**
+ * Import the key/value pairs of a stream written by fio_kv_export_pool()
+ * into a pool.
+ *
+ * The stream is read block by block, and each block is verified and then
+ * written to the pool by one of the given number of threads, in batch puts
+ * of up to FIO_KV_EXPORT_BATCH pairs. Pairs already in the pool are
+ * replaced. All reads are aligned on, and multiples of,
+ * FIO_KV_EXPORT_ALIGNMENT bytes, starting at the current offset of the file
+ * descriptor, which can be opened with O_DIRECT. If an error occurs, some of
+ * the pairs of the stream may have been imported.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	fd (int): The file descriptor to read the stream from.
+ *	threads (uint32_t): The number of threads writing to the pool, between 1
+ *	  and FIO_KV_IMPORT_MAX_THREADS.
+ * Returns:
+ *	Returns the number of pairs imported, or -1 if an error occurred, with
+ *	  errno set to EINVAL if the stream is not an export stream, or to EIO
+ *	  if it is corrupted or truncated.
+ */
+int64_t fio_kv_import_pool(const fio_kv_pool_t *pool, const int fd,
+		const uint32_t threads)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+
+	if (threads < 1 || threads > FIO_KV_IMPORT_MAX_THREADS) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	_fio_kv_import_t import;
+	memset(&import, 0, sizeof(import));
+	import.pool = pool;
+	import.buffer_count = threads + 2;
+	pthread_mutex_init(&import.lock, NULL);
+	pthread_cond_init(&import.filled, NULL);
+	pthread_cond_init(&import.released, NULL);
+
+	import.buffers = (char **)calloc(import.buffer_count, sizeof(char *));
+	import.free = (uint32_t *)calloc(import.buffer_count, sizeof(uint32_t));
+	import.ready = (uint32_t *)calloc(import.buffer_count, sizeof(uint32_t));
+	_fio_kv_import_worker_t *workers = (_fio_kv_import_worker_t *)calloc(
+			threads, sizeof(_fio_kv_import_worker_t));
+	bool ok = import.buffers != NULL && import.free != NULL &&
+		import.ready != NULL && workers != NULL;
+	for (uint32_t i=0; ok && i<import.buffer_count; i++) {
+		import.buffers[i] = _fio_kv_export_alloc();
+		import.free[import.free_count++] = i;
+		ok = import.buffers[i] != NULL;
+	}
+
+	// A group of pairs never spans blocks, so its values always fit in a
+	// block's worth of memory, plus the padding of each to a sector.
+	for (uint32_t i=0; ok && i<threads; i++) {
+		workers[i].import = &import;
+		workers[i].arena_size = FIO_KV_EXPORT_BLOCK_SIZE +
+			FIO_KV_EXPORT_BATCH * FIO_SECTOR_ALIGNMENT;
+		workers[i].arena = (char *)fio_kv_alloc(workers[i].arena_size);
+		ok = workers[i].arena != NULL;
+	}
+
+	if (!ok) {
+		_fio_kv_import_free(&import, workers, threads);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	// The stream header is read into the first buffer, before any worker
+	// is started.
+	char *first = import.buffers[0];
+	ssize_t read = _fio_kv_export_read(fd, first, FIO_KV_EXPORT_ALIGNMENT);
+	const fio_kv_export_header_t *header = (const fio_kv_export_header_t *)first;
+	if (read != FIO_KV_EXPORT_ALIGNMENT ||
+			header->magic != FIO_KV_EXPORT_MAGIC ||
+			header->version != FIO_KV_EXPORT_VERSION ||
+			header->block_size > FIO_KV_EXPORT_BLOCK_SIZE) {
+		int error = read < 0 ? errno : EINVAL;
+		_fio_kv_import_free(&import, workers, threads);
+		errno = error;
+		return -1;
+	}
+
+	pthread_t *handles = (pthread_t *)calloc(threads, sizeof(pthread_t));
+	uint32_t started = 0;
+	while (handles != NULL && started < threads &&
+			pthread_create(&handles[started], NULL, _fio_kv_import_worker,
+				&workers[started]) == 0) {
+		started++;
+	}
+
+	int error = started == 0 ? EAGAIN : 0;
+	uint64_t expected = 0;
+	uint64_t sequence = 0;
+	pthread_mutex_lock(&import.lock);
+	while (error == 0) {
+		while (import.free_count == 0) {
+			pthread_cond_wait(&import.released, &import.lock);
+		}
+
+		if (import.error != 0) {
+			break;
+		}
+
+		uint32_t buffer = import.free[--import.free_count];
+		pthread_mutex_unlock(&import.lock);
+
+		char *block = import.buffers[buffer];
+		bool ok = _fio_kv_import_read(fd, block, sequence++);
+		error = ok ? 0 : errno;
+		const fio_kv_export_block_t *b = (const fio_kv_export_block_t *)block;
+		bool last = ok && b->count == 0;
+		if (last) {
+			memcpy(&expected, block + sizeof(fio_kv_export_block_t),
+					sizeof(uint64_t));
+		}
+
+		pthread_mutex_lock(&import.lock);
+		if (!ok || last) {
+			import.free[import.free_count++] = buffer;
+			break;
+		}
+
+		import.ready[(import.ready_head + import.ready_count) %
+			import.buffer_count] = buffer;
+		import.ready_count++;
+		pthread_cond_signal(&import.filled);
+	}
+
+	import.stopping = true;
+	if (error != 0 && import.error == 0) {
+		import.error = error;
+	}
+	pthread_cond_broadcast(&import.filled);
+	pthread_mutex_unlock(&import.lock);
+
+	for (uint32_t i=0; i<started; i++) {
+		pthread_join(handles[i], NULL);
+	}
+	free(handles);
+
+	error = import.error;
+	uint64_t imported = import.imported;
+	_fio_kv_import_free(&import, workers, threads);
+
+	if (error == 0 && imported != expected) {
+		error = EIO;
+	}
+
+	if (error != 0) {
+		errno = error;
+		return -1;
+	}
+
+	return (int64_t)imported;
+}
+
+/**
+ * Open a file for an export or an import, with O_DIRECT if the file system
+ * supports it.
+ */
+int _fio_kv_export_open(const char *path, const int flags)
+{
+	int fd = open(path, flags | O_DIRECT, S_IRUSR | S_IWUSR);
+	if (fd < 0 && errno == EINVAL) {
+		fd = open(path, flags, S_IRUSR | S_IWUSR);
+	}
+
+	return fd;
+}
+
+/**
+ * Export all the key/value pairs of a pool to a file.
+ *
+ * The stream is written with fio_kv_export_pool(), through O_DIRECT when
+ * the file system supports it, to a temporary file next to the given path,
+ * which is synced and then renamed over the given path, so that a failed
+ * export never leaves a partial file.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns the number of pairs exported, or -1 if an error occurred.
+ */
+int64_t fio_kv_export_file(const fio_kv_pool_t *pool, const char *path)
+{
+	assert(path != NULL);
+
+	size_t length = strlen(path);
+	char *tmp = (char *)malloc(length + 5);
+	if (tmp == NULL) {
+		return -1;
+	}
+	memcpy(tmp, path, length);
+	memcpy(tmp + length, ".tmp", 5);
+
+	int fd = _fio_kv_export_open(tmp, O_WRONLY | O_CREAT | O_TRUNC);
+	if (fd < 0) {
+		free(tmp);
+		return -1;
+	}
+
+	int64_t ret = fio_kv_export_pool(pool, fd);
+	int error = errno;
+	if (ret >= 0 && fsync(fd) < 0) {
+		error = errno;
+		ret = -1;
+	}
+
+	if (close(fd) < 0 && ret >= 0) {
+		error = errno;
+		ret = -1;
+	}
+
+	if (ret >= 0 && rename(tmp, path) < 0) {
+		error = errno;
+		ret = -1;
+	}
+
+	if (ret < 0) {
+		unlink(tmp);
+	}
+
+	free(tmp);
+	errno = error;
+	return ret;
+}
+
+/**
+ * Import the key/value pairs of a file written by fio_kv_export_file() into
+ * a pool, with fio_kv_import_pool().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ *	threads (uint32_t): The number of threads writing to the pool.
+ * Returns:
+ *	Returns the number of pairs imported, or -1 if an error occurred.
+ */
+int64_t fio_kv_import_file(const fio_kv_pool_t *pool, const char *path,
+		const uint32_t threads)
+{
+	assert(path != NULL);
+
+	int fd = _fio_kv_export_open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	int64_t ret = fio_kv_import_pool(pool, fd, threads);
+	int error = errno;
+	close(fd);
+	errno = error;
+	return ret;
+}
@@ -0,0 +1,179 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_EXPORT_H__
+#define __FIO_KV_EXPORT_H__
+
+#include "fio_kv_helper.h"
+
+/**
+ * Alignment of all the writes and reads of an export stream, which lets it
+ * be written to or read from a file opened with O_DIRECT, and the largest
+ * size of a block of the stream.
+ */
+#define FIO_KV_EXPORT_ALIGNMENT				4096
+#define FIO_KV_EXPORT_BLOCK_SIZE			(2 * 1024 * 1024)
+
+/**
+ * Maximum number of pairs read from the pool by each iteration batch of an
+ * export, and written to the pool by each batch put of an import.
+ */
+#define FIO_KV_EXPORT_BATCH					256
+
+/** Maximum number of import threads. */
+#define FIO_KV_IMPORT_MAX_THREADS			64
+
+/** Magic numbers of export streams ('fioe') and of their blocks ('fiob'). */
+#define FIO_KV_EXPORT_MAGIC					0x66696f65
+#define FIO_KV_EXPORT_BLOCK_MAGIC			0x66696f62
+#define FIO_KV_EXPORT_VERSION				1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The stream header, at the start of the stream's first
+ * FIO_KV_EXPORT_ALIGNMENT bytes.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t block_size;
+	uint32_t pool_id;
+	char tag[FIO_TAG_MAX_LENGTH];
+} fio_kv_export_header_t;
+
+/**
+ * The header of each block, followed by length bytes of records and padded
+ * to a multiple of FIO_KV_EXPORT_ALIGNMENT. The checksum covers the header,
+ * with a zero checksum, and the records. The last block of a stream has no
+ * records and holds the total number of pairs of the stream, as a uint64_t.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t count;
+	uint32_t length;
+	uint32_t reserved;
+	uint64_t sequence;
+	uint64_t checksum;
+} fio_kv_export_block_t;
+
+/**
+ * A record of a block, followed by its key and its value, and padded to a
+ * multiple of 4 bytes.
+ */
+typedef struct {
+	uint32_t key_len;
+	uint32_t value_len;
+	uint32_t expiry;
+} fio_kv_export_record_t;
+
+
+/**
+ * Export all the key/value pairs of a pool to a stream.
+ *
+ * The pool is iterated over in batches, and its pairs are packed back to
+ * back in checksummed blocks of up to FIO_KV_EXPORT_BLOCK_SIZE bytes,
+ * written by a separate thread while the next block is filled. All writes
+ * are aligned on, and multiples of, FIO_KV_EXPORT_ALIGNMENT bytes, starting
+ * at the current offset of the file descriptor, which can be opened with
+ * O_DIRECT. Values are exported uncompressed. Pairs written to the pool
+ * during the export may or may not be part of the stream.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	fd (int): The file descriptor to write the stream to.
+ * Returns:
+ *	Returns the number of pairs exported, or -1 if an error occurred, with
+ *	  errno set to EOPNOTSUPP for packed pools.
+ */
+int64_t fio_kv_export_pool(const fio_kv_pool_t *pool, const int fd);
+
+/**
+ * Import the key/value pairs of a stream written by fio_kv_export_pool()
+ * into a pool.
+ *
+ * The stream is read block by block, and each block is verified and then
+ * written to the pool by one of the given number of threads, in batch puts
+ * of up to FIO_KV_EXPORT_BATCH pairs. Pairs already in the pool are
+ * replaced. All reads are aligned on, and multiples of,
+ * FIO_KV_EXPORT_ALIGNMENT bytes, starting at the current offset of the file
+ * descriptor, which can be opened with O_DIRECT. If an error occurs, some of
+ * the pairs of the stream may have been imported.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	fd (int): The file descriptor to read the stream from.
+ *	threads (uint32_t): The number of threads writing to the pool, between 1
+ *	  and FIO_KV_IMPORT_MAX_THREADS.
+ * Returns:
+ *	Returns the number of pairs imported, or -1 if an error occurred, with
+ *	  errno set to EINVAL if the stream is not an export stream, or to EIO
+ *	  if it is corrupted or truncated.
+ */
+int64_t fio_kv_import_pool(const fio_kv_pool_t *pool, const int fd,
+		const uint32_t threads);
+
+/**
+ * Export all the key/value pairs of a pool to a file.
+ *
+ * The stream is written with fio_kv_export_pool(), through O_DIRECT when
+ * the file system supports it, to a temporary file next to the given path,
+ * which is synced and then renamed over the given path, so that a failed
+ * export never leaves a partial file.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns the number of pairs exported, or -1 if an error occurred.
+ */
+int64_t fio_kv_export_file(const fio_kv_pool_t *pool, const char *path);
+
+/**
+ * Import the key/value pairs of a file written by fio_kv_export_file() into
+ * a pool, with fio_kv_import_pool().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ *	threads (uint32_t): The number of threads writing to the pool.
+ * Returns:
+ *	Returns the number of pairs imported, or -1 if an error occurred.
+ */
+int64_t fio_kv_import_file(const fio_kv_pool_t *pool, const char *path,
+		const uint32_t threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_EXPORT_H__ */
@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_group.h"
+
+/**
+ * Group commit of single puts.
+ *
+ * Writers that put one pair at a time pay for one device write each. With
+ * group commit, concurrent puts to the same pool are combined into a single
+ * batch write: each put joins the open batch of its pool, and waits for it to
+ * be written. There is no flusher thread: the put that fills a batch, or the
+ * first one to find its batch's deadline passed, writes the batch on behalf
+ * of all its pairs, without holding the slot's lock, while a new batch opens
+ * behind it.
+ */
+
+
+/**
+ * Return the slot batching the puts of a pool.
+ */
+fio_kv_group_slot_t *_fio_kv_group_slot(fio_kv_group_t *group,
+		const int pool_id)
+{
+	return &group->slots[(uint32_t)pool_id % FIO_KV_GROUP_SLOTS];
+}
+
+/**
+ * Tell whether the open batch of a slot can take a pair. A batch only holds
+ * pairs of one pool, with distinct keys. Called with the slot's lock held.
+ */
+bool _fio_kv_group_accepts(const fio_kv_group_slot_t *slot,
+		const int pool_id, const nvm_kv_key_t *key, const uint32_t key_len)
+{
+	for (uint32_t i=0; i<slot->count; i++) {
+		const nvm_kv_iovec_t *v = &slot->requests[i]->v;
+		if (slot->requests[i]->pool_id != pool_id ||
+				(v->key_len == key_len && memcmp(v->key, key, key_len) == 0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Compute the deadline of a batch opening now.
+ */
+void _fio_kv_group_deadline(struct timespec *deadline, const uint32_t delay)
+{
+	clock_gettime(CLOCK_REALTIME, deadline);
+	deadline->tv_sec += delay / 1000000;
+	deadline->tv_nsec += (long)(delay % 1000000) * 1000;
+	if (deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+/**
+ * Write the open batch of a slot and signal its completion. Called with the
+ * slot's lock held, which is released while the batch is written.
+ */
+void _fio_kv_group_flush(fio_kv_group_t *group, fio_kv_group_slot_t *slot)
+{
+	fio_kv_group_request_t *requests[FIO_KV_GROUP_MAX_PAIRS];
+	nvm_kv_iovec_t v[FIO_KV_GROUP_MAX_PAIRS];
+	uint32_t count = slot->count;
+
+	assert(count > 0);
+	memcpy(requests, slot->requests, count * sizeof(*requests));
+	slot->count = 0;
+	slot->batch++;
+	pthread_mutex_unlock(&slot->lock);
+
+	for (uint32_t i=0; i<count; i++) {
+		v[i] = requests[i]->v;
+	}
+
+	int ret = count > 1
+		? nvm_kv_batch_put(group->kv, requests[0]->pool_id, v, count)
+		: -1;
+
+	// Lone pairs, and the pairs of a batch the device rejected, are written
+	// on their own.
+	for (uint32_t i=0; i<count; i++) {
+		fio_kv_group_request_t *request = requests[i];
+		if (ret == 0) {
+			request->result = (int)request->v.value_len;
+			request->error = 0;
+			continue;
+		}
+
+		request->result = nvm_kv_put(group->kv, request->pool_id,
+				request->v.key, request->v.key_len,
+				request->v.value, request->v.value_len,
+				request->v.expiry, true, request->v.gen_count);
+		request->error = request->result < 0 ? errno : 0;
+	}
+
+	pthread_mutex_lock(&slot->lock);
+	for (uint32_t i=0; i<count; i++) {
+		requests[i]->done = true;
+	}
+	pthread_cond_broadcast(&slot->flushed);
+}
+
+/**
+ * Create a group commit queue combining single puts into batches.
+ *
+ * Args:
+ *	kv (int64_t): The directKV store ID the puts are written to.
+ *	max_pairs (uint32_t): The number of pairs that triggers the write of a
+ *	  batch, between 2 and FIO_KV_GROUP_MAX_PAIRS.
+ *	delay (uint32_t): The longest time, in microseconds, a put waits for
+ *	  other puts to join its batch.
+ * Returns:
+ *	Returns a newly allocated queue, or NULL if it could not be allocated,
+ *	  with errno set to EINVAL if its settings are invalid.
+ */
+fio_kv_group_t *fio_kv_group_create(const int64_t kv,
+		const uint32_t max_pairs, const uint32_t delay)
+{
+	if (max_pairs < 2 || max_pairs > FIO_KV_GROUP_MAX_PAIRS) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fio_kv_group_t *group = (fio_kv_group_t *)calloc(1,
+			sizeof(fio_kv_group_t));
+	if (group == NULL) {
+		return NULL;
+	}
+
+	group->kv = kv;
+	group->max_pairs = max_pairs;
+	group->delay = delay;
+	for (uint32_t i=0; i<FIO_KV_GROUP_SLOTS; i++) {
+		pthread_mutex_init(&group->slots[i].lock, NULL);
+		pthread_cond_init(&group->slots[i].flushed, NULL);
+	}
+
+	return group;
+}
+
+/**
+ * Release a group commit queue. No put must be in progress.
+ *
+ * Args:
+ *	group (fio_kv_group_t *): The group commit queue.
+ */
+void fio_kv_group_destroy(fio_kv_group_t *group)
+{
+	assert(group != NULL);
+
+	for (uint32_t i=0; i<FIO_KV_GROUP_SLOTS; i++) {
+		assert(group->slots[i].count == 0);
+		pthread_cond_destroy(&group->slots[i].flushed);
+		pthread_mutex_destroy(&group->slots[i].lock);
+	}
+
+	free(group);
+}
+
+/**
+ * Insert (or replace) a key/value pair as part of a batch.
+ *
+ * The pair joins the open batch of its pool, which is written to the device
+ * once it holds max_pairs pairs, or once the delay has passed since its first
+ * pair joined it. The call returns when the batch has been written. If the
+ * device rejects the batch, its pairs are written one by one so that each
+ * put gets its own result.
+ *
+ * Args:
+ *	group (fio_kv_group_t *): The group commit queue.
+ *	pool_id (int): The ID of the pool.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The value's sector-aligned data.
+ *	value_len (uint32_t): The value's length.
+ *	expiry (uint32_t): The pair's expiry.
+ *	gen_count (uint32_t): The pair's generation count, passed on to the
+ *	  device like with nvm_kv_put().
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error.
+ */
+int fio_kv_group_put(fio_kv_group_t *group, const int pool_id,
+		nvm_kv_key_t *key, const uint32_t key_len, void *value,
+		const uint32_t value_len, const uint32_t expiry,
+		const uint32_t gen_count)
+{
+	assert(group != NULL);
+	assert(key != NULL);
+
+	fio_kv_group_request_t request;
+	memset(&request, 0, sizeof(fio_kv_group_request_t));
+	request.pool_id = pool_id;
+	request.v.key = key;
+	request.v.key_len = key_len;
+	request.v.value = value;
+	request.v.value_len = value_len;
+	request.v.expiry = expiry;
+	request.v.gen_count = gen_count;
+	request.v.replace = 1;
+
+	fio_kv_group_slot_t *slot = _fio_kv_group_slot(group, pool_id);
+	pthread_mutex_lock(&slot->lock);
+
+	// Flushing releases the lock, after which another batch may have been
+	// opened by then.
+	while (slot->count > 0 &&
+			!_fio_kv_group_accepts(slot, pool_id, key, key_len)) {
+		_fio_kv_group_flush(group, slot);
+	}
+
+	request.batch = slot->batch;
+	slot->requests[slot->count++] = &request;
+	if (slot->count == 1) {
+		_fio_kv_group_deadline(&slot->deadline, group->delay);
+	}
+
+	if (slot->count >= group->max_pairs) {
+		_fio_kv_group_flush(group, slot);
+	}
+
+	while (!request.done) {
+		// Once the batch is being written, just wait for its completion.
+		if (request.batch != slot->batch) {
+			pthread_cond_wait(&slot->flushed, &slot->lock);
+			continue;
+		}
+
+		if (pthread_cond_timedwait(&slot->flushed, &slot->lock,
+					&slot->deadline) == ETIMEDOUT &&
+				request.batch == slot->batch) {
+			_fio_kv_group_flush(group, slot);
+		}
+	}
+
+	pthread_mutex_unlock(&slot->lock);
+
+	if (request.result < 0) {
+		errno = request.error;
+	}
+
+	return request.result;
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_GROUP_H__
+#define __FIO_KV_GROUP_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <nvm/nvm_kv.h>
+
+/**
+ * Number of independently locked batching slots of a group commit queue.
+ * Pools are spread over the slots by ID.
+ */
+#define FIO_KV_GROUP_SLOTS					64
+
+/**
+ * Largest number of pairs combined in one batch, which is the largest batch
+ * directKV accepts.
+ */
+#define FIO_KV_GROUP_MAX_PAIRS				16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	int pool_id;
+	nvm_kv_iovec_t v;
+	uint64_t batch;
+	int result;
+	int error;
+	bool done;
+} fio_kv_group_request_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t flushed;
+	fio_kv_group_request_t *requests[FIO_KV_GROUP_MAX_PAIRS];
+	uint32_t count;
+	uint64_t batch;
+	struct timespec deadline;
+} fio_kv_group_slot_t;
+
+typedef struct {
+	int64_t kv;
+	uint32_t max_pairs;
+	uint32_t delay;
+	fio_kv_group_slot_t slots[FIO_KV_GROUP_SLOTS];
+} fio_kv_group_t;
+
+
+/**
+ * Create a group commit queue combining single puts into batches.
+ *
+ * Args:
+ *	kv (int64_t): The directKV store ID the puts are written to.
+ *	max_pairs (uint32_t): The number of pairs that triggers the write of a
+ *	  batch, between 2 and FIO_KV_GROUP_MAX_PAIRS.
+ *	delay (uint32_t): The longest time, in microseconds, a put waits for
+ *	  other puts to join its batch.
+ * Returns:
+ *	Returns a newly allocated queue, or NULL if it could not be allocated,
+ *	  with errno set to EINVAL if its settings are invalid.
+ */
+fio_kv_group_t *fio_kv_group_create(const int64_t kv,
+		const uint32_t max_pairs, const uint32_t delay);
+
+/**
+ * Release a group commit queue. No put must be in progress.
+ *
+ * Args:
+ *	group (fio_kv_group_t *): The group commit queue.
+ */
+void fio_kv_group_destroy(fio_kv_group_t *group);
+
+/**
+ * Insert (or replace) a key/value pair as part of a batch.
+ *
+ * The pair joins the open batch of its pool, which is written to the device
+ * once it holds max_pairs pairs, or once the delay has passed since its first
+ * pair joined it. The call returns when the batch has been written. If the
+ * device rejects the batch, its pairs are written one by one so that each
+ * put gets its own result.
+ *
+ * Args:
+ *	group (fio_kv_group_t *): The group commit queue.
+ *	pool_id (int): The ID of the pool.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The value's sector-aligned data.
+ *	value_len (uint32_t): The value's length.
+ *	expiry (uint32_t): The pair's expiry.
+ *	gen_count (uint32_t): The pair's generation count, passed on to the
+ *	  device like with nvm_kv_put().
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error.
+ */
+int fio_kv_group_put(fio_kv_group_t *group, const int pool_id,
+		nvm_kv_key_t *key, const uint32_t key_len, void *value,
+		const uint32_t value_len, const uint32_t expiry,
+		const uint32_t gen_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_GROUP_H__ */
@@ -34,11 +34,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "fio_kv_helper.h"
+#include "fio_kv_hotkeys.h"
+#include "fio_kv_slab.h"
 
 /**
  * This is a glue library over FusionIO's key/value store API. It provides an
@@ -56,6 +59,38 @@
  */
 
 
+/**
+ * Fill the pool registry of a store being opened with the pools of the
+ * device.
+ */
+bool _fio_kv_load_pools(fio_kv_store_t *store)
+{
+	nvm_kv_store_info_t info;
+
+	nvm_kv_pool_metadata_t *metadata = (nvm_kv_pool_metadata_t *)calloc(
+			FIO_KV_MAX_POOLS, sizeof(nvm_kv_pool_metadata_t));
+	if (metadata == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	// TODO(mpetazzoni): use the returned count when
+	// nvm_kv_get_pool_metadata() returns the correct value.
+	bool ret = nvm_kv_get_pool_metadata(store->kv, metadata,
+			FIO_KV_MAX_POOLS, 1) >= 0 &&
+		nvm_kv_get_store_info(store->kv, &info) >= 0;
+	for (uint32_t i = 0; ret && i < info.num_pools && i < FIO_KV_MAX_POOLS;
+			i++) {
+		metadata[i].pool_tag.pool_tag[FIO_TAG_MAX_LENGTH - 1] = '\0';
+		ret = metadata[i].pool_id <= 0 ||
+			fio_kv_registry_add(store->pools, metadata[i].pool_id,
+				(const char *)metadata[i].pool_tag.pool_tag);
+	}
+
+	free(metadata);
+	return ret;
+}
+
 /**
  * Open a Fusion-IO device or directFS file for key/value store access.
  *
@@ -75,11 +110,15 @@
  *		global).
  *	expiry_time (uint32_t): The expiration time for global expiry mode, in
  *		seconds since the key/value pair insertion.
+ *	cache_size (uint64_t): The byte budget of the store's in-process read
+ *		cache, or 0 to disable it. The read cache is not available in global
+ *		expiry mode, where directKV doesn't report when pairs expire.
  * Returns:
  *	Returns true if the operation succeeded, false otherwise.
  */
 bool fio_kv_open(fio_kv_store_t *store, const uint32_t version,
-		const nvm_kv_expiry_t expiry_type, const uint32_t expiry_time)
+		const nvm_kv_expiry_t expiry_type, const uint32_t expiry_time,
+		const uint64_t cache_size)
 {
 	int flags = O_RDWR | O_DIRECT;
 
@@ -89,6 +128,21 @@ bool fio_kv_open(fio_kv_store_t *store, const uint32_t version,
 		assert(expiry_time > 0);
 	}
 
+	store->cache = NULL;
+	store->filters = NULL;
+	store->group = NULL;
+	store->codecs = NULL;
+	store->pack = NULL;
+	store->stats = NULL;
+	store->sched = NULL;
+	store->hotkeys = NULL;
+	store->pools = NULL;
+	store->locks = NULL;
+	if (cache_size > 0 && expiry_type == KV_GLOBAL_EXPIRY) {
+		errno = EINVAL;
+		return 0;
+	}
+
 	if (strncmp(store->path, "/dev", 4) != 0) {
 		flags |= O_LARGEFILE | O_CREAT;
 	}
@@ -110,6 +164,71 @@ bool fio_kv_open(fio_kv_store_t *store, const uint32_t version,
 		return 0;
 	}
 
+	store->filters = (fio_kv_bloom_t **)calloc(FIO_KV_MAX_POOLS,
+			sizeof(fio_kv_bloom_t *));
+	if (store->filters == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	store->codecs = (fio_kv_codec_t *)calloc(FIO_KV_MAX_POOLS,
+			sizeof(fio_kv_codec_t));
+	if (store->codecs == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	store->pack = fio_kv_pack_create(FIO_KV_MAX_POOLS);
+	if (store->pack == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	store->stats = fio_kv_stats_create();
+	if (store->stats == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	store->pools = fio_kv_registry_create();
+	if (store->pools == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	store->locks = (pthread_mutex_t *)malloc(FIO_KV_ATOMIC_LOCKS *
+			sizeof(pthread_mutex_t));
+	if (store->locks == NULL) {
+		fio_kv_close(store);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	for (int i=0; i<FIO_KV_ATOMIC_LOCKS; i++) {
+		pthread_mutex_init(&store->locks[i], NULL);
+	}
+
+	if (!_fio_kv_load_pools(store)) {
+		int error = errno;
+		fio_kv_close(store);
+		errno = error;
+		return 0;
+	}
+
+	if (cache_size > 0) {
+		store->cache = fio_kv_cache_create(cache_size);
+		if (store->cache == NULL) {
+			fio_kv_close(store);
+			errno = ENOMEM;
+			return 0;
+		}
+	}
+
 	return 1;
 }
 
@@ -127,15 +246,218 @@ void fio_kv_close(fio_kv_store_t *store)
 	assert(store != NULL);
 	assert(store->kv > 0);
 
+	// The manifest is saved before the cache goes away, and its prefetch
+	// stopped before the device is closed.
+	if (store->hotkeys != NULL) {
+		fio_kv_hotkeys_save(store->hotkeys);
+		fio_kv_hotkeys_destroy(store->hotkeys);
+		store->hotkeys = NULL;
+	}
+
+	if (store->group != NULL) {
+		fio_kv_group_destroy(store->group);
+		store->group = NULL;
+	}
+
 	if (store->fd) {
 		fsync(store->fd);
 		close(store->fd);
 	}
 
+	if (store->cache != NULL) {
+		fio_kv_cache_destroy(store->cache);
+		store->cache = NULL;
+	}
+
+	if (store->filters != NULL) {
+		for (int i=0; i<FIO_KV_MAX_POOLS; i++) {
+			fio_kv_bloom_t *bloom = store->filters[i];
+			while (bloom != NULL) {
+				fio_kv_bloom_t *previous = bloom->previous;
+				fio_kv_bloom_destroy(bloom);
+				bloom = previous;
+			}
+		}
+		free(store->filters);
+		store->filters = NULL;
+	}
+
+	free(store->codecs);
+	store->codecs = NULL;
+
+	if (store->pack != NULL) {
+		fio_kv_pack_destroy(store->pack);
+		store->pack = NULL;
+	}
+
+	fio_kv_stats_destroy(store->stats);
+	store->stats = NULL;
+
+	fio_kv_sched_destroy(store->sched);
+	store->sched = NULL;
+
+	fio_kv_registry_destroy(store->pools);
+	store->pools = NULL;
+
+	if (store->locks != NULL) {
+		for (int i=0; i<FIO_KV_ATOMIC_LOCKS; i++) {
+			pthread_mutex_destroy(&store->locks[i]);
+		}
+		free(store->locks);
+		store->locks = NULL;
+	}
+
 	store->fd = 0;
 	store->kv = 0;
 }
 
+/**
+ * Enable the group commit of single puts on a key/value store.
+ *
+ * Once enabled, concurrent calls to fio_kv_put() on the same pool are combined
+ * into batch writes. Each put still only returns once its pair is written,
+ * after waiting up to the given delay for other puts to join its batch. This
+ * must be done before the store is written to.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ *	max_pairs (uint32_t): The number of pairs that triggers the write of a
+ *	  batch, between 2 and FIO_KV_GROUP_MAX_PAIRS.
+ *	delay (uint32_t): The longest time, in microseconds, a put waits for
+ *	  other puts to join its batch.
+ * Returns:
+ *	Returns true if group commit was enabled, false otherwise, with errno
+ *	  set to EEXIST if it already was.
+ */
+bool fio_kv_set_group_commit(fio_kv_store_t *store, const uint32_t max_pairs,
+		const uint32_t delay)
+{
+	assert(store != NULL);
+	assert(store->kv > 0);
+
+	if (store->group != NULL) {
+		errno = EEXIST;
+		return false;
+	}
+
+	store->group = fio_kv_group_create(store->kv, max_pairs, delay);
+	return store->group != NULL;
+}
+
+/**
+ * Configure the scheduling of an I/O class on a key/value store.
+ *
+ * The store classifies its operations as foreground reads (gets and
+ * existence checks), foreground writes (puts, removals and batches of up to
+ * FIO_KV_MAX_BATCH_SIZE pairs) and background work (iterations, batch puts
+ * of more than FIO_KV_MAX_BATCH_SIZE pairs and pool deletions). Each class
+ * can be rate limited, and can yield to the classes of higher priority
+ * while they have operations in flight. Nothing is scheduled until a class
+ * is configured. This must be done before the store is used.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ *	cls (fio_kv_sched_class_t): The I/O class.
+ *	rate (uint32_t): The maximum rate of the class, in operations per
+ *	  second, or 0 for no limit. A batch counts for as many operations as
+ *	  it has pairs.
+ *	burst (uint32_t): The number of operations that can be issued at once
+ *	  above the rate, at least 1 if the rate is limited.
+ *	max_defer (uint32_t): The longest time an operation of the class yields
+ *	  to higher-priority ones, in microseconds, or 0 to never yield.
+ * Returns:
+ *	Returns true if the class was configured, false otherwise, with errno
+ *	  set to EINVAL if the class or the burst is invalid.
+ */
+bool fio_kv_set_sched(fio_kv_store_t *store, const fio_kv_sched_class_t cls,
+		const uint32_t rate, const uint32_t burst, const uint32_t max_defer)
+{
+	assert(store != NULL);
+	assert(store->kv > 0);
+
+	if (store->sched == NULL) {
+		store->sched = fio_kv_sched_create();
+		if (store->sched == NULL) {
+			errno = ENOMEM;
+			return false;
+		}
+	}
+
+	return fio_kv_sched_configure(store->sched, cls, rate, burst, max_defer);
+}
+
+/**
+ * Enable the hot key manifest of a key/value store.
+ *
+ * The keys held by the store's read cache are saved to the manifest file
+ * when the store is closed. The keys of the manifest saved by a previous use
+ * of the store, if any, are prefetched into the read cache by
+ * fio_kv_prefetch_hot_keys(), so that the cache doesn't have to fill up from
+ * scratch. This must be done right after the store is opened.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a read cache.
+ *	path (char *): The path of the manifest file.
+ *	max_keys (uint32_t): The maximum number of keys saved to the manifest.
+ * Returns:
+ *	Returns true if the manifest was enabled, false otherwise, with errno
+ *	  set to EINVAL if the store has no read cache, or to EEXIST if it
+ *	  already has a manifest.
+ */
+bool fio_kv_set_hot_keys(fio_kv_store_t *store, const char *path,
+		const uint32_t max_keys)
+{
+	assert(store != NULL);
+	assert(store->kv > 0);
+	assert(path != NULL);
+
+	if (store->cache == NULL || max_keys == 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	if (store->hotkeys != NULL) {
+		errno = EEXIST;
+		return false;
+	}
+
+	store->hotkeys = fio_kv_hotkeys_create(store, path, max_keys);
+	if (store->hotkeys == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Start prefetching the keys of the hot key manifest of a key/value store
+ * into its read cache, in the background.
+ *
+ * Keys of pools not compressed or packed as they were when the manifest was
+ * saved are not prefetched, so this should be done once the pools of the
+ * store are configured.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a hot key manifest.
+ * Returns:
+ *	Returns true if the prefetch was started, or if there is no manifest to
+ *	  prefetch, false otherwise, with errno set to EINVAL if the store has
+ *	  no hot key manifest, or to EALREADY if the prefetch was already
+ *	  started.
+ */
+bool fio_kv_prefetch_hot_keys(fio_kv_store_t *store)
+{
+	assert(store != NULL);
+
+	if (store->hotkeys == NULL) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return fio_kv_hotkeys_prefetch(store->hotkeys);
+}
+
 /**
  * Returns information about the given key/value store.
  *
@@ -160,9 +482,42 @@ nvm_kv_store_info_t *fio_kv_get_store_info(fio_kv_store_t *store)
 	return info;
 }
 
+/**
+ * Returns a snapshot of the operation statistics of the given key/value store.
+ *
+ * The latency, error and byte counters of the store's operations are summed
+ * over all threads. Latencies are the time spent in this library's calls;
+ * the JNI counters separately account for the marshalling overhead of the
+ * Java binding's calls.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ * Returns:
+ *	A pointer to a populated fio_kv_stats_snapshot_t structure, to be
+ *	  released with free(), or NULL if it could not be allocated.
+ */
+fio_kv_stats_snapshot_t *fio_kv_get_stats(const fio_kv_store_t *store)
+{
+	assert(store != NULL);
+	assert(store->stats != NULL);
+
+	fio_kv_stats_snapshot_t *snapshot = (fio_kv_stats_snapshot_t *)
+		malloc(sizeof(fio_kv_stats_snapshot_t));
+	if (snapshot == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	fio_kv_stats_get(store->stats, snapshot);
+	return snapshot;
+}
+
 /**
  * Get or create a new pool in the given key/value store.
  *
+ * Pools already known to the store's pool registry are resolved without
+ * going to the device.
+ *
  * Args:
  *	store (fio_kv_store_t *): The key/value store.
  *	tag (const char *): The pool tag. Must be a properly NUL-terminated string
@@ -178,65 +533,103 @@ fio_kv_pool_t *fio_kv_get_or_create_pool(fio_kv_store_t *store,
 	assert(store->kv > 0);
 	assert(strlen(tag) < FIO_TAG_MAX_LENGTH);
 
-	int ret = nvm_kv_pool_create(store->kv, (nvm_kv_pool_tag_t *)tag);
+	assert(store->pools != NULL);
+
+	int ret = fio_kv_registry_find(store->pools, tag);
 	if (ret <= 0) {
-		return NULL;
+		ret = nvm_kv_pool_create(store->kv, (nvm_kv_pool_tag_t *)tag);
+		if (ret <= 0 || !fio_kv_registry_add(store->pools, ret, tag)) {
+			return NULL;
+		}
 	}
 
 	fio_kv_pool_t *pool = (fio_kv_pool_t *)malloc(sizeof(fio_kv_pool_t));
+	if (pool == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
 	pool->store = store;
 	pool->id = ret;
 	strcpy(pool->tag, tag);
+	pool->size_hint = FIO_KV_DEFAULT_SIZE_HINT;
 	return pool;
 }
 
 /**
- * Get pool metadata information for up to the requested number of pools.
+ * Get the pools of the given key/value store.
+ *
+ * The pools are listed, in increasing ID order, from the store's pool
+ * registry, which is loaded from the device when the store is opened and kept
+ * up-to-date as pools are created and deleted through the store.
  *
  * Args:
  *	store (fio_kv_store_t *): The key/value store.
  *	pool_count (uint32_t *): A pointer to an integer that will contain the
- *		actual number of pools we got metadata about.
+ *		actual number of pools.
  * Returns:
  *	An array of initialized and filled-in fio_kv_pool_t structures, with the
- *	pool IDs and pool tags for each pool up to the number of requested pools.
+ *	pool IDs and pool tags for each pool.
  */
 fio_kv_pool_t *fio_kv_get_all_pools(fio_kv_store_t *store, uint32_t *pool_count)
 {
-	fio_kv_pool_t *pools;
-	nvm_kv_pool_metadata_t *metadata;
-	int ret;
-
 	assert(store != NULL);
 	assert(store->kv > 0);
+	assert(store->pools != NULL);
 	assert(pool_count != NULL);
 
-	metadata = (nvm_kv_pool_metadata_t *)calloc(FIO_KV_MAX_POOLS,
-			sizeof(nvm_kv_pool_metadata_t));
-	ret = nvm_kv_get_pool_metadata(store->kv, metadata, FIO_KV_MAX_POOLS, 1);
-	if (ret < 0) {
-		free(metadata);
+	fio_kv_registry_entry_t *entries = fio_kv_registry_list(store->pools,
+			pool_count);
+	if (entries == NULL) {
 		return NULL;
 	}
 
-	// TODO(mpetazzoni): remove when nvm_kv_get_pool_metadata() returns the
-	// correct value.
-	// *pool_count = ret;
-	nvm_kv_store_info_t *info = fio_kv_get_store_info(store);
-	*pool_count = info->num_pools;
-	free(info);
+	fio_kv_pool_t *pools = (fio_kv_pool_t *)calloc(*pool_count + 1,
+			sizeof(fio_kv_pool_t));
+	if (pools == NULL) {
+		free(entries);
+		errno = ENOMEM;
+		return NULL;
+	}
 
-	pools = (fio_kv_pool_t *)calloc(*pool_count, sizeof(fio_kv_pool_t));
-	for (int i = 0; i < *pool_count ; i++) {
+	for (uint32_t i = 0; i < *pool_count ; i++) {
 		pools[i].store = store;
-		pools[i].id = metadata[i].pool_id;
-		strcpy(pools[i].tag, (const char *)(metadata[i].pool_tag.pool_tag));
+		pools[i].id = entries[i].id;
+		strcpy(pools[i].tag, entries[i].tag);
+		pools[i].size_hint = FIO_KV_DEFAULT_SIZE_HINT;
 	}
 
-	free(metadata);
+	free(entries);
 	return pools;
 }
 
+/**
+ * Reset the per-pool state a store keeps for a pool ID once the pool is
+ * deleted, so that the next pool created with that ID starts unpacked,
+ * uncompressed and without a Bloom filter.
+ *
+ * The Bloom filter can't be released here, since concurrent operations on
+ * the pool may still be using it: it is only marked retired, and is released
+ * with the filter that replaces it when the store is closed.
+ */
+void _fio_kv_reset_pool(const fio_kv_store_t *store, const int id)
+{
+	if (store->pack != NULL) {
+		store->pack->buckets[id] = 0;
+	}
+
+	if (store->codecs != NULL) {
+		store->codecs[id] = FIO_KV_CODEC_NONE;
+	}
+
+	if (store->filters != NULL && store->filters[id] != NULL) {
+		fio_kv_bloom_t *bloom = store->filters[id];
+		bloom->ready = 0;
+		__sync_synchronize();
+		bloom->retired = 1;
+	}
+}
+
 /**
  * Delete the given pool.
  *
@@ -257,7 +650,21 @@ bool fio_kv_delete_pool(const fio_kv_pool_t *pool)
 	assert(pool->store->kv > 0);
 	assert(pool->id > 1 && pool->id < NVM_KV_MAX_POOLS);
 
-	return nvm_kv_pool_delete(pool->store->kv, pool->id) == 0;
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	int ret = nvm_kv_pool_delete(pool->store->kv, pool->id);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_BACKGROUND);
+	if (ret == 0) {
+		_fio_kv_reset_pool(pool->store, pool->id);
+		if (pool->store->pools != NULL) {
+			fio_kv_registry_remove(pool->store->pools, pool->id);
+		}
+	}
+
+	if (pool->store->cache != NULL) {
+		fio_kv_cache_invalidate_pool(pool->store->cache, pool->id);
+	}
+
+	return ret == 0;
 }
 
 /**
@@ -273,119 +680,561 @@ bool fio_kv_delete_all_pools(const fio_kv_store_t *store)
 	assert(store != NULL);
 	assert(store->kv > 0);
 
-	return nvm_kv_pool_delete(store->kv, -1) == 0;
+	fio_kv_sched_enter(store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	int ret = nvm_kv_pool_delete(store->kv, -1);
+	fio_kv_sched_exit(store->sched, FIO_KV_SCHED_BACKGROUND);
+	for (int i=2; ret == 0 && i<FIO_KV_MAX_POOLS; i++) {
+		_fio_kv_reset_pool(store, i);
+	}
+
+	if (ret == 0 && store->pools != NULL) {
+		fio_kv_registry_remove(store->pools, -1);
+	}
+
+	if (store->cache != NULL) {
+		fio_kv_cache_invalidate_pool(store->cache, -1);
+	}
+
+	return ret == 0;
 }
 
 /**
- * Allocate sector-aligned memory to hold the given number of bytes.
- *
- * Args:
- *	length (uint32_t): Size of the memory to allocate.
- * Returns:
- *	A pointer to sector-aligned, allocated memory that can hold up to length
- *	bytes.
+ * Round a length up to the next multiple of the sector size.
  */
-void *fio_kv_alloc(const uint32_t length)
+uint32_t _fio_kv_sector_round(const uint32_t length)
+{
+	return (length + FIO_SECTOR_ALIGNMENT - 1) &
+		~(uint32_t)(FIO_SECTOR_ALIGNMENT - 1);
+}
+
+/**
+ * Size and maximum number of records of the batches read while building the
+ * Bloom filter of a pool.
+ */
+#define _FIO_KV_FILTER_BATCH_SIZE		(256 * 1024)
+#define _FIO_KV_FILTER_BATCH_MAX		1024
+
+/**
+ * Return the Bloom filter of a pool, or NULL if it has none. The filter of
+ * a deleted pool stays installed, retired, until another filter replaces it.
+ */
+fio_kv_bloom_t *_fio_kv_filter(const fio_kv_pool_t *pool)
 {
-	void *p;
+	if (pool->store->filters == NULL) {
+		return NULL;
+	}
 
-	if (posix_memalign(&p, FIO_SECTOR_ALIGNMENT,
-				length + FIO_SECTOR_ALIGNMENT -
-				(length % FIO_SECTOR_ALIGNMENT))) {
+	fio_kv_bloom_t *bloom = pool->store->filters[pool->id];
+	if (bloom == NULL || bloom->retired) {
 		return NULL;
 	}
 
-	return p;
+	return bloom;
 }
 
 /**
- * Free the memory allocated for the 'data' field of a fio_kv_value_t
- * structure.
- *
- * It is still the responsibility of the caller to manage the memory of the
- * other fields of that structure, in particular the 'info' field.
- *
- * Args:
- *	value (fio_kv_value_t *): The value structure to free.
+ * Tell whether the ready Bloom filter of a pool rules out a key, in which
+ * case errno is set to ENOENT.
  */
-void fio_kv_free_value(fio_kv_value_t *value)
+bool _fio_kv_filter_excludes(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key)
 {
-	assert(value != NULL);
+	fio_kv_bloom_t *bloom = _fio_kv_filter(pool);
+	if (bloom == NULL || !bloom->ready ||
+			fio_kv_bloom_may_contain(bloom, key->bytes, key->length)) {
+		return false;
+	}
 
-	free(value->data);
-	value->data = NULL;
+	errno = ENOENT;
+	return true;
 }
 
 /**
- * Retrieve a value's length, rounded up to the next sector, without any I/O.
- *
- * Args:
- *	pool (fio_kv_pool_t *): The key/value pool.
- *	key (fio_kv_key_t *): The key.
- * Returns:
- *	The value length, rounded up to the next sector.
+ * Add a key to the Bloom filter of its pool, if it has one. Keys are added
+ * before they are written, so that the filter never rules out a key that is
+ * on the device.
  */
-int fio_kv_get_value_len(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+void _fio_kv_filter_add(const fio_kv_pool_t *pool, const nvm_kv_key_t *key,
+		const uint32_t key_len)
 {
-	assert(pool != NULL);
-	assert(pool->store != NULL);
-	assert(pool->store->kv > 0);
-	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(key != null);
-	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
-	assert(key->bytes != NULL);
-
-	int len = nvm_kv_get_val_len(pool->store->kv, pool->id,
-			key->bytes, key->length);
-	return len < NVM_KV_MAX_VALUE_SIZE ? len : NVM_KV_MAX_VALUE_SIZE;
+	fio_kv_bloom_t *bloom = _fio_kv_filter(pool);
+	if (bloom != NULL) {
+		fio_kv_bloom_add(bloom, key, key_len);
+	}
 }
 
 /**
- * Retrieve a key/value pair's exact metadata from the device.
- *
- * Args:
- *	pool (fio_kv_pool_t *): The key/value pool.
- *	key (fio_kv_key_t *): The key.
- * Returns:
- *	A pointer to an allocated and filled-in nvm_kv_key_info_t structure.
+ * Install a Bloom filter for a pool, unless it already has one. A retired
+ * filter is chained to the filter that replaces it, so that it is only
+ * released with the store.
  */
-nvm_kv_key_info_t *fio_kv_get_key_info(const fio_kv_pool_t *pool,
-		const fio_kv_key_t *key)
+bool _fio_kv_install_filter(const fio_kv_pool_t *pool, fio_kv_bloom_t *bloom)
 {
-	assert(pool != NULL);
-	assert(pool->store != NULL);
-	assert(pool->store->kv > 0);
-	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(key != null);
-	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
-	assert(key->bytes != NULL);
+	fio_kv_bloom_t **slot = &pool->store->filters[pool->id];
 
-	nvm_kv_key_info_t *info = (nvm_kv_key_info_t *)malloc(sizeof(nvm_kv_key_info_t));
-	if (nvm_kv_get_key_info(pool->store->kv, pool->id,
-			key->bytes, key->length, info)) {
-		free(info);
-		info = NULL;
-	}
+	while (true) {
+		fio_kv_bloom_t *current = *slot;
+		if (current != NULL && !current->retired) {
+			return false;
+		}
 
-	return info;
+		bloom->previous = current;
+		if (__sync_bool_compare_and_swap(slot, current, bloom)) {
+			return true;
+		}
+	}
 }
 
 /**
- * Retrieve the value associated with a given key in a key/value pool.
+ * Return the compression codec of a pool.
+ */
+fio_kv_codec_t _fio_kv_codec(const fio_kv_pool_t *pool)
+{
+	return pool->store->codecs != NULL
+		? pool->store->codecs[pool->id]
+		: FIO_KV_CODEC_NONE;
+}
+
+/**
+ * Compress a value to be written to a pool with compression enabled.
  *
- * Note that you must provide sector-aligned memory that will can contain the
- * requested number of bytes. Such memory can be obtained by calling
- * fio_kv_alloc().
+ * Compression is only worth it if it saves at least a sector on the device,
+ * so the value is compressed into a buffer one sector shorter than its
+ * sector-rounded length, and written as is if it doesn't fit.
+ *
+ * Returns the compressed value in sector-aligned memory, to release with
+ * fio_kv_slab_free(), its length being stored in *length, or NULL if the
+ * value is to be written uncompressed.
+ */
+void *_fio_kv_deflate(const fio_kv_pool_t *pool, const void *data,
+		uint32_t *length)
+{
+	fio_kv_codec_t codec = _fio_kv_codec(pool);
+	uint32_t size = _fio_kv_sector_round(*length);
+	if (codec == FIO_KV_CODEC_NONE || size <= FIO_SECTOR_ALIGNMENT) {
+		return NULL;
+	}
+
+	size -= FIO_SECTOR_ALIGNMENT;
+	void *buffer = fio_kv_slab_alloc(size);
+	if (buffer == NULL) {
+		return NULL;
+	}
+
+	uint32_t encoded = fio_kv_codec_encode(codec, data, *length, buffer, size);
+	if (encoded == 0) {
+		fio_kv_slab_free(buffer);
+		return NULL;
+	}
+
+	*length = encoded;
+	return buffer;
+}
+
+/**
+ * Compress the values of a batch, pointing its nvm_kv_iovec_t structures at
+ * the compressed values. The compressed values are recorded in encoded, to
+ * be released with _fio_kv_release_batch() once the batch is written.
+ */
+void _fio_kv_deflate_batch(const fio_kv_pool_t *pool, nvm_kv_iovec_t *v,
+		const size_t count, void **encoded)
+{
+	for (size_t i=0; i<count; i++) {
+		encoded[i] = _fio_kv_deflate(pool, v[i].value, &v[i].value_len);
+		if (encoded[i] != NULL) {
+			v[i].value = encoded[i];
+		}
+	}
+}
+
+/**
+ * Release the compressed values of a batch.
+ */
+void _fio_kv_release_batch(void **encoded, const size_t count)
+{
+	for (size_t i=0; i<count; i++) {
+		if (encoded[i] != NULL) {
+			fio_kv_slab_free(encoded[i]);
+		}
+	}
+}
+
+/**
+ * Decompress a value read from a pool with compression enabled.
+ *
+ * The data buffer, of the given capacity, holds the first read bytes of the
+ * value, and info the metadata reported by the device. If the value was
+ * stored compressed, the rest of it is read from the device if needed, and
+ * it is decompressed into the data buffer, up to its capacity. The value_len
+ * field of info is then set to the original length of the value.
+ *
+ * Returns the number of bytes of the value in the data buffer, or -1 if an
+ * error occurred.
+ */
+int _fio_kv_inflate(const fio_kv_pool_t *pool, const nvm_kv_key_t *key,
+		const uint32_t key_len, void *data, const int read,
+		const uint32_t capacity, nvm_kv_key_info_t *info)
+{
+	if (read < 0 || _fio_kv_codec(pool) == FIO_KV_CODEC_NONE ||
+			fio_kv_codec_header(data, read, info->value_len) == NULL) {
+		return read;
+	}
+
+	void *encoded = fio_kv_slab_alloc(info->value_len);
+	if (encoded == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	int ret = read;
+	if ((uint32_t)read == info->value_len) {
+		memcpy(encoded, data, read);
+	} else {
+		ret = nvm_kv_get(pool->store->kv, pool->id, (nvm_kv_key_t *)key,
+				key_len, encoded, info->value_len, false, info);
+	}
+
+	// The value may have been replaced, uncompressed, in the meantime, or be
+	// a raw value starting like a compressed one.
+	const fio_kv_codec_header_t *header = ret >= 0
+		? fio_kv_codec_header(encoded, ret, info->value_len)
+		: NULL;
+	if (header != NULL && fio_kv_codec_verify(header)) {
+		info->value_len = header->length;
+		ret = fio_kv_codec_decode(header, data, capacity);
+	} else if (ret >= 0) {
+		ret = (uint32_t)ret < capacity ? ret : (int)capacity;
+		memcpy(data, encoded, ret);
+	}
+
+	fio_kv_slab_free(encoded);
+	return ret;
+}
+
+/**
+ * Key of the records of packed pools: bucket records are keyed by their
+ * index, and the metadata record of the pool by index 0 under its own tag.
+ */
+typedef struct {
+	char tag[4];
+	uint32_t index;
+} _fio_kv_pack_key_t;
+
+/**
+ * Return the number of buckets of a pool, or 0 if it isn't packed.
+ */
+uint32_t _fio_kv_pack_buckets(const fio_kv_pool_t *pool)
+{
+	return pool->store->pack != NULL
+		? pool->store->pack->buckets[pool->id]
+		: 0;
+}
+
+/**
+ * Build the key of the bucket record holding a logical key of a packed
+ * pool, and return the bucket's index.
+ */
+uint32_t _fio_kv_pack_key(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		_fio_kv_pack_key_t *bucket_key)
+{
+	memcpy(bucket_key->tag, "fkvb", 4);
+	bucket_key->index = fio_kv_pack_hash(key->bytes, key->length) %
+		_fio_kv_pack_buckets(pool);
+	return bucket_key->index;
+}
+
+/**
+ * Look up a logical key in a packed pool.
+ *
+ * Up to capacity bytes of the key's value are copied to data, unless it is
+ * NULL, and the metadata of the pair is written to info, unless it is NULL.
+ *
+ * Returns the number of bytes copied, or the length of the value if data is
+ * NULL, or -1 if the key wasn't found, with errno set to ENOENT.
+ */
+int _fio_kv_pack_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *data, const uint32_t capacity, nvm_kv_key_info_t *info)
+{
+	_fio_kv_pack_key_t bucket_key;
+	nvm_kv_key_info_t bucket_info;
+
+	void *bucket = fio_kv_slab_alloc(FIO_KV_PACK_BUCKET_SIZE);
+	if (bucket == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	_fio_kv_pack_key(pool, key, &bucket_key);
+	int ret = nvm_kv_get(pool->store->kv, pool->id,
+			(nvm_kv_key_t *)&bucket_key, sizeof(_fio_kv_pack_key_t),
+			bucket, FIO_KV_PACK_BUCKET_SIZE, false, &bucket_info);
+	if (ret >= 0 && !fio_kv_pack_valid(bucket, ret)) {
+		fio_kv_slab_free(bucket);
+		errno = EIO;
+		return -1;
+	}
+
+	const fio_kv_pack_entry_t *entry = ret >= 0
+		? fio_kv_pack_find(bucket, key->bytes, key->length,
+				(uint32_t)time(NULL))
+		: NULL;
+	if (entry == NULL) {
+		fio_kv_slab_free(bucket);
+		errno = ENOENT;
+		return -1;
+	}
+
+	if (info != NULL) {
+		memset(info, 0, sizeof(nvm_kv_key_info_t));
+		info->pool_id = pool->id;
+		info->key_len = key->length;
+		info->value_len = entry->value_len;
+		info->expiry = entry->expiry;
+	}
+
+	ret = entry->value_len;
+	if (data != NULL) {
+		ret = (uint32_t)ret < capacity ? ret : (int)capacity;
+		memcpy(data, fio_kv_pack_value(entry), ret);
+	}
+
+	fio_kv_slab_free(bucket);
+	return ret;
+}
+
+/**
+ * Update the bucket record holding a logical key of a packed pool.
+ *
+ * The key's entry is replaced by the given value, or removed if value is
+ * NULL, and the bucket is written back, or deleted once empty. Updates of
+ * the buckets of a store are serialized by a set of locks, within this
+ * process only.
+ *
+ * Returns true if the bucket was updated, false otherwise, with errno set
+ * to EINVAL if the value is too large to be packed, ENOSPC if the bucket is
+ * full, or ENOENT if the key to remove wasn't found.
+ */
+bool _fio_kv_pack_update(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const fio_kv_value_t *value)
+{
+	fio_kv_pack_t *pack = pool->store->pack;
+	_fio_kv_pack_key_t bucket_key;
+	nvm_kv_key_info_t info;
+	bool ret = false;
+
+	if (value != NULL && value->info->value_len > FIO_KV_PACK_MAX_VALUE) {
+		errno = EINVAL;
+		return false;
+	}
+
+	void *bucket = fio_kv_slab_alloc(FIO_KV_PACK_BUCKET_SIZE);
+	if (bucket == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	uint32_t index = _fio_kv_pack_key(pool, key, &bucket_key);
+	pthread_mutex_t *lock =
+		&pack->locks[(index + pool->id) % FIO_KV_PACK_LOCKS];
+	pthread_mutex_lock(lock);
+
+	int read = nvm_kv_get(pool->store->kv, pool->id,
+			(nvm_kv_key_t *)&bucket_key, sizeof(_fio_kv_pack_key_t),
+			bucket, FIO_KV_PACK_BUCKET_SIZE, false, &info);
+	if (read < 0 && nvm_kv_exists(pool->store->kv, pool->id,
+				(nvm_kv_key_t *)&bucket_key, sizeof(_fio_kv_pack_key_t),
+				&info) == 0) {
+		fio_kv_pack_init(bucket);
+		read = sizeof(fio_kv_pack_bucket_t);
+	}
+
+	if (read < 0) {
+		// The read's error is reported.
+	} else if (!fio_kv_pack_valid(bucket, read)) {
+		errno = EIO;
+	} else if (value != NULL) {
+		ret = fio_kv_pack_insert(bucket, key->bytes, key->length,
+				value->data, value->info->value_len, value->info->expiry,
+				(uint32_t)time(NULL));
+	} else if (!(ret = fio_kv_pack_remove(bucket, key->bytes, key->length))) {
+		errno = ENOENT;
+	}
+
+	if (ret) {
+		const fio_kv_pack_bucket_t *header = (const fio_kv_pack_bucket_t *)bucket;
+		ret = header->count > 0
+			? nvm_kv_put(pool->store->kv, pool->id,
+					(nvm_kv_key_t *)&bucket_key, sizeof(_fio_kv_pack_key_t),
+					bucket, header->used, 0, true, 0) >= 0
+			: nvm_kv_delete(pool->store->kv, pool->id,
+					(nvm_kv_key_t *)&bucket_key,
+					sizeof(_fio_kv_pack_key_t)) == 0;
+	}
+
+	pthread_mutex_unlock(lock);
+	fio_kv_slab_free(bucket);
+	return ret;
+}
+
+/**
+ * Allocate sector-aligned memory to hold the given number of bytes.
+ *
+ * The memory comes from the slab allocator and must be released with
+ * fio_kv_free_value().
+ *
+ * Args:
+ *	length (uint32_t): Size of the memory to allocate.
+ * Returns:
+ *	A pointer to sector-aligned, allocated memory that can hold up to length
+ *	bytes.
+ */
+void *fio_kv_alloc(const uint32_t length)
+{
+	return fio_kv_slab_alloc(length);
+}
+
+/**
+ * Free the memory allocated for the 'data' field of a fio_kv_value_t
+ * structure.
+ *
+ * It is still the responsibility of the caller to manage the memory of the
+ * other fields of that structure, in particular the 'info' field.
+ *
+ * Args:
+ *	value (fio_kv_value_t *): The value structure to free.
+ */
+void fio_kv_free_value(fio_kv_value_t *value)
+{
+	assert(value != NULL);
+
+	fio_kv_slab_free(value->data);
+	value->data = NULL;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_get_value_len().
+ */
+int _fio_kv_get_value_len(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(key != null);
+	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
+	assert(key->bytes != NULL);
+
+	if (_fio_kv_filter_excludes(pool, key)) {
+		return -1;
+	}
+
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		return _fio_kv_pack_get(pool, key, NULL, 0, NULL);
+	}
+
+	int len = nvm_kv_get_val_len(pool->store->kv, pool->id,
+			key->bytes, key->length);
+
+	// The original length of compressed values is in their header.
+	if (len > 0 && _fio_kv_codec(pool) != FIO_KV_CODEC_NONE) {
+		void *sector = fio_kv_slab_alloc(FIO_SECTOR_ALIGNMENT);
+		nvm_kv_key_info_t info;
+		if (sector == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+
+		int ret = nvm_kv_get(pool->store->kv, pool->id,
+				key->bytes, key->length,
+				sector, FIO_SECTOR_ALIGNMENT, false, &info);
+		const fio_kv_codec_header_t *header = ret >= 0
+			? fio_kv_codec_header(sector, ret, info.value_len)
+			: NULL;
+		len = header != NULL ? (int)header->length : len;
+		fio_kv_slab_free(sector);
+	}
+
+	return len < NVM_KV_MAX_VALUE_SIZE ? len : NVM_KV_MAX_VALUE_SIZE;
+}
+
+/**
+ * Retrieve a value's length, rounded up to the next sector, without any I/O.
+ *
+ * In pools with compression enabled, the original length of compressed
+ * values is read from their header, which takes a one-sector read.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
  *	key (fio_kv_key_t *): The key.
- *	value (fio_kv_value_t *): An allocated value structure to hold the
- *	  result.
  * Returns:
- *	 The number of bytes read, or -1 if the read failed.
+ *	The value length, rounded up to the next sector.
  */
-int fio_kv_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+int fio_kv_get_value_len(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_READ, 1);
+	int ret = _fio_kv_get_value_len(pool, key);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_READ);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_GET_VALUE_LEN, start,
+			ret < 0 ? errno : 0, 0, 0);
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_get_key_info().
+ */
+nvm_kv_key_info_t *_fio_kv_get_key_info(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(key != null);
+	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
+	assert(key->bytes != NULL);
+
+	if (_fio_kv_filter_excludes(pool, key)) {
+		return NULL;
+	}
+
+	nvm_kv_key_info_t *info = (nvm_kv_key_info_t *)malloc(sizeof(nvm_kv_key_info_t));
+	if (_fio_kv_pack_buckets(pool) != 0
+			? _fio_kv_pack_get(pool, key, NULL, 0, info) < 0
+			: nvm_kv_get_key_info(pool->store->kv, pool->id,
+				key->bytes, key->length, info) != 0) {
+		free(info);
+		info = NULL;
+	}
+
+	return info;
+}
+
+/**
+ * Retrieve a key/value pair's exact metadata from the device.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	A pointer to an allocated and filled-in nvm_kv_key_info_t structure.
+ */
+nvm_kv_key_info_t *fio_kv_get_key_info(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_READ, 1);
+	nvm_kv_key_info_t *info = _fio_kv_get_key_info(pool, key);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_READ);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_GET_KEY_INFO, start,
+			info == NULL ? errno : 0, 0, 0);
+	return info;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_get().
+ */
+int _fio_kv_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
 		const fio_kv_value_t *value)
 {
 	assert(pool != NULL);
@@ -400,292 +1249,1891 @@ int fio_kv_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
 	assert(value->info != NULL);
 	assert(value->info->value_len <= NVM_KV_MAX_VALUE_SIZE);
 
-	return nvm_kv_get(pool->store->kv, pool->id,
-			key->bytes, key->length,
-			value->data, value->info->value_len, false,
-			value->info);
+	fio_kv_cache_t *cache = pool->store->cache;
+	uint32_t capacity = value->info->value_len;
+	uint64_t epoch = 0;
+	int ret;
+
+	if (_fio_kv_filter_excludes(pool, key)) {
+		return -1;
+	}
+
+	if (cache != NULL) {
+		ret = fio_kv_cache_get(cache, pool->id, key->bytes, key->length,
+				value->data, value->info->value_len, value->info, &epoch);
+		if (ret >= 0) {
+			return ret;
+		}
+	}
+
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		ret = _fio_kv_pack_get(pool, key, value->data, capacity, value->info);
+	} else {
+		ret = nvm_kv_get(pool->store->kv, pool->id,
+				key->bytes, key->length,
+				value->data, value->info->value_len, false,
+				value->info);
+		ret = _fio_kv_inflate(pool, key->bytes, key->length,
+				value->data, ret, capacity, value->info);
+	}
+
+	// Only complete values go into the cache.
+	if (cache != NULL && ret >= 0 && (uint32_t)ret == value->info->value_len) {
+		fio_kv_cache_fill(cache, pool->id, key->bytes, key->length,
+				value->data, value->info, epoch);
+	}
+
+	return ret;
+}
+
+/**
+ * Retrieve the value associated with a given key in a key/value pool.
+ *
+ * Note that you must provide sector-aligned memory that will can contain the
+ * requested number of bytes. Such memory can be obtained by calling
+ * fio_kv_alloc().
+ *
+ * When the store has a read cache, values found in it are served without a
+ * device read, and values read in full from the device are added to it.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): An allocated value structure to hold the
+ *	  result.
+ * Returns:
+ *	 The number of bytes read, or -1 if the read failed.
+ */
+int fio_kv_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const fio_kv_value_t *value)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_READ, 1);
+	int ret = _fio_kv_get(pool, key, value);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_READ);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_GET, start,
+			ret < 0 ? errno : 0, 0, ret > 0 ? ret : 0);
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_get_alloc().
+ */
+int _fio_kv_get_alloc(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		fio_kv_value_t *value, uint32_t *capacity)
+{
+	assert(pool != NULL);
+	assert(value != NULL);
+	assert(value->info != NULL);
+
+	uint32_t size = pool->size_hint;
+	int ret;
+
+	while (true) {
+		value->data = fio_kv_alloc(size);
+		if (value->data == NULL) {
+			return -1;
+		}
+
+		memset(value->info, 0, sizeof(nvm_kv_key_info_t));
+		value->info->value_len = size;
+		ret = _fio_kv_get(pool, key, value);
+		if (ret < 0) {
+			fio_kv_free_value(value);
+			return -1;
+		}
+
+		// The info structure reports the full length of the value; if it
+		// didn't fit, grow the buffer and read it again.
+		if (value->info->value_len <= size || size >= NVM_KV_MAX_VALUE_SIZE) {
+			break;
+		}
+
+		fio_kv_free_value(value);
+		size = _fio_kv_sector_round(value->info->value_len);
+		if (size > NVM_KV_MAX_VALUE_SIZE) {
+			size = NVM_KV_MAX_VALUE_SIZE;
+		}
+	}
+
+	pool->size_hint = _fio_kv_sector_round(ret > 0 ? ret : 1);
+	value->info->value_len = ret;
+	if (capacity != NULL) {
+		*capacity = size;
+	}
+
+	return ret;
+}
+
+/**
+ * Retrieve a value into newly allocated memory.
+ *
+ * The value is read into sector-aligned memory sized from the pool's size
+ * hint, so that a single device read is needed when the value fits. Larger
+ * values are read again into memory grown to fit. The pool's size hint is
+ * then updated to the sector-rounded length of the value. Concurrent
+ * updates of the hint may race, which only affects the sizing of the
+ * following reads.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): A value structure whose info member points to
+ *	  an allocated nvm_kv_key_info_t structure. Upon success, its data member
+ *	  points to memory that must be released with fio_kv_free_value().
+ *	capacity (uint32_t *): Optional pointer to receive the size of the
+ *	  allocated memory.
+ * Returns:
+ *	Returns the number of bytes read, or -1 if an error occurred.
+ */
+int fio_kv_get_alloc(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		fio_kv_value_t *value, uint32_t *capacity)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_READ, 1);
+	int ret = _fio_kv_get_alloc(pool, key, value, capacity);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_READ);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_GET, start,
+			ret < 0 ? errno : 0, 0, ret > 0 ? ret : 0);
+	return ret;
+}
+
+/**
+ * Write a key/value pair, with the generation count of its info structure.
+ *
+ * Concurrent writes are combined by group commit, when enabled, unless
+ * grouped is false.
+ */
+int _fio_kv_write(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const fio_kv_value_t *value, const bool grouped)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(key != NULL);
+	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
+	assert(key->bytes != NULL);
+	assert(value != NULL);
+	assert(value->data != NULL);
+	assert(value->info != NULL);
+	assert(value->info->value_len <= NVM_KV_MAX_VALUE_SIZE);
+
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		_fio_kv_filter_add(pool, key->bytes, key->length);
+		bool packed = _fio_kv_pack_update(pool, key, value);
+		if (pool->store->cache != NULL) {
+			fio_kv_cache_invalidate(pool->store->cache, pool->id,
+					key->bytes, key->length);
+		}
+
+		return packed ? (int)value->info->value_len : -1;
+	}
+
+	uint32_t length = value->info->value_len;
+	void *encoded = _fio_kv_deflate(pool, value->data, &length);
+	void *data = encoded != NULL ? encoded : value->data;
+
+	_fio_kv_filter_add(pool, key->bytes, key->length);
+	int ret = grouped && pool->store->group != NULL
+		? fio_kv_group_put(pool->store->group, pool->id,
+				key->bytes, key->length,
+				data, length, value->info->expiry,
+				value->info->gen_count)
+		: nvm_kv_put(pool->store->kv, pool->id,
+				key->bytes, key->length,
+				data, length, value->info->expiry, true,
+				value->info->gen_count);
+
+	if (encoded != NULL) {
+		fio_kv_slab_free(encoded);
+		ret = ret >= 0 ? (int)value->info->value_len : ret;
+	}
+
+	if (pool->store->cache != NULL) {
+		fio_kv_cache_invalidate(pool->store->cache, pool->id,
+				key->bytes, key->length);
+	}
+
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_put().
+ */
+int _fio_kv_put(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const fio_kv_value_t *value)
+{
+	return _fio_kv_write(pool, key, value, true);
+}
+
+/**
+ * Insert (or replace) a key/value pair into a pool.
+ *
+ * Note that the value's data must be sector-aligned memory, which can be
+ * obtained from the fio_kv_alloc() function. When the store has group commit
+ * enabled, the pair is written in a batch with concurrent puts to the same
+ * pool.
+ *
+ * Args:
+ *	 pool (fio_kv_pool_t *): The key/value pool.
+ *	 key (fio_kv_key_t): The key.
+ *	 value (fio_kv_value_t): The value.
+ * Returns:
+ *	 The number of bytes written, or -1 in case of an error.
+ */
+int fio_kv_put(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const fio_kv_value_t *value)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	int ret = _fio_kv_put(pool, key, value);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_PUT, start,
+			ret < 0 ? errno : 0, ret > 0 ? ret : 0, 0);
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_exists().
+ */
+bool _fio_kv_exists(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		nvm_kv_key_info_t *info)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(key != NULL);
+	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
+	assert(key->bytes != NULL);
+
+	// TODO(mpetazzoni): remove once nvm_kv_exists() no longer segfaults when
+	// passed a NULL nvm_kv_key_info_t parameter.
+	nvm_kv_key_info_t _info;
+	if (info == NULL) {
+		info = &_info;
+	}
+
+	if (_fio_kv_filter_excludes(pool, key)) {
+		return false;
+	}
+
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		return _fio_kv_pack_get(pool, key, NULL, 0, info) >= 0;
+	}
+
+	return nvm_kv_exists(pool->store->kv, pool->id,
+			key->bytes, key->length, info) == 1;
+}
+
+/**
+ * Tell whether a specific key exists in a key/value pool.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key of the mapping to check the existence of.
+ *	info (nvm_kv_key_info_t *): An optional pointer to a nvm_kv_key_info_t
+ *	  structure to fill with key/value pair information if it exists in the
+ *	  key/value pool.
+ * Returns:
+ *	Returns true if a mapping for the given key exists in the key/value pool,
+ *		false if it doesn't or if an error occured.
+ */
+bool fio_kv_exists(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		nvm_kv_key_info_t *info)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_READ, 1);
+	bool ret = _fio_kv_exists(pool, key, info);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_READ);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_EXISTS, start, 0,
+			0, 0);
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_delete().
+ */
+bool _fio_kv_delete(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(key != NULL);
+	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
+	assert(key->bytes != NULL);
+
+	int ret = _fio_kv_pack_buckets(pool) != 0
+		? (_fio_kv_pack_update(pool, key, NULL) ? 0 : -1)
+		: nvm_kv_delete(pool->store->kv, pool->id,
+				key->bytes, key->length);
+
+	if (pool->store->cache != NULL) {
+		fio_kv_cache_invalidate(pool->store->cache, pool->id,
+				key->bytes, key->length);
+	}
+
+	return ret == 0;
+}
+
+/**
+ * Removes a key/value pair from a pool.
+ *
+ * Args:
+ *	 pool (fio_kv_pool_t *): The key/value pool.
+ *	 key (fio_kv_key_t *): The key to the mapping to remove.
+ * Returns:
+ *	 Returns true if the mapping was successfuly removed, false otherwise.
+ */
+bool fio_kv_delete(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	bool ret = _fio_kv_delete(pool, key);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_DELETE, start,
+			ret ? 0 : errno, 0, 0);
+	return ret;
+}
+
+/**
+ * Return the lock serializing the conditional and read-modify-write
+ * operations on a key.
+ */
+pthread_mutex_t *_fio_kv_atomic_lock(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key)
+{
+	uint32_t hash = fio_kv_pack_hash(key->bytes, key->length);
+	return &pool->store->locks[(hash + pool->id) % FIO_KV_ATOMIC_LOCKS];
+}
+
+/**
+ * Write the new value of a key from a conditional or read-modify-write
+ * operation, with the generation count following its current one.
+ *
+ * Group commit is bypassed, so that the key's lock isn't held while waiting
+ * for other puts to join a batch.
+ */
+int _fio_kv_atomic_write(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *data, const uint32_t length, const uint32_t expiry,
+		const nvm_kv_key_info_t *current)
+{
+	nvm_kv_key_info_t info;
+	fio_kv_value_t value;
+
+	memset(&info, 0, sizeof(info));
+	info.key_len = key->length;
+	info.value_len = length;
+	info.expiry = expiry;
+	info.gen_count = current != NULL ? current->gen_count + 1 : 0;
+	value.data = data;
+	value.info = &info;
+	return _fio_kv_write(pool, key, &value, false);
+}
+
+/**
+ * Replace a key/value pair only if its generation count matches.
+ *
+ * The generation count of the pair is checked and the pair replaced
+ * atomically with respect to the other conditional and read-modify-write
+ * operations of this process on the store, which are serialized per key by a
+ * set of locks. Plain puts are not: mixing them with conditional operations
+ * on the same keys can lose updates. The new pair is written with the next
+ * generation count. This is not available for packed pools, whose pairs have
+ * no generation count.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): The new value.
+ *	gen_count (uint32_t): The expected generation count of the pair.
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error, with
+ *	  errno set to ECANCELED if the pair doesn't exist or has a different
+ *	  generation count, or to EOPNOTSUPP for packed pools.
+ */
+int fio_kv_compare_and_put(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const fio_kv_value_t *value,
+		const uint32_t gen_count)
+{
+	assert(value != NULL);
+	assert(value->info != NULL);
+
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	nvm_kv_key_info_t current;
+	int ret = -1;
+
+	pthread_mutex_t *lock = _fio_kv_atomic_lock(pool, key);
+	pthread_mutex_lock(lock);
+	if (!_fio_kv_exists(pool, key, &current) ||
+			current.gen_count != gen_count) {
+		errno = ECANCELED;
+	} else {
+		ret = _fio_kv_atomic_write(pool, key, value->data,
+				value->info->value_len, value->info->expiry, &current);
+	}
+	pthread_mutex_unlock(lock);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_PUT, start,
+			ret < 0 ? errno : 0, ret > 0 ? ret : 0, 0);
+	return ret;
+}
+
+/**
+ * Insert a key/value pair only if the key doesn't exist yet.
+ *
+ * The existence check and the insertion are atomic with respect to the
+ * other conditional and read-modify-write operations of this process on the
+ * store (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): The value.
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error, with
+ *	  errno set to EEXIST if the key already exists.
+ */
+int fio_kv_put_if_absent(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const fio_kv_value_t *value)
+{
+	assert(value != NULL);
+	assert(value->info != NULL);
+
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	int ret = -1;
+
+	pthread_mutex_t *lock = _fio_kv_atomic_lock(pool, key);
+	pthread_mutex_lock(lock);
+	if (_fio_kv_exists(pool, key, NULL)) {
+		errno = EEXIST;
+	} else {
+		ret = _fio_kv_atomic_write(pool, key, value->data,
+				value->info->value_len, value->info->expiry, NULL);
+	}
+	pthread_mutex_unlock(lock);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_PUT, start,
+			ret < 0 ? errno : 0, ret > 0 ? ret : 0, 0);
+	return ret;
+}
+
+/**
+ * Read the current value of a key for a read-modify-write operation, into
+ * memory allocated to hold it and extra more bytes, to be released with
+ * fio_kv_slab_free().
+ *
+ * Returns the length of the value, 0 with a NULL data pointer if the key
+ * doesn't exist, or -1 if an error occurred.
+ */
+int _fio_kv_atomic_read(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const uint32_t extra, void **data, nvm_kv_key_info_t *info)
+{
+	fio_kv_value_t value;
+	uint32_t capacity;
+
+	*data = NULL;
+	if (!_fio_kv_exists(pool, key, info)) {
+		return 0;
+	}
+
+	value.info = info;
+	int ret = _fio_kv_get_alloc(pool, key, &value, &capacity);
+	if (ret < 0) {
+		return -1;
+	}
+
+	if (ret + extra > NVM_KV_MAX_VALUE_SIZE) {
+		fio_kv_free_value(&value);
+		errno = EINVAL;
+		return -1;
+	}
+
+	*data = value.data;
+	if (capacity < ret + extra) {
+		*data = fio_kv_alloc(ret + extra);
+		if (*data != NULL) {
+			memcpy(*data, value.data, ret);
+		}
+
+		fio_kv_free_value(&value);
+		if (*data == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Atomically add to the 64-bit counter stored as the value of a key.
+ *
+ * Counters are stored as 8-byte values in native byte order. A missing key
+ * is a counter of 0. The update is atomic with respect to the other
+ * conditional and read-modify-write operations of this process on the store
+ * (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	delta (int64_t): The value to add to the counter.
+ *	expiry (uint32_t): The expiry of the updated pair.
+ *	result (int64_t *): Optional pointer to receive the counter's new value.
+ * Returns:
+ *	Returns true if the counter was updated, false otherwise, with errno set
+ *	  to EINVAL if the key's value is not a counter.
+ */
+bool fio_kv_increment(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const int64_t delta, const uint32_t expiry, int64_t *result)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	nvm_kv_key_info_t current;
+	int64_t counter = 0;
+	void *data = NULL;
+	int ret = -1;
+
+	pthread_mutex_t *lock = _fio_kv_atomic_lock(pool, key);
+	pthread_mutex_lock(lock);
+	int length = _fio_kv_atomic_read(pool, key, 0, &data, &current);
+	if (length >= 0 && data != NULL && length != sizeof(int64_t)) {
+		errno = EINVAL;
+	} else if (length >= 0 && data == NULL &&
+			(data = fio_kv_alloc(sizeof(int64_t))) == NULL) {
+		errno = ENOMEM;
+	} else if (length >= 0) {
+		if (length > 0) {
+			memcpy(&counter, data, sizeof(int64_t));
+		}
+
+		counter += delta;
+		memcpy(data, &counter, sizeof(int64_t));
+		ret = _fio_kv_atomic_write(pool, key, data, sizeof(int64_t), expiry,
+				length > 0 ? &current : NULL);
+	}
+	pthread_mutex_unlock(lock);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+
+	if (data != NULL) {
+		fio_kv_slab_free(data);
+	}
+
+	if (ret >= 0 && result != NULL) {
+		*result = counter;
+	}
+
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_PUT, start,
+			ret < 0 ? errno : 0, ret > 0 ? ret : 0, 0);
+	return ret >= 0;
+}
+
+/**
+ * Atomically append data to the value of a key.
+ *
+ * A missing key is created with the given data as its value. The update is
+ * atomic with respect to the other conditional and read-modify-write
+ * operations of this process on the store (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	data (void *): The data to append.
+ *	length (uint32_t): The length of the data.
+ *	expiry (uint32_t): The expiry of the updated pair.
+ * Returns:
+ *	Returns the new length of the value, or -1 in case of an error, with
+ *	  errno set to EINVAL if it would exceed the maximum value size.
+ */
+int fio_kv_append(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const void *data, const uint32_t length, const uint32_t expiry)
+{
+	assert(data != NULL);
+
+	if (length > NVM_KV_MAX_VALUE_SIZE) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_WRITE, 1);
+	nvm_kv_key_info_t current;
+	void *value = NULL;
+	int ret = -1;
+
+	pthread_mutex_t *lock = _fio_kv_atomic_lock(pool, key);
+	pthread_mutex_lock(lock);
+	int read = _fio_kv_atomic_read(pool, key, length, &value, &current);
+	bool existed = value != NULL;
+	if (read >= 0 && !existed && (value = fio_kv_alloc(length)) == NULL) {
+		errno = ENOMEM;
+	} else if (read >= 0) {
+		memcpy((char *)value + read, data, length);
+		ret = _fio_kv_atomic_write(pool, key, value, read + length, expiry,
+				existed ? &current : NULL);
+	}
+	pthread_mutex_unlock(lock);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_WRITE);
+
+	if (value != NULL) {
+		fio_kv_slab_free(value);
+	}
+
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_PUT, start,
+			ret < 0 ? errno : 0, ret > 0 ? ret : 0, 0);
+	return ret;
+}
+
+/**
+ * Removes all key/value pairs from all pools.
+ *
+ * All key/value pairs from all pools, including the default pools, are
+ * removed. Pools are not deleted (use fio_kv_delete_pool() or
+ * fio_kv_delete_all_pools() for that).
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ * Returns:
+ *	Returns true if the operation was successful, false otherwise.
+ */
+bool fio_kv_delete_all(const fio_kv_store_t *store)
+{
+	assert(store != NULL);
+	assert(store->kv > 0);
+
+	fio_kv_sched_enter(store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	int ret = nvm_kv_delete_all(store->kv);
+	fio_kv_sched_exit(store->sched, FIO_KV_SCHED_BACKGROUND);
+
+	if (store->cache != NULL) {
+		fio_kv_cache_invalidate_pool(store->cache, -1);
+	}
+
+	return ret == 0;
+}
+
+/**
+ * Prepare a nvm_kv_iovec_t structure array for batch operations.
+ *
+ * Args:
+ *	keys (fio_kv_key_t **): An array of pointer to keys.
+ *	values (fio_kv_value_t **): An array of pointer to the corresponding
+ *	  values (optional).
+ *	count (size_t): The number of elements.
+ *	v (nvm_kv_iovec_t *): An array of at least count nvm_kv_iovec_t
+ *	  structures to populate.
+ */
+void _fio_kv_prepare_batch(const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count,
+		nvm_kv_iovec_t *v)
+{
+	assert(keys != NULL);
+	assert(count > 0);
+	assert(v != NULL);
+
+	memset(v, 0, count * sizeof(nvm_kv_iovec_t));
+	for (size_t i=0; i<count; i++) {
+		assert(keys[i] != NULL);
+		assert(keys[i]->length >= 1 && keys[i]->length <= NVM_KV_MAX_KEY_SIZE);
+		assert(keys[i]->bytes != NULL);
+
+		v[i].key = keys[i]->bytes;
+		v[i].key_len = keys[i]->length;
+
+		if (values != NULL) {
+			assert(values[i] != NULL);
+			assert(values[i]->data != NULL);
+			assert(values[i]->info != NULL);
+
+			v[i].value = values[i]->data;
+			v[i].value_len = values[i]->info->value_len;
+			v[i].expiry = values[i]->info->expiry;
+			v[i].gen_count = values[i]->info->gen_count;
+			v[i].replace = 1;
+		}
+	}
+}
+
+/**
+ * Invalidate the read cache entries of the keys of a batch.
+ */
+void _fio_kv_cache_invalidate_batch(const fio_kv_pool_t *pool,
+		const nvm_kv_iovec_t *v, const size_t count)
+{
+	if (pool->store->cache == NULL) {
+		return;
+	}
+
+	for (size_t i=0; i<count; i++) {
+		fio_kv_cache_invalidate(pool->store->cache, pool->id,
+				v[i].key, v[i].key_len);
+	}
+}
+
+/**
+ * Returns the I/O class of a batch write of the given number of pairs.
+ *
+ * Batches that don't fit in a single device batch are bulk loads, scheduled
+ * as background work.
+ */
+fio_kv_sched_class_t _fio_kv_batch_class(const size_t count)
+{
+	return count > FIO_KV_MAX_BATCH_SIZE
+		? FIO_KV_SCHED_BACKGROUND
+		: FIO_KV_SCHED_WRITE;
+}
+
+/**
+ * Batch operations supported by _fio_kv_batch().
+ */
+typedef enum {
+	FIO_KV_BATCH_PUT,
+	FIO_KV_BATCH_GET,
+	FIO_KV_BATCH_PREFETCH
+} _fio_kv_batch_op_t;
+
+/**
+ * Run a batch operation of arbitrary size.
+ *
+ * The batch is split into chunks of at most FIO_KV_MAX_BATCH_SIZE pairs,
+ * which are submitted to the device one after the other through a single
+ * nvm_kv_iovec_t scratch array. Processing stops at the first chunk that
+ * fails.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values.
+ *	count (size_t): The number of key/value pairs.
+ *	op (_fio_kv_batch_op_t): The batch operation. For reads, the info
+ *	  structure of each value is updated from the device's results.
+ *	  Prefetches are reads scheduled as background work, whose values are
+ *	  added to the read cache when they were read in full.
+ * Returns:
+ *	Returns the number of key/value pairs successfully processed, which is
+ *	  count if all chunks succeeded. Otherwise, the failed chunk starts at
+ *	  the returned position.
+ */
+size_t _fio_kv_batch(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count,
+		const _fio_kv_batch_op_t op)
+{
+	nvm_kv_iovec_t v[FIO_KV_MAX_BATCH_SIZE];
+	void *encoded[FIO_KV_MAX_BATCH_SIZE];
+	uint64_t epochs[FIO_KV_MAX_BATCH_SIZE];
+	bool cached[FIO_KV_MAX_BATCH_SIZE];
+	size_t done = 0;
+
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(keys != NULL);
+	assert(values != NULL);
+
+	fio_kv_cache_t *cache = pool->store->cache;
+	fio_kv_sched_t *sched = pool->store->sched;
+	bool reading = op != FIO_KV_BATCH_PUT;
+	fio_kv_sched_class_t cls = op == FIO_KV_BATCH_GET
+		? FIO_KV_SCHED_READ
+		: op == FIO_KV_BATCH_PREFETCH
+			? FIO_KV_SCHED_BACKGROUND
+			: _fio_kv_batch_class(count);
+
+	// The pairs of packed pools are processed one by one, in their buckets,
+	// and single gets fill the read cache by themselves.
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		for (; done < count; done++) {
+			fio_kv_sched_enter(sched, cls, 1);
+			int ret = reading
+				? _fio_kv_get(pool, keys[done], values[done])
+				: _fio_kv_put(pool, keys[done], values[done]);
+			fio_kv_sched_exit(sched, cls);
+			if (ret < 0) {
+				break;
+			}
+
+			if (reading) {
+				values[done]->info->value_len = ret;
+			}
+		}
+
+		return done;
+	}
+
+	while (done < count) {
+		size_t chunk = count - done;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		_fio_kv_prepare_batch(keys + done, values + done, chunk, v);
+		for (size_t i=0; op == FIO_KV_BATCH_PUT && i<chunk; i++) {
+			_fio_kv_filter_add(pool, v[i].key, v[i].key_len);
+		}
+
+		if (op == FIO_KV_BATCH_PUT) {
+			_fio_kv_deflate_batch(pool, v, chunk, encoded);
+		}
+
+		for (size_t i=0; op == FIO_KV_BATCH_PREFETCH && i<chunk; i++) {
+			cached[i] = fio_kv_cache_contains(cache, pool->id, v[i].key,
+					v[i].key_len, &epochs[i]);
+		}
+
+		fio_kv_sched_enter(sched, cls, chunk);
+		int ret = reading
+			? nvm_kv_batch_get(pool->store->kv, pool->id, v, chunk)
+			: nvm_kv_batch_put(pool->store->kv, pool->id, v, chunk);
+		fio_kv_sched_exit(sched, cls);
+
+		// A failed chunk may still have been partly written.
+		if (op == FIO_KV_BATCH_PUT) {
+			_fio_kv_release_batch(encoded, chunk);
+			_fio_kv_cache_invalidate_batch(pool, v, chunk);
+		}
+
+		if (ret != 0) {
+			break;
+		}
+
+		for (size_t i=0; reading && i<chunk; i++) {
+			nvm_kv_key_info_t *info = values[done+i]->info;
+			uint32_t capacity = info->value_len;
+			info->pool_id = pool->id;
+			info->key_len = v[i].key_len;
+			info->value_len = v[i].value_len;
+			info->expiry = v[i].expiry;
+			info->gen_count = v[i].gen_count;
+
+			int read = _fio_kv_inflate(pool, v[i].key, v[i].key_len,
+					v[i].value, (int)v[i].value_len, capacity, info);
+			if (read < 0) {
+				return done;
+			}
+			info->value_len = (uint32_t)read;
+
+			// The device doesn't report the full length of the values of a
+			// batch: only values shorter than their buffer are known to be
+			// complete.
+			if (op == FIO_KV_BATCH_PREFETCH && !cached[i] &&
+					(uint32_t)read < capacity) {
+				fio_kv_cache_fill(cache, pool->id, v[i].key, v[i].key_len,
+						values[done+i]->data, info, epochs[i]);
+			}
+		}
+
+		done += chunk;
+	}
+
+	return done;
+}
+
+/**
+ * Returns the number of value bytes of the given key/value pairs.
+ *
+ * Args:
+ *	values (fio_kv_value_t **): An array of pointers to the values.
+ *	count (size_t): The number of values.
+ */
+uint64_t _fio_kv_batch_bytes(const fio_kv_value_t **values,
+		const size_t count)
+{
+	uint64_t bytes = 0;
+	for (size_t i=0; i<count; i++) {
+		bytes += values[i]->info->value_len;
+	}
+	return bytes;
+}
+
+/**
+ * Insert (or replace) a set of key/value pairs in one batch operation.
+ *
+ * Batches larger than FIO_KV_MAX_BATCH_SIZE pairs are transparently split
+ * into device-sized chunks, like with fio_kv_batch_put_count().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to insert.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values.
+ *	count (size_t): The number of key/value pairs.
+ * Returns:
+ *	Returns true if the batch insertion was successful, false otherwise.
+ */
+bool fio_kv_batch_put(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count)
+{
+	return fio_kv_batch_put_count(pool, keys, values, count) == count;
+}
+
+/**
+ * Insert (or replace) a set of key/value pairs in one batch operation, and
+ * report how many of them were written.
+ *
+ * Batches larger than FIO_KV_MAX_BATCH_SIZE pairs are transparently split
+ * into device-sized chunks. If a chunk fails, the pairs of the previous
+ * chunks have been written but none of the following ones are.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to insert.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values.
+ *	count (size_t): The number of key/value pairs.
+ * Returns:
+ *	Returns the number of key/value pairs written, which is count on
+ *	  success. Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_put_count(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count)
+{
+	uint64_t start = fio_kv_stats_clock();
+	size_t done = _fio_kv_batch(pool, keys, values, count,
+			FIO_KV_BATCH_PUT);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_BATCH_PUT, start,
+			done < count ? errno : 0, _fio_kv_batch_bytes(values, done), 0);
+	return done;
+}
+
+/**
+ * Retrieve a set of values in one batch operation.
+ *
+ * The values are read like with fio_kv_batch_get_count().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to retrieve.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the results.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns true if all the values were read, false otherwise.
+ */
+bool fio_kv_batch_get(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count)
+{
+	return fio_kv_batch_get_count(pool, keys, values, count) == count;
+}
+
+/**
+ * Retrieve a set of values in one batch operation, and report how many of
+ * them were read.
+ *
+ * Each value structure must point to sector-aligned memory large enough to
+ * hold the value_len bytes advertised by its info structure, which can be
+ * obtained with fio_kv_alloc(). Upon success, the info structure of each
+ * value is filled in with the metadata of the corresponding key/value pair,
+ * its value_len field holding the number of bytes read. Batches larger than
+ * FIO_KV_MAX_BATCH_SIZE pairs are transparently split into device-sized
+ * chunks.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to retrieve.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the results.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of values read, which is count on success.
+ *	  Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_get_count(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count)
+{
+	uint64_t start = fio_kv_stats_clock();
+	size_t done = _fio_kv_batch(pool, keys, values, count,
+			FIO_KV_BATCH_GET);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_BATCH_GET, start,
+			done < count ? errno : 0, 0, _fio_kv_batch_bytes(values, done));
+	return done;
+}
+
+/**
+ * Read a set of values into the read cache of a store in one batch
+ * operation.
+ *
+ * The values are read like with fio_kv_batch_get(), but as background work,
+ * and those read in full, that is shorter than their buffer, are added to
+ * the store's read cache unless they already are in it. Prefetches are not
+ * counted in the store's statistics, so that warming the cache up doesn't
+ * skew the latencies of foreground reads.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool, of a store with a read
+ *	  cache.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to prefetch.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the values.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of values read, which is count on success.
+ *	  Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_prefetch(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->cache != NULL);
+
+	return _fio_kv_batch(pool, keys, values, count, FIO_KV_BATCH_PREFETCH);
+}
+
+/**
+ * Run a key-only batch operation of arbitrary size.
+ *
+ * The keys are prepared in chunks of at most FIO_KV_MAX_BATCH_SIZE through a
+ * single nvm_kv_iovec_t scratch array, like for _fio_kv_batch(), and each
+ * key of a chunk is then processed on its own.
+ *
+ * Returns the number of keys processed for removals, or the number of keys
+ * that exist for existence checks.
+ */
+size_t _fio_kv_batch_keys(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const size_t count, uint8_t *bitmap)
+{
+	nvm_kv_iovec_t v[FIO_KV_MAX_BATCH_SIZE];
+	size_t done = 0;
+	size_t found = 0;
+
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(keys != NULL);
+
+	bool packed = _fio_kv_pack_buckets(pool) != 0;
+	fio_kv_sched_t *sched = pool->store->sched;
+	fio_kv_sched_class_t cls = bitmap != NULL
+		? FIO_KV_SCHED_READ
+		: _fio_kv_batch_class(count);
+	if (bitmap != NULL) {
+		memset(bitmap, 0, (count + 7) / 8);
+	}
+
+	while (done < count) {
+		size_t chunk = count - done;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		_fio_kv_prepare_batch(keys + done, NULL, chunk, v);
+		fio_kv_sched_enter(sched, cls, chunk);
+		for (size_t i=0; i<chunk; i++) {
+			if (bitmap != NULL) {
+				if (_fio_kv_exists(pool, keys[done+i], NULL)) {
+					bitmap[(done+i) / 8] |= (uint8_t)(1 << ((done+i) % 8));
+					found++;
+				}
+				continue;
+			}
+
+			errno = 0;
+			int ret = packed
+				? (_fio_kv_pack_update(pool, keys[done+i], NULL) ? 0 : -1)
+				: nvm_kv_delete(pool->store->kv, pool->id,
+						v[i].key, v[i].key_len);
+			if (ret != 0 && errno != ENOENT) {
+				fio_kv_sched_exit(sched, cls);
+				_fio_kv_cache_invalidate_batch(pool, v, i + 1);
+				return done + i;
+			}
+		}
+
+		fio_kv_sched_exit(sched, cls);
+		if (bitmap == NULL) {
+			_fio_kv_cache_invalidate_batch(pool, v, chunk);
+		}
+
+		done += chunk;
+	}
+
+	return bitmap != NULL ? found : done;
+}
+
+/**
+ * Remove a set of key/value pairs in one call.
+ *
+ * The keys are processed in chunks of FIO_KV_MAX_BATCH_SIZE, prepared as for
+ * the other batch operations. directKV has no batch removal, so each key is
+ * then removed from the device on its own. Keys that don't exist are not
+ * errors. Processing stops at the first key that fails to be removed.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to remove.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of keys processed, which is count on success.
+ *	  Otherwise, the key at the returned position failed to be removed.
+ */
+size_t fio_kv_batch_delete(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const size_t count)
+{
+	uint64_t start = fio_kv_stats_clock();
+	size_t done = _fio_kv_batch_keys(pool, keys, count, NULL);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_BATCH_DELETE, start,
+			done < count ? errno : 0, 0, 0);
+	return done;
+}
+
+/**
+ * Tell which keys of a set exist in a pool, in one call.
+ *
+ * The keys are processed in chunks of FIO_KV_MAX_BATCH_SIZE, prepared as for
+ * the other batch operations; keys excluded by the pool's Bloom filter are
+ * answered without any device I/O, the others with one existence check each
+ * as directKV has no batch existence check.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to check.
+ *	count (size_t): The number of keys.
+ *	bitmap (uint8_t *): An array of at least (count + 7) / 8 bytes, in which
+ *	  bit i % 8 of byte i / 8 is set if the i-th key exists, and cleared
+ *	  otherwise.
+ * Returns:
+ *	Returns the number of keys that exist.
+ */
+size_t fio_kv_batch_exists(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const size_t count, uint8_t *bitmap)
+{
+	assert(bitmap != NULL);
+
+	uint64_t start = fio_kv_stats_clock();
+	size_t found = _fio_kv_batch_keys(pool, keys, count, bitmap);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_BATCH_EXISTS, start,
+			0, 0, 0);
+	return found;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_batch_put_packed().
+ */
+size_t _fio_kv_batch_put_packed(const fio_kv_pool_t *pool, void *buffer,
+		const uint32_t size, const uint32_t count)
+{
+	nvm_kv_iovec_t v[FIO_KV_MAX_BATCH_SIZE];
+	void *encoded[FIO_KV_MAX_BATCH_SIZE];
+	const fio_kv_packed_t *entries = (const fio_kv_packed_t *)buffer;
+	char *base = (char *)buffer;
+	size_t done = 0;
+
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(buffer != NULL);
+	assert((uintptr_t)buffer % FIO_SECTOR_ALIGNMENT == 0);
+
+	if ((uint64_t)count * sizeof(fio_kv_packed_t) > size) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	for (uint32_t i=0; i<count; i++) {
+		const fio_kv_packed_t *e = &entries[i];
+		if (e->key_len < 1 || e->key_len > NVM_KV_MAX_KEY_SIZE ||
+				(uint64_t)e->key_offset + e->key_len > size ||
+				(uint64_t)e->value_offset + e->value_len > size ||
+				e->value_offset % FIO_SECTOR_ALIGNMENT != 0) {
+			errno = EINVAL;
+			return 0;
+		}
+	}
+
+	fio_kv_sched_class_t cls = _fio_kv_batch_class(count);
+
+	// The pairs of packed pools are written one by one, in their buckets.
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		for (; done < count; done++) {
+			const fio_kv_packed_t *e = &entries[done];
+			nvm_kv_key_info_t info;
+			fio_kv_key_t key;
+			fio_kv_value_t value;
+
+			memset(&info, 0, sizeof(nvm_kv_key_info_t));
+			info.value_len = e->value_len;
+			info.expiry = e->expiry;
+			info.gen_count = e->gen_count;
+			key.length = e->key_len;
+			key.bytes = (nvm_kv_key_t *)(base + e->key_offset);
+			value.data = base + e->value_offset;
+			value.info = &info;
+			fio_kv_sched_enter(pool->store->sched, cls, 1);
+			int ret = _fio_kv_put(pool, &key, &value);
+			fio_kv_sched_exit(pool->store->sched, cls);
+			if (ret < 0) {
+				break;
+			}
+		}
+
+		return done;
+	}
+
+	while (done < count) {
+		size_t chunk = count - done;
+		if (chunk > FIO_KV_MAX_BATCH_SIZE) {
+			chunk = FIO_KV_MAX_BATCH_SIZE;
+		}
+
+		memset(v, 0, chunk * sizeof(nvm_kv_iovec_t));
+		for (size_t i=0; i<chunk; i++) {
+			const fio_kv_packed_t *e = &entries[done+i];
+			v[i].key = (nvm_kv_key_t *)(base + e->key_offset);
+			v[i].key_len = e->key_len;
+			v[i].value = base + e->value_offset;
+			v[i].value_len = e->value_len;
+			v[i].expiry = e->expiry;
+			v[i].gen_count = e->gen_count;
+			v[i].replace = 1;
+			_fio_kv_filter_add(pool, v[i].key, v[i].key_len);
+		}
+
+		_fio_kv_deflate_batch(pool, v, chunk, encoded);
+		fio_kv_sched_enter(pool->store->sched, cls, chunk);
+		int ret = nvm_kv_batch_put(pool->store->kv, pool->id, v, chunk);
+		fio_kv_sched_exit(pool->store->sched, cls);
+		_fio_kv_release_batch(encoded, chunk);
+		_fio_kv_cache_invalidate_batch(pool, v, chunk);
+		if (ret != 0) {
+			break;
+		}
+
+		done += chunk;
+	}
+
+	return done;
+}
+
+/**
+ * Insert (or replace) a set of key/value pairs packed in a single buffer.
+ *
+ * The buffer starts with a table of count fio_kv_packed_t entries, each
+ * giving the position of a key and its value within the buffer, along with
+ * the pair's expiry and generation count. Value offsets must be multiples of
+ * the sector size. The nvm_kv_iovec_t arrays are built straight from this
+ * table, in chunks of FIO_KV_MAX_BATCH_SIZE pairs; if a chunk fails, the
+ * pairs of the previous chunks have been written but none of the following
+ * ones are.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	buffer (void *): A sector-aligned buffer holding the packed pairs.
+ *	size (uint32_t): The size of the buffer.
+ *	count (uint32_t): The number of key/value pairs.
+ * Returns:
+ *	Returns the number of key/value pairs written, which is count on
+ *	  success. Otherwise, the failed chunk starts at the returned position.
+ *	  Nothing is written, with errno set to EINVAL, if an entry points
+ *	  outside of the buffer.
+ */
+size_t fio_kv_batch_put_packed(const fio_kv_pool_t *pool, void *buffer,
+		const uint32_t size, const uint32_t count)
+{
+	uint64_t start = fio_kv_stats_clock();
+	size_t done = _fio_kv_batch_put_packed(pool, buffer, size, count);
+
+	uint64_t bytes = 0;
+	for (size_t i=0; i<done; i++) {
+		bytes += ((const fio_kv_packed_t *)buffer)[i].value_len;
+	}
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_BATCH_PUT, start,
+			done < count ? errno : 0, bytes, 0);
+	return done;
 }
 
 /**
- * Insert (or replace) a key/value pair into a pool.
- *
- * Note that the value's data must be sector-aligned memory, which can be
- * obtained from the fio_kv_alloc() function.
+ * Create an iterator on a key/value pool.
  *
  * Args:
- *	 pool (fio_kv_pool_t *): The key/value pool.
- *	 key (fio_kv_key_t): The key.
- *	 value (fio_kv_value_t): The value.
+ *	pool (fio_kv_pool_t *): The key/value pool.
  * Returns:
- *	 The number of bytes written, or -1 in case of an error.
+ *	Returns the new iterator's ID, or -1 if an iterator could not be
+ *	  created, with errno set to EINVAL for packed pools, which can't be
+ *	  iterated over.
  */
-int fio_kv_put(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
-		const fio_kv_value_t *value)
+int fio_kv_iterator(const fio_kv_pool_t *pool)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(key != NULL);
-	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
-	assert(key->bytes != NULL);
-	assert(value != NULL);
-	assert(value->data != NULL);
-	assert(value->info != NULL);
-	assert(value->info->value_len <= NVM_KV_MAX_VALUE_SIZE);
 
-	return nvm_kv_put(pool->store->kv, pool->id,
-			key->bytes, key->length,
-			value->data, value->info->value_len,
-			value->info->expiry, true, 0);
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	int ret = nvm_kv_begin(pool->store->kv, pool->id);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_BACKGROUND);
+	return ret;
 }
 
 /**
- * Tell whether a specific key exists in a key/value pool.
- *
- * Args:
- *	pool (fio_kv_pool_t *): The key/value pool.
- *	key (fio_kv_key_t *): The key of the mapping to check the existence of.
- *	info (nvm_kv_key_info_t *): An optional pointer to a nvm_kv_key_info_t
- *	  structure to fill with key/value pair information if it exists in the
- *	  key/value pool.
- * Returns:
- *	Returns true if a mapping for the given key exists in the key/value pool,
- *		false if it doesn't or if an error occured.
+ * Uninstrumented implementation of fio_kv_next().
  */
-bool fio_kv_exists(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
-		nvm_kv_key_info_t *info)
+bool _fio_kv_next(const fio_kv_pool_t *pool, const int iterator)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(key != NULL);
-	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
-	assert(key->bytes != NULL);
-
-	// TODO(mpetazzoni): remove once nvm_kv_exists() no longer segfaults when
-	// passed a NULL nvm_kv_key_info_t parameter.
-	nvm_kv_key_info_t _info;
-	if (info == NULL) {
-		info = &_info;
-	}
+	assert(iterator >= 0);
 
-	return nvm_kv_exists(pool->store->kv, pool->id,
-			key->bytes, key->length, info) == 1;
+	return nvm_kv_next(pool->store->kv, iterator) == 0;
 }
 
 /**
- * Removes a key/value pair from a pool.
+ * Move an iterator to the following element in a key/value pool.
  *
  * Args:
- *	 pool (fio_kv_pool_t *): The key/value pool.
- *	 key (fio_kv_key_t *): The key to the mapping to remove.
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	iterator (int): The ID of the iterator to advance.
  * Returns:
- *	 Returns true if the mapping was successfuly removed, false otherwise.
+ *	Returns true if the operation was successful, false otherwise.
  */
-bool fio_kv_delete(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+bool fio_kv_next(const fio_kv_pool_t *pool, const int iterator)
+{
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	bool ret = _fio_kv_next(pool, iterator);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_BACKGROUND);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_ITERATE, start, 0,
+			0, 0);
+	return ret;
+}
+
+/**
+ * Uninstrumented implementation of fio_kv_get_current().
+ */
+bool _fio_kv_get_current(const fio_kv_pool_t *pool, const int iterator,
+		fio_kv_key_t *key, const fio_kv_value_t *value)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+	assert(iterator >= 0);
 	assert(key != NULL);
 	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
 	assert(key->bytes != NULL);
+	assert(value != NULL);
+	assert(value->data != NULL);
+	assert(value->info != NULL);
 
-	return nvm_kv_delete(pool->store->kv, pool->id,
-			key->bytes, key->length) == 0;
+	uint32_t capacity = value->info->value_len;
+	int ret = nvm_kv_get_current(pool->store->kv, iterator,
+			key->bytes, &(key->length),
+			value->data, value->info->value_len,
+			value->info);
+	return _fio_kv_inflate(pool, key->bytes, key->length,
+			value->data, ret, capacity, value->info) >= 0;
 }
 
 /**
- * Removes all key/value pairs from all pools.
- *
- * All key/value pairs from all pools, including the default pools, are
- * removed. Pools are not deleted (use fio_kv_delete_pool() or
- * fio_kv_delete_all_pools() for that).
+ * Retrieve the key and value at the current iterator's position.
  *
  * Args:
- *	store (fio_kv_store_t *): The key/value store.
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	iterator (int): The ID of the iterator.
+ *	key (fio_kv_key_t *): An allocated key structure to hold the current
+ *	  key.
+ *	value (fio_kv_value_t *): An allocated value structure to hold the
+ * 	  current value.
  * Returns:
  *	Returns true if the operation was successful, false otherwise.
  */
-bool fio_kv_delete_all(const fio_kv_store_t *store)
+bool fio_kv_get_current(const fio_kv_pool_t *pool, const int iterator,
+		fio_kv_key_t *key, const fio_kv_value_t *value)
 {
-	assert(store != NULL);
-	assert(store->kv > 0);
-
-	return nvm_kv_delete_all(store->kv) == 0;
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_BACKGROUND, 1);
+	bool ret = _fio_kv_get_current(pool, iterator, key, value);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_BACKGROUND);
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_ITERATE, start,
+			ret ? 0 : errno, 0, ret ? value->info->value_len : 0);
+	return ret;
 }
 
 /**
- * Prepare a nvm_kv_iovec_t structure array for batch operations.
- *
- * Args:
- *	keys (fio_kv_key_t **): An array of pointer to keys.
- *	values (fio_kv_value_t **): An array of pointer to the corresponding
- *	  values (optional).
- *	count (size_t): The number of elements.
- * Returns:
- *	Returns an allocated, populated array of count nvm_kv_iovec_t structures
- *	to be used for batch operations.
+ * Uninstrumented implementation of fio_kv_next_batch().
  */
-nvm_kv_iovec_t *_fio_kv_prepare_batch(const fio_kv_key_t **keys,
-		const fio_kv_value_t **values, const size_t count)
+int _fio_kv_next_batch(const fio_kv_pool_t *pool, const int iterator,
+		void *buffer, const uint32_t size, const uint32_t max,
+		const bool keys_only)
 {
-	nvm_kv_iovec_t *v;
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->kv > 0);
+	assert(iterator >= 0);
+	assert(buffer != NULL);
+	assert((uintptr_t)buffer % FIO_SECTOR_ALIGNMENT == 0);
+	assert(size % FIO_SECTOR_ALIGNMENT == 0);
+
+	fio_kv_batch_t *batch = (fio_kv_batch_t *)buffer;
+	uint32_t *offsets = (uint32_t *)(batch + 1);
+	uint32_t offset = _fio_kv_sector_round(sizeof(fio_kv_batch_t) +
+			max * sizeof(uint32_t));
+	if (offset + FIO_SECTOR_ALIGNMENT > size) {
+		return -1;
+	}
 
-	assert(keys != NULL);
-	assert(count > 0);
+	// In keys-only mode, the value of each pair is read into a single
+	// scratch sector, only there to satisfy the directKV API, in front of
+	// the records.
+	void *scratch = NULL;
+	if (keys_only) {
+		scratch = (char *)buffer + offset;
+		offset += FIO_SECTOR_ALIGNMENT;
+	}
 
-	v = (nvm_kv_iovec_t *)calloc(count, sizeof(nvm_kv_iovec_t));
-	for (int i=0; i<count; i++) {
-		assert(keys[i] != NULL);
-		assert(keys[i]->length >= 1 && keys[i]->length <= NVM_KV_MAX_KEY_SIZE);
-		assert(keys[i]->bytes != NULL);
+	batch->count = 0;
+	batch->ended = 0;
 
-		v[i].key = keys[i]->bytes;
-		v[i].key_len = keys[i]->length;
+	while (batch->count < max) {
+		uint32_t key_offset = offset + sizeof(fio_kv_record_t);
+		uint32_t value_offset = keys_only ? 0 : offset + FIO_SECTOR_ALIGNMENT;
+		if ((keys_only && key_offset + NVM_KV_MAX_KEY_SIZE > size) ||
+				(!keys_only && value_offset >= size)) {
+			break;
+		}
 
-		if (values != NULL) {
-			assert(values[i] != NULL);
-			assert(values[i]->data != NULL);
-			assert(values[i]->info != NULL);
+		fio_kv_record_t *record = (fio_kv_record_t *)((char *)buffer + offset);
+		uint32_t room = keys_only ? FIO_SECTOR_ALIGNMENT : size - value_offset;
+		uint32_t key_len = NVM_KV_MAX_KEY_SIZE;
+		nvm_kv_key_info_t info;
+
+		memset(&info, 0, sizeof(nvm_kv_key_info_t));
+		int ret = nvm_kv_get_current(pool->store->kv, iterator,
+				(nvm_kv_key_t *)(record + 1), &key_len,
+				keys_only ? scratch : (char *)buffer + value_offset,
+				room, &info);
+
+		// Compressed values are reported with their original length.
+		if (keys_only && ret >= 0 && _fio_kv_codec(pool) != FIO_KV_CODEC_NONE) {
+			const fio_kv_codec_header_t *header =
+				fio_kv_codec_header(scratch, ret, info.value_len);
+			info.value_len = header != NULL ? header->length : info.value_len;
+		} else if (!keys_only) {
+			ret = _fio_kv_inflate(pool, (nvm_kv_key_t *)(record + 1),
+					key_len, (char *)buffer + value_offset, ret, room, &info);
+		}
 
-			v[i].value = values[i]->data;
-			v[i].value_len = values[i]->info->value_len;
-			v[i].expiry = values[i]->info->expiry;
-			v[i].gen_count = values[i]->info->gen_count;
-			v[i].replace = 1;
+		// A pair that doesn't fit in what's left of the buffer is left for
+		// the next batch, unless the buffer is empty.
+		if (ret < 0 || (!keys_only && info.value_len > room)) {
+			if (batch->count == 0) {
+				return -1;
+			}
+			break;
+		}
+
+		record->key_len = key_len;
+		record->value_len = keys_only ? info.value_len : (uint32_t)ret;
+		record->expiry = info.expiry;
+		record->gen_count = info.gen_count;
+		record->value_offset = value_offset;
+		offsets[batch->count++] = offset;
+		offset = keys_only
+			? (key_offset + key_len + 3) & ~3U
+			: value_offset + _fio_kv_sector_round((uint32_t)ret);
+
+		if (nvm_kv_next(pool->store->kv, iterator) < 0) {
+			batch->ended = 1;
+			break;
 		}
 	}
 
-	return v;
+	return (int)batch->count;
 }
 
 /**
- * Insert (or replace) a set of key/value pairs in one batch operation.
+ * Read the following key/value pairs of an iteration into a buffer.
+ *
+ * Starting with the iterator's current element, pairs are packed into the
+ * buffer until it is full, max pairs were read or the iteration ends. The
+ * iterator is left on the first element that wasn't read. The buffer starts
+ * with a fio_kv_batch_t header holding the number of records and whether the
+ * iteration ended, followed by a table of max uint32_t offsets giving the
+ * position of each record within the buffer. Each
+ * record is a fio_kv_record_t structure immediately followed by the key
+ * bytes, and its value is stored at the following sector boundary.
+ *
+ * In keys-only mode, value data is not transferred: records only hold the
+ * key and its metadata, the value_len field giving the length of the value
+ * on the device and value_offset being zero, and are packed back to back on
+ * 4-byte boundaries.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
- *	keys (fio_kv_key_t **): An array of pointers to the keys to insert.
- *	values (fio_kv_value_t **): An array of pointers to the corresponding
- *	  values.
- *	count (size_t): The number of key/value pairs.
+ *	iterator (int): The ID of the iterator.
+ *	buffer (void *): A sector-aligned buffer to pack the records in.
+ *	size (uint32_t): The size of the buffer, a multiple of the sector size.
+ *	max (uint32_t): The maximum number of records to read.
+ *	keys_only (bool): Whether to only read keys and their metadata.
  * Returns:
- *	Returns true if the batch insertion was successful, false otherwise.
+ *	Returns the number of records read, or -1 if an error occurred or the
+ *	  current element doesn't fit in the buffer.
  */
-bool fio_kv_batch_put(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
-		const fio_kv_value_t **values, const size_t count)
+int fio_kv_next_batch(const fio_kv_pool_t *pool, const int iterator,
+		void *buffer, const uint32_t size, const uint32_t max,
+		const bool keys_only)
 {
-	nvm_kv_iovec_t *v;
-	int ret;
+	uint64_t start = fio_kv_stats_clock();
+	fio_kv_sched_enter(pool->store->sched, FIO_KV_SCHED_BACKGROUND, max);
+	int ret = _fio_kv_next_batch(pool, iterator, buffer, size, max, keys_only);
+	fio_kv_sched_exit(pool->store->sched, FIO_KV_SCHED_BACKGROUND);
+
+	// In keys-only mode, record value lengths are those on the device and
+	// no value byte was transferred.
+	uint64_t bytes = 0;
+	const fio_kv_batch_t *batch = (const fio_kv_batch_t *)buffer;
+	const uint32_t *offsets = (const uint32_t *)(batch + 1);
+	for (int i=0; !keys_only && i<ret; i++) {
+		bytes += ((const fio_kv_record_t *)
+			((const char *)buffer + offsets[i]))->value_len;
+	}
+	fio_kv_stats_record(pool->store->stats, FIO_KV_STATS_ITERATE, start,
+			ret < 0 ? errno : 0, 0, bytes);
+	return ret;
+}
 
+/**
+ * End an iteration.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	iterator (int): The ID of the iterator.
+ * Returns:
+ *	Returns true if the operation was successful, false otherwise.
+ */
+bool fio_kv_end_iteration(const fio_kv_pool_t *pool, const int iterator)
+{
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(keys != NULL);
-	assert(values != NULL);
-
-	v = _fio_kv_prepare_batch(keys, values, count);
-	ret = nvm_kv_batch_put(pool->store->kv, pool->id, v, count);
-	free(v);
+	assert(iterator >= 0);
 
-	return ret == 0;
+	return nvm_kv_iteration_end(pool->store->kv, iterator) == 0;
 }
 
 /**
- * Create an iterator on a key/value pool.
+ * Enable or disable the compression of the values of a pool.
+ *
+ * Once enabled, values written to the pool are compressed with the given
+ * codec when that saves at least one sector on the device, and prefixed with
+ * a header giving the codec and their original length. Values read from the
+ * pool are decompressed transparently, and fio_kv_get_value_len() then
+ * reports their original length at the cost of a one-sector read, while
+ * fio_kv_get_key_info() and fio_kv_exists() report the length stored on the
+ * device. Values that were written uncompressed remain readable. The setting
+ * lives until the store is closed; every store reading a pool with
+ * compressed values must enable it.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
+ *	codec (fio_kv_codec_t): The compression codec, or FIO_KV_CODEC_NONE to
+ *	  disable compression.
  * Returns:
- *	Returns the new iterator's ID, or -1 if an iterator could not be
- *	  created.
+ *	Returns true if the setting was applied, false otherwise, with errno set
+ *	  to EINVAL if the codec is not supported.
  */
-int fio_kv_iterator(const fio_kv_pool_t *pool)
+bool fio_kv_set_compression(const fio_kv_pool_t *pool,
+		const fio_kv_codec_t codec)
+{
+	assert(pool != NULL);
+	assert(pool->store != NULL);
+	assert(pool->store->codecs != NULL);
+	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
+
+	if (codec != FIO_KV_CODEC_NONE && codec != FIO_KV_CODEC_LZ4) {
+		errno = EINVAL;
+		return false;
+	}
+
+	pool->store->codecs[pool->id] = codec;
+	return true;
+}
+
+/**
+ * Make a pool a packed pool, holding small values in shared bucket records.
+ *
+ * The logical key/value pairs of a packed pool are stored, many to a
+ * record, in the bucket record their key hashes to, so that small values
+ * don't each take a full sector on the device. Pairs are read with a single
+ * read of their bucket, and written or removed with a read-modify-write of
+ * it; updates are serialized within the store only, so a packed pool must
+ * only be written to by one process at a time. Values are limited to
+ * FIO_KV_PACK_MAX_VALUE bytes, and the pairs of a bucket to
+ * FIO_KV_PACK_BUCKET_SIZE bytes, so the number of buckets should allow for
+ * the expected number of pairs. Packed pools can't be iterated over and
+ * don't support Bloom filters; batch operations process their pairs one by
+ * one.
+ *
+ * The number of buckets is recorded in the pool the first time it is
+ * packed, and must be given again, identically, by every store using the
+ * pool, before any other operation on it.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool, which must be empty the
+ *	  first time it is packed.
+ *	buckets (uint32_t): The number of buckets.
+ * Returns:
+ *	Returns true if the pool is packed, false otherwise, with errno set to
+ *	  EINVAL if it was packed with a different number of buckets.
+ */
+bool fio_kv_set_packing(const fio_kv_pool_t *pool, const uint32_t buckets)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
+	assert(pool->store->pack != NULL);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
 
-	return nvm_kv_begin(pool->store->kv, pool->id);
+	fio_kv_pack_t *pack = pool->store->pack;
+	if (buckets == 0 ||
+			(pack->buckets[pool->id] != 0 && pack->buckets[pool->id] != buckets)) {
+		errno = EINVAL;
+		return false;
+	}
+
+	if (pack->buckets[pool->id] == buckets) {
+		return true;
+	}
+
+	fio_kv_pack_meta_t *meta = (fio_kv_pack_meta_t *)fio_kv_slab_alloc(
+			FIO_SECTOR_ALIGNMENT);
+	if (meta == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	_fio_kv_pack_key_t meta_key;
+	nvm_kv_key_info_t info;
+	bool ret = false;
+
+	memcpy(meta_key.tag, "fkvm", 4);
+	meta_key.index = 0;
+	int read = nvm_kv_get(pool->store->kv, pool->id,
+			(nvm_kv_key_t *)&meta_key, sizeof(_fio_kv_pack_key_t),
+			meta, FIO_SECTOR_ALIGNMENT, false, &info);
+	if (read >= (int)sizeof(fio_kv_pack_meta_t) &&
+			meta->magic == FIO_KV_PACK_META_MAGIC) {
+		ret = meta->buckets == buckets;
+		errno = ret ? errno : EINVAL;
+	} else if (read < 0 && nvm_kv_exists(pool->store->kv, pool->id,
+				(nvm_kv_key_t *)&meta_key, sizeof(_fio_kv_pack_key_t),
+				&info) == 0) {
+		memset(meta, 0, FIO_SECTOR_ALIGNMENT);
+		meta->magic = FIO_KV_PACK_META_MAGIC;
+		meta->buckets = buckets;
+		ret = nvm_kv_put(pool->store->kv, pool->id,
+				(nvm_kv_key_t *)&meta_key, sizeof(_fio_kv_pack_key_t),
+				meta, sizeof(fio_kv_pack_meta_t), 0, true, 0) >= 0;
+	} else if (read >= 0) {
+		errno = EINVAL;
+	}
+
+	if (ret) {
+		pack->buckets[pool->id] = buckets;
+	}
+
+	fio_kv_slab_free(meta);
+	return ret;
 }
 
 /**
- * Move an iterator to the following element in a key/value pool.
+ * Build the Bloom filter of a pool from a keys-only iteration over it.
+ *
+ * Once built, the filter lets fio_kv_get(), fio_kv_get_value_len(),
+ * fio_kv_get_key_info() and fio_kv_exists() answer lookups of absent keys
+ * without a device I/O. Keys written through this library are added to it,
+ * including while it is being built; keys written by other processes are
+ * not, and would be reported absent. Filters are not rebuilt when keys are
+ * removed, and live until the store is closed. Building the filter of a
+ * pool that already has a ready filter does nothing.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
- *	iterator (int): The ID of the iterator to advance.
+ *	capacity (uint64_t): The expected number of keys in the pool, which
+ *	  sizes a new filter.
  * Returns:
- *	Returns true if the operation was successful, false otherwise.
+ *	Returns true if the pool's filter is ready, false otherwise, with errno
+ *	  set to EINVAL for packed pools.
  */
-bool fio_kv_next(const fio_kv_pool_t *pool, const int iterator)
+bool fio_kv_build_filter(const fio_kv_pool_t *pool, const uint64_t capacity)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
 	assert(pool->store->kv > 0);
+	assert(pool->store->filters != NULL);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(iterator >= 0);
 
-	return nvm_kv_next(pool->store->kv, iterator) == 0;
+	// The keys of packed pools are only found in their buckets.
+	if (_fio_kv_pack_buckets(pool) != 0) {
+		errno = EINVAL;
+		return false;
+	}
+
+	// The filter is installed before the iteration starts, so that it
+	// collects the keys written while it is being built.
+	fio_kv_bloom_t *bloom = _fio_kv_filter(pool);
+	if (bloom == NULL) {
+		fio_kv_bloom_t *filter = fio_kv_bloom_create(capacity);
+		if (filter == NULL) {
+			errno = ENOMEM;
+			return false;
+		}
+
+		if (!_fio_kv_install_filter(pool, filter)) {
+			fio_kv_bloom_destroy(filter);
+		}
+		bloom = pool->store->filters[pool->id];
+	}
+
+	if (bloom->ready) {
+		return true;
+	}
+
+	// No iterator can be created on an empty pool, whose filter is empty.
+	int iterator = fio_kv_iterator(pool);
+	if (iterator < 0) {
+		if (errno == EINVAL) {
+			return false;
+		}
+
+		__sync_synchronize();
+		bloom->ready = 1;
+		return true;
+	}
+
+	void *buffer = fio_kv_alloc(_FIO_KV_FILTER_BATCH_SIZE);
+	if (buffer == NULL) {
+		fio_kv_end_iteration(pool, iterator);
+		errno = ENOMEM;
+		return false;
+	}
+
+	fio_kv_batch_t *batch = (fio_kv_batch_t *)buffer;
+	uint32_t *offsets = (uint32_t *)(batch + 1);
+	bool ret = true;
+
+	do {
+		int read = fio_kv_next_batch(pool, iterator, buffer,
+				_FIO_KV_FILTER_BATCH_SIZE, _FIO_KV_FILTER_BATCH_MAX, true);
+		if (read < 0) {
+			ret = false;
+			break;
+		}
+
+		for (int i=0; i<read; i++) {
+			fio_kv_record_t *record = (fio_kv_record_t *)
+				((char *)buffer + offsets[i]);
+			fio_kv_bloom_add(bloom, record + 1, record->key_len);
+		}
+	} while (!batch->ended);
+
+	fio_kv_slab_free(buffer);
+	fio_kv_end_iteration(pool, iterator);
+
+	if (ret) {
+		__sync_synchronize();
+		bloom->ready = 1;
+	}
+
+	return ret;
 }
 
 /**
- * Retrieve the key and value at the current iterator's position.
+ * Write the ready Bloom filter of a pool to a file.
+ *
+ * The file can be loaded with fio_kv_load_filter() after the store is
+ * re-opened, instead of rebuilding the filter. Keys written while the filter
+ * is being saved may be missing from the file; it should be saved once
+ * writes to the pool are over, typically right before closing the store.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
- *	iterator (int): The ID of the iterator.
- *	key (fio_kv_key_t *): An allocated key structure to hold the current
- *	  key.
- *	value (fio_kv_value_t *): An allocated value structure to hold the
- * 	  current value.
+ *	path (char *): The path of the file.
  * Returns:
- *	Returns true if the operation was successful, false otherwise.
+ *	Returns true if the filter was written, false otherwise, with errno set
+ *	  to ENOENT if the pool has no ready filter.
  */
-bool fio_kv_get_current(const fio_kv_pool_t *pool, const int iterator,
-		fio_kv_key_t *key, const fio_kv_value_t *value)
+bool fio_kv_save_filter(const fio_kv_pool_t *pool, const char *path)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
-	assert(pool->store->kv > 0);
+	assert(pool->store->filters != NULL);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(iterator >= 0);
-	assert(key != NULL);
-	assert(key->length >= 1 && key->length <= NVM_KV_MAX_KEY_SIZE);
-	assert(key->bytes != NULL);
-	assert(value != NULL);
-	assert(value->data != NULL);
-	assert(value->info != NULL);
+	assert(path != NULL);
 
-	return nvm_kv_get_current(pool->store->kv, iterator,
-			key->bytes, &(key->length),
-			value->data, value->info->value_len,
-			value->info) >= 0;
+	fio_kv_bloom_t *bloom = _fio_kv_filter(pool);
+	if (bloom == NULL || !bloom->ready) {
+		errno = ENOENT;
+		return false;
+	}
+
+	return fio_kv_bloom_save(bloom, pool->id, path);
 }
 
 /**
- * End an iteration.
+ * Load the Bloom filter of a pool from a file written by
+ * fio_kv_save_filter().
+ *
+ * The pool must not have been written to since the filter was saved, except
+ * through a store with that same filter.
  *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
- *	iterator (int): The ID of the iterator.
+ *	path (char *): The path of the file.
  * Returns:
- *	Returns true if the operation was successful, false otherwise.
+ *	Returns true if the filter was loaded, false otherwise, with errno set
+ *	  to EEXIST if the pool already has a filter.
  */
-bool fio_kv_end_iteration(const fio_kv_pool_t *pool, const int iterator)
+bool fio_kv_load_filter(const fio_kv_pool_t *pool, const char *path)
 {
 	assert(pool != NULL);
 	assert(pool->store != NULL);
-	assert(pool->store->kv > 0);
+	assert(pool->store->filters != NULL);
 	assert(pool->id >= 0 && pool->id < NVM_KV_MAX_POOLS);
-	assert(iterator >= 0);
+	assert(path != NULL);
 
-	return nvm_kv_iteration_end(pool->store->kv, iterator) == 0;
+	if (_fio_kv_filter(pool) != NULL) {
+		errno = EEXIST;
+		return false;
+	}
+
+	fio_kv_bloom_t *bloom = fio_kv_bloom_load(path, pool->id);
+	if (bloom == NULL) {
+		return false;
+	}
+
+	if (!_fio_kv_install_filter(pool, bloom)) {
+		fio_kv_bloom_destroy(bloom);
+		errno = EEXIST;
+		return false;
+	}
+
+	return true;
 }
 
 /**
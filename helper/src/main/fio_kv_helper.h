@@ -31,26 +31,53 @@
 #ifndef __FIO_KV_HELPER_H__
 #define __FIO_KV_HELPER_H__
 
+#include <pthread.h>
+
 #include <nvm/nvm_kv.h>
 
+#include "fio_kv_bloom.h"
+#include "fio_kv_cache.h"
+#include "fio_kv_codec.h"
+#include "fio_kv_group.h"
+#include "fio_kv_pack.h"
+#include "fio_kv_registry.h"
+#include "fio_kv_sched.h"
+#include "fio_kv_stats.h"
+
 #define FIO_SECTOR_ALIGNMENT        512
 #define FIO_KV_MAX_POOLS						NVM_KV_MAX_POOLS // 1024
 #define FIO_TAG_MAX_LENGTH					16
+#define FIO_KV_MAX_BATCH_SIZE				16
+#define FIO_KV_DEFAULT_SIZE_HINT		4096
+#define FIO_KV_ATOMIC_LOCKS			64
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct _fio_kv_hotkeys fio_kv_hotkeys_t;
+
 typedef struct {
 	const char *path;
 	int fd;
 	int64_t kv;
+	fio_kv_cache_t *cache;
+	fio_kv_bloom_t **filters;
+	fio_kv_group_t *group;
+	fio_kv_codec_t *codecs;
+	fio_kv_pack_t *pack;
+	fio_kv_stats_t *stats;
+	fio_kv_sched_t *sched;
+	fio_kv_hotkeys_t *hotkeys;
+	fio_kv_registry_t *pools;
+	pthread_mutex_t *locks;
 } fio_kv_store_t;
 
 typedef struct {
 	fio_kv_store_t *store;
 	int id;
 	char tag[FIO_TAG_MAX_LENGTH];
+	uint32_t size_hint;
 } fio_kv_pool_t;
 
 typedef struct {
@@ -63,6 +90,28 @@ typedef struct {
 	nvm_kv_key_info_t *info;
 } fio_kv_value_t;
 
+typedef struct {
+	uint32_t key_offset;
+	uint32_t key_len;
+	uint32_t value_offset;
+	uint32_t value_len;
+	uint32_t expiry;
+	uint32_t gen_count;
+} fio_kv_packed_t;
+
+typedef struct {
+	uint32_t count;
+	uint32_t ended;
+} fio_kv_batch_t;
+
+typedef struct {
+	uint32_t key_len;
+	uint32_t value_len;
+	uint32_t expiry;
+	uint32_t gen_count;
+	uint32_t value_offset;
+} fio_kv_record_t;
+
 
 /**
  * Open a Fusion-IO device or directFS file for key/value store access.
@@ -83,12 +132,16 @@ typedef struct {
  *		global).
  *	expiry_time (uint32_t): The expiration time for global expiry mode, in
  *		seconds since the key/value pair insertion.
+ *	cache_size (uint64_t): The byte budget of the store's in-process read
+ *		cache, or 0 to disable it. The read cache is not available in global
+ *		expiry mode, where directKV doesn't report when pairs expire.
  * Returns:
  *	 Returns true if the operation was successful (and the fd and kv fields of
  *	 the fio_kv_store_t structure are filled in), false otherwise.
  */
 bool fio_kv_open(fio_kv_store_t *store, const uint32_t version,
-		const nvm_kv_expiry_t expiry_type, const uint32_t expiry_time);
+		const nvm_kv_expiry_t expiry_type, const uint32_t expiry_time,
+		const uint64_t cache_size);
 
 /**
  * Close a key/value store.
@@ -101,6 +154,94 @@ bool fio_kv_open(fio_kv_store_t *store, const uint32_t version,
  */
 void fio_kv_close(fio_kv_store_t *store);
 
+/**
+ * Enable the group commit of single puts on a key/value store.
+ *
+ * Once enabled, concurrent calls to fio_kv_put() on the same pool are combined
+ * into batch writes. Each put still only returns once its pair is written,
+ * after waiting up to the given delay for other puts to join its batch. This
+ * must be done before the store is written to.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ *	max_pairs (uint32_t): The number of pairs that triggers the write of a
+ *	  batch, between 2 and FIO_KV_GROUP_MAX_PAIRS.
+ *	delay (uint32_t): The longest time, in microseconds, a put waits for
+ *	  other puts to join its batch.
+ * Returns:
+ *	Returns true if group commit was enabled, false otherwise, with errno
+ *	  set to EEXIST if it already was.
+ */
+bool fio_kv_set_group_commit(fio_kv_store_t *store, const uint32_t max_pairs,
+		const uint32_t delay);
+
+/**
+ * Configure the scheduling of an I/O class on a key/value store.
+ *
+ * The store classifies its operations as foreground reads (gets and
+ * existence checks), foreground writes (puts, removals and batches of up to
+ * FIO_KV_MAX_BATCH_SIZE pairs) and background work (iterations, batch puts
+ * of more than FIO_KV_MAX_BATCH_SIZE pairs and pool deletions). Each class
+ * can be rate limited, and can yield to the classes of higher priority
+ * while they have operations in flight. Nothing is scheduled until a class
+ * is configured. This must be done before the store is used.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ *	cls (fio_kv_sched_class_t): The I/O class.
+ *	rate (uint32_t): The maximum rate of the class, in operations per
+ *	  second, or 0 for no limit. A batch counts for as many operations as
+ *	  it has pairs.
+ *	burst (uint32_t): The number of operations that can be issued at once
+ *	  above the rate, at least 1 if the rate is limited.
+ *	max_defer (uint32_t): The longest time an operation of the class yields
+ *	  to higher-priority ones, in microseconds, or 0 to never yield.
+ * Returns:
+ *	Returns true if the class was configured, false otherwise, with errno
+ *	  set to EINVAL if the class or the burst is invalid.
+ */
+bool fio_kv_set_sched(fio_kv_store_t *store, const fio_kv_sched_class_t cls,
+		const uint32_t rate, const uint32_t burst, const uint32_t max_defer);
+
+/**
+ * Enable the hot key manifest of a key/value store.
+ *
+ * The keys held by the store's read cache are saved to the manifest file
+ * when the store is closed. The keys of the manifest saved by a previous use
+ * of the store, if any, are prefetched into the read cache by
+ * fio_kv_prefetch_hot_keys(), so that the cache doesn't have to fill up from
+ * scratch. This must be done right after the store is opened.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a read cache.
+ *	path (char *): The path of the manifest file.
+ *	max_keys (uint32_t): The maximum number of keys saved to the manifest.
+ * Returns:
+ *	Returns true if the manifest was enabled, false otherwise, with errno
+ *	  set to EINVAL if the store has no read cache, or to EEXIST if it
+ *	  already has a manifest.
+ */
+bool fio_kv_set_hot_keys(fio_kv_store_t *store, const char *path,
+		const uint32_t max_keys);
+
+/**
+ * Start prefetching the keys of the hot key manifest of a key/value store
+ * into its read cache, in the background.
+ *
+ * Keys of pools not compressed or packed as they were when the manifest was
+ * saved are not prefetched, so this should be done once the pools of the
+ * store are configured.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a hot key manifest.
+ * Returns:
+ *	Returns true if the prefetch was started, or if there is no manifest to
+ *	  prefetch, false otherwise, with errno set to EINVAL if the store has
+ *	  no hot key manifest, or to EALREADY if the prefetch was already
+ *	  started.
+ */
+bool fio_kv_prefetch_hot_keys(fio_kv_store_t *store);
+
 /**
  * Returns information about the given key/value store.
  *
@@ -112,9 +253,28 @@ void fio_kv_close(fio_kv_store_t *store);
  */
 nvm_kv_store_info_t *fio_kv_get_store_info(fio_kv_store_t *store);
 
+/**
+ * Returns a snapshot of the operation statistics of the given key/value store.
+ *
+ * The latency, error and byte counters of the store's operations are summed
+ * over all threads. Latencies are the time spent in this library's calls;
+ * the JNI counters separately account for the marshalling overhead of the
+ * Java binding's calls.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store.
+ * Returns:
+ *	A pointer to a populated fio_kv_stats_snapshot_t structure, to be
+ *	  released with free(), or NULL if it could not be allocated.
+ */
+fio_kv_stats_snapshot_t *fio_kv_get_stats(const fio_kv_store_t *store);
+
 /**
  * Get or create a new pool in the given key/value store.
  *
+ * Pools already known to the store's pool registry are resolved without
+ * going to the device.
+ *
  * Args:
  *	store (fio_kv_store_t *): The key/value store.
  *	tag (const char *): The pool name tag.
@@ -126,15 +286,19 @@ fio_kv_pool_t *fio_kv_get_or_create_pool(fio_kv_store_t *store,
 		const char *tag);
 
 /**
- * Get pool metadata information for up to the requested number of pools.
+ * Get the pools of the given key/value store.
+ *
+ * The pools are listed, in increasing ID order, from the store's pool
+ * registry, which is loaded from the device when the store is opened and kept
+ * up-to-date as pools are created and deleted through the store.
  *
  * Args:
  *	store (fio_kv_store_t *): The key/value store.
  *	pool_count (int *): A pointer to an integer that will contain the actual
- *		number of pools we got metadata about.
+ *		number of pools.
  * Returns:
  *	An array of initialized and filled-in fio_kv_pool_t structures, with the
- *	pool IDs and pool tags for each pool up to the number of requested pools.
+ *	pool IDs and pool tags for each pool.
  */
 fio_kv_pool_t *fio_kv_get_all_pools(fio_kv_store_t *store,
 		uint32_t *pool_count);
@@ -142,6 +306,9 @@ fio_kv_pool_t *fio_kv_get_all_pools(fio_kv_store_t *store,
 /**
  * Allocate sector-aligned memory to hold the given number of bytes.
  *
+ * The memory comes from the slab allocator and must be released with
+ * fio_kv_free_value().
+ *
  * Args:
  *	 length (uint32_t): Size of the memory to allocate.
  * Returns:
@@ -165,6 +332,9 @@ void fio_kv_free_value(fio_kv_value_t *value);
 /**
  * Retrieve a value's length, rounded up to the next sector, without any I/O.
  *
+ * In pools with compression enabled, the original length of compressed
+ * values is read from their header, which takes a one-sector read.
+ *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
  *	key (fio_kv_key_t *): The key.
@@ -192,6 +362,9 @@ nvm_kv_key_info_t *fio_kv_get_key_info(const fio_kv_pool_t *pool,
  * requested number of bytes. Such memory can be obtained by calling
  * fio_kv_alloc().
  *
+ * When the store has a read cache, values found in it are served without a
+ * device read, and values read in full from the device are added to it.
+ *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
  *	key (fio_kv_key_t *): The key.
@@ -203,11 +376,35 @@ nvm_kv_key_info_t *fio_kv_get_key_info(const fio_kv_pool_t *pool,
 int fio_kv_get(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
 		const fio_kv_value_t *value);
 
+/**
+ * Retrieve a value into newly allocated memory.
+ *
+ * The value is read into sector-aligned memory sized from the pool's size
+ * hint, so that a single device read is needed when the value fits. Larger
+ * values are read again into memory grown to fit. The pool's size hint is
+ * then updated to the sector-rounded length of the value.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): A value structure whose info member points to
+ *	  an allocated nvm_kv_key_info_t structure. Upon success, its data member
+ *	  points to memory that must be released with fio_kv_free_value().
+ *	capacity (uint32_t *): Optional pointer to receive the size of the
+ *	  allocated memory.
+ * Returns:
+ *	Returns the number of bytes read, or -1 if an error occurred.
+ */
+int fio_kv_get_alloc(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		fio_kv_value_t *value, uint32_t *capacity);
+
 /**
  * Insert (or replace) a key/value pair into a pool.
  *
  * Note that the value's data must be sector-aligned memory, which can be
- * obtained from the fio_kv_alloc() function.
+ * obtained from the fio_kv_alloc() function. When the store has group commit
+ * enabled, the pair is written in a batch with concurrent puts to the same
+ * pool.
  *
  * Args:
  *	 pool (fio_kv_pool_t *): The key/value pool.
@@ -246,6 +443,90 @@ bool fio_kv_exists(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
  */
 bool fio_kv_delete(const fio_kv_pool_t *pool, const fio_kv_key_t *key);
 
+/**
+ * Replace a key/value pair only if its generation count matches.
+ *
+ * The generation count of the pair is checked and the pair replaced
+ * atomically with respect to the other conditional and read-modify-write
+ * operations of this process on the store, which are serialized per key by a
+ * set of locks. Plain puts are not: mixing them with conditional operations
+ * on the same keys can lose updates. The new pair is written with the next
+ * generation count. This is not available for packed pools, whose pairs have
+ * no generation count.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): The new value.
+ *	gen_count (uint32_t): The expected generation count of the pair.
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error, with
+ *	  errno set to ECANCELED if the pair doesn't exist or has a different
+ *	  generation count, or to EOPNOTSUPP for packed pools.
+ */
+int fio_kv_compare_and_put(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const fio_kv_value_t *value,
+		const uint32_t gen_count);
+
+/**
+ * Insert a key/value pair only if the key doesn't exist yet.
+ *
+ * The existence check and the insertion are atomic with respect to the
+ * other conditional and read-modify-write operations of this process on the
+ * store (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	value (fio_kv_value_t *): The value.
+ * Returns:
+ *	Returns the number of bytes written, or -1 in case of an error, with
+ *	  errno set to EEXIST if the key already exists.
+ */
+int fio_kv_put_if_absent(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const fio_kv_value_t *value);
+
+/**
+ * Atomically add to the 64-bit counter stored as the value of a key.
+ *
+ * Counters are stored as 8-byte values in native byte order. A missing key
+ * is a counter of 0. The update is atomic with respect to the other
+ * conditional and read-modify-write operations of this process on the store
+ * (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	delta (int64_t): The value to add to the counter.
+ *	expiry (uint32_t): The expiry of the updated pair.
+ *	result (int64_t *): Optional pointer to receive the counter's new value.
+ * Returns:
+ *	Returns true if the counter was updated, false otherwise, with errno set
+ *	  to EINVAL if the key's value is not a counter.
+ */
+bool fio_kv_increment(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const int64_t delta, const uint32_t expiry, int64_t *result);
+
+/**
+ * Atomically append data to the value of a key.
+ *
+ * A missing key is created with the given data as its value. The update is
+ * atomic with respect to the other conditional and read-modify-write
+ * operations of this process on the store (see fio_kv_compare_and_put()).
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	data (void *): The data to append.
+ *	length (uint32_t): The length of the data.
+ *	expiry (uint32_t): The expiry of the updated pair.
+ * Returns:
+ *	Returns the new length of the value, or -1 in case of an error, with
+ *	  errno set to EINVAL if it would exceed the maximum value size.
+ */
+int fio_kv_append(fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		const void *data, const uint32_t length, const uint32_t expiry);
+
 /**
  * Removes all key/value pairs from all pools.
  *
@@ -288,6 +569,9 @@ bool fio_kv_delete_all_pools(const fio_kv_store_t *store);
 /**
  * Insert (or replace) a set of key/value pairs in one batch operation.
  *
+ * Batches larger than FIO_KV_MAX_BATCH_SIZE pairs are transparently split
+ * into device-sized chunks, like with fio_kv_batch_put_count().
+ *
  * Args:
  *	pool (fio_kv_pool_t *): The key/value pool.
  *	keys (fio_kv_key_t **): An array of pointers to the keys to insert.
@@ -300,6 +584,160 @@ bool fio_kv_delete_all_pools(const fio_kv_store_t *store);
 bool fio_kv_batch_put(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
 		const fio_kv_value_t **values, const size_t count);
 
+/**
+ * Insert (or replace) a set of key/value pairs in one batch operation, and
+ * report how many of them were written.
+ *
+ * Batches larger than FIO_KV_MAX_BATCH_SIZE pairs are transparently split
+ * into device-sized chunks. If a chunk fails, the pairs of the previous
+ * chunks have been written but none of the following ones are.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to insert.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values.
+ *	count (size_t): The number of key/value pairs.
+ * Returns:
+ *	Returns the number of key/value pairs written, which is count on
+ *	  success. Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_put_count(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count);
+
+/**
+ * Retrieve a set of values in one batch operation.
+ *
+ * The values are read like with fio_kv_batch_get_count().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to retrieve.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the results.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns true if all the values were read, false otherwise.
+ */
+bool fio_kv_batch_get(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count);
+
+/**
+ * Retrieve a set of values in one batch operation, and report how many of
+ * them were read.
+ *
+ * Each value structure must point to sector-aligned memory large enough to
+ * hold the value_len bytes advertised by its info structure. Upon success,
+ * the info structure of each value is filled in with the metadata of the
+ * corresponding key/value pair, its value_len field holding the number of
+ * bytes read. Batches larger than FIO_KV_MAX_BATCH_SIZE pairs are
+ * transparently split into device-sized chunks.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to retrieve.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the results.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of values read, which is count on success.
+ *	  Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_get_count(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count);
+
+/**
+ * Read a set of values into the read cache of a store in one batch
+ * operation.
+ *
+ * The values are read like with fio_kv_batch_get(), but as background work,
+ * and those read in full, that is shorter than their buffer, are added to
+ * the store's read cache unless they already are in it. Prefetches are not
+ * counted in the store's statistics, so that warming the cache up doesn't
+ * skew the latencies of foreground reads.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool, of a store with a read
+ *	  cache.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to prefetch.
+ *	values (fio_kv_value_t **): An array of pointers to allocated value
+ *	  structures to hold the values.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of values read, which is count on success.
+ *	  Otherwise, the failed chunk starts at the returned position.
+ */
+size_t fio_kv_batch_prefetch(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const fio_kv_value_t **values,
+		const size_t count);
+
+/**
+ * Remove a set of key/value pairs in one call.
+ *
+ * The keys are processed in chunks of FIO_KV_MAX_BATCH_SIZE, prepared as for
+ * the other batch operations. directKV has no batch removal, so each key is
+ * then removed from the device on its own. Keys that don't exist are not
+ * errors. Processing stops at the first key that fails to be removed.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to remove.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of keys processed, which is count on success.
+ *	  Otherwise, the key at the returned position failed to be removed.
+ */
+size_t fio_kv_batch_delete(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const size_t count);
+
+/**
+ * Tell which keys of a set exist in a pool, in one call.
+ *
+ * The keys are processed in chunks of FIO_KV_MAX_BATCH_SIZE, prepared as for
+ * the other batch operations; keys excluded by the pool's Bloom filter are
+ * answered without any device I/O, the others with one existence check each
+ * as directKV has no batch existence check.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys to check.
+ *	count (size_t): The number of keys.
+ *	bitmap (uint8_t *): An array of at least (count + 7) / 8 bytes, in which
+ *	  bit i % 8 of byte i / 8 is set if the i-th key exists, and cleared
+ *	  otherwise.
+ * Returns:
+ *	Returns the number of keys that exist.
+ */
+size_t fio_kv_batch_exists(const fio_kv_pool_t *pool,
+		const fio_kv_key_t **keys, const size_t count, uint8_t *bitmap);
+
+/**
+ * Insert (or replace) a set of key/value pairs packed in a single buffer.
+ *
+ * The buffer starts with a table of count fio_kv_packed_t entries, each
+ * giving the position of a key and its value within the buffer, along with
+ * the pair's expiry and generation count. Value offsets must be multiples of
+ * the sector size. The nvm_kv_iovec_t arrays are built straight from this
+ * table, in chunks of FIO_KV_MAX_BATCH_SIZE pairs; if a chunk fails, the
+ * pairs of the previous chunks have been written but none of the following
+ * ones are.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	buffer (void *): A sector-aligned buffer holding the packed pairs.
+ *	size (uint32_t): The size of the buffer.
+ *	count (uint32_t): The number of key/value pairs.
+ * Returns:
+ *	Returns the number of key/value pairs written, which is count on
+ *	  success. Otherwise, the failed chunk starts at the returned position.
+ *	  Nothing is written, with errno set to EINVAL, if an entry points
+ *	  outside of the buffer.
+ */
+size_t fio_kv_batch_put_packed(const fio_kv_pool_t *pool, void *buffer,
+		const uint32_t size, const uint32_t count);
+
 /**
  * Create an iterator on a key/value pool.
  *
@@ -307,7 +745,8 @@ bool fio_kv_batch_put(const fio_kv_pool_t *pool, const fio_kv_key_t **keys,
  *	pool (fio_kv_pool_t *): The key/value pool.
  * Returns:
  *	Returns the new iterator's ID, or -1 if an iterator could not be
- *	  created.
+ *	  created, with errno set to EINVAL for packed pools, which can't be
+ *	  iterated over.
  */
 int fio_kv_iterator(const fio_kv_pool_t *pool);
 
@@ -338,6 +777,38 @@ bool fio_kv_next(const fio_kv_pool_t *pool, const int iterator);
 bool fio_kv_get_current(const fio_kv_pool_t *pool, const int iterator,
 		fio_kv_key_t *key, const fio_kv_value_t *value);
 
+/**
+ * Read the following key/value pairs of an iteration into a buffer.
+ *
+ * Starting with the iterator's current element, pairs are packed into the
+ * buffer until it is full, max pairs were read or the iteration ends. The
+ * iterator is left on the first element that wasn't read. The buffer starts
+ * with a fio_kv_batch_t header holding the number of records and whether the
+ * iteration ended, followed by a table of max uint32_t offsets giving the
+ * position of each record within the buffer. Each
+ * record is a fio_kv_record_t structure immediately followed by the key
+ * bytes, and its value is stored at the following sector boundary.
+ *
+ * In keys-only mode, value data is not transferred: records only hold the
+ * key and its metadata, the value_len field giving the length of the value
+ * on the device and value_offset being zero, and are packed back to back on
+ * 4-byte boundaries.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	iterator (int): The ID of the iterator.
+ *	buffer (void *): A sector-aligned buffer to pack the records in.
+ *	size (uint32_t): The size of the buffer, a multiple of the sector size.
+ *	max (uint32_t): The maximum number of records to read.
+ *	keys_only (bool): Whether to only read keys and their metadata.
+ * Returns:
+ *	Returns the number of records read, or -1 if an error occurred or the
+ *	  current element doesn't fit in the buffer.
+ */
+int fio_kv_next_batch(const fio_kv_pool_t *pool, const int iterator,
+		void *buffer, const uint32_t size, const uint32_t max,
+		const bool keys_only);
+
 /**
  * End an iteration.
  *
@@ -349,6 +820,113 @@ bool fio_kv_get_current(const fio_kv_pool_t *pool, const int iterator,
  */
 bool fio_kv_end_iteration(const fio_kv_pool_t *pool, const int iterator);
 
+/**
+ * Enable or disable the compression of the values of a pool.
+ *
+ * Once enabled, values written to the pool are compressed with the given
+ * codec when that saves at least one sector on the device, and prefixed with
+ * a header giving the codec and their original length. Values read from the
+ * pool are decompressed transparently, and fio_kv_get_value_len() then
+ * reports their original length at the cost of a one-sector read, while
+ * fio_kv_get_key_info() and fio_kv_exists() report the length stored on the
+ * device. Values that were written uncompressed remain readable. The setting
+ * lives until the store is closed; every store reading a pool with
+ * compressed values must enable it.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	codec (fio_kv_codec_t): The compression codec, or FIO_KV_CODEC_NONE to
+ *	  disable compression.
+ * Returns:
+ *	Returns true if the setting was applied, false otherwise, with errno set
+ *	  to EINVAL if the codec is not supported.
+ */
+bool fio_kv_set_compression(const fio_kv_pool_t *pool,
+		const fio_kv_codec_t codec);
+
+/**
+ * Make a pool a packed pool, holding small values in shared bucket records.
+ *
+ * The logical key/value pairs of a packed pool are stored, many to a
+ * record, in the bucket record their key hashes to, so that small values
+ * don't each take a full sector on the device. Pairs are read with a single
+ * read of their bucket, and written or removed with a read-modify-write of
+ * it; updates are serialized within the store only, so a packed pool must
+ * only be written to by one process at a time. Values are limited to
+ * FIO_KV_PACK_MAX_VALUE bytes, and the pairs of a bucket to
+ * FIO_KV_PACK_BUCKET_SIZE bytes, so the number of buckets should allow for
+ * the expected number of pairs. Packed pools can't be iterated over and
+ * don't support Bloom filters; batch operations process their pairs one by
+ * one.
+ *
+ * The number of buckets is recorded in the pool the first time it is
+ * packed, and must be given again, identically, by every store using the
+ * pool, before any other operation on it.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool, which must be empty the
+ *	  first time it is packed.
+ *	buckets (uint32_t): The number of buckets.
+ * Returns:
+ *	Returns true if the pool is packed, false otherwise, with errno set to
+ *	  EINVAL if it was packed with a different number of buckets.
+ */
+bool fio_kv_set_packing(const fio_kv_pool_t *pool, const uint32_t buckets);
+
+/**
+ * Build the Bloom filter of a pool from a keys-only iteration over it.
+ *
+ * Once built, the filter lets fio_kv_get(), fio_kv_get_value_len(),
+ * fio_kv_get_key_info() and fio_kv_exists() answer lookups of absent keys
+ * without a device I/O. Keys written through this library are added to it,
+ * including while it is being built; keys written by other processes are
+ * not, and would be reported absent. Filters are not rebuilt when keys are
+ * removed, and live until the store is closed. Building the filter of a
+ * pool that already has a ready filter does nothing.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	capacity (uint64_t): The expected number of keys in the pool, which
+ *	  sizes a new filter.
+ * Returns:
+ *	Returns true if the pool's filter is ready, false otherwise, with errno
+ *	  set to EINVAL for packed pools.
+ */
+bool fio_kv_build_filter(const fio_kv_pool_t *pool, const uint64_t capacity);
+
+/**
+ * Write the ready Bloom filter of a pool to a file.
+ *
+ * The file can be loaded with fio_kv_load_filter() after the store is
+ * re-opened, instead of rebuilding the filter. Keys written while the filter
+ * is being saved may be missing from the file; it should be saved once
+ * writes to the pool are over, typically right before closing the store.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns true if the filter was written, false otherwise, with errno set
+ *	  to ENOENT if the pool has no ready filter.
+ */
+bool fio_kv_save_filter(const fio_kv_pool_t *pool, const char *path);
+
+/**
+ * Load the Bloom filter of a pool from a file written by
+ * fio_kv_save_filter().
+ *
+ * The pool must not have been written to since the filter was saved, except
+ * through a store with that same filter.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	path (char *): The path of the file.
+ * Returns:
+ *	Returns true if the filter was loaded, false otherwise, with errno set
+ *	  to EEXIST if the pool already has a filter.
+ */
+bool fio_kv_load_filter(const fio_kv_pool_t *pool, const char *path);
+
 /**
  * Retrieve the last errno value.
  *
@@ -0,0 +1,494 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fio_kv_hotkeys.h"
+#include "fio_kv_slab.h"
+
+/**
+ * Hot key persistence and read cache prefetch.
+ *
+ * The read cache of a store holds its hot set, but is lost on every
+ * restart, after which reads are served by the device until the cache fills
+ * up again. When a store is closed, the keys of its cache are saved to a
+ * manifest file, most recently read first, with the length of their values
+ * and the configuration of their pool. When the store is opened again and
+ * its pools are configured, a background thread reads the manifest and
+ * prefetches its keys into the cache with batch reads, scheduled as
+ * background work so that they yield to the store's foreground operations.
+ *
+ * Only the keys are saved: the values are always read from the device, so a
+ * stale manifest can only cost useless reads, never stale values.
+ */
+
+
+typedef struct {
+	uint32_t pool_id;
+	size_t offset;
+} _fio_kv_hotkeys_index_t;
+
+typedef struct {
+	fio_kv_store_t *store;
+	char *buffer;
+	size_t length;
+	size_t capacity;
+	uint32_t count;
+	uint32_t max_keys;
+} _fio_kv_hotkeys_collect_t;
+
+/**
+ * Return the configuration flags of a pool of a store.
+ */
+uint8_t _fio_kv_hotkeys_flags(const fio_kv_store_t *store,
+		const uint32_t pool_id)
+{
+	uint8_t flags = 0;
+	if (store->codecs != NULL && store->codecs[pool_id] != FIO_KV_CODEC_NONE) {
+		flags |= FIO_KV_HOTKEYS_COMPRESSED;
+	}
+	if (store->pack != NULL && store->pack->buckets[pool_id] != 0) {
+		flags |= FIO_KV_HOTKEYS_PACKED;
+	}
+	return flags;
+}
+
+/**
+ * Cache visitor appending the entries of the read cache to a manifest being
+ * collected, until it holds its maximum number of keys.
+ */
+bool _fio_kv_hotkeys_collect(void *arg, const uint32_t pool_id,
+		const void *key, const uint32_t key_len, const uint32_t value_len)
+{
+	_fio_kv_hotkeys_collect_t *collect = (_fio_kv_hotkeys_collect_t *)arg;
+	if (collect->count >= collect->max_keys) {
+		return false;
+	}
+
+	size_t size = sizeof(fio_kv_hotkeys_entry_t) + key_len;
+	if (collect->length + size > collect->capacity) {
+		size_t capacity = collect->capacity * 2 + size;
+		char *buffer = (char *)realloc(collect->buffer, capacity);
+		if (buffer == NULL) {
+			return false;
+		}
+		collect->buffer = buffer;
+		collect->capacity = capacity;
+	}
+
+	fio_kv_hotkeys_entry_t entry;
+	entry.pool_id = pool_id;
+	entry.value_len = value_len;
+	entry.key_len = (uint8_t)key_len;
+	entry.flags = _fio_kv_hotkeys_flags(collect->store, pool_id);
+	entry.reserved = 0;
+	memcpy(collect->buffer + collect->length, &entry, sizeof(entry));
+	memcpy(collect->buffer + collect->length + sizeof(entry), key, key_len);
+
+	collect->length += size;
+	collect->count++;
+	return true;
+}
+
+/**
+ * Order manifest entries by pool, keeping the order in which they were
+ * collected within each pool.
+ */
+int _fio_kv_hotkeys_compare(const void *a, const void *b)
+{
+	const _fio_kv_hotkeys_index_t *x = (const _fio_kv_hotkeys_index_t *)a;
+	const _fio_kv_hotkeys_index_t *y = (const _fio_kv_hotkeys_index_t *)b;
+
+	if (x->pool_id != y->pool_id) {
+		return x->pool_id < y->pool_id ? -1 : 1;
+	}
+	return x->offset < y->offset ? -1 : x->offset > y->offset ? 1 : 0;
+}
+
+/**
+ * Write the entries of a collected manifest to a file, grouped by pool.
+ *
+ * Returns false if the file could not be written.
+ */
+bool _fio_kv_hotkeys_write(const _fio_kv_hotkeys_collect_t *collect,
+		FILE *f)
+{
+	_fio_kv_hotkeys_index_t *index = (_fio_kv_hotkeys_index_t *)malloc(
+			(collect->count + 1) * sizeof(_fio_kv_hotkeys_index_t));
+	if (index == NULL) {
+		return false;
+	}
+
+	size_t offset = 0;
+	for (uint32_t i=0; i<collect->count; i++) {
+		fio_kv_hotkeys_entry_t entry;
+		memcpy(&entry, collect->buffer + offset, sizeof(entry));
+		index[i].pool_id = entry.pool_id;
+		index[i].offset = offset;
+		offset += sizeof(entry) + entry.key_len;
+	}
+	qsort(index, collect->count, sizeof(_fio_kv_hotkeys_index_t),
+			_fio_kv_hotkeys_compare);
+
+	fio_kv_hotkeys_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = FIO_KV_HOTKEYS_MAGIC;
+	header.version = FIO_KV_HOTKEYS_VERSION;
+	header.count = collect->count;
+
+	bool ret = fwrite(&header, sizeof(header), 1, f) == 1;
+	for (uint32_t i=0; ret && i<collect->count; i++) {
+		const char *entry = collect->buffer + index[i].offset;
+		size_t size = sizeof(fio_kv_hotkeys_entry_t) +
+			((const fio_kv_hotkeys_entry_t *)entry)->key_len;
+		ret = fwrite(entry, size, 1, f) == 1;
+	}
+
+	free(index);
+	return ret;
+}
+
+/**
+ * Read a manifest file, with its header.
+ *
+ * Returns a newly allocated buffer holding the file, or NULL if it could not
+ * be read or is not a manifest.
+ */
+char *_fio_kv_hotkeys_read(const char *path, size_t *length)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return NULL;
+	}
+
+	long size = -1;
+	if (fseek(f, 0, SEEK_END) == 0) {
+		size = ftell(f);
+	}
+
+	char *buffer = NULL;
+	if (size >= (long)sizeof(fio_kv_hotkeys_header_t) &&
+			fseek(f, 0, SEEK_SET) == 0) {
+		buffer = (char *)malloc((size_t)size);
+	}
+
+	if (buffer != NULL && fread(buffer, (size_t)size, 1, f) != 1) {
+		free(buffer);
+		buffer = NULL;
+	}
+	fclose(f);
+
+	const fio_kv_hotkeys_header_t *header =
+		(const fio_kv_hotkeys_header_t *)buffer;
+	if (buffer != NULL && (header->magic != FIO_KV_HOTKEYS_MAGIC ||
+			header->version != FIO_KV_HOTKEYS_VERSION)) {
+		free(buffer);
+		buffer = NULL;
+	}
+
+	*length = (size_t)size;
+	return buffer;
+}
+
+/**
+ * Prefetch a batch of hot keys of a pool into the read cache, skipping the
+ * chunks that fail, for instance because some of their keys were removed.
+ */
+void _fio_kv_hotkeys_prefetch_batch(fio_kv_store_t *store,
+		const uint32_t pool_id, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count)
+{
+	fio_kv_pool_t pool;
+	memset(&pool, 0, sizeof(pool));
+	pool.store = store;
+	pool.id = (int)pool_id;
+	pool.size_hint = FIO_KV_DEFAULT_SIZE_HINT;
+
+	size_t done = 0;
+	while (done < count) {
+		done += fio_kv_batch_prefetch(&pool, keys + done, values + done,
+				count - done);
+		if (done < count) {
+			done += FIO_KV_MAX_BATCH_SIZE;
+		}
+	}
+}
+
+/**
+ * Prefetch thread main loop: read the manifest and prefetch its entries in
+ * batches of up to FIO_KV_HOTKEYS_BATCH keys of the same pool, until all
+ * entries are done or the manifest is destroyed.
+ */
+void *_fio_kv_hotkeys_run(void *arg)
+{
+	fio_kv_hotkeys_t *hotkeys = (fio_kv_hotkeys_t *)arg;
+	fio_kv_store_t *store = hotkeys->store;
+
+	fio_kv_key_t keys[FIO_KV_HOTKEYS_BATCH];
+	const fio_kv_key_t *pkeys[FIO_KV_HOTKEYS_BATCH];
+	nvm_kv_key_info_t info[FIO_KV_HOTKEYS_BATCH];
+	fio_kv_value_t values[FIO_KV_HOTKEYS_BATCH];
+	const fio_kv_value_t *pvalues[FIO_KV_HOTKEYS_BATCH];
+
+	size_t length = 0;
+	char *manifest = _fio_kv_hotkeys_read(hotkeys->path, &length);
+	char *arena = manifest != NULL
+		? (char *)fio_kv_alloc(FIO_KV_HOTKEYS_ARENA_SIZE)
+		: NULL;
+	if (arena == NULL) {
+		free(manifest);
+		return NULL;
+	}
+
+	for (uint32_t i=0; i<FIO_KV_HOTKEYS_BATCH; i++) {
+		pkeys[i] = &keys[i];
+		pvalues[i] = &values[i];
+	}
+
+	const fio_kv_hotkeys_header_t *header =
+		(const fio_kv_hotkeys_header_t *)manifest;
+	size_t offset = sizeof(fio_kv_hotkeys_header_t);
+	uint32_t count = 0;
+	uint32_t used = 0;
+	uint32_t pool_id = 0;
+
+	for (uint32_t i=0; i<header->count && !hotkeys->stopping; i++) {
+		fio_kv_hotkeys_entry_t entry;
+		if (offset + sizeof(entry) > length) {
+			break;
+		}
+
+		memcpy(&entry, manifest + offset, sizeof(entry));
+		char *key = manifest + offset + sizeof(entry);
+		offset += sizeof(entry) + entry.key_len;
+		if (offset > length || entry.pool_id >= FIO_KV_MAX_POOLS ||
+				entry.key_len < 1 || entry.value_len > NVM_KV_MAX_VALUE_SIZE) {
+			break;
+		}
+
+		// Values are read into buffers a sector larger than they were, so
+		// that values read in full can be told apart.
+		uint32_t capacity = (entry.value_len / FIO_SECTOR_ALIGNMENT + 1) *
+			FIO_SECTOR_ALIGNMENT;
+		if (capacity > NVM_KV_MAX_VALUE_SIZE) {
+			capacity = NVM_KV_MAX_VALUE_SIZE;
+		}
+
+		if (count > 0 && (entry.pool_id != pool_id ||
+				count == FIO_KV_HOTKEYS_BATCH ||
+				used + capacity > FIO_KV_HOTKEYS_ARENA_SIZE)) {
+			_fio_kv_hotkeys_prefetch_batch(store, pool_id, pkeys, pvalues,
+					count);
+			count = 0;
+			used = 0;
+		}
+
+		uint64_t epoch;
+		if (entry.flags != _fio_kv_hotkeys_flags(store, entry.pool_id) ||
+				fio_kv_cache_contains(store->cache, entry.pool_id, key,
+					entry.key_len, &epoch)) {
+			continue;
+		}
+
+		pool_id = entry.pool_id;
+		keys[count].length = entry.key_len;
+		keys[count].bytes = (nvm_kv_key_t *)key;
+		memset(&info[count], 0, sizeof(nvm_kv_key_info_t));
+		info[count].value_len = capacity;
+		values[count].data = arena + used;
+		values[count].info = &info[count];
+		used += capacity;
+		count++;
+	}
+
+	if (count > 0 && !hotkeys->stopping) {
+		_fio_kv_hotkeys_prefetch_batch(store, pool_id, pkeys, pvalues, count);
+	}
+
+	fio_kv_slab_free(arena);
+	free(manifest);
+	return NULL;
+}
+
+/**
+ * Enable the hot key manifest of a store. The keys of the existing manifest
+ * are only prefetched once fio_kv_hotkeys_prefetch() is called.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a read cache.
+ *	path (char *): The path of the manifest file.
+ *	max_keys (uint32_t): The maximum number of keys of the manifest.
+ * Returns:
+ *	Returns the hot key manifest, or NULL if an error occurred. A manifest
+ *	  that doesn't exist or can't be read is not an error.
+ */
+fio_kv_hotkeys_t *fio_kv_hotkeys_create(fio_kv_store_t *store,
+		const char *path, const uint32_t max_keys)
+{
+	assert(store != NULL);
+	assert(store->cache != NULL);
+	assert(path != NULL);
+
+	fio_kv_hotkeys_t *hotkeys = (fio_kv_hotkeys_t *)calloc(1,
+			sizeof(fio_kv_hotkeys_t));
+	if (hotkeys == NULL) {
+		return NULL;
+	}
+
+	size_t length = strlen(path);
+	hotkeys->path = (char *)malloc(length + 1);
+	if (hotkeys->path == NULL) {
+		free(hotkeys);
+		return NULL;
+	}
+	memcpy(hotkeys->path, path, length + 1);
+
+	hotkeys->store = store;
+	hotkeys->max_keys = max_keys;
+	hotkeys->prefetching = false;
+	hotkeys->stopping = 0;
+	return hotkeys;
+}
+
+/**
+ * Start prefetching the keys of the existing manifest, if any, into the
+ * store's read cache, in a background thread.
+ *
+ * Keys of compressed or packed pools are only prefetched if their pool is
+ * configured as it was when the manifest was saved, so the prefetch should
+ * only be started once the pools of the store are configured.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ * Returns:
+ *	Returns true if the prefetch was started or if there is no manifest to
+ *	  prefetch, false otherwise, with errno set to EALREADY if the prefetch
+ *	  was already started.
+ */
+bool fio_kv_hotkeys_prefetch(fio_kv_hotkeys_t *hotkeys)
+{
+	assert(hotkeys != NULL);
+
+	if (hotkeys->prefetching) {
+		errno = EALREADY;
+		return false;
+	}
+
+	// Without a prefetch thread, the cache just warms up on its own.
+	hotkeys->prefetching = access(hotkeys->path, R_OK) == 0 &&
+		pthread_create(&hotkeys->thread, NULL, _fio_kv_hotkeys_run,
+			hotkeys) == 0;
+	return true;
+}
+
+/**
+ * Save the hot keys of a store's read cache to its manifest file.
+ *
+ * The keys of the values read since the last pass of the cache's eviction
+ * hand come first, followed by the rest of the cached keys, up to the
+ * manifest's maximum number of keys. The file is written under a temporary
+ * name and renamed over the previous manifest once synced.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ * Returns:
+ *	Returns true if the manifest was saved, false otherwise.
+ */
+bool fio_kv_hotkeys_save(fio_kv_hotkeys_t *hotkeys)
+{
+	assert(hotkeys != NULL);
+	assert(hotkeys->store->cache != NULL);
+
+	_fio_kv_hotkeys_collect_t collect;
+	memset(&collect, 0, sizeof(collect));
+	collect.store = hotkeys->store;
+	collect.max_keys = hotkeys->max_keys;
+	fio_kv_cache_visit(hotkeys->store->cache, true, _fio_kv_hotkeys_collect,
+			&collect);
+	fio_kv_cache_visit(hotkeys->store->cache, false, _fio_kv_hotkeys_collect,
+			&collect);
+
+	size_t length = strlen(hotkeys->path);
+	char *tmp = (char *)malloc(length + 5);
+	if (tmp == NULL) {
+		free(collect.buffer);
+		return false;
+	}
+	memcpy(tmp, hotkeys->path, length);
+	memcpy(tmp + length, ".tmp", 5);
+
+	FILE *f = fopen(tmp, "wb");
+	if (f == NULL) {
+		free(collect.buffer);
+		free(tmp);
+		return false;
+	}
+
+	bool ret = _fio_kv_hotkeys_write(&collect, f) &&
+		fflush(f) == 0 &&
+		fsync(fileno(f)) == 0;
+	ret = fclose(f) == 0 && ret;
+	ret = ret && rename(tmp, hotkeys->path) == 0;
+
+	if (!ret) {
+		unlink(tmp);
+	}
+
+	free(collect.buffer);
+	free(tmp);
+	return ret;
+}
+
+/**
+ * Stop the prefetch of a hot key manifest, if it is still running, and
+ * release it.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ */
+void fio_kv_hotkeys_destroy(fio_kv_hotkeys_t *hotkeys)
+{
+	if (hotkeys == NULL) {
+		return;
+	}
+
+	if (hotkeys->prefetching) {
+		__sync_lock_test_and_set(&hotkeys->stopping, 1);
+		pthread_join(hotkeys->thread, NULL);
+	}
+
+	free(hotkeys->path);
+	free(hotkeys);
+}
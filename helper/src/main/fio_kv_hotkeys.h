@@ -0,0 +1,151 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_HOTKEYS_H__
+#define __FIO_KV_HOTKEYS_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "fio_kv_helper.h"
+
+/**
+ * Number of keys of the batch reads prefetching the hot keys of a
+ * manifest, and the size of the memory their values are read into.
+ */
+#define FIO_KV_HOTKEYS_BATCH				64
+#define FIO_KV_HOTKEYS_ARENA_SIZE			(2 * 1024 * 1024)
+
+/** Magic number of hot key manifests ('fioh'). */
+#define FIO_KV_HOTKEYS_MAGIC				0x66696f68
+#define FIO_KV_HOTKEYS_VERSION				2
+
+/**
+ * Configuration of the pool of a hot key when the manifest was saved. Keys
+ * are only prefetched if their pool is configured the same way, so that
+ * values of pools not yet configured are not cached as stored.
+ */
+#define FIO_KV_HOTKEYS_COMPRESSED			0x01
+#define FIO_KV_HOTKEYS_PACKED				0x02
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Header of a hot key manifest file. It is followed by count entries, each
+ * made of a fio_kv_hotkeys_entry_t and of the key's bytes, grouped by pool.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t reserved;
+} fio_kv_hotkeys_header_t;
+
+typedef struct {
+	uint32_t pool_id;
+	uint32_t value_len;
+	uint8_t key_len;
+	uint8_t flags;
+	uint16_t reserved;
+} fio_kv_hotkeys_entry_t;
+
+struct _fio_kv_hotkeys {
+	fio_kv_store_t *store;
+	char *path;
+	uint32_t max_keys;
+	pthread_t thread;
+	bool prefetching;
+	volatile int stopping;
+};
+
+
+/**
+ * Enable the hot key manifest of a store. The keys of the existing manifest
+ * are only prefetched once fio_kv_hotkeys_prefetch() is called.
+ *
+ * Args:
+ *	store (fio_kv_store_t *): The key/value store, with a read cache.
+ *	path (char *): The path of the manifest file.
+ *	max_keys (uint32_t): The maximum number of keys of the manifest.
+ * Returns:
+ *	Returns the hot key manifest, or NULL if an error occurred. A manifest
+ *	  that doesn't exist or can't be read is not an error.
+ */
+fio_kv_hotkeys_t *fio_kv_hotkeys_create(fio_kv_store_t *store,
+		const char *path, const uint32_t max_keys);
+
+/**
+ * Start prefetching the keys of the existing manifest, if any, into the
+ * store's read cache, in a background thread.
+ *
+ * Keys of compressed or packed pools are only prefetched if their pool is
+ * configured as it was when the manifest was saved, so the prefetch should
+ * only be started once the pools of the store are configured.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ * Returns:
+ *	Returns true if the prefetch was started or if there is no manifest to
+ *	  prefetch, false otherwise, with errno set to EALREADY if the prefetch
+ *	  was already started.
+ */
+bool fio_kv_hotkeys_prefetch(fio_kv_hotkeys_t *hotkeys);
+
+/**
+ * Save the hot keys of a store's read cache to its manifest file.
+ *
+ * The keys of the values read since the last pass of the cache's eviction
+ * hand come first, followed by the rest of the cached keys, up to the
+ * manifest's maximum number of keys. The file is written under a temporary
+ * name and renamed over the previous manifest once synced.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ * Returns:
+ *	Returns true if the manifest was saved, false otherwise.
+ */
+bool fio_kv_hotkeys_save(fio_kv_hotkeys_t *hotkeys);
+
+/**
+ * Stop the prefetch of a hot key manifest, if it is still running, and
+ * release it.
+ *
+ * Args:
+ *	hotkeys (fio_kv_hotkeys_t *): The hot key manifest.
+ */
+void fio_kv_hotkeys_destroy(fio_kv_hotkeys_t *hotkeys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_HOTKEYS_H__ */
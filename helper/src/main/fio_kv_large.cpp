@@ -0,0 +1,549 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_large.h"
+
+/**
+ * Chunked large values.
+ *
+ * directKV caps values to NVM_KV_MAX_VALUE_SIZE bytes. Larger values are
+ * stored as a set of chunks, each under the value's key followed by a marker
+ * byte, the value's generation and the chunk's index, and a manifest stored
+ * under the value's key giving the value's length, number of chunks and
+ * generation. Each write of a key uses the next generation, so that its
+ * chunks never overwrite those of the value readers may still be reading,
+ * which are removed once the new manifest is in place. All the chunks but the
+ * last one are FIO_KV_LARGE_CHUNK_SIZE bytes, a multiple of the sector size,
+ * so that each chunk can be transferred directly from or to its position in
+ * the value's contiguous, sector-aligned buffer.
+ *
+ * The chunks are transferred in slices of FIO_KV_LARGE_SLICE chunks, each
+ * with one batch operation; the slices are picked up by the calling thread
+ * and up to FIO_KV_LARGE_THREADS - 1 helper threads, to keep several batches
+ * in flight on the device.
+ */
+
+
+typedef struct {
+	const fio_kv_pool_t *pool;
+	bool put;
+	const fio_kv_key_t **keys;
+	const fio_kv_value_t **values;
+	size_t count;
+	size_t next;
+	int error;
+} _fio_kv_large_io_t;
+
+typedef struct {
+	size_t count;
+	uint8_t *bytes;
+	fio_kv_key_t *keys;
+	const fio_kv_key_t **pkeys;
+	nvm_kv_key_info_t *info;
+	fio_kv_value_t *values;
+	const fio_kv_value_t **pvalues;
+} _fio_kv_large_chunks_t;
+
+/**
+ * Release the chunk descriptors of a large value.
+ */
+void _fio_kv_large_free_chunks(_fio_kv_large_chunks_t *chunks)
+{
+	free(chunks->bytes);
+	free(chunks->keys);
+	free(chunks->pkeys);
+	free(chunks->info);
+	free(chunks->values);
+	free(chunks->pvalues);
+	memset(chunks, 0, sizeof(_fio_kv_large_chunks_t));
+}
+
+/**
+ * Build the keys of chunks [first, first + count) of the given generation of
+ * the large value of a key and, if data is not NULL, their value structures
+ * pointing to their position in data.
+ *
+ * Args:
+ *	key (fio_kv_key_t *): The key of the large value.
+ *	generation (uint32_t): The generation of the large value.
+ *	first (uint32_t): The index of the first chunk.
+ *	count (size_t): The number of chunks.
+ *	data (void *): The value's buffer, or NULL for keys only.
+ *	length (uint64_t): The size of the value's buffer.
+ *	chunks (_fio_kv_large_chunks_t *): The chunk descriptors to fill in.
+ * Returns:
+ *	Returns true on success, false with errno set to ENOMEM otherwise.
+ */
+bool _fio_kv_large_chunks(const fio_kv_key_t *key, const uint32_t generation,
+		const uint32_t first, const size_t count, void *data,
+		const uint64_t length, _fio_kv_large_chunks_t *chunks)
+{
+	uint32_t key_len = key->length + FIO_KV_LARGE_KEY_SUFFIX;
+	size_t n = count > 0 ? count : 1;
+
+	memset(chunks, 0, sizeof(_fio_kv_large_chunks_t));
+	chunks->count = count;
+	chunks->bytes = (uint8_t *)malloc(n * key_len);
+	chunks->keys = (fio_kv_key_t *)malloc(n * sizeof(fio_kv_key_t));
+	chunks->pkeys = (const fio_kv_key_t **)malloc(n * sizeof(fio_kv_key_t *));
+	if (data != NULL) {
+		chunks->info = (nvm_kv_key_info_t *)calloc(n,
+				sizeof(nvm_kv_key_info_t));
+		chunks->values = (fio_kv_value_t *)malloc(n * sizeof(fio_kv_value_t));
+		chunks->pvalues = (const fio_kv_value_t **)malloc(
+				n * sizeof(fio_kv_value_t *));
+	}
+
+	if (chunks->bytes == NULL || chunks->keys == NULL ||
+			chunks->pkeys == NULL || (data != NULL &&
+				(chunks->info == NULL || chunks->values == NULL ||
+				 chunks->pvalues == NULL))) {
+		_fio_kv_large_free_chunks(chunks);
+		errno = ENOMEM;
+		return false;
+	}
+
+	for (size_t i=0; i<count; i++) {
+		uint32_t index = first + (uint32_t)i;
+		uint8_t *bytes = chunks->bytes + i * key_len;
+		memcpy(bytes, key->bytes, key->length);
+		bytes[key->length] = 0xff;
+		bytes[key->length + 1] = (uint8_t)(generation >> 24);
+		bytes[key->length + 2] = (uint8_t)(generation >> 16);
+		bytes[key->length + 3] = (uint8_t)(generation >> 8);
+		bytes[key->length + 4] = (uint8_t)generation;
+		bytes[key->length + 5] = (uint8_t)(index >> 24);
+		bytes[key->length + 6] = (uint8_t)(index >> 16);
+		bytes[key->length + 7] = (uint8_t)(index >> 8);
+		bytes[key->length + 8] = (uint8_t)index;
+
+		chunks->keys[i].length = key_len;
+		chunks->keys[i].bytes = (nvm_kv_key_t *)bytes;
+		chunks->pkeys[i] = &chunks->keys[i];
+
+		if (data == NULL) {
+			continue;
+		}
+
+		uint64_t offset = (uint64_t)index * FIO_KV_LARGE_CHUNK_SIZE;
+		uint64_t size = length - offset;
+		if (size > FIO_KV_LARGE_CHUNK_SIZE) {
+			size = FIO_KV_LARGE_CHUNK_SIZE;
+		}
+
+		chunks->info[i].value_len = (uint32_t)size;
+		chunks->values[i].data = (char *)data + offset;
+		chunks->values[i].info = &chunks->info[i];
+		chunks->pvalues[i] = &chunks->values[i];
+	}
+
+	return true;
+}
+
+/**
+ * Transfer slices of chunks until all of them have been picked up or one
+ * failed.
+ */
+void *_fio_kv_large_worker(void *arg)
+{
+	_fio_kv_large_io_t *io = (_fio_kv_large_io_t *)arg;
+
+	while (io->error == 0) {
+		size_t first = __sync_fetch_and_add(&io->next, FIO_KV_LARGE_SLICE);
+		if (first >= io->count) {
+			break;
+		}
+
+		size_t count = io->count - first;
+		if (count > FIO_KV_LARGE_SLICE) {
+			count = FIO_KV_LARGE_SLICE;
+		}
+
+		errno = 0;
+		bool done = io->put
+			? fio_kv_batch_put(io->pool, io->keys + first, io->values + first,
+					count)
+			: fio_kv_batch_get(io->pool, io->keys + first, io->values + first,
+					count);
+		if (!done) {
+			__sync_bool_compare_and_swap(&io->error, 0,
+					errno != 0 ? errno : EIO);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Transfer all the chunks of a large value, from the calling thread and as
+ * many helper threads as there are slices to keep busy, up to
+ * FIO_KV_LARGE_THREADS threads in total.
+ *
+ * Returns:
+ *	Returns true if all the chunks were transferred, false otherwise with
+ *	  errno set.
+ */
+bool _fio_kv_large_transfer(const fio_kv_pool_t *pool, const bool put,
+		_fio_kv_large_chunks_t *chunks)
+{
+	_fio_kv_large_io_t io;
+	pthread_t threads[FIO_KV_LARGE_THREADS - 1];
+	size_t slices = (chunks->count + FIO_KV_LARGE_SLICE - 1) /
+		FIO_KV_LARGE_SLICE;
+	size_t helpers = 0;
+
+	io.pool = pool;
+	io.put = put;
+	io.keys = chunks->pkeys;
+	io.values = chunks->pvalues;
+	io.count = chunks->count;
+	io.next = 0;
+	io.error = 0;
+
+	// The calling thread does the work of the helpers that can't be started.
+	while (helpers + 1 < slices && helpers < FIO_KV_LARGE_THREADS - 1 &&
+			pthread_create(&threads[helpers], NULL, _fio_kv_large_worker,
+				&io) == 0) {
+		helpers++;
+	}
+
+	_fio_kv_large_worker(&io);
+	for (size_t i=0; i<helpers; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	if (io.error != 0) {
+		errno = io.error;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Read the manifest of the large value of a key.
+ *
+ * Returns:
+ *	Returns true if the key holds a large value, false otherwise with errno
+ *	  set to ENOENT if it doesn't exist, or to EINVAL if its value is not a
+ *	  large value manifest.
+ */
+bool _fio_kv_large_manifest(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, fio_kv_large_manifest_t *manifest)
+{
+	nvm_kv_key_info_t info;
+	fio_kv_value_t value;
+
+	memset(&info, 0, sizeof(info));
+	info.value_len = FIO_SECTOR_ALIGNMENT;
+	value.info = &info;
+	value.data = fio_kv_alloc(FIO_SECTOR_ALIGNMENT);
+	if (value.data == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	int ret = fio_kv_get(pool, key, &value);
+	if (ret == sizeof(fio_kv_large_manifest_t)) {
+		memcpy(manifest, value.data, sizeof(fio_kv_large_manifest_t));
+	}
+	fio_kv_free_value(&value);
+
+	if (ret < 0) {
+		return false;
+	}
+
+	if (ret != sizeof(fio_kv_large_manifest_t) ||
+			manifest->magic != FIO_KV_LARGE_MAGIC ||
+			manifest->chunk_size != FIO_KV_LARGE_CHUNK_SIZE ||
+			manifest->chunks != (manifest->length +
+				FIO_KV_LARGE_CHUNK_SIZE - 1) / FIO_KV_LARGE_CHUNK_SIZE) {
+		errno = EINVAL;
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Remove chunks [first, last) of the given generation of the large value of
+ * a key.
+ */
+bool _fio_kv_large_delete_chunks(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const uint32_t generation,
+		const uint32_t first, const uint32_t last)
+{
+	_fio_kv_large_chunks_t chunks;
+	if (first >= last) {
+		return true;
+	}
+
+	if (!_fio_kv_large_chunks(key, generation, first, last - first, NULL, 0,
+				&chunks)) {
+		return false;
+	}
+
+	size_t done = fio_kv_batch_delete(pool, chunks.pkeys, chunks.count);
+	_fio_kv_large_free_chunks(&chunks);
+	return done == last - first;
+}
+
+/**
+ * Remove the chunks of a generation that could not be published, keeping the
+ * errno of the failure.
+ */
+void _fio_kv_large_discard(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key, const uint32_t generation,
+		const uint32_t count)
+{
+	int error = errno;
+	_fio_kv_large_delete_chunks(pool, key, generation, 0, count);
+	errno = error;
+}
+
+/**
+ * Write a large value, of any size, under the given key.
+ *
+ * The value is split in chunks of FIO_KV_LARGE_CHUNK_SIZE bytes, stored
+ * under keys derived from the value's key, and a manifest describing them is
+ * stored under the key itself once all the chunks have been written. The
+ * chunks are written with batch puts executed by up to FIO_KV_LARGE_THREADS
+ * threads in parallel.
+ *
+ * The chunks are keyed by a generation number, one more than the previous
+ * value's, which the manifest records. The previous value's chunks are only
+ * removed once the new manifest is written, so readers get either the
+ * previous value or the new one; a reader still reading the previous chunks
+ * when they are removed fails instead of mixing both values. Concurrent
+ * writes of the same key are not serialized.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key, at most NVM_KV_MAX_KEY_SIZE -
+ *	  FIO_KV_LARGE_KEY_SUFFIX bytes long.
+ *	data (void *): The sector-aligned value data.
+ *	length (uint64_t): The value length, in bytes.
+ *	expiry (uint32_t): The expiry of the value, for arbitrary expiry stores.
+ * Returns:
+ *	Returns true if the value was written, false otherwise with errno set.
+ */
+bool fio_kv_put_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *data, const uint64_t length, const uint32_t expiry)
+{
+	assert(pool != NULL);
+	assert(key != NULL);
+	assert(data != NULL);
+	assert(((uintptr_t)data % FIO_SECTOR_ALIGNMENT) == 0);
+
+	uint64_t count = (length + FIO_KV_LARGE_CHUNK_SIZE - 1) /
+		FIO_KV_LARGE_CHUNK_SIZE;
+	if (key->length > NVM_KV_MAX_KEY_SIZE - FIO_KV_LARGE_KEY_SUFFIX ||
+			count > (uint32_t)-1) {
+		errno = EINVAL;
+		return false;
+	}
+
+	fio_kv_large_manifest_t previous;
+	bool replacing = _fio_kv_large_manifest(pool, key, &previous);
+	uint32_t generation = replacing ? previous.generation + 1 : 0;
+
+	_fio_kv_large_chunks_t chunks;
+	if (!_fio_kv_large_chunks(key, generation, 0, (size_t)count, data,
+				length, &chunks)) {
+		return false;
+	}
+
+	for (size_t i=0; i<chunks.count; i++) {
+		chunks.info[i].expiry = expiry;
+	}
+
+	bool ret = _fio_kv_large_transfer(pool, true, &chunks);
+	_fio_kv_large_free_chunks(&chunks);
+	if (!ret) {
+		_fio_kv_large_discard(pool, key, generation, (uint32_t)count);
+		return false;
+	}
+
+	nvm_kv_key_info_t info;
+	fio_kv_value_t value;
+	fio_kv_large_manifest_t manifest;
+
+	memset(&manifest, 0, sizeof(manifest));
+	manifest.magic = FIO_KV_LARGE_MAGIC;
+	manifest.chunk_size = FIO_KV_LARGE_CHUNK_SIZE;
+	manifest.length = length;
+	manifest.chunks = (uint32_t)count;
+	manifest.generation = generation;
+
+	memset(&info, 0, sizeof(info));
+	info.value_len = sizeof(manifest);
+	info.expiry = expiry;
+	value.info = &info;
+	value.data = fio_kv_alloc(sizeof(manifest));
+	if (value.data == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+
+	memcpy(value.data, &manifest, sizeof(manifest));
+	ret = fio_kv_put(pool, key, &value) == (int)sizeof(manifest);
+	fio_kv_free_value(&value);
+	if (!ret) {
+		_fio_kv_large_discard(pool, key, generation, manifest.chunks);
+		return false;
+	}
+
+	return !replacing || _fio_kv_large_delete_chunks(pool, key,
+			previous.generation, 0, previous.chunks);
+}
+
+/**
+ * Return the length of the large value stored under a key, from its
+ * manifest.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns the value length, or -1 with errno set to ENOENT if the key
+ *	  doesn't exist or to EINVAL if its value is not a large value.
+ */
+int64_t fio_kv_get_large_len(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key)
+{
+	assert(pool != NULL);
+	assert(key != NULL);
+
+	fio_kv_large_manifest_t manifest;
+	if (!_fio_kv_large_manifest(pool, key, &manifest)) {
+		return -1;
+	}
+
+	return (int64_t)manifest.length;
+}
+
+/**
+ * Read a large value into a contiguous buffer.
+ *
+ * The chunks listed by the key's manifest are read with batch gets executed
+ * by up to FIO_KV_LARGE_THREADS threads in parallel, each directly at its
+ * position in the buffer.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	buffer (void *): Sector-aligned memory, as allocated by fio_kv_alloc(),
+ *	  to read the value into.
+ *	capacity (uint64_t): The size of the buffer, in bytes.
+ * Returns:
+ *	Returns the value length, or -1 in case of an error with errno set. In
+ *	  particular, errno is set to ENOBUFS if the value doesn't fit in the
+ *	  buffer, to EIO if a chunk doesn't match the manifest, and to ENOENT if
+ *	  the value was replaced or removed while being read.
+ */
+int64_t fio_kv_get_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *buffer, const uint64_t capacity)
+{
+	assert(pool != NULL);
+	assert(key != NULL);
+	assert(buffer != NULL);
+	assert(((uintptr_t)buffer % FIO_SECTOR_ALIGNMENT) == 0);
+
+	fio_kv_large_manifest_t manifest;
+	if (!_fio_kv_large_manifest(pool, key, &manifest)) {
+		return -1;
+	}
+
+	if (manifest.length > capacity) {
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	// Each chunk may use the rest of the buffer, so that the device can
+	// transfer the last one in whole sectors.
+	_fio_kv_large_chunks_t chunks;
+	if (!_fio_kv_large_chunks(key, manifest.generation, 0, manifest.chunks,
+				buffer, capacity, &chunks)) {
+		return -1;
+	}
+
+	bool ret = _fio_kv_large_transfer(pool, false, &chunks);
+	for (size_t i=0; ret && i<chunks.count; i++) {
+		uint64_t expected = manifest.length - i * FIO_KV_LARGE_CHUNK_SIZE;
+		if (expected > FIO_KV_LARGE_CHUNK_SIZE) {
+			expected = FIO_KV_LARGE_CHUNK_SIZE;
+		}
+
+		if (chunks.info[i].value_len != expected) {
+			errno = EIO;
+			ret = false;
+		}
+	}
+
+	_fio_kv_large_free_chunks(&chunks);
+	return ret ? (int64_t)manifest.length : -1;
+}
+
+/**
+ * Remove a large value.
+ *
+ * The manifest is removed first, so the value is gone for readers before its
+ * chunks are removed. A key that doesn't hold a large value is removed like
+ * with fio_kv_delete().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns true if the value was removed, false otherwise.
+ */
+bool fio_kv_delete_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key)
+{
+	assert(pool != NULL);
+	assert(key != NULL);
+
+	fio_kv_large_manifest_t manifest;
+	uint32_t count = _fio_kv_large_manifest(pool, key, &manifest)
+		? manifest.chunks : 0;
+
+	if (!fio_kv_delete(pool, key)) {
+		return false;
+	}
+
+	return count == 0 || _fio_kv_large_delete_chunks(pool, key,
+			manifest.generation, 0, count);
+}
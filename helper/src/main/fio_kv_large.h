@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_LARGE_H__
+#define __FIO_KV_LARGE_H__
+
+#include "fio_kv_helper.h"
+
+/**
+ * Size of the chunks large values are split into, the number of chunks read
+ * or written by each batch operation, and the maximum number of threads
+ * executing these batches in parallel for one value.
+ */
+#define FIO_KV_LARGE_CHUNK_SIZE				(512 * 1024)
+#define FIO_KV_LARGE_SLICE					4
+#define FIO_KV_LARGE_THREADS				4
+
+/**
+ * Number of bytes appended to a large value's key to derive the keys of its
+ * chunks: a marker byte, the value's generation and the chunk index, both in
+ * big-endian order.
+ */
+#define FIO_KV_LARGE_KEY_SUFFIX				9
+
+/** Magic number of large value manifests ('fiol'). */
+#define FIO_KV_LARGE_MAGIC					0x66696f6c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	uint32_t magic;
+	uint32_t chunk_size;
+	uint64_t length;
+	uint32_t chunks;
+	uint32_t generation;
+} fio_kv_large_manifest_t;
+
+
+/**
+ * Write a large value, of any size, under the given key.
+ *
+ * The value is split in chunks of FIO_KV_LARGE_CHUNK_SIZE bytes, stored
+ * under keys derived from the value's key, and a manifest describing them is
+ * stored under the key itself once all the chunks have been written. The
+ * chunks are written with batch puts executed by up to FIO_KV_LARGE_THREADS
+ * threads in parallel.
+ *
+ * The chunks are keyed by a generation number, one more than the previous
+ * value's, which the manifest records. The previous value's chunks are only
+ * removed once the new manifest is written, so readers get either the
+ * previous value or the new one; a reader still reading the previous chunks
+ * when they are removed fails instead of mixing both values. Concurrent
+ * writes of the same key are not serialized.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key, at most NVM_KV_MAX_KEY_SIZE -
+ *	  FIO_KV_LARGE_KEY_SUFFIX bytes long.
+ *	data (void *): The sector-aligned value data.
+ *	length (uint64_t): The value length, in bytes.
+ *	expiry (uint32_t): The expiry of the value, for arbitrary expiry stores.
+ * Returns:
+ *	Returns true if the value was written, false otherwise with errno set.
+ */
+bool fio_kv_put_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *data, const uint64_t length, const uint32_t expiry);
+
+/**
+ * Return the length of the large value stored under a key, from its
+ * manifest.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns the value length, or -1 with errno set to ENOENT if the key
+ *	  doesn't exist or to EINVAL if its value is not a large value.
+ */
+int64_t fio_kv_get_large_len(const fio_kv_pool_t *pool,
+		const fio_kv_key_t *key);
+
+/**
+ * Read a large value into a contiguous buffer.
+ *
+ * The chunks listed by the key's manifest are read with batch gets executed
+ * by up to FIO_KV_LARGE_THREADS threads in parallel, each directly at its
+ * position in the buffer.
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ *	buffer (void *): Sector-aligned memory, as allocated by fio_kv_alloc(),
+ *	  to read the value into.
+ *	capacity (uint64_t): The size of the buffer, in bytes.
+ * Returns:
+ *	Returns the value length, or -1 in case of an error with errno set. In
+ *	  particular, errno is set to ENOBUFS if the value doesn't fit in the
+ *	  buffer, to EIO if a chunk doesn't match the manifest, and to ENOENT if
+ *	  the value was replaced or removed while being read.
+ */
+int64_t fio_kv_get_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key,
+		void *buffer, const uint64_t capacity);
+
+/**
+ * Remove a large value.
+ *
+ * The manifest is removed first, so the value is gone for readers before its
+ * chunks are removed. A key that doesn't hold a large value is removed like
+ * with fio_kv_delete().
+ *
+ * Args:
+ *	pool (fio_kv_pool_t *): The key/value pool.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns true if the value was removed, false otherwise.
+ */
+bool fio_kv_delete_large(const fio_kv_pool_t *pool, const fio_kv_key_t *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_LARGE_H__ */
@@ -0,0 +1,294 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * No-op directKV backend.
+ *
+ * When the helper library is built with FIO_KV_NOOP defined (see the noop
+ * Maven profile), this file provides the nvm_kv_*() functions in place of
+ * FusionIO's nvmkv library. Nothing is read from or written to the device:
+ * writes are acknowledged and discarded, every key exists with the length of
+ * the last value written, reads leave the caller's buffer untouched, and
+ * iterations go over FIO_KV_NOOP_RECORDS synthetic keys. Only pools are
+ * tracked, so that they can be created and listed as usual.
+ *
+ * This makes it possible to measure the cost of the JNI crossings and of the
+ * marshalling done by the helper library and the Java binding in isolation,
+ * without a FusionIO device. Read caching, Bloom filters and value
+ * compression work on top of it, but packed pools, which need to read back
+ * what they wrote, do not.
+ */
+
+#ifdef FIO_KV_NOOP
+
+#include <pthread.h>
+#include <string.h>
+
+#include <nvm/nvm_kv.h>
+
+#ifndef FIO_KV_NOOP_RECORDS
+#define FIO_KV_NOOP_RECORDS			1024
+#endif
+
+#define FIO_KV_NOOP_MAX_POOLS		1024
+#define FIO_KV_NOOP_VALUE_LEN		512
+
+static pthread_mutex_t _fio_kv_noop_lock = PTHREAD_MUTEX_INITIALIZER;
+static nvm_kv_pool_tag_t _fio_kv_noop_pools[FIO_KV_NOOP_MAX_POOLS];
+static bool _fio_kv_noop_live[FIO_KV_NOOP_MAX_POOLS];
+static uint32_t _fio_kv_noop_pool_count = 0;
+static uint32_t _fio_kv_noop_expiry = 0;
+static uint32_t _fio_kv_noop_value_len = FIO_KV_NOOP_VALUE_LEN;
+static uint32_t _fio_kv_noop_positions[NVM_KV_MAX_ITERATORS];
+static int _fio_kv_noop_iterator_pools[NVM_KV_MAX_ITERATORS];
+static bool _fio_kv_noop_iterators[NVM_KV_MAX_ITERATORS];
+
+
+/**
+ * Fill in the key information of a synthetic key/value pair.
+ */
+void _fio_kv_noop_info(const int pool_id, const uint32_t key_len,
+		nvm_kv_key_info_t *info)
+{
+	if (info == NULL) {
+		return;
+	}
+
+	memset(info, 0, sizeof(nvm_kv_key_info_t));
+	info->pool_id = pool_id;
+	info->key_len = key_len;
+	info->value_len = _fio_kv_noop_value_len;
+}
+
+int64_t nvm_kv_open(int id, uint32_t version, uint32_t max_pools,
+		uint32_t expiry)
+{
+	_fio_kv_noop_expiry = expiry;
+	return id + 1;
+}
+
+int nvm_kv_close(int64_t kv_id)
+{
+	return 0;
+}
+
+int nvm_kv_set_global_expiry(int64_t kv_id, uint32_t expiry)
+{
+	return 0;
+}
+
+int nvm_kv_get_store_info(int64_t kv_id, nvm_kv_store_info_t *info)
+{
+	memset(info, 0, sizeof(nvm_kv_store_info_t));
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	for (uint32_t i = 0; i < _fio_kv_noop_pool_count; i++) {
+		info->num_pools += _fio_kv_noop_live[i];
+	}
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	info->max_pools = NVM_KV_MAX_POOLS;
+	info->expiry_mode = _fio_kv_noop_expiry;
+	return 0;
+}
+
+int nvm_kv_pool_create(int64_t kv_id, nvm_kv_pool_tag_t *tag)
+{
+	int ret = -1;
+
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	for (uint32_t i = 0; i < _fio_kv_noop_pool_count && ret < 0; i++) {
+		if (_fio_kv_noop_live[i] &&
+				strncmp((const char *)_fio_kv_noop_pools[i].pool_tag,
+					(const char *)tag->pool_tag,
+					NVM_KV_MAX_POOL_TAG_SIZE) == 0) {
+			ret = i + 1;
+		}
+	}
+
+	if (ret < 0 && _fio_kv_noop_pool_count < FIO_KV_NOOP_MAX_POOLS) {
+		memset(&_fio_kv_noop_pools[_fio_kv_noop_pool_count], 0,
+				sizeof(nvm_kv_pool_tag_t));
+		strncpy((char *)_fio_kv_noop_pools[_fio_kv_noop_pool_count].pool_tag,
+				(const char *)tag->pool_tag, NVM_KV_MAX_POOL_TAG_SIZE - 1);
+		_fio_kv_noop_live[_fio_kv_noop_pool_count] = true;
+		ret = ++_fio_kv_noop_pool_count;
+	}
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	return ret;
+}
+
+int nvm_kv_pool_delete(int64_t kv_id, int pool_id)
+{
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	if (pool_id == -1) {
+		_fio_kv_noop_pool_count = 0;
+	} else if (pool_id > 0 && (uint32_t)pool_id <= _fio_kv_noop_pool_count) {
+		_fio_kv_noop_live[pool_id - 1] = false;
+	}
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	return 0;
+}
+
+int nvm_kv_get_pool_metadata(int64_t kv_id, nvm_kv_pool_metadata_t *md,
+		uint32_t count, uint32_t start)
+{
+	uint32_t found = 0;
+
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	for (uint32_t id = start; id <= _fio_kv_noop_pool_count && found < count;
+			id++) {
+		if (id > 0 && _fio_kv_noop_live[id - 1]) {
+			md[found].pool_id = id;
+			md[found].pool_status = 0;
+			md[found].pool_tag = _fio_kv_noop_pools[id - 1];
+			found++;
+		}
+	}
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	return (int)found;
+}
+
+int nvm_kv_get_val_len(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len)
+{
+	return (int)_fio_kv_noop_value_len;
+}
+
+int nvm_kv_get_key_info(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len, nvm_kv_key_info_t *info)
+{
+	_fio_kv_noop_info(pool_id, key_len, info);
+	return 0;
+}
+
+int nvm_kv_get(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len, void *value, uint32_t value_len, bool read_exact,
+		nvm_kv_key_info_t *info)
+{
+	_fio_kv_noop_info(pool_id, key_len, info);
+	return (int)(value_len < _fio_kv_noop_value_len
+		? value_len : _fio_kv_noop_value_len);
+}
+
+int nvm_kv_put(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len, void *value, uint32_t value_len, uint32_t expiry,
+		bool replace, uint32_t gen_count)
+{
+	_fio_kv_noop_value_len = value_len;
+	return (int)value_len;
+}
+
+int nvm_kv_exists(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len, nvm_kv_key_info_t *info)
+{
+	_fio_kv_noop_info(pool_id, key_len, info);
+	return 1;
+}
+
+int nvm_kv_delete(int64_t kv_id, int pool_id, nvm_kv_key_t *key,
+		uint32_t key_len)
+{
+	return 0;
+}
+
+int nvm_kv_delete_all(int64_t kv_id)
+{
+	return 0;
+}
+
+int nvm_kv_batch_put(int64_t kv_id, int pool_id, nvm_kv_iovec_t *iov,
+		uint32_t count)
+{
+	if (count > 0) {
+		_fio_kv_noop_value_len = iov[count - 1].value_len;
+	}
+	return 0;
+}
+
+int nvm_kv_batch_get(int64_t kv_id, int pool_id, nvm_kv_iovec_t *iov,
+		uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		if (iov[i].value_len > _fio_kv_noop_value_len) {
+			iov[i].value_len = _fio_kv_noop_value_len;
+		}
+	}
+	return 0;
+}
+
+int nvm_kv_begin(int64_t kv_id, int pool_id)
+{
+	int ret = -1;
+
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	for (int i = 0; i < NVM_KV_MAX_ITERATORS && ret < 0; i++) {
+		if (!_fio_kv_noop_iterators[i]) {
+			_fio_kv_noop_iterators[i] = true;
+			_fio_kv_noop_positions[i] = 0;
+			_fio_kv_noop_iterator_pools[i] = pool_id;
+			ret = i;
+		}
+	}
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	return ret;
+}
+
+int nvm_kv_next(int64_t kv_id, int it_id)
+{
+	if (_fio_kv_noop_positions[it_id] + 1 >= FIO_KV_NOOP_RECORDS) {
+		return -1;
+	}
+
+	_fio_kv_noop_positions[it_id]++;
+	return 0;
+}
+
+int nvm_kv_get_current(int64_t kv_id, int it_id, nvm_kv_key_t *key,
+		uint32_t *key_len, void *value, uint32_t value_len,
+		nvm_kv_key_info_t *info)
+{
+	uint32_t position = _fio_kv_noop_positions[it_id];
+
+	memcpy(key, &position, sizeof(uint32_t));
+	*key_len = sizeof(uint32_t);
+	_fio_kv_noop_info(_fio_kv_noop_iterator_pools[it_id], *key_len, info);
+	return (int)(value_len < _fio_kv_noop_value_len
+		? value_len : _fio_kv_noop_value_len);
+}
+
+int nvm_kv_iteration_end(int64_t kv_id, int it_id)
+{
+	pthread_mutex_lock(&_fio_kv_noop_lock);
+	_fio_kv_noop_iterators[it_id] = false;
+	pthread_mutex_unlock(&_fio_kv_noop_lock);
+	return 0;
+}
+
+#endif /* FIO_KV_NOOP */
@@ -0,0 +1,349 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_pack.h"
+
+/**
+ * Small-value packing.
+ *
+ * Packed pools store many small logical key/value pairs in shared bucket
+ * records, so that they don't each take a full sector on the device. A
+ * bucket holds the pairs whose key hashes to it, as a fio_kv_pack_bucket_t
+ * header followed by its entries, back to back on 4-byte boundaries: a
+ * fio_kv_pack_entry_t structure, the key bytes and the value bytes. Entries
+ * are unordered; removing one moves the following ones down.
+ */
+
+
+/**
+ * Return the size taken by an entry in a bucket.
+ */
+uint32_t _fio_kv_pack_entry_size(const uint32_t key_len,
+		const uint32_t value_len)
+{
+	return (sizeof(fio_kv_pack_entry_t) + key_len + value_len + 3) & ~3U;
+}
+
+/**
+ * Return the entry at the given offset of a bucket.
+ */
+fio_kv_pack_entry_t *_fio_kv_pack_entry(const void *bucket,
+		const uint32_t offset)
+{
+	return (fio_kv_pack_entry_t *)((char *)bucket + offset);
+}
+
+/**
+ * Remove the entry at the given offset of a bucket.
+ */
+void _fio_kv_pack_erase(void *bucket, const uint32_t offset)
+{
+	fio_kv_pack_bucket_t *header = (fio_kv_pack_bucket_t *)bucket;
+	fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, offset);
+	uint32_t size = _fio_kv_pack_entry_size(entry->key_len, entry->value_len);
+
+	memmove(entry, (char *)entry + size, header->used - offset - size);
+	header->used -= size;
+	header->count--;
+}
+
+/**
+ * Create the packing state of a store.
+ *
+ * Args:
+ *	pool_count (uint32_t): The maximum number of pools of the store.
+ * Returns:
+ *	Returns a newly allocated packing state with no packed pool, or NULL if
+ *	  it could not be allocated.
+ */
+fio_kv_pack_t *fio_kv_pack_create(const uint32_t pool_count)
+{
+	fio_kv_pack_t *pack = (fio_kv_pack_t *)malloc(sizeof(fio_kv_pack_t));
+	if (pack == NULL) {
+		return NULL;
+	}
+
+	pack->buckets = (uint32_t *)calloc(pool_count, sizeof(uint32_t));
+	if (pack->buckets == NULL) {
+		free(pack);
+		return NULL;
+	}
+
+	for (uint32_t i=0; i<FIO_KV_PACK_LOCKS; i++) {
+		pthread_mutex_init(&pack->locks[i], NULL);
+	}
+
+	return pack;
+}
+
+/**
+ * Release the packing state of a store.
+ *
+ * Args:
+ *	pack (fio_kv_pack_t *): The packing state.
+ */
+void fio_kv_pack_destroy(fio_kv_pack_t *pack)
+{
+	assert(pack != NULL);
+
+	for (uint32_t i=0; i<FIO_KV_PACK_LOCKS; i++) {
+		pthread_mutex_destroy(&pack->locks[i]);
+	}
+
+	free(pack->buckets);
+	free(pack);
+}
+
+/**
+ * Hash a logical key with the 32-bit FNV-1a function, to find the bucket it
+ * is packed in.
+ *
+ * Args:
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns the key's 32-bit hash.
+ */
+uint32_t fio_kv_pack_hash(const nvm_kv_key_t *key, const uint32_t key_len)
+{
+	const unsigned char *p = (const unsigned char *)key;
+	uint32_t hash = 2166136261U;
+
+	for (uint32_t i=0; i<key_len; i++) {
+		hash = (hash ^ p[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+/**
+ * Initialize an empty bucket.
+ *
+ * Args:
+ *	bucket (void *): A buffer of FIO_KV_PACK_BUCKET_SIZE bytes.
+ */
+void fio_kv_pack_init(void *bucket)
+{
+	fio_kv_pack_bucket_t *header = (fio_kv_pack_bucket_t *)bucket;
+
+	assert(bucket != NULL);
+
+	header->magic = FIO_KV_PACK_BUCKET_MAGIC;
+	header->count = 0;
+	header->used = sizeof(fio_kv_pack_bucket_t);
+	header->reserved = 0;
+}
+
+/**
+ * Tell whether a record read from the device is a valid bucket.
+ *
+ * Args:
+ *	bucket (void *): The record.
+ *	length (uint32_t): The record's length.
+ * Returns:
+ *	Returns true if the record holds a valid bucket, false otherwise.
+ */
+bool fio_kv_pack_valid(const void *bucket, const uint32_t length)
+{
+	const fio_kv_pack_bucket_t *header = (const fio_kv_pack_bucket_t *)bucket;
+
+	assert(bucket != NULL);
+
+	if (length < sizeof(fio_kv_pack_bucket_t) ||
+			header->magic != FIO_KV_PACK_BUCKET_MAGIC ||
+			header->used != length ||
+			header->used > FIO_KV_PACK_BUCKET_SIZE) {
+		return false;
+	}
+
+	uint32_t offset = sizeof(fio_kv_pack_bucket_t);
+	for (uint32_t i=0; i<header->count; i++) {
+		if (offset + sizeof(fio_kv_pack_entry_t) > header->used) {
+			return false;
+		}
+
+		const fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, offset);
+		offset += _fio_kv_pack_entry_size(entry->key_len, entry->value_len);
+		if (offset > header->used) {
+			return false;
+		}
+	}
+
+	return offset == header->used;
+}
+
+/**
+ * Find the entry of a logical key in a bucket.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	now (uint32_t): The current time, entries expired by then being ignored.
+ * Returns:
+ *	Returns the key's entry, or NULL if the bucket has no live entry for it.
+ */
+const fio_kv_pack_entry_t *fio_kv_pack_find(const void *bucket,
+		const nvm_kv_key_t *key, const uint32_t key_len, const uint32_t now)
+{
+	const fio_kv_pack_bucket_t *header = (const fio_kv_pack_bucket_t *)bucket;
+	uint32_t offset = sizeof(fio_kv_pack_bucket_t);
+
+	assert(bucket != NULL);
+	assert(key != NULL);
+
+	for (uint32_t i=0; i<header->count; i++) {
+		const fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, offset);
+		if (entry->key_len == key_len &&
+				memcmp(entry + 1, key, key_len) == 0) {
+			return entry->expiry == 0 || entry->expiry > now ? entry : NULL;
+		}
+
+		offset += _fio_kv_pack_entry_size(entry->key_len, entry->value_len);
+	}
+
+	return NULL;
+}
+
+/**
+ * Return the value of a bucket entry.
+ *
+ * Args:
+ *	entry (fio_kv_pack_entry_t *): The entry.
+ * Returns:
+ *	Returns a pointer to the entry's value_len bytes of value.
+ */
+const void *fio_kv_pack_value(const fio_kv_pack_entry_t *entry)
+{
+	assert(entry != NULL);
+
+	return (const char *)(entry + 1) + entry->key_len;
+}
+
+/**
+ * Insert (or replace) the entry of a logical key in a bucket.
+ *
+ * Expired entries are dropped from the bucket along the way. The bucket must
+ * not be written back if the insertion fails.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket, in a buffer of FIO_KV_PACK_BUCKET_SIZE
+ *	  bytes.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The value's data.
+ *	value_len (uint32_t): The value's length, at most FIO_KV_PACK_MAX_VALUE.
+ *	expiry (uint32_t): The entry's expiry, or 0 for none.
+ *	now (uint32_t): The current time.
+ * Returns:
+ *	Returns true if the entry was inserted, false if the bucket is full,
+ *	  with errno set to ENOSPC.
+ */
+bool fio_kv_pack_insert(void *bucket, const nvm_kv_key_t *key,
+		const uint32_t key_len, const void *value, const uint32_t value_len,
+		const uint32_t expiry, const uint32_t now)
+{
+	fio_kv_pack_bucket_t *header = (fio_kv_pack_bucket_t *)bucket;
+	uint32_t offset = sizeof(fio_kv_pack_bucket_t);
+
+	assert(bucket != NULL);
+	assert(key != NULL);
+	assert(value_len <= FIO_KV_PACK_MAX_VALUE);
+
+	// Drop the key's previous entry and the expired ones.
+	for (uint32_t i=0; i<header->count; ) {
+		fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, offset);
+		if ((entry->expiry != 0 && entry->expiry <= now) ||
+				(entry->key_len == key_len &&
+				 memcmp(entry + 1, key, key_len) == 0)) {
+			_fio_kv_pack_erase(bucket, offset);
+			continue;
+		}
+
+		offset += _fio_kv_pack_entry_size(entry->key_len, entry->value_len);
+		i++;
+	}
+
+	uint32_t size = _fio_kv_pack_entry_size(key_len, value_len);
+	if (header->used + size > FIO_KV_PACK_BUCKET_SIZE) {
+		errno = ENOSPC;
+		return false;
+	}
+
+	fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, header->used);
+	memset(entry, 0, size);
+	entry->key_len = (uint16_t)key_len;
+	entry->value_len = (uint16_t)value_len;
+	entry->expiry = expiry;
+	memcpy(entry + 1, key, key_len);
+	memcpy((char *)(entry + 1) + key_len, value, value_len);
+	header->used += size;
+	header->count++;
+	return true;
+}
+
+/**
+ * Remove the entry of a logical key from a bucket.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns true if an entry was removed, false otherwise.
+ */
+bool fio_kv_pack_remove(void *bucket, const nvm_kv_key_t *key,
+		const uint32_t key_len)
+{
+	fio_kv_pack_bucket_t *header = (fio_kv_pack_bucket_t *)bucket;
+	uint32_t offset = sizeof(fio_kv_pack_bucket_t);
+
+	assert(bucket != NULL);
+	assert(key != NULL);
+
+	for (uint32_t i=0; i<header->count; i++) {
+		fio_kv_pack_entry_t *entry = _fio_kv_pack_entry(bucket, offset);
+		if (entry->key_len == key_len &&
+				memcmp(entry + 1, key, key_len) == 0) {
+			_fio_kv_pack_erase(bucket, offset);
+			return true;
+		}
+
+		offset += _fio_kv_pack_entry_size(entry->key_len, entry->value_len);
+	}
+
+	return false;
+}
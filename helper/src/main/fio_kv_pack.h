@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_PACK_H__
+#define __FIO_KV_PACK_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <nvm/nvm_kv.h>
+
+/**
+ * Maximum size of a bucket record and of the values packed in it, and
+ * number of locks serializing the updates of bucket records.
+ */
+#define FIO_KV_PACK_BUCKET_SIZE				4096
+#define FIO_KV_PACK_MAX_VALUE				512
+#define FIO_KV_PACK_LOCKS					64
+
+/**
+ * Magic numbers of bucket records ("fkvb") and of the metadata records of
+ * packed pools ("fkvm").
+ */
+#define FIO_KV_PACK_BUCKET_MAGIC			0x62766b66
+#define FIO_KV_PACK_META_MAGIC				0x6d766b66
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	uint32_t magic;
+	uint32_t count;
+	uint32_t used;
+	uint32_t reserved;
+} fio_kv_pack_bucket_t;
+
+typedef struct {
+	uint16_t key_len;
+	uint16_t value_len;
+	uint32_t expiry;
+} fio_kv_pack_entry_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t buckets;
+} fio_kv_pack_meta_t;
+
+typedef struct {
+	uint32_t *buckets;
+	pthread_mutex_t locks[FIO_KV_PACK_LOCKS];
+} fio_kv_pack_t;
+
+
+/**
+ * Create the packing state of a store.
+ *
+ * Args:
+ *	pool_count (uint32_t): The maximum number of pools of the store.
+ * Returns:
+ *	Returns a newly allocated packing state with no packed pool, or NULL if
+ *	  it could not be allocated.
+ */
+fio_kv_pack_t *fio_kv_pack_create(const uint32_t pool_count);
+
+/**
+ * Release the packing state of a store.
+ *
+ * Args:
+ *	pack (fio_kv_pack_t *): The packing state.
+ */
+void fio_kv_pack_destroy(fio_kv_pack_t *pack);
+
+/**
+ * Hash a logical key with the 32-bit FNV-1a function, to find the bucket it
+ * is packed in.
+ *
+ * Args:
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns the key's 32-bit hash.
+ */
+uint32_t fio_kv_pack_hash(const nvm_kv_key_t *key, const uint32_t key_len);
+
+/**
+ * Initialize an empty bucket.
+ *
+ * Args:
+ *	bucket (void *): A buffer of FIO_KV_PACK_BUCKET_SIZE bytes.
+ */
+void fio_kv_pack_init(void *bucket);
+
+/**
+ * Tell whether a record read from the device is a valid bucket.
+ *
+ * Args:
+ *	bucket (void *): The record.
+ *	length (uint32_t): The record's length.
+ * Returns:
+ *	Returns true if the record holds a valid bucket, false otherwise.
+ */
+bool fio_kv_pack_valid(const void *bucket, const uint32_t length);
+
+/**
+ * Find the entry of a logical key in a bucket.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	now (uint32_t): The current time, entries expired by then being ignored.
+ * Returns:
+ *	Returns the key's entry, or NULL if the bucket has no live entry for it.
+ */
+const fio_kv_pack_entry_t *fio_kv_pack_find(const void *bucket,
+		const nvm_kv_key_t *key, const uint32_t key_len, const uint32_t now);
+
+/**
+ * Return the value of a bucket entry.
+ *
+ * Args:
+ *	entry (fio_kv_pack_entry_t *): The entry.
+ * Returns:
+ *	Returns a pointer to the entry's value_len bytes of value.
+ */
+const void *fio_kv_pack_value(const fio_kv_pack_entry_t *entry);
+
+/**
+ * Insert (or replace) the entry of a logical key in a bucket.
+ *
+ * Expired entries are dropped from the bucket along the way. The bucket must
+ * not be written back if the insertion fails.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket, in a buffer of FIO_KV_PACK_BUCKET_SIZE
+ *	  bytes.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ *	value (void *): The value's data.
+ *	value_len (uint32_t): The value's length, at most FIO_KV_PACK_MAX_VALUE.
+ *	expiry (uint32_t): The entry's expiry, or 0 for none.
+ *	now (uint32_t): The current time.
+ * Returns:
+ *	Returns true if the entry was inserted, false if the bucket is full,
+ *	  with errno set to ENOSPC.
+ */
+bool fio_kv_pack_insert(void *bucket, const nvm_kv_key_t *key,
+		const uint32_t key_len, const void *value, const uint32_t value_len,
+		const uint32_t expiry, const uint32_t now);
+
+/**
+ * Remove the entry of a logical key from a bucket.
+ *
+ * Args:
+ *	bucket (void *): A valid bucket.
+ *	key (nvm_kv_key_t *): The key's bytes.
+ *	key_len (uint32_t): The key's length.
+ * Returns:
+ *	Returns true if an entry was removed, false otherwise.
+ */
+bool fio_kv_pack_remove(void *bucket, const nvm_kv_key_t *key,
+		const uint32_t key_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_PACK_H__ */
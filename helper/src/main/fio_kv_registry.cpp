@@ -0,0 +1,308 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_pack.h"
+#include "fio_kv_registry.h"
+
+/**
+ * Pool registry.
+ *
+ * A store's registry maps the tags of its pools to their IDs, so that pools
+ * can be resolved by tag and listed without going to the device. It is an
+ * open-addressing hash table with linear probing, keyed by the pool tags and
+ * doubled in size whenever it gets half full. Free slots have an ID of 0,
+ * which is the default pool's and is never registered. Removals shift the
+ * following entries of the probe sequence back instead of leaving tombstones.
+ */
+
+
+/**
+ * Return the slot a tag hashes to.
+ */
+uint32_t _fio_kv_registry_slot(const fio_kv_registry_t *registry,
+		const char *tag)
+{
+	return fio_kv_pack_hash((const nvm_kv_key_t *)tag, strlen(tag)) &
+		(registry->capacity - 1);
+}
+
+/**
+ * Return the slot holding a tag, or the free slot ending its probe sequence.
+ */
+uint32_t _fio_kv_registry_probe(const fio_kv_registry_t *registry,
+		const char *tag)
+{
+	uint32_t slot = _fio_kv_registry_slot(registry, tag);
+
+	while (registry->slots[slot].id != 0 &&
+			strcmp(registry->slots[slot].tag, tag) != 0) {
+		slot = (slot + 1) & (registry->capacity - 1);
+	}
+
+	return slot;
+}
+
+/**
+ * Move the entries of a registry into a new table of the given capacity.
+ */
+bool _fio_kv_registry_resize(fio_kv_registry_t *registry,
+		const uint32_t capacity)
+{
+	fio_kv_registry_entry_t *slots = registry->slots;
+	uint32_t previous = registry->capacity;
+
+	registry->slots = (fio_kv_registry_entry_t *)calloc(capacity,
+			sizeof(fio_kv_registry_entry_t));
+	if (registry->slots == NULL) {
+		registry->slots = slots;
+		errno = ENOMEM;
+		return false;
+	}
+
+	registry->capacity = capacity;
+	for (uint32_t i = 0; i < previous; i++) {
+		if (slots[i].id != 0) {
+			registry->slots[_fio_kv_registry_probe(registry, slots[i].tag)] =
+				slots[i];
+		}
+	}
+
+	free(slots);
+	return true;
+}
+
+/**
+ * Remove the entry in the given slot, moving back the entries following it
+ * that would no longer be reachable.
+ */
+void _fio_kv_registry_erase(fio_kv_registry_t *registry, uint32_t slot)
+{
+	uint32_t mask = registry->capacity - 1;
+	uint32_t next = (slot + 1) & mask;
+
+	while (registry->slots[next].id != 0) {
+		uint32_t home = _fio_kv_registry_slot(registry,
+				registry->slots[next].tag);
+
+		// The entry can move back if its home isn't between the hole and it.
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			registry->slots[slot] = registry->slots[next];
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+
+	memset(&registry->slots[slot], 0, sizeof(fio_kv_registry_entry_t));
+	registry->count--;
+}
+
+/**
+ * Order registry entries by increasing pool ID.
+ */
+int _fio_kv_registry_compare(const void *a, const void *b)
+{
+	return ((const fio_kv_registry_entry_t *)a)->id -
+		((const fio_kv_registry_entry_t *)b)->id;
+}
+
+/**
+ * Create an empty pool registry.
+ *
+ * Returns:
+ *	Returns a newly allocated registry, or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_registry_t *fio_kv_registry_create(void)
+{
+	fio_kv_registry_t *registry = (fio_kv_registry_t *)malloc(
+			sizeof(fio_kv_registry_t));
+	if (registry == NULL) {
+		return NULL;
+	}
+
+	registry->slots = (fio_kv_registry_entry_t *)calloc(
+			FIO_KV_REGISTRY_MIN_SLOTS, sizeof(fio_kv_registry_entry_t));
+	if (registry->slots == NULL) {
+		free(registry);
+		return NULL;
+	}
+
+	registry->capacity = FIO_KV_REGISTRY_MIN_SLOTS;
+	registry->count = 0;
+	pthread_mutex_init(&registry->lock, NULL);
+	return registry;
+}
+
+/**
+ * Release a pool registry.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry. May be NULL.
+ */
+void fio_kv_registry_destroy(fio_kv_registry_t *registry)
+{
+	if (registry == NULL) {
+		return;
+	}
+
+	pthread_mutex_destroy(&registry->lock);
+	free(registry->slots);
+	free(registry);
+}
+
+/**
+ * Look up the ID of a pool by its tag.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	tag (const char *): The NUL-terminated pool tag.
+ * Returns:
+ *	Returns the pool's ID, or -1 if no pool with this tag is registered.
+ */
+int fio_kv_registry_find(fio_kv_registry_t *registry, const char *tag)
+{
+	assert(registry != NULL);
+	assert(tag != NULL);
+
+	pthread_mutex_lock(&registry->lock);
+	int id = registry->slots[_fio_kv_registry_probe(registry, tag)].id;
+	pthread_mutex_unlock(&registry->lock);
+	return id != 0 ? id : -1;
+}
+
+/**
+ * Register a pool, or update the ID registered for its tag.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	id (int): The pool ID, greater than 0.
+ *	tag (const char *): The NUL-terminated pool tag, shorter than
+ *	  FIO_KV_REGISTRY_TAG_LENGTH.
+ * Returns:
+ *	Returns true if the pool was registered, false if the registry could
+ *	  not grow, with errno set to ENOMEM.
+ */
+bool fio_kv_registry_add(fio_kv_registry_t *registry, const int id,
+		const char *tag)
+{
+	assert(registry != NULL);
+	assert(id > 0);
+	assert(strlen(tag) < FIO_KV_REGISTRY_TAG_LENGTH);
+
+	bool ret = true;
+
+	pthread_mutex_lock(&registry->lock);
+	uint32_t slot = _fio_kv_registry_probe(registry, tag);
+	if (registry->slots[slot].id == 0 &&
+			2 * (registry->count + 1) > registry->capacity) {
+		ret = _fio_kv_registry_resize(registry, 2 * registry->capacity);
+		slot = _fio_kv_registry_probe(registry, tag);
+	}
+
+	if (ret) {
+		registry->count += registry->slots[slot].id == 0;
+		registry->slots[slot].id = id;
+		strcpy(registry->slots[slot].tag, tag);
+	}
+	pthread_mutex_unlock(&registry->lock);
+	return ret;
+}
+
+/**
+ * Unregister a pool.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	id (int): The ID of the pool to unregister, or -1 for all pools.
+ */
+void fio_kv_registry_remove(fio_kv_registry_t *registry, const int id)
+{
+	assert(registry != NULL);
+
+	pthread_mutex_lock(&registry->lock);
+	if (id == -1) {
+		memset(registry->slots, 0,
+				registry->capacity * sizeof(fio_kv_registry_entry_t));
+		registry->count = 0;
+	} else {
+		for (uint32_t i = 0; i < registry->capacity; i++) {
+			if (registry->slots[i].id == id) {
+				_fio_kv_registry_erase(registry, i);
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&registry->lock);
+}
+
+/**
+ * Return a snapshot of the registered pools.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	count (uint32_t *): Set to the number of registered pools.
+ * Returns:
+ *	Returns a newly allocated array of the registered pools, in increasing
+ *	  ID order, to be released with free(), or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_registry_entry_t *fio_kv_registry_list(fio_kv_registry_t *registry,
+		uint32_t *count)
+{
+	assert(registry != NULL);
+	assert(count != NULL);
+
+	pthread_mutex_lock(&registry->lock);
+	fio_kv_registry_entry_t *entries = (fio_kv_registry_entry_t *)malloc(
+			(registry->count + 1) * sizeof(fio_kv_registry_entry_t));
+	if (entries == NULL) {
+		pthread_mutex_unlock(&registry->lock);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	*count = 0;
+	for (uint32_t i = 0; i < registry->capacity; i++) {
+		if (registry->slots[i].id != 0) {
+			entries[(*count)++] = registry->slots[i];
+		}
+	}
+	pthread_mutex_unlock(&registry->lock);
+
+	qsort(entries, *count, sizeof(fio_kv_registry_entry_t),
+			_fio_kv_registry_compare);
+	return entries;
+}
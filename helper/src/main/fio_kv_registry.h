@@ -0,0 +1,131 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_REGISTRY_H__
+#define __FIO_KV_REGISTRY_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * Maximum length of a pool tag, including the terminating NUL, and initial
+ * number of slots of a registry's hash table.
+ */
+#define FIO_KV_REGISTRY_TAG_LENGTH			16
+#define FIO_KV_REGISTRY_MIN_SLOTS			64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	int id;
+	char tag[FIO_KV_REGISTRY_TAG_LENGTH];
+} fio_kv_registry_entry_t;
+
+typedef struct {
+	fio_kv_registry_entry_t *slots;
+	uint32_t capacity;
+	uint32_t count;
+	pthread_mutex_t lock;
+} fio_kv_registry_t;
+
+
+/**
+ * Create an empty pool registry.
+ *
+ * Returns:
+ *	Returns a newly allocated registry, or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_registry_t *fio_kv_registry_create(void);
+
+/**
+ * Release a pool registry.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry. May be NULL.
+ */
+void fio_kv_registry_destroy(fio_kv_registry_t *registry);
+
+/**
+ * Look up the ID of a pool by its tag.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	tag (const char *): The NUL-terminated pool tag.
+ * Returns:
+ *	Returns the pool's ID, or -1 if no pool with this tag is registered.
+ */
+int fio_kv_registry_find(fio_kv_registry_t *registry, const char *tag);
+
+/**
+ * Register a pool, or update the ID registered for its tag.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	id (int): The pool ID, greater than 0.
+ *	tag (const char *): The NUL-terminated pool tag, shorter than
+ *	  FIO_KV_REGISTRY_TAG_LENGTH.
+ * Returns:
+ *	Returns true if the pool was registered, false if the registry could
+ *	  not grow, with errno set to ENOMEM.
+ */
+bool fio_kv_registry_add(fio_kv_registry_t *registry, const int id,
+		const char *tag);
+
+/**
+ * Unregister a pool.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	id (int): The ID of the pool to unregister, or -1 for all pools.
+ */
+void fio_kv_registry_remove(fio_kv_registry_t *registry, const int id);
+
+/**
+ * Return a snapshot of the registered pools.
+ *
+ * Args:
+ *	registry (fio_kv_registry_t *): The registry.
+ *	count (uint32_t *): Set to the number of registered pools.
+ * Returns:
+ *	Returns a newly allocated array of the registered pools, in increasing
+ *	  ID order, to be released with free(), or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_registry_entry_t *fio_kv_registry_list(fio_kv_registry_t *registry,
+		uint32_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_REGISTRY_H__ */
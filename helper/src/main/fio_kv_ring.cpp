@@ -0,0 +1,372 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fio_kv_ring.h"
+
+/**
+ * Shared-memory submission and completion rings.
+ *
+ * A ring lets the Java side submit operations without a JNI call per
+ * operation. The submission queue is a single-producer ring: the Java side
+ * serializes its submitters. Workers claim entries by compare-and-swap on
+ * sq_head, after copying the entry out; a worker whose swap fails discards
+ * its copy, which the submitter may have overwritten since. Completions are
+ * posted under a lock shared by the workers, and published by advancing
+ * cq_tail once the entry is written.
+ *
+ * Idle workers spin on the submission queue for a while and then sleep,
+ * raising FIO_KV_RING_NEED_WAKEUP. Both sides follow the same pattern: the
+ * submitter advances sq_tail and then reads flags, a worker raises the flag
+ * and then reads sq_tail, each with a full barrier in between, so at least
+ * one of them sees the other's write. Sleeps are also bounded by
+ * FIO_KV_RING_IDLE_DELAY.
+ */
+
+
+/**
+ * Compute the deadline of a wait of the given number of microseconds.
+ */
+void _fio_kv_ring_deadline(struct timespec *deadline, const uint32_t delay)
+{
+	clock_gettime(CLOCK_REALTIME, deadline);
+	deadline->tv_sec += delay / 1000000;
+	deadline->tv_nsec += (long)(delay % 1000000) * 1000;
+	if (deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+/**
+ * Execute the operation of a submission queue entry.
+ */
+void _fio_kv_ring_execute(const fio_kv_ring_sqe_t *sqe,
+		fio_kv_ring_cqe_t *cqe)
+{
+	fio_kv_pool_t *pool = (fio_kv_pool_t *)(uintptr_t)sqe->pool;
+	fio_kv_key_t key;
+	fio_kv_value_t value;
+	nvm_kv_key_info_t info;
+
+	key.length = sqe->key_len;
+	key.bytes = (nvm_kv_key_t *)(uintptr_t)sqe->key;
+	memset(&info, 0, sizeof(info));
+	info.value_len = sqe->value_len;
+	info.expiry = sqe->expiry;
+	value.data = (void *)(uintptr_t)sqe->value;
+	value.info = &info;
+
+	cqe->user_data = sqe->user_data;
+	errno = 0;
+	switch (sqe->op) {
+		case FIO_KV_RING_GET:
+			cqe->result = fio_kv_get(pool, &key, &value);
+			break;
+		case FIO_KV_RING_PUT:
+			cqe->result = fio_kv_put(pool, &key, &value);
+			break;
+		case FIO_KV_RING_EXISTS:
+			cqe->result = fio_kv_exists(pool, &key, NULL) ? 1 : 0;
+			break;
+		case FIO_KV_RING_DELETE:
+			cqe->result = fio_kv_delete(pool, &key) ? 0 : -1;
+			break;
+		default:
+			cqe->result = -1;
+			errno = EINVAL;
+			break;
+	}
+
+	cqe->error = cqe->result < 0 ? errno : 0;
+}
+
+/**
+ * Post a completion to the completion queue, and wake up the threads waiting
+ * for completions.
+ */
+void _fio_kv_ring_post(fio_kv_ring_t *ring, const fio_kv_ring_cqe_t *cqe)
+{
+	fio_kv_ring_header_t *header = ring->header;
+
+	pthread_mutex_lock(&ring->cq_lock);
+
+	// Only a submitter exceeding its bound on operations in flight can fill
+	// the completion queue; wait for it to catch up rather than overwrite.
+	while (header->cq_tail - header->cq_head > ring->mask &&
+			!ring->stopping) {
+		pthread_mutex_unlock(&ring->cq_lock);
+		sched_yield();
+		pthread_mutex_lock(&ring->cq_lock);
+	}
+
+	uint32_t tail = header->cq_tail;
+	ring->cq[tail & ring->mask] = *cqe;
+	__sync_synchronize();
+	header->cq_tail = tail + 1;
+
+	if (ring->waiters > 0) {
+		pthread_cond_broadcast(&ring->completed);
+	}
+	pthread_mutex_unlock(&ring->cq_lock);
+}
+
+/**
+ * Put an idle worker to sleep until it is woken up, the submission queue is
+ * no longer empty or FIO_KV_RING_IDLE_DELAY elapsed.
+ */
+void _fio_kv_ring_sleep(fio_kv_ring_t *ring)
+{
+	fio_kv_ring_header_t *header = ring->header;
+	struct timespec deadline;
+
+	pthread_mutex_lock(&ring->lock);
+	ring->sleepers++;
+	__sync_fetch_and_or(&header->flags, FIO_KV_RING_NEED_WAKEUP);
+
+	if (!ring->stopping && header->sq_head == header->sq_tail) {
+		_fio_kv_ring_deadline(&deadline, FIO_KV_RING_IDLE_DELAY);
+		pthread_cond_timedwait(&ring->wakeup, &ring->lock, &deadline);
+	}
+
+	if (--ring->sleepers == 0) {
+		__sync_fetch_and_and(&header->flags, ~FIO_KV_RING_NEED_WAKEUP);
+	}
+	pthread_mutex_unlock(&ring->lock);
+}
+
+/**
+ * Worker thread main loop: claim and execute submission queue entries until
+ * the ring is destroyed.
+ */
+void *_fio_kv_ring_worker(void *arg)
+{
+	fio_kv_ring_t *ring = (fio_kv_ring_t *)arg;
+	fio_kv_ring_header_t *header = ring->header;
+	fio_kv_ring_sqe_t sqe;
+	fio_kv_ring_cqe_t cqe;
+	uint32_t idle = 0;
+
+	while (!ring->stopping) {
+		uint32_t head = header->sq_head;
+		__sync_synchronize();
+		if (head == header->sq_tail) {
+			if (++idle < FIO_KV_RING_SPIN) {
+				sched_yield();
+			} else {
+				_fio_kv_ring_sleep(ring);
+				idle = 0;
+			}
+			continue;
+		}
+
+		// Read the entry published by the submitter, then claim it.
+		__sync_synchronize();
+		sqe = ring->sq[head & ring->mask];
+		if (!__sync_bool_compare_and_swap(&header->sq_head, head, head + 1)) {
+			continue;
+		}
+
+		idle = 0;
+		_fio_kv_ring_execute(&sqe, &cqe);
+		_fio_kv_ring_post(ring, &cqe);
+	}
+
+	return NULL;
+}
+
+/**
+ * Create a submission/completion ring pair and start its worker threads.
+ *
+ * The rings live in one block of memory, starting with a
+ * fio_kv_ring_header_t followed by the submission queue entries and then by
+ * the completion queue entries, to be shared with the submitter. The
+ * submitter writes operation descriptors in the submission queue and
+ * publishes them by advancing sq_tail; the workers poll it, execute each
+ * operation on the pool, key and value buffers it gives, and post its result
+ * with the descriptor's user data to the completion queue, where the
+ * submitter collects them and advances cq_head.
+ *
+ * The submitter must not have more than the ring's number of entries
+ * submitted and not reaped, which guarantees that both queues have room.
+ *
+ * Args:
+ *	entries (uint32_t): The number of entries of each queue, a power of two
+ *	  no greater than FIO_KV_RING_MAX_ENTRIES.
+ *	workers (uint32_t): The number of worker threads polling the ring.
+ * Returns:
+ *	Returns the newly allocated ring, or NULL if it could not be created.
+ */
+fio_kv_ring_t *fio_kv_ring_create(const uint32_t entries,
+		const uint32_t workers)
+{
+	if (entries == 0 || entries > FIO_KV_RING_MAX_ENTRIES ||
+			(entries & (entries - 1)) != 0 || workers == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	fio_kv_ring_t *ring = (fio_kv_ring_t *)calloc(1, sizeof(fio_kv_ring_t));
+	if (ring == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	ring->size = sizeof(fio_kv_ring_header_t) +
+		entries * (sizeof(fio_kv_ring_sqe_t) + sizeof(fio_kv_ring_cqe_t));
+	ring->workers = (pthread_t *)calloc(workers, sizeof(pthread_t));
+	if (ring->workers == NULL ||
+			posix_memalign(&ring->memory, 64, ring->size) != 0) {
+		free(ring->workers);
+		free(ring);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	memset(ring->memory, 0, ring->size);
+	ring->header = (fio_kv_ring_header_t *)ring->memory;
+	ring->header->entries = entries;
+	ring->sq = (fio_kv_ring_sqe_t *)(ring->header + 1);
+	ring->cq = (fio_kv_ring_cqe_t *)(ring->sq + entries);
+	ring->mask = entries - 1;
+
+	pthread_mutex_init(&ring->lock, NULL);
+	pthread_cond_init(&ring->wakeup, NULL);
+	pthread_mutex_init(&ring->cq_lock, NULL);
+	pthread_cond_init(&ring->completed, NULL);
+
+	for (uint32_t i=0; i<workers; i++) {
+		if (pthread_create(&ring->workers[i], NULL, _fio_kv_ring_worker,
+					ring) != 0) {
+			fio_kv_ring_destroy(ring);
+			errno = EAGAIN;
+			return NULL;
+		}
+		ring->worker_count++;
+	}
+
+	return ring;
+}
+
+/**
+ * Wake up the sleeping workers of a ring.
+ *
+ * Workers that found the submission queue empty for FIO_KV_RING_SPIN polls
+ * go to sleep and set FIO_KV_RING_NEED_WAKEUP in the ring's flags. A
+ * submitter seeing that flag after advancing sq_tail must then call this
+ * function for its submissions to be picked up without delay.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ */
+void fio_kv_ring_wake(fio_kv_ring_t *ring)
+{
+	assert(ring != NULL);
+
+	pthread_mutex_lock(&ring->lock);
+	pthread_cond_broadcast(&ring->wakeup);
+	pthread_mutex_unlock(&ring->lock);
+}
+
+/**
+ * Wait for completions to be posted to a ring's completion queue.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ *	head (uint32_t): The submitter's cq_head.
+ *	timeout (uint32_t): The maximum time to wait, in microseconds.
+ * Returns:
+ *	Returns true if completions are available past the given head, false
+ *	  if the wait timed out or if the ring is being destroyed.
+ */
+bool fio_kv_ring_wait(fio_kv_ring_t *ring, const uint32_t head,
+		const uint32_t timeout)
+{
+	assert(ring != NULL);
+
+	struct timespec deadline;
+	int ret = 0;
+
+	_fio_kv_ring_deadline(&deadline, timeout);
+	pthread_mutex_lock(&ring->cq_lock);
+	ring->waiters++;
+	while (ring->header->cq_tail == head && !ring->stopping &&
+			ret != ETIMEDOUT) {
+		ret = pthread_cond_timedwait(&ring->completed, &ring->cq_lock,
+				&deadline);
+	}
+	ring->waiters--;
+
+	bool available = ring->header->cq_tail != head;
+	pthread_mutex_unlock(&ring->cq_lock);
+	return available;
+}
+
+/**
+ * Stop the workers of a ring and release it.
+ *
+ * Operations still in the submission queue are not executed: the submitter
+ * should reap all its operations before destroying the ring.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ */
+void fio_kv_ring_destroy(fio_kv_ring_t *ring)
+{
+	assert(ring != NULL);
+
+	pthread_mutex_lock(&ring->lock);
+	ring->stopping = true;
+	pthread_cond_broadcast(&ring->wakeup);
+	pthread_mutex_unlock(&ring->lock);
+
+	pthread_mutex_lock(&ring->cq_lock);
+	pthread_cond_broadcast(&ring->completed);
+	pthread_mutex_unlock(&ring->cq_lock);
+
+	for (uint32_t i=0; i<ring->worker_count; i++) {
+		pthread_join(ring->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&ring->completed);
+	pthread_mutex_destroy(&ring->cq_lock);
+	pthread_cond_destroy(&ring->wakeup);
+	pthread_mutex_destroy(&ring->lock);
+	free(ring->workers);
+	free(ring->memory);
+	free(ring);
+}
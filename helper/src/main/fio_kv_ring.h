@@ -0,0 +1,191 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_RING_H__
+#define __FIO_KV_RING_H__
+
+#include <pthread.h>
+
+#include "fio_kv_helper.h"
+
+/**
+ * Maximum number of entries of a ring, number of polls of an idle worker
+ * before it goes to sleep, and the time after which a sleeping worker polls
+ * the ring again even if it wasn't woken up, in microseconds.
+ */
+#define FIO_KV_RING_MAX_ENTRIES				65536
+#define FIO_KV_RING_SPIN					4096
+#define FIO_KV_RING_IDLE_DELAY				10000
+
+/**
+ * Ring flag set while at least one worker sleeps, telling the submitter to
+ * ring the doorbell with fio_kv_ring_wake() after its submissions.
+ */
+#define FIO_KV_RING_NEED_WAKEUP				0x1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The layout below is shared with the Java side (see IORing.java) and must
+ * be kept in sync with it. Each index lives on its own cache line, written
+ * by a single side: the submitter owns sq_tail and cq_head, the workers
+ * sq_head, cq_tail and flags. Indices run freely and wrap around; entries
+ * live at index & (entries - 1).
+ */
+typedef struct {
+	volatile uint32_t sq_tail;
+	uint8_t _pad0[60];
+	volatile uint32_t sq_head;
+	uint8_t _pad1[60];
+	volatile uint32_t cq_tail;
+	uint8_t _pad2[60];
+	volatile uint32_t cq_head;
+	uint8_t _pad3[60];
+	volatile uint32_t flags;
+	uint32_t entries;
+	uint8_t _pad4[56];
+} fio_kv_ring_header_t;
+
+typedef enum {
+	FIO_KV_RING_GET = 1,
+	FIO_KV_RING_PUT = 2,
+	FIO_KV_RING_EXISTS = 3,
+	FIO_KV_RING_DELETE = 4
+} fio_kv_ring_op_t;
+
+typedef struct {
+	uint64_t user_data;
+	uint64_t pool;
+	uint64_t key;
+	uint64_t value;
+	uint32_t key_len;
+	uint32_t value_len;
+	uint32_t expiry;
+	uint32_t op;
+} fio_kv_ring_sqe_t;
+
+typedef struct {
+	uint64_t user_data;
+	int32_t result;
+	int32_t error;
+} fio_kv_ring_cqe_t;
+
+typedef struct {
+	void *memory;
+	size_t size;
+	fio_kv_ring_header_t *header;
+	fio_kv_ring_sqe_t *sq;
+	fio_kv_ring_cqe_t *cq;
+	uint32_t mask;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wakeup;
+	uint32_t sleepers;
+
+	pthread_mutex_t cq_lock;
+	pthread_cond_t completed;
+	uint32_t waiters;
+
+	pthread_t *workers;
+	uint32_t worker_count;
+	volatile bool stopping;
+} fio_kv_ring_t;
+
+
+/**
+ * Create a submission/completion ring pair and start its worker threads.
+ *
+ * The rings live in one block of memory, starting with a
+ * fio_kv_ring_header_t followed by the submission queue entries and then by
+ * the completion queue entries, to be shared with the submitter. The
+ * submitter writes operation descriptors in the submission queue and
+ * publishes them by advancing sq_tail; the workers poll it, execute each
+ * operation on the pool, key and value buffers it gives, and post its result
+ * with the descriptor's user data to the completion queue, where the
+ * submitter collects them and advances cq_head.
+ *
+ * The submitter must not have more than the ring's number of entries
+ * submitted and not reaped, which guarantees that both queues have room.
+ *
+ * Args:
+ *	entries (uint32_t): The number of entries of each queue, a power of two
+ *	  no greater than FIO_KV_RING_MAX_ENTRIES.
+ *	workers (uint32_t): The number of worker threads polling the ring.
+ * Returns:
+ *	Returns the newly allocated ring, or NULL if it could not be created.
+ */
+fio_kv_ring_t *fio_kv_ring_create(const uint32_t entries,
+		const uint32_t workers);
+
+/**
+ * Wake up the sleeping workers of a ring.
+ *
+ * Workers that found the submission queue empty for FIO_KV_RING_SPIN polls
+ * go to sleep and set FIO_KV_RING_NEED_WAKEUP in the ring's flags. A
+ * submitter seeing that flag after advancing sq_tail must then call this
+ * function for its submissions to be picked up without delay.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ */
+void fio_kv_ring_wake(fio_kv_ring_t *ring);
+
+/**
+ * Wait for completions to be posted to a ring's completion queue.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ *	head (uint32_t): The submitter's cq_head.
+ *	timeout (uint32_t): The maximum time to wait, in microseconds.
+ * Returns:
+ *	Returns true if completions are available past the given head, false
+ *	  if the wait timed out or if the ring is being destroyed.
+ */
+bool fio_kv_ring_wait(fio_kv_ring_t *ring, const uint32_t head,
+		const uint32_t timeout);
+
+/**
+ * Stop the workers of a ring and release it.
+ *
+ * Operations still in the submission queue are not executed: the submitter
+ * should reap all its operations before destroying the ring.
+ *
+ * Args:
+ *	ring (fio_kv_ring_t *): The ring.
+ */
+void fio_kv_ring_destroy(fio_kv_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_RING_H__ */
@@ -0,0 +1,351 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_scan.h"
+
+/**
+ * Parallel scan driver for the key/value store.
+ *
+ * Iterations with directKV are strictly sequential, and each only covers one
+ * pool. To make use of the device's read parallelism during full scans, a
+ * set of worker threads iterate over different pools at the same time, each
+ * reading batches of records into buffers taken from a free queue and
+ * handing them over to the consumer through a ready queue. Both queues are
+ * bounded by the number of buffers, which keeps the workers from running
+ * arbitrarily far ahead of the consumer.
+ */
+
+
+/**
+ * Append a buffer to a queue. The queue must have room for it.
+ */
+void _fio_kv_scan_push(fio_kv_scan_queue_t *queue, const uint32_t capacity,
+		const uint32_t buffer)
+{
+	assert(queue->count < capacity);
+	queue->buffers[(queue->head + queue->count) % capacity] = buffer;
+	queue->count++;
+}
+
+/**
+ * Remove the buffer at the head of a non-empty queue.
+ */
+uint32_t _fio_kv_scan_pop(fio_kv_scan_queue_t *queue, const uint32_t capacity)
+{
+	assert(queue->count > 0);
+	uint32_t buffer = queue->buffers[queue->head];
+	queue->head = (queue->head + 1) % capacity;
+	queue->count--;
+	return buffer;
+}
+
+/**
+ * Iterate over one pool, handing its batches over to the consumer until the
+ * iteration ends or the scan is stopped. Called and returns with the scan's
+ * lock held.
+ */
+void _fio_kv_scan_pool(fio_kv_scan_t *scan, const uint32_t index)
+{
+	fio_kv_pool_t *pool = &scan->pools[index];
+
+	pthread_mutex_unlock(&scan->lock);
+	int iterator = fio_kv_iterator(pool);
+	pthread_mutex_lock(&scan->lock);
+
+	// Pools that can't be iterated over, like empty ones, are skipped.
+	if (iterator < 0) {
+		return;
+	}
+
+	bool ended = false;
+	while (!ended) {
+		while (scan->free.count == 0 && !scan->stopping) {
+			pthread_cond_wait(&scan->released, &scan->lock);
+		}
+
+		if (scan->stopping) {
+			break;
+		}
+
+		uint32_t buffer = _fio_kv_scan_pop(&scan->free, scan->buffer_count);
+		pthread_mutex_unlock(&scan->lock);
+
+		// An empty pool, or a failure to read its current element, also
+		// ends its iteration.
+		fio_kv_batch_t *batch = (fio_kv_batch_t *)scan->buffers[buffer];
+		int read = fio_kv_next_batch(pool, iterator, batch,
+				scan->buffer_size, scan->max, scan->keys_only);
+		ended = read <= 0 || batch->ended;
+
+		pthread_mutex_lock(&scan->lock);
+		if (read > 0) {
+			scan->owners[buffer] = index;
+			_fio_kv_scan_push(&scan->ready, scan->buffer_count, buffer);
+			pthread_cond_signal(&scan->filled);
+		} else {
+			_fio_kv_scan_push(&scan->free, scan->buffer_count, buffer);
+			pthread_cond_signal(&scan->released);
+		}
+	}
+
+	pthread_mutex_unlock(&scan->lock);
+	fio_kv_end_iteration(pool, iterator);
+	pthread_mutex_lock(&scan->lock);
+}
+
+/**
+ * Worker thread main loop: scan pools until all of them have been taken or
+ * the scan is stopped.
+ */
+void *_fio_kv_scan_worker(void *arg)
+{
+	fio_kv_scan_t *scan = (fio_kv_scan_t *)arg;
+
+	pthread_mutex_lock(&scan->lock);
+	while (!scan->stopping && scan->next_pool < scan->pool_count) {
+		_fio_kv_scan_pool(scan, scan->next_pool++);
+	}
+
+	scan->running--;
+	pthread_cond_broadcast(&scan->filled);
+	pthread_mutex_unlock(&scan->lock);
+	return NULL;
+}
+
+/**
+ * Start a parallel scan of the given pools.
+ *
+ * Worker threads each take the next pool that hasn't been scanned yet, and
+ * iterate over it with fio_kv_next_batch(), reading one batch in each free
+ * buffer of the scan and handing it over to the consumer. The number of
+ * buffers bounds how far the workers get ahead of the consumer, which
+ * collects filled buffers with fio_kv_scan_reap() and gives them back with
+ * fio_kv_scan_release() once it is done with them.
+ *
+ * Args:
+ *	pools (fio_kv_pool_t **): The pools to scan.
+ *	pool_count (uint32_t): The number of pools to scan.
+ *	workers (uint32_t): The number of worker threads, each scanning one
+ *	  pool at a time.
+ *	buffers (uint32_t): The number of batch buffers.
+ *	size (uint32_t): The size of each batch buffer, a multiple of the sector
+ *	  size.
+ *	max (uint32_t): The maximum number of records in a batch.
+ *	keys_only (bool): Whether to only read keys and their metadata.
+ * Returns:
+ *	Returns a newly allocated scan, or NULL if it could not be started.
+ */
+fio_kv_scan_t *fio_kv_scan_create(fio_kv_pool_t **pools,
+		const uint32_t pool_count, const uint32_t workers,
+		const uint32_t buffers, const uint32_t size, const uint32_t max,
+		const bool keys_only)
+{
+	assert(pools != NULL);
+	assert(workers > 0);
+	assert(buffers > 0);
+	assert(size % FIO_SECTOR_ALIGNMENT == 0);
+	assert(max > 0);
+
+	fio_kv_scan_t *scan = (fio_kv_scan_t *)calloc(1, sizeof(fio_kv_scan_t));
+	if (scan == NULL) {
+		return NULL;
+	}
+
+	scan->pool_count = pool_count;
+	scan->buffer_size = size;
+	scan->max = max;
+	scan->keys_only = keys_only;
+	scan->pools = (fio_kv_pool_t *)calloc(pool_count + 1,
+			sizeof(fio_kv_pool_t));
+	scan->buffers = (void **)calloc(buffers, sizeof(void *));
+	scan->owners = (uint32_t *)calloc(buffers, sizeof(uint32_t));
+	scan->free.buffers = (uint32_t *)calloc(buffers, sizeof(uint32_t));
+	scan->ready.buffers = (uint32_t *)calloc(buffers, sizeof(uint32_t));
+	scan->workers = (pthread_t *)calloc(workers, sizeof(pthread_t));
+	pthread_mutex_init(&scan->lock, NULL);
+	pthread_cond_init(&scan->released, NULL);
+	pthread_cond_init(&scan->filled, NULL);
+
+	if (scan->pools == NULL || scan->buffers == NULL ||
+			scan->owners == NULL || scan->free.buffers == NULL ||
+			scan->ready.buffers == NULL || scan->workers == NULL) {
+		fio_kv_scan_destroy(scan);
+		return NULL;
+	}
+
+	for (uint32_t i=0; i<pool_count; i++) {
+		assert(pools[i] != NULL);
+		scan->pools[i] = *pools[i];
+	}
+
+	for (uint32_t i=0; i<buffers; i++) {
+		scan->buffers[i] = fio_kv_alloc(size);
+		if (scan->buffers[i] == NULL) {
+			break;
+		}
+
+		scan->buffer_count++;
+		_fio_kv_scan_push(&scan->free, buffers, i);
+	}
+
+	if (scan->buffer_count < buffers) {
+		fio_kv_scan_destroy(scan);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&scan->lock);
+	for (uint32_t i=0; i<workers; i++) {
+		if (pthread_create(&scan->workers[i], NULL,
+					_fio_kv_scan_worker, scan) != 0) {
+			break;
+		}
+
+		scan->worker_count++;
+		scan->running++;
+	}
+	pthread_mutex_unlock(&scan->lock);
+
+	if (scan->worker_count < workers) {
+		fio_kv_scan_destroy(scan);
+		return NULL;
+	}
+
+	return scan;
+}
+
+/**
+ * Return the given batch buffer of a scan.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	buffer (uint32_t): The batch buffer's index.
+ * Returns:
+ *	Returns a pointer to the sector-aligned batch buffer.
+ */
+void *fio_kv_scan_buffer(fio_kv_scan_t *scan, const uint32_t buffer)
+{
+	assert(scan != NULL);
+	assert(buffer < scan->buffer_count);
+
+	return scan->buffers[buffer];
+}
+
+/**
+ * Wait for a filled batch buffer.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	pool (uint32_t *): Set to the index of the pool the batch was read from.
+ * Returns:
+ *	Returns the index of a batch buffer laid out as by fio_kv_next_batch(),
+ *	  or -1 once all pools have been scanned, or the scan was stopped, and
+ *	  all the filled buffers have been reaped.
+ */
+int fio_kv_scan_reap(fio_kv_scan_t *scan, uint32_t *pool)
+{
+	assert(scan != NULL);
+	assert(pool != NULL);
+
+	pthread_mutex_lock(&scan->lock);
+	while (scan->ready.count == 0 && scan->running > 0) {
+		pthread_cond_wait(&scan->filled, &scan->lock);
+	}
+
+	int buffer = -1;
+	if (scan->ready.count > 0) {
+		buffer = (int)_fio_kv_scan_pop(&scan->ready, scan->buffer_count);
+		*pool = scan->owners[buffer];
+	}
+	pthread_mutex_unlock(&scan->lock);
+
+	return buffer;
+}
+
+/**
+ * Give a reaped batch buffer back to the workers of a scan.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	buffer (uint32_t): The batch buffer's index.
+ */
+void fio_kv_scan_release(fio_kv_scan_t *scan, const uint32_t buffer)
+{
+	assert(scan != NULL);
+	assert(buffer < scan->buffer_count);
+
+	pthread_mutex_lock(&scan->lock);
+	_fio_kv_scan_push(&scan->free, scan->buffer_count, buffer);
+	pthread_cond_signal(&scan->released);
+	pthread_mutex_unlock(&scan->lock);
+}
+
+/**
+ * Stop a parallel scan and release its resources.
+ *
+ * Workers stop at their next batch, end their iteration and are joined. The
+ * batch buffers, whether reaped or not, become invalid.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ */
+void fio_kv_scan_destroy(fio_kv_scan_t *scan)
+{
+	assert(scan != NULL);
+
+	pthread_mutex_lock(&scan->lock);
+	scan->stopping = true;
+	pthread_cond_broadcast(&scan->released);
+	pthread_mutex_unlock(&scan->lock);
+
+	for (uint32_t i=0; i<scan->worker_count; i++) {
+		pthread_join(scan->workers[i], NULL);
+	}
+
+	for (uint32_t i=0; i<scan->buffer_count; i++) {
+		fio_kv_value_t value = { scan->buffers[i], NULL };
+		fio_kv_free_value(&value);
+	}
+
+	pthread_cond_destroy(&scan->filled);
+	pthread_cond_destroy(&scan->released);
+	pthread_mutex_destroy(&scan->lock);
+	free(scan->workers);
+	free(scan->ready.buffers);
+	free(scan->free.buffers);
+	free(scan->owners);
+	free(scan->buffers);
+	free(scan->pools);
+	free(scan);
+}
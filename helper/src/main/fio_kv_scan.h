@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_SCAN_H__
+#define __FIO_KV_SCAN_H__
+
+#include <pthread.h>
+
+#include "fio_kv_helper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	uint32_t *buffers;
+	uint32_t head;
+	uint32_t count;
+} fio_kv_scan_queue_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t released;
+	pthread_cond_t filled;
+	fio_kv_pool_t *pools;
+	uint32_t pool_count;
+	uint32_t next_pool;
+	void **buffers;
+	uint32_t *owners;
+	uint32_t buffer_count;
+	uint32_t buffer_size;
+	uint32_t max;
+	bool keys_only;
+	fio_kv_scan_queue_t free;
+	fio_kv_scan_queue_t ready;
+	pthread_t *workers;
+	uint32_t worker_count;
+	uint32_t running;
+	bool stopping;
+} fio_kv_scan_t;
+
+
+/**
+ * Start a parallel scan of the given pools.
+ *
+ * Worker threads each take the next pool that hasn't been scanned yet, and
+ * iterate over it with fio_kv_next_batch(), reading one batch in each free
+ * buffer of the scan and handing it over to the consumer. The number of
+ * buffers bounds how far the workers get ahead of the consumer, which
+ * collects filled buffers with fio_kv_scan_reap() and gives them back with
+ * fio_kv_scan_release() once it is done with them.
+ *
+ * Args:
+ *	pools (fio_kv_pool_t **): The pools to scan.
+ *	pool_count (uint32_t): The number of pools to scan.
+ *	workers (uint32_t): The number of worker threads, each scanning one
+ *	  pool at a time.
+ *	buffers (uint32_t): The number of batch buffers.
+ *	size (uint32_t): The size of each batch buffer, a multiple of the sector
+ *	  size.
+ *	max (uint32_t): The maximum number of records in a batch.
+ *	keys_only (bool): Whether to only read keys and their metadata.
+ * Returns:
+ *	Returns a newly allocated scan, or NULL if it could not be started.
+ */
+fio_kv_scan_t *fio_kv_scan_create(fio_kv_pool_t **pools,
+		const uint32_t pool_count, const uint32_t workers,
+		const uint32_t buffers, const uint32_t size, const uint32_t max,
+		const bool keys_only);
+
+/**
+ * Return the given batch buffer of a scan.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	buffer (uint32_t): The batch buffer's index.
+ * Returns:
+ *	Returns a pointer to the sector-aligned batch buffer.
+ */
+void *fio_kv_scan_buffer(fio_kv_scan_t *scan, const uint32_t buffer);
+
+/**
+ * Wait for a filled batch buffer.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	pool (uint32_t *): Set to the index of the pool the batch was read from.
+ * Returns:
+ *	Returns the index of a batch buffer laid out as by fio_kv_next_batch(),
+ *	  or -1 once all pools have been scanned, or the scan was stopped, and
+ *	  all the filled buffers have been reaped.
+ */
+int fio_kv_scan_reap(fio_kv_scan_t *scan, uint32_t *pool);
+
+/**
+ * Give a reaped batch buffer back to the workers of a scan.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ *	buffer (uint32_t): The batch buffer's index.
+ */
+void fio_kv_scan_release(fio_kv_scan_t *scan, const uint32_t buffer);
+
+/**
+ * Stop a parallel scan and release its resources.
+ *
+ * Workers stop at their next batch, end their iteration and are joined. The
+ * batch buffers, whether reaped or not, become invalid.
+ *
+ * Args:
+ *	scan (fio_kv_scan_t *): The parallel scan.
+ */
+void fio_kv_scan_destroy(fio_kv_scan_t *scan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_SCAN_H__ */
@@ -0,0 +1,272 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fio_kv_sched.h"
+#include "fio_kv_stats.h"
+
+/**
+ * Read-priority I/O scheduling.
+ *
+ * Operations are classified as foreground reads, foreground writes and
+ * background work (iterations, bulk loads and pool deletions). Each class
+ * counts its operations in flight; an operation of a class with a deferral
+ * delay waits, polling every FIO_KV_SCHED_POLL_DELAY microseconds, while
+ * higher-priority classes have operations in flight, so that background
+ * work fills the device's idle time without queuing in front of latency
+ * sensitive operations. The delay bounds the wait so that a continuously
+ * busy foreground cannot starve background work entirely.
+ *
+ * Rate limits are token buckets holding tokens in millionths of an
+ * operation, refilled at the class's rate. A costly operation may take the
+ * bucket below zero: it reserves the tokens it needs and then sleeps until
+ * the refill would have covered them, outside of the bucket's lock, which
+ * keeps concurrent callers in arrival order.
+ */
+
+
+/**
+ * Number of tokens in an operation.
+ */
+#define _FIO_KV_SCHED_UNIT					1000000
+
+
+/**
+ * Sleep for the given number of microseconds.
+ */
+void _fio_kv_sched_sleep(const uint64_t delay)
+{
+	struct timespec ts;
+	ts.tv_sec = delay / 1000000;
+	ts.tv_nsec = (long)(delay % 1000000) * 1000;
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+}
+
+/**
+ * Tells whether operations of a class of higher priority than the given one
+ * are in flight.
+ */
+bool _fio_kv_sched_busy(const fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls)
+{
+	for (int i=0; i<cls; i++) {
+		if (sched->queues[i].active > 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Take the given number of operations from a class's token bucket.
+ *
+ * Returns the time to wait, in microseconds, for the bucket to cover them.
+ */
+uint64_t _fio_kv_sched_reserve(fio_kv_sched_queue_t *queue,
+		const uint32_t cost)
+{
+	uint64_t now = fio_kv_stats_clock();
+	uint64_t delay = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if (queue->rate > 0) {
+		int64_t capacity = (int64_t)queue->burst * _FIO_KV_SCHED_UNIT;
+		uint64_t elapsed = now > queue->stamp ? now - queue->stamp : 0;
+		queue->stamp = now;
+
+		// Tokens accrue at rate per second, that is rate / 1000 tokens for
+		// each elapsed nanosecond. Long idle periods fill the bucket.
+		uint64_t missing = (uint64_t)(capacity - queue->tokens);
+		if (elapsed >= missing / queue->rate * 1000 + 1000) {
+			queue->tokens = capacity;
+		} else {
+			queue->tokens += (int64_t)(elapsed * queue->rate / 1000);
+			if (queue->tokens > capacity) {
+				queue->tokens = capacity;
+			}
+		}
+
+		queue->tokens -= (int64_t)cost * _FIO_KV_SCHED_UNIT;
+		if (queue->tokens < 0) {
+			delay = (uint64_t)(-queue->tokens) / queue->rate;
+		}
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return delay;
+}
+
+/**
+ * Create an I/O scheduler, with no rate limit nor deferral on any class.
+ *
+ * Returns:
+ *	Returns the newly allocated scheduler, or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_sched_t *fio_kv_sched_create(void)
+{
+	fio_kv_sched_t *sched = (fio_kv_sched_t *)calloc(1,
+			sizeof(fio_kv_sched_t));
+	if (sched == NULL) {
+		return NULL;
+	}
+
+	for (int i=0; i<FIO_KV_SCHED_CLASSES; i++) {
+		pthread_mutex_init(&sched->queues[i].lock, NULL);
+	}
+
+	return sched;
+}
+
+/**
+ * Configure an I/O class of a scheduler.
+ *
+ * Operations of the class are limited to the given rate by a token bucket
+ * holding up to burst operations, and are deferred, for up to max_defer
+ * microseconds, while operations of a higher-priority class are in flight.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler.
+ *	cls (fio_kv_sched_class_t): The I/O class.
+ *	rate (uint32_t): The maximum rate, in operations per second, or 0 for no
+ *	  limit.
+ *	burst (uint32_t): The number of operations that can be issued at once
+ *	  above the rate, at least 1 if the rate is limited.
+ *	max_defer (uint32_t): The longest time an operation of the class yields
+ *	  to higher-priority ones, in microseconds, or 0 to never yield.
+ * Returns:
+ *	Returns true if the class was configured, false with errno set to
+ *	  EINVAL if the class or the burst is invalid.
+ */
+bool fio_kv_sched_configure(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls, const uint32_t rate,
+		const uint32_t burst, const uint32_t max_defer)
+{
+	assert(sched != NULL);
+
+	if (cls >= FIO_KV_SCHED_CLASSES || (rate > 0 && burst == 0)) {
+		errno = EINVAL;
+		return false;
+	}
+
+	fio_kv_sched_queue_t *queue = &sched->queues[cls];
+	pthread_mutex_lock(&queue->lock);
+	queue->rate = rate;
+	queue->burst = burst;
+	queue->tokens = (int64_t)burst * _FIO_KV_SCHED_UNIT;
+	queue->stamp = fio_kv_stats_clock();
+	queue->max_defer = max_defer;
+	pthread_mutex_unlock(&queue->lock);
+	return true;
+}
+
+/**
+ * Admit an operation of the given class, waiting as needed.
+ *
+ * The operation first yields to the operations in flight of the classes of
+ * higher priority, for up to the class's max_defer, and then waits for the
+ * class's token bucket to cover its cost. Each admitted operation must be
+ * followed by a call to fio_kv_sched_exit() once it completes.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL for no scheduling.
+ *	cls (fio_kv_sched_class_t): The I/O class of the operation.
+ *	cost (uint32_t): The number of operations it counts for.
+ */
+void fio_kv_sched_enter(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls, const uint32_t cost)
+{
+	if (sched == NULL) {
+		return;
+	}
+
+	assert(cls < FIO_KV_SCHED_CLASSES);
+	fio_kv_sched_queue_t *queue = &sched->queues[cls];
+
+	if (queue->max_defer > 0 && _fio_kv_sched_busy(sched, cls)) {
+		uint64_t deadline = fio_kv_stats_clock() +
+			(uint64_t)queue->max_defer * 1000;
+		do {
+			_fio_kv_sched_sleep(FIO_KV_SCHED_POLL_DELAY);
+		} while (_fio_kv_sched_busy(sched, cls) &&
+				fio_kv_stats_clock() < deadline);
+	}
+
+	if (queue->rate > 0) {
+		uint64_t delay = _fio_kv_sched_reserve(queue, cost);
+		if (delay > 0) {
+			_fio_kv_sched_sleep(delay);
+		}
+	}
+
+	__sync_fetch_and_add(&queue->active, 1);
+}
+
+/**
+ * Record the completion of an operation admitted by fio_kv_sched_enter().
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL for no scheduling.
+ *	cls (fio_kv_sched_class_t): The I/O class of the operation.
+ */
+void fio_kv_sched_exit(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls)
+{
+	if (sched == NULL) {
+		return;
+	}
+
+	assert(cls < FIO_KV_SCHED_CLASSES);
+	__sync_fetch_and_sub(&sched->queues[cls].active, 1);
+}
+
+/**
+ * Destroy an I/O scheduler.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL.
+ */
+void fio_kv_sched_destroy(fio_kv_sched_t *sched)
+{
+	if (sched == NULL) {
+		return;
+	}
+
+	for (int i=0; i<FIO_KV_SCHED_CLASSES; i++) {
+		pthread_mutex_destroy(&sched->queues[i].lock);
+	}
+
+	free(sched);
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_SCHED_H__
+#define __FIO_KV_SCHED_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+/**
+ * Number of I/O classes, and the interval at which a deferred operation
+ * checks whether the classes it yields to are idle, in microseconds.
+ */
+#define FIO_KV_SCHED_CLASSES				3
+#define FIO_KV_SCHED_POLL_DELAY				50
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * I/O classes, by decreasing priority.
+ */
+typedef enum {
+	FIO_KV_SCHED_READ = 0,
+	FIO_KV_SCHED_WRITE = 1,
+	FIO_KV_SCHED_BACKGROUND = 2
+} fio_kv_sched_class_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	uint32_t rate;
+	uint32_t burst;
+	int64_t tokens;
+	uint64_t stamp;
+	uint32_t max_defer;
+	volatile uint32_t active;
+} fio_kv_sched_queue_t;
+
+typedef struct {
+	fio_kv_sched_queue_t queues[FIO_KV_SCHED_CLASSES];
+} fio_kv_sched_t;
+
+
+/**
+ * Create an I/O scheduler, with no rate limit nor deferral on any class.
+ *
+ * Returns:
+ *	Returns the newly allocated scheduler, or NULL if it could not be
+ *	  allocated.
+ */
+fio_kv_sched_t *fio_kv_sched_create(void);
+
+/**
+ * Configure an I/O class of a scheduler.
+ *
+ * Operations of the class are limited to the given rate by a token bucket
+ * holding up to burst operations, and are deferred, for up to max_defer
+ * microseconds, while operations of a higher-priority class are in flight.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler.
+ *	cls (fio_kv_sched_class_t): The I/O class.
+ *	rate (uint32_t): The maximum rate, in operations per second, or 0 for no
+ *	  limit.
+ *	burst (uint32_t): The number of operations that can be issued at once
+ *	  above the rate, at least 1 if the rate is limited.
+ *	max_defer (uint32_t): The longest time an operation of the class yields
+ *	  to higher-priority ones, in microseconds, or 0 to never yield.
+ * Returns:
+ *	Returns true if the class was configured, false with errno set to
+ *	  EINVAL if the class or the burst is invalid.
+ */
+bool fio_kv_sched_configure(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls, const uint32_t rate,
+		const uint32_t burst, const uint32_t max_defer);
+
+/**
+ * Admit an operation of the given class, waiting as needed.
+ *
+ * The operation first yields to the operations in flight of the classes of
+ * higher priority, for up to the class's max_defer, and then waits for the
+ * class's token bucket to cover its cost. Each admitted operation must be
+ * followed by a call to fio_kv_sched_exit() once it completes.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL for no scheduling.
+ *	cls (fio_kv_sched_class_t): The I/O class of the operation.
+ *	cost (uint32_t): The number of operations it counts for.
+ */
+void fio_kv_sched_enter(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls, const uint32_t cost);
+
+/**
+ * Record the completion of an operation admitted by fio_kv_sched_enter().
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL for no scheduling.
+ *	cls (fio_kv_sched_class_t): The I/O class of the operation.
+ */
+void fio_kv_sched_exit(fio_kv_sched_t *sched,
+		const fio_kv_sched_class_t cls);
+
+/**
+ * Destroy an I/O scheduler.
+ *
+ * Args:
+ *	sched (fio_kv_sched_t *): The scheduler, or NULL.
+ */
+void fio_kv_sched_destroy(fio_kv_sched_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_SCHED_H__ */
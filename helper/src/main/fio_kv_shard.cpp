@@ -0,0 +1,389 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio_kv_shard.h"
+
+/**
+ * Multi-device sharding.
+ *
+ * A sharded store spreads its keys over several devices. Each shard has
+ * FIO_KV_SHARD_POINTS points on a consistent hashing ring, and a key lives on
+ * the shard owning the first point at or after its hash. Batch operations are
+ * split by shard and the sub-batches handed over to per-shard worker threads
+ * through their job queues, so that all the devices work at the same time;
+ * the dispatching thread executes one sub-batch itself and waits for the
+ * others to complete.
+ */
+
+
+/**
+ * Finalize a 32-bit FNV-1a hash, for an even spread of the keys and ring
+ * points.
+ */
+uint32_t _fio_kv_shard_mix(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/**
+ * Order ring points by increasing hash.
+ */
+int _fio_kv_shard_compare(const void *a, const void *b)
+{
+	uint32_t x = ((const fio_kv_shard_point_t *)a)->hash;
+	uint32_t y = ((const fio_kv_shard_point_t *)b)->hash;
+	return x < y ? -1 : x > y;
+}
+
+/**
+ * Execute a sub-batch on its shard's pool.
+ */
+void _fio_kv_shard_execute(fio_kv_shard_job_t *job)
+{
+	errno = 0;
+	switch (job->op) {
+		case FIO_KV_SHARD_GET:
+			job->done = fio_kv_batch_get_count(job->pool, job->keys,
+					job->values, job->count);
+			break;
+		case FIO_KV_SHARD_PUT:
+			job->done = fio_kv_batch_put_count(job->pool, job->keys,
+					job->values, job->count);
+			break;
+		case FIO_KV_SHARD_DELETE:
+			job->done = 0;
+			while (job->done < job->count &&
+					fio_kv_delete(job->pool, job->keys[job->done])) {
+				job->done++;
+			}
+			break;
+	}
+
+	job->error = job->done < job->count ? errno : 0;
+}
+
+/**
+ * Worker thread main loop: execute the jobs queued for a shard until the
+ * sharded store is destroyed and the queue is drained.
+ */
+void *_fio_kv_shard_worker(void *arg)
+{
+	fio_kv_shard_worker_t *worker = (fio_kv_shard_worker_t *)arg;
+
+	pthread_mutex_lock(&worker->lock);
+	while (true) {
+		while (worker->head == NULL && !worker->stopping) {
+			pthread_cond_wait(&worker->submitted, &worker->lock);
+		}
+
+		fio_kv_shard_job_t *job = worker->head;
+		if (job == NULL) {
+			break;
+		}
+
+		worker->head = job->next;
+		worker->tail = worker->head != NULL ? worker->tail : NULL;
+		pthread_mutex_unlock(&worker->lock);
+
+		_fio_kv_shard_execute(job);
+
+		fio_kv_shard_dispatch_t *dispatch = job->dispatch;
+		pthread_mutex_lock(&dispatch->lock);
+		if (--dispatch->pending == 0) {
+			pthread_cond_signal(&dispatch->completed);
+		}
+		pthread_mutex_unlock(&dispatch->lock);
+
+		pthread_mutex_lock(&worker->lock);
+	}
+	pthread_mutex_unlock(&worker->lock);
+	return NULL;
+}
+
+/**
+ * Queue a job for execution by a shard's worker thread.
+ */
+void _fio_kv_shard_submit(fio_kv_shard_worker_t *worker,
+		fio_kv_shard_job_t *job)
+{
+	job->next = NULL;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->tail != NULL) {
+		worker->tail->next = job;
+	} else {
+		worker->head = job;
+	}
+	worker->tail = job;
+	pthread_cond_signal(&worker->submitted);
+	pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+ * Create the sharding state of a store spread over several devices, and
+ * start one worker thread per device.
+ *
+ * Keys are spread over the shards by consistent hashing: adding a shard at
+ * the end only moves about 1/count of the keys to it. A sharded pool is made
+ * of one pool of the same tag on each device, given to the batch operations
+ * as an array of pools indexed by shard.
+ *
+ * Args:
+ *	count (uint32_t): The number of shards, between 1 and
+ *	  FIO_KV_SHARD_MAX_SHARDS.
+ * Returns:
+ *	Returns the newly allocated sharding state, or NULL if it could not be
+ *	  created.
+ */
+fio_kv_shard_t *fio_kv_shard_create(const uint32_t count)
+{
+	assert(count > 0 && count <= FIO_KV_SHARD_MAX_SHARDS);
+
+	fio_kv_shard_t *shard = (fio_kv_shard_t *)calloc(1,
+			sizeof(fio_kv_shard_t));
+	if (shard == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	uint32_t points = count * FIO_KV_SHARD_POINTS;
+	for (uint32_t i = 0; i < points; i++) {
+		uint32_t point[2] = { i / FIO_KV_SHARD_POINTS, i % FIO_KV_SHARD_POINTS };
+		shard->ring[i].hash = _fio_kv_shard_mix(fio_kv_pack_hash(
+					(const nvm_kv_key_t *)point, sizeof(point)));
+		shard->ring[i].shard = point[0];
+	}
+	qsort(shard->ring, points, sizeof(fio_kv_shard_point_t),
+			_fio_kv_shard_compare);
+
+	for (uint32_t i = 0; i < count; i++) {
+		fio_kv_shard_worker_t *worker = &shard->workers[i];
+		shard->count = i + 1;
+		pthread_mutex_init(&worker->lock, NULL);
+		pthread_cond_init(&worker->submitted, NULL);
+		worker->running = pthread_create(&worker->thread, NULL,
+				_fio_kv_shard_worker, worker) == 0;
+		if (!worker->running) {
+			fio_kv_shard_destroy(shard);
+			return NULL;
+		}
+	}
+
+	return shard;
+}
+
+/**
+ * Stop the worker threads of a sharded store and release its sharding state.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ */
+void fio_kv_shard_destroy(fio_kv_shard_t *shard)
+{
+	assert(shard != NULL);
+
+	for (uint32_t i = 0; i < shard->count; i++) {
+		fio_kv_shard_worker_t *worker = &shard->workers[i];
+		if (worker->running) {
+			pthread_mutex_lock(&worker->lock);
+			worker->stopping = true;
+			pthread_cond_signal(&worker->submitted);
+			pthread_mutex_unlock(&worker->lock);
+			pthread_join(worker->thread, NULL);
+		}
+
+		pthread_cond_destroy(&worker->submitted);
+		pthread_mutex_destroy(&worker->lock);
+	}
+
+	free(shard);
+}
+
+/**
+ * Return the shard a key lives on.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns the index of the key's shard.
+ */
+uint32_t fio_kv_shard_of(const fio_kv_shard_t *shard,
+		const fio_kv_key_t *key)
+{
+	assert(shard != NULL);
+	assert(key != NULL);
+
+	if (shard->count == 1) {
+		return 0;
+	}
+
+	uint32_t hash = _fio_kv_shard_mix(fio_kv_pack_hash(key->bytes,
+				key->length));
+	uint32_t low = 0;
+	uint32_t high = shard->count * FIO_KV_SHARD_POINTS;
+
+	// Find the first point at or after the key's hash, wrapping around.
+	while (low < high) {
+		uint32_t middle = (low + high) / 2;
+		if (shard->ring[middle].hash < hash) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return shard->ring[low < shard->count * FIO_KV_SHARD_POINTS ? low : 0]
+		.shard;
+}
+
+/**
+ * Execute a batch operation on a sharded pool.
+ *
+ * The keys are split by shard, and each shard's sub-batch is executed on its
+ * device in parallel with the others', by the shard's worker thread or, for
+ * the first one, by the calling thread. Sub-batches follow the semantics of
+ * fio_kv_batch_get(), fio_kv_batch_put() and fio_kv_delete(); if one fails,
+ * the others are still executed.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ *	pools (fio_kv_pool_t **): The pools of the sharded pool, by shard.
+ *	op (fio_kv_shard_op_t): The batch operation.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values, or NULL for FIO_KV_SHARD_DELETE.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of key/value pairs successfully processed, which is
+ *	  count on success. Otherwise errno is set to the error of a failed
+ *	  sub-batch.
+ */
+size_t fio_kv_shard_batch(fio_kv_shard_t *shard, fio_kv_pool_t **pools,
+		const fio_kv_shard_op_t op, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count)
+{
+	assert(shard != NULL);
+	assert(pools != NULL);
+	assert(keys != NULL);
+	assert(values != NULL || op == FIO_KV_SHARD_DELETE);
+
+	fio_kv_shard_job_t jobs[FIO_KV_SHARD_MAX_SHARDS];
+	fio_kv_shard_dispatch_t dispatch;
+	size_t offsets[FIO_KV_SHARD_MAX_SHARDS + 1];
+	size_t done = 0;
+	int error = 0;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	// Group the keys and values by shard, in their original order.
+	uint32_t *shards = (uint32_t *)malloc(count * sizeof(uint32_t));
+	const void **grouped = (const void **)malloc(2 * count * sizeof(void *));
+	if (shards == NULL || grouped == NULL) {
+		free(shards);
+		free(grouped);
+		errno = ENOMEM;
+		return 0;
+	}
+
+	memset(offsets, 0, sizeof(offsets));
+	for (size_t i = 0; i < count; i++) {
+		shards[i] = fio_kv_shard_of(shard, keys[i]);
+		offsets[shards[i] + 1]++;
+	}
+	for (uint32_t s = 0; s < shard->count; s++) {
+		offsets[s + 1] += offsets[s];
+		jobs[s].op = op;
+		jobs[s].pool = pools[s];
+		jobs[s].keys = (const fio_kv_key_t **)grouped + offsets[s];
+		jobs[s].values = (const fio_kv_value_t **)(grouped + count) +
+			offsets[s];
+		jobs[s].count = 0;
+		jobs[s].dispatch = &dispatch;
+	}
+	for (size_t i = 0; i < count; i++) {
+		fio_kv_shard_job_t *job = &jobs[shards[i]];
+		job->keys[job->count] = keys[i];
+		job->values[job->count] = values != NULL ? values[i] : NULL;
+		job->count++;
+	}
+	free(shards);
+
+	pthread_mutex_init(&dispatch.lock, NULL);
+	pthread_cond_init(&dispatch.completed, NULL);
+	dispatch.pending = 0;
+
+	// Hand the sub-batches over to the workers, but for the first one.
+	fio_kv_shard_job_t *local = NULL;
+	for (uint32_t s = 0; s < shard->count; s++) {
+		if (jobs[s].count == 0) {
+			continue;
+		} else if (local == NULL) {
+			local = &jobs[s];
+			continue;
+		}
+
+		pthread_mutex_lock(&dispatch.lock);
+		dispatch.pending++;
+		pthread_mutex_unlock(&dispatch.lock);
+		_fio_kv_shard_submit(&shard->workers[s], &jobs[s]);
+	}
+
+	_fio_kv_shard_execute(local);
+
+	pthread_mutex_lock(&dispatch.lock);
+	while (dispatch.pending > 0) {
+		pthread_cond_wait(&dispatch.completed, &dispatch.lock);
+	}
+	pthread_mutex_unlock(&dispatch.lock);
+	pthread_cond_destroy(&dispatch.completed);
+	pthread_mutex_destroy(&dispatch.lock);
+
+	for (uint32_t s = 0; s < shard->count; s++) {
+		done += jobs[s].count > 0 ? jobs[s].done : 0;
+		error = error == 0 && jobs[s].count > 0 ? jobs[s].error : error;
+	}
+
+	free(grouped);
+	errno = error;
+	return done;
+}
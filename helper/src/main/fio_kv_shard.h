@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_SHARD_H__
+#define __FIO_KV_SHARD_H__
+
+#include <pthread.h>
+
+#include "fio_kv_helper.h"
+
+/**
+ * Maximum number of shards of a sharded store, and number of points each
+ * shard has on the consistent hashing ring.
+ */
+#define FIO_KV_SHARD_MAX_SHARDS				16
+#define FIO_KV_SHARD_POINTS					160
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	FIO_KV_SHARD_GET,
+	FIO_KV_SHARD_PUT,
+	FIO_KV_SHARD_DELETE
+} fio_kv_shard_op_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t completed;
+	uint32_t pending;
+} fio_kv_shard_dispatch_t;
+
+typedef struct fio_kv_shard_job {
+	struct fio_kv_shard_job *next;
+	fio_kv_shard_op_t op;
+	const fio_kv_pool_t *pool;
+	const fio_kv_key_t **keys;
+	const fio_kv_value_t **values;
+	size_t count;
+	size_t done;
+	int error;
+	fio_kv_shard_dispatch_t *dispatch;
+} fio_kv_shard_job_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t submitted;
+	fio_kv_shard_job_t *head;
+	fio_kv_shard_job_t *tail;
+	pthread_t thread;
+	bool running;
+	bool stopping;
+} fio_kv_shard_worker_t;
+
+typedef struct {
+	uint32_t hash;
+	uint32_t shard;
+} fio_kv_shard_point_t;
+
+typedef struct {
+	uint32_t count;
+	fio_kv_shard_point_t ring[FIO_KV_SHARD_MAX_SHARDS * FIO_KV_SHARD_POINTS];
+	fio_kv_shard_worker_t workers[FIO_KV_SHARD_MAX_SHARDS];
+} fio_kv_shard_t;
+
+
+/**
+ * Create the sharding state of a store spread over several devices, and
+ * start one worker thread per device.
+ *
+ * Keys are spread over the shards by consistent hashing: adding a shard at
+ * the end only moves about 1/count of the keys to it. A sharded pool is made
+ * of one pool of the same tag on each device, given to the batch operations
+ * as an array of pools indexed by shard.
+ *
+ * Args:
+ *	count (uint32_t): The number of shards, between 1 and
+ *	  FIO_KV_SHARD_MAX_SHARDS.
+ * Returns:
+ *	Returns the newly allocated sharding state, or NULL if it could not be
+ *	  created.
+ */
+fio_kv_shard_t *fio_kv_shard_create(const uint32_t count);
+
+/**
+ * Stop the worker threads of a sharded store and release its sharding state.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ */
+void fio_kv_shard_destroy(fio_kv_shard_t *shard);
+
+/**
+ * Return the shard a key lives on.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ *	key (fio_kv_key_t *): The key.
+ * Returns:
+ *	Returns the index of the key's shard.
+ */
+uint32_t fio_kv_shard_of(const fio_kv_shard_t *shard,
+		const fio_kv_key_t *key);
+
+/**
+ * Execute a batch operation on a sharded pool.
+ *
+ * The keys are split by shard, and each shard's sub-batch is executed on its
+ * device in parallel with the others', by the shard's worker thread or, for
+ * the first one, by the calling thread. Sub-batches follow the semantics of
+ * fio_kv_batch_get(), fio_kv_batch_put() and fio_kv_delete(); if one fails,
+ * the others are still executed.
+ *
+ * Args:
+ *	shard (fio_kv_shard_t *): The sharding state.
+ *	pools (fio_kv_pool_t **): The pools of the sharded pool, by shard.
+ *	op (fio_kv_shard_op_t): The batch operation.
+ *	keys (fio_kv_key_t **): An array of pointers to the keys.
+ *	values (fio_kv_value_t **): An array of pointers to the corresponding
+ *	  values, or NULL for FIO_KV_SHARD_DELETE.
+ *	count (size_t): The number of keys.
+ * Returns:
+ *	Returns the number of key/value pairs successfully processed, which is
+ *	  count on success. Otherwise errno is set to the error of a failed
+ *	  sub-batch.
+ */
+size_t fio_kv_shard_batch(fio_kv_shard_t *shard, fio_kv_pool_t **pools,
+		const fio_kv_shard_op_t op, const fio_kv_key_t **keys,
+		const fio_kv_value_t **values, const size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_SHARD_H__ */
@@ -0,0 +1,505 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "fio_kv_helper.h"
+#include "fio_kv_slab.h"
+
+/**
+ * Sector-aligned slab allocator for key/value data buffers.
+ *
+ * Memory is reserved from the system in segments of FIO_KV_SLAB_SEGMENT_SIZE
+ * bytes, aligned on their size and optionally backed by huge pages. The first
+ * sector of each segment holds a header describing it; the rest is carved
+ * into blocks of one sector-multiple size class. Since all blocks are
+ * sector-aligned and live within their segment's first megabytes, the header
+ * of the segment a block belongs to is found by masking the block's address.
+ *
+ * Each thread keeps a free list per size class, refilled from and flushed to
+ * a global, mutex-protected free list by batches. Segments are never returned
+ * to the system, which keeps the reserved memory bounded by the peak demand
+ * of each size class instead of fragmenting the process heap.
+ *
+ * Allocations larger than FIO_KV_SLAB_MAX_BLOCK_SIZE get a dedicated mapping,
+ * laid out like a segment with a single block. Mappings of up to
+ * FIO_KV_SLAB_MAX_CACHED_SIZE bytes are rounded up to a power of two and a
+ * few of them are kept aside when freed for reuse.
+ */
+
+#define FIO_KV_SLAB_MAGIC		0x66696f6b
+#define FIO_KV_SLAB_MAPPING		((uint32_t)-1)
+#define FIO_KV_SLAB_MAX_CLASSES		64
+#define FIO_KV_SLAB_THREAD_CACHE_SIZE	(1024 * 1024)
+#define FIO_KV_SLAB_MAX_BATCH		128
+#define FIO_KV_SLAB_MAX_CACHED_MAPPINGS	8
+
+typedef struct {
+	uint32_t magic;
+	uint32_t cls;
+	uint32_t block;
+	size_t size;
+} _fio_kv_slab_header_t;
+
+typedef struct _fio_kv_slab_block {
+	struct _fio_kv_slab_block *next;
+} _fio_kv_slab_block_t;
+
+typedef struct {
+	_fio_kv_slab_block_t *head;
+	uint32_t count;
+} _fio_kv_slab_list_t;
+
+typedef struct {
+	pthread_mutex_t lock;
+	_fio_kv_slab_list_t free;
+	uint32_t size;
+	uint32_t batch;
+} _fio_kv_slab_class_t;
+
+static pthread_once_t _slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t _slab_thread_key;
+static size_t _slab_page_size;
+static volatile bool _slab_hugepages = false;
+
+static _fio_kv_slab_class_t _slab_classes[FIO_KV_SLAB_MAX_CLASSES];
+static uint32_t _slab_class_count = 0;
+
+static pthread_mutex_t _slab_mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+static _fio_kv_slab_header_t *_slab_mappings[FIO_KV_SLAB_MAX_CACHED_MAPPINGS];
+static uint32_t _slab_mappings_count = 0;
+
+static volatile uint64_t _slab_reserved = 0;
+static volatile uint64_t _slab_used = 0;
+static volatile uint64_t _slab_segments = 0;
+static volatile uint64_t _slab_mapped = 0;
+
+static __thread _fio_kv_slab_list_t _slab_thread_cache[FIO_KV_SLAB_MAX_CLASSES];
+static __thread bool _slab_thread_registered = false;
+
+/**
+ * Return a thread's cached blocks to the global free lists when it exits.
+ */
+void _fio_kv_slab_thread_exit(void *arg)
+{
+	for (uint32_t i=0; i<_slab_class_count; i++) {
+		_fio_kv_slab_list_t *list = &_slab_thread_cache[i];
+		_fio_kv_slab_class_t *c = &_slab_classes[i];
+		if (list->head == NULL) {
+			continue;
+		}
+
+		_fio_kv_slab_block_t *tail = list->head;
+		while (tail->next != NULL) {
+			tail = tail->next;
+		}
+
+		pthread_mutex_lock(&c->lock);
+		tail->next = c->free.head;
+		c->free.head = list->head;
+		c->free.count += list->count;
+		pthread_mutex_unlock(&c->lock);
+
+		list->head = NULL;
+		list->count = 0;
+	}
+}
+
+/**
+ * Add a size class, with a thread cache batch sized so that each thread
+ * caches about FIO_KV_SLAB_THREAD_CACHE_SIZE bytes of that class.
+ */
+void _fio_kv_slab_add_class(const uint32_t size)
+{
+	assert(_slab_class_count < FIO_KV_SLAB_MAX_CLASSES);
+	assert(size % FIO_SECTOR_ALIGNMENT == 0);
+
+	_fio_kv_slab_class_t *c = &_slab_classes[_slab_class_count++];
+	pthread_mutex_init(&c->lock, NULL);
+	c->free.head = NULL;
+	c->free.count = 0;
+	c->size = size;
+	c->batch = FIO_KV_SLAB_THREAD_CACHE_SIZE / size / 2;
+	if (c->batch < 1) {
+		c->batch = 1;
+	} else if (c->batch > FIO_KV_SLAB_MAX_BATCH) {
+		c->batch = FIO_KV_SLAB_MAX_BATCH;
+	}
+}
+
+/**
+ * Initialize the size classes: every sector multiple up to 4kB, then four
+ * classes per power of two up to FIO_KV_SLAB_MAX_BLOCK_SIZE.
+ */
+void _fio_kv_slab_init(void)
+{
+	_slab_page_size = (size_t)sysconf(_SC_PAGESIZE);
+	pthread_key_create(&_slab_thread_key, _fio_kv_slab_thread_exit);
+
+	for (uint32_t size = FIO_SECTOR_ALIGNMENT; size <= 4096;
+			size += FIO_SECTOR_ALIGNMENT) {
+		_fio_kv_slab_add_class(size);
+	}
+
+	for (uint32_t base = 4096; base < FIO_KV_SLAB_MAX_BLOCK_SIZE; base *= 2) {
+		for (uint32_t step = 1; step <= 4; step++) {
+			_fio_kv_slab_add_class(base + step * (base / 4));
+		}
+	}
+}
+
+/**
+ * Find the smallest size class that can hold the given number of bytes.
+ */
+uint32_t _fio_kv_slab_class_of(const uint32_t length)
+{
+	assert(length <= FIO_KV_SLAB_MAX_BLOCK_SIZE);
+
+	if (length <= 4096) {
+		return length > 0 ? (length - 1) / FIO_SECTOR_ALIGNMENT : 0;
+	}
+
+	uint32_t i = 4096 / FIO_SECTOR_ALIGNMENT;
+	while (_slab_classes[i].size < length) {
+		i++;
+	}
+
+	assert(i < _slab_class_count);
+	return i;
+}
+
+/**
+ * Map memory aligned on FIO_KV_SLAB_SEGMENT_SIZE from the system.
+ *
+ * Args:
+ *	size (size_t *): The amount of memory to map. On return, the actual
+ *	  size of the mapping, rounded up to a page or huge page multiple.
+ * Returns:
+ *	A pointer to the mapped memory, or NULL if the mapping failed.
+ */
+void *_fio_kv_slab_map(size_t *size)
+{
+	char *p;
+
+#ifdef MAP_HUGETLB
+	if (_slab_hugepages) {
+		size_t huge = (*size + FIO_KV_SLAB_SEGMENT_SIZE - 1) &
+			~(size_t)(FIO_KV_SLAB_SEGMENT_SIZE - 1);
+		p = (char *)mmap(NULL, huge, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED) {
+			*size = huge;
+			return p;
+		}
+	}
+#endif
+
+	// Over-allocate regular pages to align the mapping on the segment size,
+	// then release the excess on each side.
+	*size = (*size + _slab_page_size - 1) & ~(_slab_page_size - 1);
+	size_t span = *size + FIO_KV_SLAB_SEGMENT_SIZE;
+	p = (char *)mmap(NULL, span, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		return NULL;
+	}
+
+	char *aligned = (char *)(((uintptr_t)p + FIO_KV_SLAB_SEGMENT_SIZE - 1) &
+			~(uintptr_t)(FIO_KV_SLAB_SEGMENT_SIZE - 1));
+	if (aligned > p) {
+		munmap(p, aligned - p);
+	}
+	if (p + span > aligned + *size) {
+		munmap(aligned + *size, (p + span) - (aligned + *size));
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (_slab_hugepages) {
+		madvise(aligned, *size, MADV_HUGEPAGE);
+	}
+#endif
+
+	return aligned;
+}
+
+/**
+ * Reserve a new segment for the given size class and carve it into blocks
+ * on the class' global free list. Must be called with the class lock held.
+ */
+bool _fio_kv_slab_grow(const uint32_t cls)
+{
+	_fio_kv_slab_class_t *c = &_slab_classes[cls];
+	size_t size = FIO_KV_SLAB_SEGMENT_SIZE;
+	char *segment = (char *)_fio_kv_slab_map(&size);
+	if (segment == NULL) {
+		return false;
+	}
+
+	_fio_kv_slab_header_t *header = (_fio_kv_slab_header_t *)segment;
+	header->magic = FIO_KV_SLAB_MAGIC;
+	header->cls = cls;
+	header->block = c->size;
+	header->size = size;
+
+	for (size_t offset = FIO_SECTOR_ALIGNMENT;
+			offset + c->size <= FIO_KV_SLAB_SEGMENT_SIZE;
+			offset += c->size) {
+		_fio_kv_slab_block_t *block = (_fio_kv_slab_block_t *)(segment + offset);
+		block->next = c->free.head;
+		c->free.head = block;
+		c->free.count++;
+	}
+
+	__sync_fetch_and_add(&_slab_reserved, (uint64_t)size);
+	__sync_fetch_and_add(&_slab_segments, (uint64_t)1);
+	return true;
+}
+
+/**
+ * Allocate a dedicated mapping for a large allocation, reusing a cached one
+ * when possible.
+ */
+void *_fio_kv_slab_map_block(const uint32_t length)
+{
+	uint32_t block = length;
+	if (length <= FIO_KV_SLAB_MAX_CACHED_SIZE) {
+		block = FIO_KV_SLAB_MAX_BLOCK_SIZE;
+		while (block < length) {
+			block *= 2;
+		}
+
+		pthread_mutex_lock(&_slab_mappings_lock);
+		for (uint32_t i=0; i<_slab_mappings_count; i++) {
+			_fio_kv_slab_header_t *header = _slab_mappings[i];
+			if (header->block == block) {
+				_slab_mappings[i] = _slab_mappings[--_slab_mappings_count];
+				pthread_mutex_unlock(&_slab_mappings_lock);
+				__sync_fetch_and_add(&_slab_used, (uint64_t)block);
+				return (char *)header + FIO_SECTOR_ALIGNMENT;
+			}
+		}
+		pthread_mutex_unlock(&_slab_mappings_lock);
+	} else {
+		block = (length + FIO_SECTOR_ALIGNMENT - 1) &
+			~(uint32_t)(FIO_SECTOR_ALIGNMENT - 1);
+	}
+
+	size_t size = FIO_SECTOR_ALIGNMENT + (size_t)block;
+	_fio_kv_slab_header_t *header =
+		(_fio_kv_slab_header_t *)_fio_kv_slab_map(&size);
+	if (header == NULL) {
+		return NULL;
+	}
+
+	header->magic = FIO_KV_SLAB_MAGIC;
+	header->cls = FIO_KV_SLAB_MAPPING;
+	header->block = block;
+	header->size = size;
+
+	__sync_fetch_and_add(&_slab_reserved, (uint64_t)size);
+	__sync_fetch_and_add(&_slab_mapped, (uint64_t)1);
+	__sync_fetch_and_add(&_slab_used, (uint64_t)block);
+	return (char *)header + FIO_SECTOR_ALIGNMENT;
+}
+
+/**
+ * Release a dedicated mapping, keeping it aside for reuse if it is small
+ * enough and the cache isn't full.
+ */
+void _fio_kv_slab_unmap_block(_fio_kv_slab_header_t *header)
+{
+	__sync_fetch_and_sub(&_slab_used, (uint64_t)header->block);
+
+	if (header->block <= FIO_KV_SLAB_MAX_CACHED_SIZE) {
+		pthread_mutex_lock(&_slab_mappings_lock);
+		if (_slab_mappings_count < FIO_KV_SLAB_MAX_CACHED_MAPPINGS) {
+			_slab_mappings[_slab_mappings_count++] = header;
+			pthread_mutex_unlock(&_slab_mappings_lock);
+			return;
+		}
+		pthread_mutex_unlock(&_slab_mappings_lock);
+	}
+
+	size_t size = header->size;
+	munmap(header, size);
+	__sync_fetch_and_sub(&_slab_reserved, (uint64_t)size);
+	__sync_fetch_and_sub(&_slab_mapped, (uint64_t)1);
+}
+
+/**
+ * Enable or disable the use of huge pages for the memory reserved from now
+ * on by the allocator.
+ *
+ * When huge pages can't be obtained, the allocator falls back to regular
+ * pages.
+ *
+ * Args:
+ *	enabled (bool): Whether to use huge pages.
+ */
+void fio_kv_slab_use_hugepages(const bool enabled)
+{
+	_slab_hugepages = enabled;
+}
+
+/**
+ * Allocate sector-aligned memory to hold the given number of bytes.
+ *
+ * Allocations are rounded up to a sector-multiple size class and served from
+ * the calling thread's free list for that class when possible.
+ *
+ * Args:
+ *	length (uint32_t): Size of the memory to allocate.
+ * Returns:
+ *	A pointer to sector-aligned memory that can hold up to length bytes, or
+ *	NULL if the memory could not be allocated.
+ */
+void *fio_kv_slab_alloc(const uint32_t length)
+{
+	pthread_once(&_slab_once, _fio_kv_slab_init);
+
+	if (length > FIO_KV_SLAB_MAX_BLOCK_SIZE) {
+		return _fio_kv_slab_map_block(length);
+	}
+
+	if (!_slab_thread_registered) {
+		pthread_setspecific(_slab_thread_key, (void *)&_slab_thread_registered);
+		_slab_thread_registered = true;
+	}
+
+	uint32_t cls = _fio_kv_slab_class_of(length);
+	_fio_kv_slab_class_t *c = &_slab_classes[cls];
+	_fio_kv_slab_list_t *list = &_slab_thread_cache[cls];
+
+	// Refill the thread's free list from the global one, reserving a new
+	// segment if needed.
+	if (list->head == NULL) {
+		pthread_mutex_lock(&c->lock);
+		if (c->free.head == NULL && !_fio_kv_slab_grow(cls)) {
+			pthread_mutex_unlock(&c->lock);
+			return NULL;
+		}
+
+		while (c->free.head != NULL && list->count < c->batch) {
+			_fio_kv_slab_block_t *block = c->free.head;
+			c->free.head = block->next;
+			c->free.count--;
+			block->next = list->head;
+			list->head = block;
+			list->count++;
+		}
+		pthread_mutex_unlock(&c->lock);
+	}
+
+	_fio_kv_slab_block_t *block = list->head;
+	list->head = block->next;
+	list->count--;
+
+	__sync_fetch_and_add(&_slab_used, (uint64_t)c->size);
+	return block;
+}
+
+/**
+ * Release memory allocated by fio_kv_slab_alloc().
+ *
+ * Args:
+ *	p (void *): The memory to release. May be NULL.
+ */
+void fio_kv_slab_free(void *p)
+{
+	if (p == NULL) {
+		return;
+	}
+
+	_fio_kv_slab_header_t *header = (_fio_kv_slab_header_t *)
+		((uintptr_t)p & ~(uintptr_t)(FIO_KV_SLAB_SEGMENT_SIZE - 1));
+	assert(header->magic == FIO_KV_SLAB_MAGIC);
+
+	if (header->cls == FIO_KV_SLAB_MAPPING) {
+		_fio_kv_slab_unmap_block(header);
+		return;
+	}
+
+	_fio_kv_slab_class_t *c = &_slab_classes[header->cls];
+	_fio_kv_slab_list_t *list = &_slab_thread_cache[header->cls];
+	__sync_fetch_and_sub(&_slab_used, (uint64_t)c->size);
+
+	if (!_slab_thread_registered) {
+		pthread_setspecific(_slab_thread_key, (void *)&_slab_thread_registered);
+		_slab_thread_registered = true;
+	}
+
+	_fio_kv_slab_block_t *block = (_fio_kv_slab_block_t *)p;
+	block->next = list->head;
+	list->head = block;
+	list->count++;
+
+	// Hand a batch of blocks back to the global free list when the thread
+	// holds too many of them.
+	if (list->count >= 2 * c->batch) {
+		_fio_kv_slab_block_t *head = list->head;
+		_fio_kv_slab_block_t *tail = head;
+		for (uint32_t i=1; i<c->batch; i++) {
+			tail = tail->next;
+		}
+
+		list->head = tail->next;
+		list->count -= c->batch;
+
+		pthread_mutex_lock(&c->lock);
+		tail->next = c->free.head;
+		c->free.head = head;
+		c->free.count += c->batch;
+		pthread_mutex_unlock(&c->lock);
+	}
+}
+
+/**
+ * Retrieve the allocator's statistics.
+ *
+ * Args:
+ *	stats (fio_kv_slab_stats_t *): The structure to fill in with the number
+ *	  of bytes reserved from the system, the number of bytes currently
+ *	  handed out, the number of slab segments and the number of dedicated
+ *	  mappings held.
+ */
+void fio_kv_slab_get_stats(fio_kv_slab_stats_t *stats)
+{
+	assert(stats != NULL);
+
+	stats->reserved = _slab_reserved;
+	stats->used = _slab_used;
+	stats->segments = _slab_segments;
+	stats->mappings = _slab_mapped;
+}
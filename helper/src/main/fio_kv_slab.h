@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_SLAB_H__
+#define __FIO_KV_SLAB_H__
+
+#include <stdint.h>
+
+/**
+ * Size of the slab segments, and alignment of all slab allocations' backing
+ * memory. This matches the size of a huge page.
+ */
+#define FIO_KV_SLAB_SEGMENT_SIZE		(2 * 1024 * 1024)
+
+/**
+ * Largest allocation served from slab segments. Larger allocations get a
+ * dedicated mapping.
+ */
+#define FIO_KV_SLAB_MAX_BLOCK_SIZE	(256 * 1024)
+
+/**
+ * Largest allocation whose dedicated mapping is cached for reuse when freed.
+ */
+#define FIO_KV_SLAB_MAX_CACHED_SIZE	(1024 * 1024)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	uint64_t reserved;
+	uint64_t used;
+	uint64_t segments;
+	uint64_t mappings;
+} fio_kv_slab_stats_t;
+
+
+/**
+ * Enable or disable the use of huge pages for the memory reserved from now
+ * on by the allocator.
+ *
+ * When huge pages can't be obtained, the allocator falls back to regular
+ * pages.
+ *
+ * Args:
+ *	enabled (bool): Whether to use huge pages.
+ */
+void fio_kv_slab_use_hugepages(const bool enabled);
+
+/**
+ * Allocate sector-aligned memory to hold the given number of bytes.
+ *
+ * Allocations are rounded up to a sector-multiple size class and served from
+ * the calling thread's free list for that class when possible.
+ *
+ * Args:
+ *	length (uint32_t): Size of the memory to allocate.
+ * Returns:
+ *	A pointer to sector-aligned memory that can hold up to length bytes, or
+ *	NULL if the memory could not be allocated.
+ */
+void *fio_kv_slab_alloc(const uint32_t length);
+
+/**
+ * Release memory allocated by fio_kv_slab_alloc().
+ *
+ * Args:
+ *	p (void *): The memory to release. May be NULL.
+ */
+void fio_kv_slab_free(void *p);
+
+/**
+ * Retrieve the allocator's statistics.
+ *
+ * Args:
+ *	stats (fio_kv_slab_stats_t *): The structure to fill in with the number
+ *	  of bytes reserved from the system, the number of bytes currently
+ *	  handed out, the number of slab segments and the number of dedicated
+ *	  mappings held.
+ */
+void fio_kv_slab_get_stats(fio_kv_slab_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_SLAB_H__ */
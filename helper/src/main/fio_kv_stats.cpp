@@ -0,0 +1,287 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fio_kv_stats.h"
+
+/**
+ * Operation statistics for the key/value store.
+ *
+ * Every instrumented operation is timed with the monotonic clock, and its
+ * latency counted in a log-linear histogram: latencies are bucketed by
+ * their highest set bit, each power of two being split into
+ * 1 << FIO_KV_STATS_SUB_BITS linear sub-buckets, which bounds the relative
+ * error of any percentile computed from it. Operation, error and byte
+ * counts are kept alongside.
+ *
+ * Threads record into the stripe they were assigned on their first
+ * operation, with atomic increments since more threads than stripes may
+ * share one, so that threads working on the same store don't contend on
+ * the same cache lines. JNI calls additionally record their own duration
+ * minus the time spent in the operations they made, which is accumulated
+ * per thread, so that the marshalling overhead can be told apart from the
+ * device latency.
+ */
+
+#define _FIO_KV_STATS_SUB_COUNT		(1U << FIO_KV_STATS_SUB_BITS)
+
+/**
+ * Stripe assigned to the calling thread, plus one, or 0 if it wasn't
+ * assigned one yet.
+ */
+static __thread uint32_t _fio_kv_stats_stripe = 0;
+
+/**
+ * Time spent by the calling thread in the operations it recorded since its
+ * last fio_kv_stats_begin() call, in nanoseconds.
+ */
+static __thread uint64_t _fio_kv_stats_native = 0;
+
+/**
+ * Number of stripes handed out to threads so far.
+ */
+static uint32_t _fio_kv_stats_assigned = 0;
+
+
+/**
+ * Create the operation statistics of a store.
+ *
+ * Returns:
+ *	Returns newly allocated statistics, with all counters at zero, or NULL
+ *	if they could not be allocated.
+ */
+fio_kv_stats_t *fio_kv_stats_create(void)
+{
+	return (fio_kv_stats_t *)calloc(1, sizeof(fio_kv_stats_t));
+}
+
+/**
+ * Release the operation statistics of a store.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics.
+ */
+void fio_kv_stats_destroy(fio_kv_stats_t *stats)
+{
+	free(stats);
+}
+
+/**
+ * Read the monotonic clock used to time operations.
+ *
+ * Returns:
+ *	Returns the current time, in nanoseconds.
+ */
+uint64_t fio_kv_stats_clock(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Start timing a JNI call.
+ *
+ * This resets the calling thread's count of the time spent in instrumented
+ * operations, so that fio_kv_stats_record_jni() can tell the time spent
+ * marshalling the call apart from the time spent in the operations it made.
+ *
+ * Returns:
+ *	Returns the current time, in nanoseconds.
+ */
+uint64_t fio_kv_stats_begin(void)
+{
+	_fio_kv_stats_native = 0;
+	return fio_kv_stats_clock();
+}
+
+/**
+ * Returns the histogram bucket counting the given latency.
+ *
+ * Args:
+ *	ns (uint64_t): The latency, in nanoseconds.
+ */
+uint32_t _fio_kv_stats_bucket(const uint64_t ns)
+{
+	if (ns < _FIO_KV_STATS_SUB_COUNT) {
+		return (uint32_t)ns;
+	}
+
+	uint32_t high = (uint32_t)(ns >> 32);
+	uint32_t msb = high != 0
+		? 63 - __builtin_clz(high)
+		: 31 - __builtin_clz((uint32_t)ns);
+	uint32_t bucket = ((msb - FIO_KV_STATS_SUB_BITS + 1) << FIO_KV_STATS_SUB_BITS) +
+		(uint32_t)((ns >> (msb - FIO_KV_STATS_SUB_BITS)) &
+			(_FIO_KV_STATS_SUB_COUNT - 1));
+	return bucket < FIO_KV_STATS_BUCKETS ? bucket : FIO_KV_STATS_BUCKETS - 1;
+}
+
+/**
+ * Returns the highest latency, in nanoseconds, counted in the given bucket
+ * of a latency histogram.
+ *
+ * Args:
+ *	bucket (uint32_t): The bucket index.
+ */
+uint64_t fio_kv_stats_bucket_limit(const uint32_t bucket)
+{
+	if (bucket < _FIO_KV_STATS_SUB_COUNT) {
+		return bucket;
+	}
+
+	uint32_t shift = (bucket >> FIO_KV_STATS_SUB_BITS) - 1;
+	uint64_t sub = bucket & (_FIO_KV_STATS_SUB_COUNT - 1);
+	return ((_FIO_KV_STATS_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+/**
+ * Returns the stripe the calling thread records into.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics.
+ */
+fio_kv_stats_snapshot_t *_fio_kv_stats_stripe_of(fio_kv_stats_t *stats)
+{
+	if (_fio_kv_stats_stripe == 0) {
+		_fio_kv_stats_stripe = 1 +
+			__sync_fetch_and_add(&_fio_kv_stats_assigned, 1) %
+				FIO_KV_STATS_STRIPES;
+	}
+
+	return &stats->stripes[_fio_kv_stats_stripe - 1];
+}
+
+/**
+ * Record the completion of an operation.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics, or NULL to only account for
+ *	  the operation's time in the calling thread's JNI call.
+ *	op (fio_kv_stats_op_t): The operation.
+ *	start (uint64_t): The time the operation started at, as returned by
+ *	  fio_kv_stats_clock().
+ *	error (int): The errno value the operation failed with, or 0 if it
+ *	  succeeded.
+ *	bytes_in (uint64_t): The number of value bytes written.
+ *	bytes_out (uint64_t): The number of value bytes read.
+ */
+void fio_kv_stats_record(fio_kv_stats_t *stats, const fio_kv_stats_op_t op,
+		const uint64_t start, const int error, const uint64_t bytes_in,
+		const uint64_t bytes_out)
+{
+	uint64_t elapsed = fio_kv_stats_clock() - start;
+	_fio_kv_stats_native += elapsed;
+	if (stats == NULL) {
+		return;
+	}
+
+	fio_kv_stats_snapshot_t *stripe = _fio_kv_stats_stripe_of(stats);
+	fio_kv_stats_op_counters_t *counters = &stripe->ops[op];
+	__sync_fetch_and_add(&counters->count, 1);
+	__sync_fetch_and_add(&counters->native_ns, elapsed);
+	__sync_fetch_and_add(&counters->native[_fio_kv_stats_bucket(elapsed)], 1);
+	if (bytes_in > 0) {
+		__sync_fetch_and_add(&counters->bytes_in, bytes_in);
+	}
+	if (bytes_out > 0) {
+		__sync_fetch_and_add(&counters->bytes_out, bytes_out);
+	}
+
+	if (error != 0) {
+		__sync_fetch_and_add(&counters->errors, 1);
+		__sync_fetch_and_add(&stripe->errnos[error > 0 &&
+				error < FIO_KV_STATS_ERRNOS ? error : FIO_KV_STATS_ERRNOS - 1], 1);
+	}
+}
+
+/**
+ * Record the completion of a JNI call.
+ *
+ * The call's marshalling overhead, its duration minus the time spent in the
+ * operations it recorded since fio_kv_stats_begin(), is added to the JNI
+ * counters of the operation.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics, or NULL.
+ *	op (fio_kv_stats_op_t): The operation the JNI call maps to.
+ *	start (uint64_t): The time the call started at, as returned by
+ *	  fio_kv_stats_begin().
+ */
+void fio_kv_stats_record_jni(fio_kv_stats_t *stats,
+		const fio_kv_stats_op_t op, const uint64_t start)
+{
+	if (stats == NULL) {
+		return;
+	}
+
+	uint64_t elapsed = fio_kv_stats_clock() - start;
+	uint64_t overhead = elapsed > _fio_kv_stats_native
+		? elapsed - _fio_kv_stats_native
+		: 0;
+
+	fio_kv_stats_op_counters_t *counters =
+		&_fio_kv_stats_stripe_of(stats)->ops[op];
+	__sync_fetch_and_add(&counters->jni_count, 1);
+	__sync_fetch_and_add(&counters->jni_ns, overhead);
+	__sync_fetch_and_add(&counters->jni[_fio_kv_stats_bucket(overhead)], 1);
+}
+
+/**
+ * Retrieve a snapshot of the operation statistics of a store.
+ *
+ * Counters are read while they may be updated, so a snapshot is not an
+ * atomic view of all of them, but each counter is consistent.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics.
+ *	snapshot (fio_kv_stats_snapshot_t *): The structure to fill in with the
+ *	  counters summed over all stripes.
+ */
+void fio_kv_stats_get(fio_kv_stats_t *stats,
+		fio_kv_stats_snapshot_t *snapshot)
+{
+	memset(snapshot, 0, sizeof(fio_kv_stats_snapshot_t));
+
+	// Both structures are made of uint64_t counters only, summed one by one.
+	const size_t counters = sizeof(fio_kv_stats_snapshot_t) / sizeof(uint64_t);
+	uint64_t *sum = (uint64_t *)snapshot;
+	for (uint32_t s=0; s<FIO_KV_STATS_STRIPES; s++) {
+		const volatile uint64_t *stripe =
+			(const volatile uint64_t *)&stats->stripes[s];
+		for (size_t i=0; i<counters; i++) {
+			sum[i] += stripe[i];
+		}
+	}
+}
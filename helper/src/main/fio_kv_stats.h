@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __FIO_KV_STATS_H__
+#define __FIO_KV_STATS_H__
+
+#include <stdint.h>
+
+/**
+ * Number of sub-buckets per power of two in latency histograms, as a power
+ * of two. With 8 sub-buckets, recorded latencies are within 12.5% of their
+ * actual value.
+ */
+#define FIO_KV_STATS_SUB_BITS				3
+
+/**
+ * Number of buckets of a latency histogram, covering latencies of up to
+ * about 17 seconds. Longer operations are counted in the last bucket.
+ */
+#define FIO_KV_STATS_BUCKETS				256
+
+/**
+ * Number of errno values counted individually. Errors with a larger errno
+ * are counted in the last slot.
+ */
+#define FIO_KV_STATS_ERRNOS					64
+
+/**
+ * Number of independently updated stripes of a store's statistics. Each
+ * thread records into its own stripe, stripes being handed out to threads
+ * in turn.
+ */
+#define FIO_KV_STATS_STRIPES				4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Operations instrumented by the statistics.
+ */
+typedef enum {
+	FIO_KV_STATS_GET = 0,
+	FIO_KV_STATS_PUT,
+	FIO_KV_STATS_EXISTS,
+	FIO_KV_STATS_DELETE,
+	FIO_KV_STATS_GET_VALUE_LEN,
+	FIO_KV_STATS_GET_KEY_INFO,
+	FIO_KV_STATS_BATCH_GET,
+	FIO_KV_STATS_BATCH_PUT,
+	FIO_KV_STATS_ITERATE,
+	FIO_KV_STATS_BATCH_DELETE,
+	FIO_KV_STATS_BATCH_EXISTS,
+	FIO_KV_STATS_OPS
+} fio_kv_stats_op_t;
+
+typedef struct {
+	uint64_t count;
+	uint64_t errors;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t native_ns;
+	uint64_t jni_count;
+	uint64_t jni_ns;
+	uint64_t native[FIO_KV_STATS_BUCKETS];
+	uint64_t jni[FIO_KV_STATS_BUCKETS];
+} fio_kv_stats_op_counters_t;
+
+typedef struct {
+	fio_kv_stats_op_counters_t ops[FIO_KV_STATS_OPS];
+	uint64_t errnos[FIO_KV_STATS_ERRNOS];
+} fio_kv_stats_snapshot_t;
+
+typedef struct {
+	fio_kv_stats_snapshot_t stripes[FIO_KV_STATS_STRIPES];
+} fio_kv_stats_t;
+
+
+/**
+ * Create the operation statistics of a store.
+ *
+ * Returns:
+ *	Returns newly allocated statistics, with all counters at zero, or NULL
+ *	if they could not be allocated.
+ */
+fio_kv_stats_t *fio_kv_stats_create(void);
+
+/**
+ * Release the operation statistics of a store.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics.
+ */
+void fio_kv_stats_destroy(fio_kv_stats_t *stats);
+
+/**
+ * Read the monotonic clock used to time operations.
+ *
+ * Returns:
+ *	Returns the current time, in nanoseconds.
+ */
+uint64_t fio_kv_stats_clock(void);
+
+/**
+ * Start timing a JNI call.
+ *
+ * This resets the calling thread's count of the time spent in instrumented
+ * operations, so that fio_kv_stats_record_jni() can tell the time spent
+ * marshalling the call apart from the time spent in the operations it made.
+ *
+ * Returns:
+ *	Returns the current time, in nanoseconds.
+ */
+uint64_t fio_kv_stats_begin(void);
+
+/**
+ * Record the completion of an operation.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics, or NULL to only account for
+ *	  the operation's time in the calling thread's JNI call.
+ *	op (fio_kv_stats_op_t): The operation.
+ *	start (uint64_t): The time the operation started at, as returned by
+ *	  fio_kv_stats_clock().
+ *	error (int): The errno value the operation failed with, or 0 if it
+ *	  succeeded.
+ *	bytes_in (uint64_t): The number of value bytes written.
+ *	bytes_out (uint64_t): The number of value bytes read.
+ */
+void fio_kv_stats_record(fio_kv_stats_t *stats, const fio_kv_stats_op_t op,
+		const uint64_t start, const int error, const uint64_t bytes_in,
+		const uint64_t bytes_out);
+
+/**
+ * Record the completion of a JNI call.
+ *
+ * The call's marshalling overhead, its duration minus the time spent in the
+ * operations it recorded since fio_kv_stats_begin(), is added to the JNI
+ * counters of the operation.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics, or NULL.
+ *	op (fio_kv_stats_op_t): The operation the JNI call maps to.
+ *	start (uint64_t): The time the call started at, as returned by
+ *	  fio_kv_stats_begin().
+ */
+void fio_kv_stats_record_jni(fio_kv_stats_t *stats,
+		const fio_kv_stats_op_t op, const uint64_t start);
+
+/**
+ * Retrieve a snapshot of the operation statistics of a store.
+ *
+ * Counters are read while they may be updated, so a snapshot is not an
+ * atomic view of all of them, but each counter is consistent.
+ *
+ * Args:
+ *	stats (fio_kv_stats_t *): The statistics.
+ *	snapshot (fio_kv_stats_snapshot_t *): The structure to fill in with the
+ *	  counters summed over all stripes.
+ */
+void fio_kv_stats_get(fio_kv_stats_t *stats,
+		fio_kv_stats_snapshot_t *snapshot);
+
+/**
+ * Returns the highest latency, in nanoseconds, counted in the given bucket
+ * of a latency histogram.
+ *
+ * Args:
+ *	bucket (uint32_t): The bucket index.
+ */
+uint64_t fio_kv_stats_bucket_limit(const uint32_t bucket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIO_KV_STATS_H__ */
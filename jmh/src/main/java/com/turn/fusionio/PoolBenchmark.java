@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import java.util.concurrent.TimeUnit;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OperationsPerInvocation;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+/**
+ * Microbenchmarks of the single and batch operations of a {@link Pool}.
+ *
+ * <p>
+ * Each thread cycles through the keys of the benchmark pool. The
+ * <tt>jniCall</tt> and <tt>fastGet</tt> benchmarks give the cost of a bare
+ * JNI crossing and of a read without the {@link Value} allocation done by
+ * {@link Pool#get(Key)}; against the no-op backend, the others give the
+ * overhead of the binding itself. The <tt>*Long</tt> variants use the long
+ * key entry points, without {@link Key} objects.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+public class PoolBenchmark {
+
+	private static final int BATCH_SIZE = Pool.FUSION_IO_MAX_BATCH_SIZE;
+
+	/**
+	 * Per-thread keys and value buffers.
+	 */
+	@State(Scope.Thread)
+	public static class ThreadState {
+
+		Key key;
+		Value value;
+		Key[] keys;
+		long[] ids;
+		Value[] values;
+		PackedBatch batch;
+
+		private int records;
+		private long next;
+
+		@Setup(Level.Trial)
+		public void setUp(StoreState state) {
+			this.records = state.records;
+			this.next = 0;
+			this.key = Key.get(8);
+			this.value = Value.get(state.valueSize);
+			this.keys = new Key[BATCH_SIZE];
+			this.ids = new long[BATCH_SIZE];
+			this.values = new Value[BATCH_SIZE];
+			for (int i=0; i<BATCH_SIZE; i++) {
+				this.keys[i] = Key.get(8);
+				this.values[i] = Value.get(state.valueSize);
+			}
+			this.batch = new PackedBatch(
+				BATCH_SIZE * (state.valueSize + 4096), BATCH_SIZE);
+		}
+
+		@TearDown(Level.Trial)
+		public void tearDown() {
+			this.value.free();
+			for (Value value : this.values) {
+				value.free();
+			}
+			this.batch.free();
+		}
+
+		/** Set the key to the following record's. */
+		Key next() {
+			return this.key.set(this.next++ % this.records);
+		}
+
+		/** Return the following record's key, as a long. */
+		long nextId() {
+			return this.next++ % this.records;
+		}
+
+		/** Set the batch long keys to the following records'. */
+		long[] nextIds() {
+			for (int i=0; i<BATCH_SIZE; i++) {
+				this.ids[i] = this.next++ % this.records;
+			}
+			return this.ids;
+		}
+
+		/** Set the batch keys to the following records'. */
+		Key[] nextBatch() {
+			for (Key key : this.keys) {
+				key.set(this.next++ % this.records);
+			}
+			return this.keys;
+		}
+	}
+
+	@Benchmark
+	public int jniCall() {
+		return FusionIOAPI.fio_kv_get_last_error();
+	}
+
+	@Benchmark
+	public int get(StoreState state, ThreadState ts) throws FusionIOException {
+		Value value = state.pool.get(ts.next());
+		int size = value.size();
+		value.free();
+		return size;
+	}
+
+	@Benchmark
+	public int fastGet(StoreState state, ThreadState ts) {
+		Key key = ts.next();
+		return FusionIOAPI.fio_kv_fast_get(state.pool.handle(),
+			key.address(), key.size(), ts.value.address(), ts.value.size());
+	}
+
+	@Benchmark
+	public int getLong(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		Value value = state.pool.getLong(ts.nextId());
+		int size = value.size();
+		value.free();
+		return size;
+	}
+
+	@Benchmark
+	public int fastGetLong(StoreState state, ThreadState ts) {
+		return FusionIOAPI.fio_kv_fast_get_long(state.pool.handle(),
+			ts.nextId(), ts.value.address(), ts.value.size());
+	}
+
+	@Benchmark
+	public void put(StoreState state, ThreadState ts) throws FusionIOException {
+		state.pool.put(ts.next(), ts.value);
+	}
+
+	@Benchmark
+	public boolean exists(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		return state.pool.exists(ts.next());
+	}
+
+	@Benchmark
+	@OperationsPerInvocation(BATCH_SIZE)
+	public void batchPut(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		state.pool.put(ts.nextBatch(), ts.values);
+	}
+
+	@Benchmark
+	public void putLong(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		state.pool.putLong(ts.nextId(), ts.value);
+	}
+
+	@Benchmark
+	public boolean existsLong(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		return state.pool.existsLong(ts.nextId());
+	}
+
+	@Benchmark
+	@OperationsPerInvocation(BATCH_SIZE)
+	public void batchPutLong(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		state.pool.putLong(ts.nextIds(), ts.values);
+	}
+
+	@Benchmark
+	@OperationsPerInvocation(BATCH_SIZE)
+	public void packedBatchPut(StoreState state, ThreadState ts)
+			throws FusionIOException {
+		Key[] keys = ts.nextBatch();
+		ts.batch.clear();
+		for (int i=0; i<BATCH_SIZE; i++) {
+			ts.batch.add(keys[i], ts.values[i].getByteBuffer());
+		}
+		state.pool.put(ts.batch);
+	}
+}
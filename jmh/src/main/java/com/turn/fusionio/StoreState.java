@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2012-2013 Turn Inc.  All Rights Reserved.
+ * Proprietary and confidential.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * - Neither the name Turn Inc. nor the names of its contributors may be used
+ *   to endorse or promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+package com.turn.fusionio;
+
+import com.turn.fusionio.FusionIOAPI.ExpiryMode;
+
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+
+/**
+ * Key/value store shared by the threads of a benchmark.
+ *
+ * <p>
+ * The store is opened on the device or directFS file given by the
+ * <tt>path</tt> parameter, and a benchmark pool is loaded with
+ * <tt>records</tt> key/value pairs of <tt>valueSize</tt> bytes, keyed by
+ * their index. The pool is deleted when the benchmark completes.
+ * </p>
+ *
+ * <p>
+ * When running against the no-op backend of the helper library, the path
+ * can be any file on a filesystem supporting direct I/O.
+ * </p>
+ *
+ * @author mpetazzoni
+ */
+@State(Scope.Benchmark)
+public class StoreState {
+
+	/** Tag of the benchmark pool. */
+	private static final String POOL_TAG = "jmh";
+
+	@Param("/dev/fioa")
+	public String path;
+
+	@Param({"512", "4096"})
+	public int valueSize;
+
+	@Param("1024")
+	public int records;
+
+	Store store;
+	Pool pool;
+
+	@Setup(Level.Trial)
+	public void setUp() throws FusionIOException {
+		this.store = FusionIOAPI.get(this.path, 0, ExpiryMode.NO_EXPIRY, 0);
+		this.store.open();
+		this.pool = this.store.getOrCreatePool(POOL_TAG);
+
+		Key[] keys = new Key[Pool.FUSION_IO_MAX_BATCH_SIZE];
+		Value[] values = new Value[keys.length];
+		for (int i=0; i<keys.length; i++) {
+			keys[i] = Key.get(8);
+			values[i] = Value.get(this.valueSize);
+		}
+
+		for (int i=0; i<this.records; i+=keys.length) {
+			int count = Math.min(keys.length, this.records - i);
+			for (int j=0; j<count; j++) {
+				keys[j].set(i + j);
+			}
+
+			if (count == keys.length) {
+				this.pool.put(keys, values);
+			} else {
+				for (int j=0; j<count; j++) {
+					this.pool.put(keys[j], values[j]);
+				}
+			}
+		}
+
+		for (Value value : values) {
+			value.free();
+		}
+	}
+
+	@TearDown(Level.Trial)
+	public void tearDown() throws FusionIOException {
+		this.store.deletePool(this.pool);
+		this.store.close();
+	}
+}